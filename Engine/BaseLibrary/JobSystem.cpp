@@ -0,0 +1,262 @@
+#include "JobSystem.hpp"
+#include "ThreadName.hpp"
+
+#include <string>
+
+
+namespace inl {
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Tries this many times to find work before a worker goes to sleep.
+constexpr unsigned IdleSpinCount = 32;
+
+// Identifies worker threads, so that jobs spawned by a worker go to its own deque.
+thread_local const JobSystem* t_jobSystem = nullptr;
+thread_local unsigned t_workerIndex = 0;
+thread_local uint32_t t_randomState = 0x9E3779B9u;
+
+uint32_t NextRandom() {
+	// xorshift, good enough to spread out thieves
+	uint32_t x = t_randomState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	t_randomState = x;
+	return x;
+}
+
+} // namespace
+
+
+struct JobSystem::Worker {
+	WorkStealingDeque<impl::Job*> deque;
+	std::thread thread;
+};
+
+
+
+//------------------------------------------------------------------------------
+// Job system
+//------------------------------------------------------------------------------
+
+JobSystem::JobSystem(unsigned numWorkers, bool pinWorkers)
+	: m_globalQueueSize(0),
+	m_epoch(0),
+	m_numSleeping(0),
+	m_stop(false)
+{
+	if (numWorkers == 0) {
+		unsigned numHardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+	}
+
+	// all deques must exist before any worker starts stealing
+	for (unsigned i = 0; i < numWorkers; ++i) {
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+	for (unsigned i = 0; i < numWorkers; ++i) {
+		m_workers[i]->thread = std::thread([this, i, pinWorkers] {
+			std::string name = "Job Worker " + std::to_string(i);
+			SetCurrentThreadName(name.c_str());
+			if (pinWorkers) {
+				SetCurrentThreadAffinity(i);
+			}
+			WorkerThread(i);
+		});
+	}
+}
+
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lkg(m_sleepMutex);
+		m_stop = true;
+	}
+	m_sleepCv.notify_all();
+	for (auto& worker : m_workers) {
+		worker->thread.join();
+	}
+
+	for (auto& worker : m_workers) {
+		while (impl::Job* job = worker->deque.Pop()) {
+			delete job;
+		}
+	}
+	for (impl::Job* job : m_globalQueue) {
+		delete job;
+	}
+}
+
+
+void JobSystem::Run(JobFunction function, JobCounter* counter) {
+	if (counter) {
+		counter->m_value.fetch_add(1, std::memory_order_relaxed);
+	}
+	Schedule(new impl::Job{ std::move(function), counter });
+}
+
+
+void JobSystem::Run(JobFunction function, JobCounter* counter, JobCounter& dependency) {
+	if (counter) {
+		counter->m_value.fetch_add(1, std::memory_order_relaxed);
+	}
+	impl::Job* job = new impl::Job{ std::move(function), counter };
+
+	// The counter is only decremented under the lock, so either we see it at zero,
+	// or the finishing job will see us in the waiters.
+	{
+		std::lock_guard<spin_mutex> lkg(dependency.m_waitersMutex);
+		if (dependency.m_value.load(std::memory_order_acquire) != 0) {
+			dependency.m_waiters.push_back(job);
+			return;
+		}
+	}
+	Schedule(job);
+}
+
+
+void JobSystem::Wait(JobCounter& counter) {
+	while (!counter.IsZero()) {
+		if (impl::Job* job = FindJob()) {
+			Execute(job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	// The last job may still be inside Finish, touching the counter.
+	// Going through the lock makes sure it's done before the caller destroys the counter.
+	std::lock_guard<spin_mutex> lkg(counter.m_waitersMutex);
+}
+
+
+int JobSystem::GetCurrentWorkerIndex() const {
+	return t_jobSystem == this ? int(t_workerIndex) : -1;
+}
+
+
+void JobSystem::WorkerThread(unsigned index) {
+	t_jobSystem = this;
+	t_workerIndex = index;
+	t_randomState = 0x9E3779B9u * (index + 1);
+
+	while (true) {
+		uint64_t epoch = m_epoch.load();
+
+		impl::Job* job = nullptr;
+		for (unsigned i = 0; i < IdleSpinCount && !job; ++i) {
+			job = FindJob();
+			if (!job && i > 0) {
+				std::this_thread::yield();
+			}
+		}
+		if (job) {
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(m_sleepMutex);
+		if (m_stop) {
+			break;
+		}
+		m_numSleeping.fetch_add(1);
+		if (m_epoch.load() == epoch) {
+			m_sleepCv.wait(lk);
+		}
+		m_numSleeping.fetch_sub(1);
+		if (m_stop) {
+			break;
+		}
+	}
+
+	t_jobSystem = nullptr;
+}
+
+
+void JobSystem::Schedule(impl::Job* job) {
+	if (t_jobSystem == this) {
+		m_workers[t_workerIndex]->deque.Push(job);
+	}
+	else {
+		std::lock_guard<std::mutex> lkg(m_globalQueueMutex);
+		m_globalQueue.push_back(job);
+		m_globalQueueSize.fetch_add(1, std::memory_order_release);
+	}
+	Wake();
+}
+
+
+impl::Job* JobSystem::FindJob() {
+	bool isWorker = t_jobSystem == this;
+	if (isWorker) {
+		if (impl::Job* job = m_workers[t_workerIndex]->deque.Pop()) {
+			return job;
+		}
+	}
+
+	if (m_globalQueueSize.load(std::memory_order_acquire) > 0) {
+		std::lock_guard<std::mutex> lkg(m_globalQueueMutex);
+		if (!m_globalQueue.empty()) {
+			impl::Job* job = m_globalQueue.front();
+			m_globalQueue.pop_front();
+			m_globalQueueSize.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	size_t numWorkers = m_workers.size();
+	size_t first = NextRandom() % numWorkers;
+	for (size_t i = 0; i < numWorkers; ++i) {
+		size_t victim = (first + i) % numWorkers;
+		if (isWorker && victim == t_workerIndex) {
+			continue;
+		}
+		if (impl::Job* job = m_workers[victim]->deque.Steal()) {
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+
+void JobSystem::Execute(impl::Job* job) {
+	job->function();
+	if (job->counter) {
+		Finish(*job->counter);
+	}
+	delete job;
+}
+
+
+void JobSystem::Finish(JobCounter& counter) {
+	std::vector<impl::Job*> waiters;
+	{
+		std::lock_guard<spin_mutex> lkg(counter.m_waitersMutex);
+		if (counter.m_value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			waiters.swap(counter.m_waiters);
+		}
+	}
+	for (impl::Job* waiter : waiters) {
+		Schedule(waiter);
+	}
+}
+
+
+void JobSystem::Wake() {
+	// Pairs with the sleeping side: either the worker sees the new epoch, or we see it sleeping.
+	m_epoch.fetch_add(1);
+	if (m_numSleeping.load() > 0) {
+		std::lock_guard<std::mutex> lkg(m_sleepMutex);
+		m_sleepCv.notify_one();
+	}
+}
+
+
+} // namespace inl
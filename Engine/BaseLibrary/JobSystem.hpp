@@ -0,0 +1,164 @@
+#pragma once
+
+#include "WorkStealingDeque.hpp"
+#include "SpinMutex.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace inl {
+
+
+class JobSystem;
+
+namespace impl {
+struct Job;
+} // namespace impl
+
+
+/// <summary>
+/// Counts unfinished jobs. Jobs started with a counter increment it when they are spawned
+/// and decrement it when they finish. Jobs can be made to wait for a counter to reach zero,
+/// and threads can wait for it with <see cref="JobSystem::Wait"/>.
+/// </summary>
+/// <remarks> The counter must outlive all jobs that refer to it. </remarks>
+class JobCounter {
+	friend class JobSystem;
+public:
+	JobCounter() : m_value(0) {}
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	/// <summary> True if all jobs associated with the counter are finished. </summary>
+	bool IsZero() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+	int Value() const { return m_value.load(std::memory_order_acquire); }
+private:
+	std::atomic<int> m_value;
+	spin_mutex m_waitersMutex;
+	std::vector<impl::Job*> m_waiters; // jobs to start when the counter reaches zero
+};
+
+
+/// <summary>
+/// A fixed pool of worker threads that run small tasks.
+/// Each worker has its own deque of jobs, idle workers steal from the others.
+/// Jobs spawned from outside the pool go to a shared queue.
+/// Waiting for a counter runs pending jobs on the waiting thread instead of blocking it.
+/// </summary>
+/// <remarks>
+/// Jobs must not throw. All counters must be waited for before destroying the job system,
+/// jobs that did not start by then are discarded.
+/// </remarks>
+class JobSystem {
+public:
+	using JobFunction = std::function<void()>;
+
+	/// <param name="numWorkers"> Number of worker threads. Zero means one less than the number of hardware threads,
+	///		since the thread that owns the job system usually helps out by waiting. </param>
+	/// <param name="pinWorkers"> Bind each worker to a single core. </param>
+	explicit JobSystem(unsigned numWorkers = 0, bool pinWorkers = false);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem();
+
+	/// <summary> Starts a job. </summary>
+	/// <param name="counter"> Optional, incremented now and decremented when the job finishes. </param>
+	void Run(JobFunction function, JobCounter* counter = nullptr);
+
+	/// <summary> Starts a job once all jobs of <paramref name="dependency"/> have finished. </summary>
+	/// <param name="counter"> Optional, incremented now and decremented when the job finishes. </param>
+	void Run(JobFunction function, JobCounter* counter, JobCounter& dependency);
+
+	/// <summary> Returns when the counter reaches zero. Runs other jobs in the meantime. </summary>
+	void Wait(JobCounter& counter);
+
+	/// <summary>
+	/// Calls <paramref name="function"/>(first, last) for consecutive sub-ranges of [begin, end)
+	/// on all workers and returns when all of them are done.
+	/// </summary>
+	/// <param name="grainSize"> Ranges are not split below this size. </param>
+	template <class Func>
+	void ParallelFor(size_t begin, size_t end, size_t grainSize, Func function);
+
+	/// <summary> Number of worker threads, not counting threads that only wait. </summary>
+	unsigned GetWorkerCount() const { return unsigned(m_workers.size()); }
+
+	/// <summary> Index of the worker the calling thread is, or -1 if it's not a worker of this job system. </summary>
+	int GetCurrentWorkerIndex() const;
+private:
+	struct Worker;
+
+	void WorkerThread(unsigned index);
+
+	void Schedule(impl::Job* job);
+	impl::Job* FindJob();
+	void Execute(impl::Job* job);
+	void Finish(JobCounter& counter);
+	void Wake();
+
+	template <class Func>
+	void SplitRange(size_t begin, size_t end, size_t grainSize, const Func& function, JobCounter& counter);
+private:
+	std::vector<std::unique_ptr<Worker>> m_workers;
+
+	std::mutex m_globalQueueMutex;
+	std::deque<impl::Job*> m_globalQueue;
+	std::atomic<size_t> m_globalQueueSize;
+
+	// Idle workers sleep on the condition variable. Spawning bumps the epoch,
+	// a worker only goes to sleep if the epoch did not change since it last looked for work.
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCv;
+	std::atomic<uint64_t> m_epoch;
+	std::atomic<unsigned> m_numSleeping;
+	std::atomic_bool m_stop;
+};
+
+
+namespace impl {
+
+struct Job {
+	JobSystem::JobFunction function;
+	JobCounter* counter;
+};
+
+} // namespace impl
+
+
+template <class Func>
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grainSize, Func function) {
+	if (begin >= end) {
+		return;
+	}
+	grainSize = grainSize > 0 ? grainSize : 1;
+	JobCounter counter;
+	SplitRange(begin, end, grainSize, function, counter);
+	Wait(counter);
+}
+
+
+template <class Func>
+void JobSystem::SplitRange(size_t begin, size_t end, size_t grainSize, const Func& function, JobCounter& counter) {
+	// Halves go to the deque for others to steal, the remaining part is processed right away.
+	// Splitting recursively lets thieves grab large chunks and split them further on their own.
+	while (end - begin > grainSize) {
+		size_t middle = begin + (end - begin) / 2;
+		Run([this, middle, end, grainSize, &function, &counter] {
+			SplitRange(middle, end, grainSize, function, counter);
+		}, &counter);
+		end = middle;
+	}
+	function(begin, end);
+}
+
+
+} // namespace inl
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Event.hpp"
+#include "../Memory/AllocationTracker.hpp"
 
 #include <chrono>
 #include <deque>
@@ -16,7 +17,7 @@ struct EventEntry {
 
 
 /// <summary> Used by LogPipe and LogNode to buffer incoming events. </summary>
-using EventBuffer = std::deque<EventEntry>;
+using EventBuffer = std::deque<EventEntry, TrackedAllocator<EventEntry, eAllocationTag::LOGGING>>;
 
 
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "AllocationTracker.hpp"
+#include "../StackTrace.hpp"
+#include "../Logging/LogStream.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+
+namespace inl {
+
+
+//------------------------------------------------------------------------------
+// Thread counters
+//------------------------------------------------------------------------------
+
+struct AllocationTracker::ThreadCounters {
+	ThreadCounters() {
+		for (size_t tag = 0; tag < NumTags; ++tag) {
+			pendingBytes[tag].store(0, std::memory_order_relaxed);
+			allocationCount[tag].store(0, std::memory_order_relaxed);
+			totalAllocations[tag].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// Only the owner thread writes these, others read them for snapshots.
+	std::atomic<int64_t> pendingBytes[NumTags]; // not yet flushed to the shared counters
+	std::atomic<int64_t> allocationCount[NumTags];
+	std::atomic<uint64_t> totalAllocations[NumTags];
+	unsigned samplingCounter = 0;
+};
+
+
+// Registers the thread's counters on first use and hands them over to the shared counters at thread exit.
+struct AllocationTracker::ThreadCountersOwner {
+	ThreadCountersOwner(AllocationTracker& tracker) : tracker(tracker) {
+		tracker.RegisterThread(&counters);
+	}
+	~ThreadCountersOwner() {
+		tracker.UnregisterThread(&counters);
+	}
+	AllocationTracker& tracker;
+	ThreadCounters counters;
+};
+
+
+namespace {
+
+enum class eThreadState { UNINITIALIZED, ACTIVE, EXITED };
+
+// Plain thread locals, so they can still be read after the owner object was destroyed at thread exit.
+thread_local eThreadState t_threadState = eThreadState::UNINITIALIZED;
+
+void AtomicMax(std::atomic<int64_t>& target, int64_t value) {
+	int64_t current = target.load(std::memory_order_relaxed);
+	while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+
+
+//------------------------------------------------------------------------------
+// Snapshot
+//------------------------------------------------------------------------------
+
+int64_t AllocationSnapshot::GetTotalBytes() const {
+	int64_t total = 0;
+	for (auto& tag : tags) {
+		total += tag.bytes;
+	}
+	return total;
+}
+
+
+
+//------------------------------------------------------------------------------
+// Tracker
+//------------------------------------------------------------------------------
+
+AllocationTracker& AllocationTracker::GetInstance() {
+	static AllocationTracker* instance = new AllocationTracker();
+	return *instance;
+}
+
+
+AllocationTracker::AllocationTracker() : m_samplingInterval(0) {
+	for (size_t tag = 0; tag < NumTags; ++tag) {
+		m_bytes[tag].store(0, std::memory_order_relaxed);
+		m_peakBytes[tag].store(0, std::memory_order_relaxed);
+		m_retiredAllocationCount[tag].store(0, std::memory_order_relaxed);
+		m_retiredTotalAllocations[tag].store(0, std::memory_order_relaxed);
+	}
+}
+
+
+void AllocationTracker::RecordAllocation(eAllocationTag tag, size_t bytes) {
+	size_t tagIndex = size_t(tag);
+	ThreadCounters* counters = GetThreadCounters();
+	if (counters) {
+		auto& count = counters->allocationCount[tagIndex];
+		auto& total = counters->totalAllocations[tagIndex];
+		auto& pending = counters->pendingBytes[tagIndex];
+		count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		int64_t pendingBytes = pending.load(std::memory_order_relaxed) + int64_t(bytes);
+		if (pendingBytes >= FlushThreshold) {
+			pending.store(0, std::memory_order_relaxed);
+			FlushBytes(tagIndex, pendingBytes);
+		}
+		else {
+			pending.store(pendingBytes, std::memory_order_relaxed);
+		}
+
+		unsigned interval = m_samplingInterval.load(std::memory_order_relaxed);
+		if (interval > 0 && ++counters->samplingCounter >= interval) {
+			counters->samplingCounter = 0;
+			SampleStack(tag, bytes);
+		}
+	}
+	else {
+		// thread is shutting down, go straight to the shared counters
+		m_retiredAllocationCount[tagIndex].fetch_add(1, std::memory_order_relaxed);
+		m_retiredTotalAllocations[tagIndex].fetch_add(1, std::memory_order_relaxed);
+		FlushBytes(tagIndex, int64_t(bytes));
+	}
+}
+
+
+void AllocationTracker::RecordDeallocation(eAllocationTag tag, size_t bytes) {
+	size_t tagIndex = size_t(tag);
+	ThreadCounters* counters = GetThreadCounters();
+	if (counters) {
+		// Memory is often freed on another thread than it was allocated on,
+		// so per-thread counts can go negative, only the sum is meaningful.
+		auto& count = counters->allocationCount[tagIndex];
+		auto& pending = counters->pendingBytes[tagIndex];
+		count.store(count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+
+		int64_t pendingBytes = pending.load(std::memory_order_relaxed) - int64_t(bytes);
+		if (pendingBytes <= -FlushThreshold) {
+			pending.store(0, std::memory_order_relaxed);
+			FlushBytes(tagIndex, pendingBytes);
+		}
+		else {
+			pending.store(pendingBytes, std::memory_order_relaxed);
+		}
+	}
+	else {
+		m_retiredAllocationCount[tagIndex].fetch_sub(1, std::memory_order_relaxed);
+		FlushBytes(tagIndex, -int64_t(bytes));
+	}
+}
+
+
+AllocationSnapshot AllocationTracker::GetSnapshot() const {
+	AllocationSnapshot snapshot;
+	for (size_t tag = 0; tag < NumTags; ++tag) {
+		auto& statistics = snapshot.tags[tag];
+		statistics.bytes = m_bytes[tag].load(std::memory_order_relaxed);
+		statistics.allocationCount = m_retiredAllocationCount[tag].load(std::memory_order_relaxed);
+		statistics.totalAllocations = m_retiredTotalAllocations[tag].load(std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> lkg(m_threadsMutex);
+		for (const ThreadCounters* counters : m_threads) {
+			for (size_t tag = 0; tag < NumTags; ++tag) {
+				auto& statistics = snapshot.tags[tag];
+				statistics.bytes += counters->pendingBytes[tag].load(std::memory_order_relaxed);
+				statistics.allocationCount += counters->allocationCount[tag].load(std::memory_order_relaxed);
+				statistics.totalAllocations += counters->totalAllocations[tag].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	for (size_t tag = 0; tag < NumTags; ++tag) {
+		auto& statistics = snapshot.tags[tag];
+		statistics.peakBytes = std::max(m_peakBytes[tag].load(std::memory_order_relaxed), statistics.bytes);
+	}
+	return snapshot;
+}
+
+
+void AllocationTracker::LogSnapshot(LogStream& log) const {
+	AllocationSnapshot snapshot = GetSnapshot();
+
+	LogEvent event("Memory usage by subsystem", eEventType::INFO);
+	for (size_t tag = 0; tag < NumTags; ++tag) {
+		auto& statistics = snapshot.tags[tag];
+		std::stringstream ss;
+		ss << statistics.bytes << " bytes, peak " << statistics.peakBytes
+			<< ", " << statistics.allocationCount << " allocations alive, " << statistics.totalAllocations << " total";
+		event.PutParameter(EventParameterString(GetTagName(eAllocationTag(tag)), ss.str()));
+	}
+	log.Event(std::move(event));
+}
+
+
+void AllocationTracker::SetStackSamplingInterval(unsigned interval) {
+	m_samplingInterval.store(interval, std::memory_order_relaxed);
+}
+
+
+std::vector<AllocationStackSample> AllocationTracker::GetStackSamples() const {
+	std::lock_guard<std::mutex> lkg(m_samplesMutex);
+	return { m_samples.begin(), m_samples.end() };
+}
+
+
+void AllocationTracker::ClearStackSamples() {
+	std::lock_guard<std::mutex> lkg(m_samplesMutex);
+	m_samples.clear();
+}
+
+
+const char* AllocationTracker::GetTagName(eAllocationTag tag) {
+	switch (tag) {
+		case eAllocationTag::GENERAL: return "general";
+		case eAllocationTag::GRAPHICS: return "graphics";
+		case eAllocationTag::UPLOAD: return "upload";
+		case eAllocationTag::LOGGING: return "logging";
+		case eAllocationTag::NET: return "net";
+		case eAllocationTag::PHYSICS: return "physics";
+		case eAllocationTag::ASSET: return "asset";
+		default: return "unknown";
+	}
+}
+
+
+auto AllocationTracker::GetThreadCounters() -> ThreadCounters* {
+	switch (t_threadState) {
+		case eThreadState::ACTIVE: {
+			thread_local ThreadCountersOwner owner(*this);
+			return &owner.counters;
+		}
+		case eThreadState::UNINITIALIZED: {
+			t_threadState = eThreadState::ACTIVE;
+			return GetThreadCounters();
+		}
+		default:
+			return nullptr;
+	}
+}
+
+
+void AllocationTracker::RegisterThread(ThreadCounters* counters) {
+	std::lock_guard<std::mutex> lkg(m_threadsMutex);
+	m_threads.push_back(counters);
+}
+
+
+void AllocationTracker::UnregisterThread(ThreadCounters* counters) {
+	std::lock_guard<std::mutex> lkg(m_threadsMutex);
+	for (size_t tag = 0; tag < NumTags; ++tag) {
+		FlushBytes(tag, counters->pendingBytes[tag].load(std::memory_order_relaxed));
+		m_retiredAllocationCount[tag].fetch_add(counters->allocationCount[tag].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_retiredTotalAllocations[tag].fetch_add(counters->totalAllocations[tag].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+	m_threads.erase(std::find(m_threads.begin(), m_threads.end(), counters));
+	t_threadState = eThreadState::EXITED;
+}
+
+
+void AllocationTracker::FlushBytes(size_t tag, int64_t bytes) {
+	int64_t current = m_bytes[tag].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	AtomicMax(m_peakBytes[tag], current);
+}
+
+
+void AllocationTracker::SampleStack(eAllocationTag tag, size_t bytes) {
+	auto frames = GetStackTrace();
+
+	AllocationStackSample sample;
+	sample.tag = tag;
+	sample.bytes = bytes;
+	std::stringstream ss;
+	// the first two frames are this function and RecordAllocation
+	for (size_t i = std::min<size_t>(2, frames.size() - 1); i < frames.size(); ++i) {
+		ss << frames[i] << "\n";
+	}
+	sample.stackTrace = ss.str();
+
+	std::lock_guard<std::mutex> lkg(m_samplesMutex);
+	if (m_samples.size() == MaxStackSamples) {
+		m_samples.pop_front();
+	}
+	m_samples.push_back(std::move(sample));
+}
+
+
+} // namespace inl
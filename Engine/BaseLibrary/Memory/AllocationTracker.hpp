@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace inl {
+
+
+class LogStream;
+
+
+/// <summary> Subsystems that memory usage is accounted to. </summary>
+enum class eAllocationTag : uint8_t {
+	GENERAL,
+	GRAPHICS,
+	UPLOAD,
+	LOGGING,
+	NET,
+	PHYSICS,
+	ASSET,
+	COUNT,
+};
+
+
+struct AllocationTagStatistics {
+	int64_t bytes = 0; /// <summary> Bytes currently allocated. </summary>
+	int64_t peakBytes = 0; /// <summary> Highest value of bytes so far. </summary>
+	int64_t allocationCount = 0; /// <summary> Number of allocations currently alive. </summary>
+	uint64_t totalAllocations = 0; /// <summary> Number of allocations ever made. </summary>
+};
+
+
+struct AllocationSnapshot {
+	std::array<AllocationTagStatistics, size_t(eAllocationTag::COUNT)> tags;
+
+	const AllocationTagStatistics& operator[](eAllocationTag tag) const { return tags[size_t(tag)]; }
+	int64_t GetTotalBytes() const;
+};
+
+
+struct AllocationStackSample {
+	eAllocationTag tag;
+	size_t bytes;
+	std::string stackTrace; /// <summary> One frame per line. </summary>
+};
+
+
+/// <summary>
+/// Accounts memory used by engine subsystems. Subsystems report their allocations with a tag,
+/// either by calling <see cref="RecordAllocation"/> and <see cref="RecordDeallocation"/> directly,
+/// or by using <see cref="TrackedAllocator"/> for their containers.
+/// Recording only touches counters of the calling thread, they are merged when a snapshot is taken.
+/// Thread safe.
+/// </summary>
+/// <remarks>
+/// Byte counts are forwarded to shared counters in chunks, so the peak is only accurate
+/// to about <see cref="FlushThreshold"/> bytes per thread.
+/// Snapshots taken while other threads are allocating may be slightly off.
+/// </remarks>
+class AllocationTracker {
+	struct ThreadCounters;
+	struct ThreadCountersOwner;
+	static constexpr size_t NumTags = size_t(eAllocationTag::COUNT);
+public:
+	static constexpr int64_t FlushThreshold = 64 * 1024;
+	static constexpr size_t MaxStackSamples = 256;
+public:
+	/// <summary> The tracker is never destroyed, so that static objects can report memory in their destructors. </summary>
+	static AllocationTracker& GetInstance();
+
+	AllocationTracker(const AllocationTracker&) = delete;
+	AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+	void RecordAllocation(eAllocationTag tag, size_t bytes);
+	void RecordDeallocation(eAllocationTag tag, size_t bytes);
+
+	/// <summary> Sums up the counters of all threads. </summary>
+	AllocationSnapshot GetSnapshot() const;
+
+	/// <summary> Writes the current snapshot as one event into the log. </summary>
+	void LogSnapshot(LogStream& log) const;
+
+	/// <summary> Capture the call stack of every <paramref name="interval"/>th allocation on each thread.
+	///		Zero turns sampling off, which is the default. Capturing is slow, use large intervals. </summary>
+	void SetStackSamplingInterval(unsigned interval);
+
+	/// <summary> The most recent stack samples, at most <see cref="MaxStackSamples"/>. </summary>
+	std::vector<AllocationStackSample> GetStackSamples() const;
+
+	void ClearStackSamples();
+
+	static const char* GetTagName(eAllocationTag tag);
+private:
+	AllocationTracker();
+
+	ThreadCounters* GetThreadCounters();
+	void RegisterThread(ThreadCounters* counters);
+	void UnregisterThread(ThreadCounters* counters);
+	void FlushBytes(size_t tag, int64_t bytes);
+	void SampleStack(eAllocationTag tag, size_t bytes);
+private:
+	// Counters of threads that have exited and bytes flushed from threads.
+	std::atomic<int64_t> m_bytes[NumTags];
+	std::atomic<int64_t> m_peakBytes[NumTags];
+	std::atomic<int64_t> m_retiredAllocationCount[NumTags];
+	std::atomic<uint64_t> m_retiredTotalAllocations[NumTags];
+
+	mutable std::mutex m_threadsMutex;
+	std::vector<ThreadCounters*> m_threads;
+
+	std::atomic<unsigned> m_samplingInterval;
+	mutable std::mutex m_samplesMutex;
+	std::deque<AllocationStackSample> m_samples;
+};
+
+
+
+/// <summary> STL allocator that reports to the <see cref="AllocationTracker"/> under the given tag. </summary>
+template <class T, eAllocationTag Tag>
+class TrackedAllocator {
+public:
+	using value_type = T;
+	template <class U>
+	struct rebind { using other = TrackedAllocator<U, Tag>; };
+
+	TrackedAllocator() = default;
+	template <class U>
+	TrackedAllocator(const TrackedAllocator<U, Tag>&) {}
+
+	T* allocate(size_t n) {
+		T* ptr = std::allocator<T>().allocate(n);
+		AllocationTracker::GetInstance().RecordAllocation(Tag, n * sizeof(T));
+		return ptr;
+	}
+
+	void deallocate(T* ptr, size_t n) {
+		AllocationTracker::GetInstance().RecordDeallocation(Tag, n * sizeof(T));
+		std::allocator<T>().deallocate(ptr, n);
+	}
+};
+
+template <class T, class U, eAllocationTag Tag>
+bool operator==(const TrackedAllocator<T, Tag>&, const TrackedAllocator<U, Tag>&) {
+	return true;
+}
+
+template <class T, class U, eAllocationTag Tag>
+bool operator!=(const TrackedAllocator<T, Tag>&, const TrackedAllocator<U, Tag>&) {
+	return false;
+}
+
+
+} // namespace inl
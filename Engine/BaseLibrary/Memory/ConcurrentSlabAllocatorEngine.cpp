@@ -0,0 +1,221 @@
+#include "ConcurrentSlabAllocatorEngine.hpp"
+#include "../BitOperations.hpp"
+
+#include <cassert>
+#include <new>
+
+
+namespace inl {
+
+
+ConcurrentSlabAllocatorEngine::ConcurrentSlabAllocatorEngine() : m_freeHead(InvalidBlock), m_poolSize(0) {
+
+}
+
+
+ConcurrentSlabAllocatorEngine::ConcurrentSlabAllocatorEngine(size_t poolSize)
+	: m_freeHead(InvalidBlock), m_poolSize(0)
+{
+	Resize(poolSize);
+}
+
+
+size_t ConcurrentSlabAllocatorEngine::Allocate() {
+	while (true) {
+		uint64_t head = m_freeHead.load(std::memory_order_acquire);
+		uint32_t blockIndex = uint32_t(head);
+		if (blockIndex == InvalidBlock) {
+			throw std::bad_alloc();
+		}
+
+		// try to grab a slot from the top block
+		Block& block = BlockAt(blockIndex);
+		uint64_t occupancy = block.slotOccupancy.load(std::memory_order_relaxed);
+		while (occupancy != FullMask) {
+			int index = CountTrailingZeros(~occupancy);
+			assert(index >= 0);
+			uint64_t desired = occupancy | (uint64_t(1) << index);
+			if (block.slotOccupancy.compare_exchange_weak(occupancy, desired, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				if (desired == FullMask) {
+					TryPopFull(head);
+				}
+				return size_t(blockIndex) * SlotsPerBlock + index;
+			}
+		}
+
+		// the block got full meanwhile, remove it and retry with the next one
+		TryPopFull(head);
+	}
+}
+
+
+void ConcurrentSlabAllocatorEngine::Deallocate(size_t index) {
+	assert(index < Size());
+
+	uint32_t blockIndex = uint32_t(index / SlotsPerBlock);
+	uint64_t mask = uint64_t(1) << (index - size_t(blockIndex) * SlotsPerBlock);
+
+	uint64_t prevMask = BlockAt(blockIndex).slotOccupancy.fetch_and(~mask, std::memory_order_seq_cst);
+	assert((prevMask & mask) != 0);
+	if (prevMask == FullMask) {
+		PushFree(blockIndex);
+	}
+}
+
+
+void ConcurrentSlabAllocatorEngine::Resize(size_t newPoolSize) {
+	std::lock_guard<std::mutex> lkg(m_resizeMutex);
+
+	size_t oldPoolSize = m_poolSize.load(std::memory_order_relaxed);
+	size_t oldBlockCount = BlockCountOf(oldPoolSize);
+	size_t newBlockCount = BlockCountOf(newPoolSize);
+	unsigned oldNumLastSlots = unsigned(oldPoolSize % SlotsPerBlock);
+	unsigned newNumLastSlots = unsigned(newPoolSize % SlotsPerBlock);
+
+	if (newPoolSize > oldPoolSize) {
+		if (newBlockCount > uint64_t(InvalidBlock)) {
+			throw std::bad_alloc();
+		}
+
+		// allocate missing chunks, existing ones are not touched
+		size_t coveredBlocks = 0;
+		for (size_t chunk = 0; coveredBlocks < newBlockCount; ++chunk) {
+			if (chunk >= MaxChunks) {
+				throw std::bad_alloc();
+			}
+			size_t chunkSize = FirstChunkBlocks << chunk;
+			if (!m_chunks[chunk]) {
+				m_chunks[chunk].reset(new Block[chunkSize]);
+			}
+			coveredBlocks += chunkSize;
+		}
+
+		// clear new blocks
+		for (size_t i = oldBlockCount; i < newBlockCount; ++i) {
+			Block& block = BlockAt(i);
+			block.slotOccupancy.store(0, std::memory_order_relaxed);
+			block.nextBlockIndex.store(InvalidBlock, std::memory_order_relaxed);
+			block.isInFreeStack.store(false, std::memory_order_relaxed);
+		}
+
+		// lock last slots of the NEW last block
+		if (newBlockCount > oldBlockCount && newNumLastSlots > 0) {
+			BlockAt(newBlockCount - 1).slotOccupancy.store(FullMask << newNumLastSlots, std::memory_order_relaxed);
+		}
+
+		// publish the size first, slots of the new blocks may be freed as soon as they are pushed
+		m_poolSize.store(newPoolSize, std::memory_order_release);
+
+		// unlock slots of the OLD last block, it might be in use by other threads
+		if (oldNumLastSlots > 0) {
+			uint64_t unlockMask = FullMask << oldNumLastSlots;
+			if (newBlockCount == oldBlockCount && newNumLastSlots > 0) {
+				unlockMask &= ~(FullMask << newNumLastSlots);
+			}
+			uint64_t prevMask = BlockAt(oldBlockCount - 1).slotOccupancy.fetch_and(~unlockMask, std::memory_order_seq_cst);
+			if (prevMask == FullMask) {
+				PushFree(uint32_t(oldBlockCount - 1));
+			}
+		}
+
+		// publish new blocks, lowest index ends up on top
+		for (size_t i = newBlockCount; i-- > oldBlockCount;) {
+			PushFree(uint32_t(i));
+		}
+	}
+	else if (newPoolSize < oldPoolSize) {
+		// lock last slots of the NEW last block
+		if (newNumLastSlots > 0) {
+			BlockAt(newBlockCount - 1).slotOccupancy.fetch_or(FullMask << newNumLastSlots, std::memory_order_relaxed);
+		}
+
+		// release chunks that are entirely cut off
+		for (size_t chunk = 0; chunk < MaxChunks; ++chunk) {
+			size_t firstBlock = FirstChunkBlocks * ((size_t(1) << chunk) - 1);
+			if (firstBlock >= newBlockCount) {
+				m_chunks[chunk].reset();
+			}
+		}
+
+		m_poolSize.store(newPoolSize, std::memory_order_release);
+		RebuildFreeStack(newBlockCount);
+	}
+}
+
+
+void ConcurrentSlabAllocatorEngine::Reset() {
+	size_t poolSize = m_poolSize.load(std::memory_order_relaxed);
+	size_t blockCount = BlockCountOf(poolSize);
+
+	for (size_t i = 0; i < blockCount; ++i) {
+		BlockAt(i).slotOccupancy.store(0, std::memory_order_relaxed);
+	}
+
+	// mask out unused part of last block
+	unsigned numLastSlots = unsigned(poolSize % SlotsPerBlock);
+	if (numLastSlots != 0) {
+		BlockAt(blockCount - 1).slotOccupancy.store(FullMask << numLastSlots, std::memory_order_relaxed);
+	}
+
+	RebuildFreeStack(blockCount);
+}
+
+
+auto ConcurrentSlabAllocatorEngine::BlockAt(size_t blockIndex) const -> Block& {
+	// chunk k holds FirstChunkBlocks * 2^k blocks, starting at FirstChunkBlocks * (2^k - 1)
+	uint64_t q = blockIndex / FirstChunkBlocks + 1;
+	int chunk = 63 - CountLeadingZeros(q);
+	size_t offset = blockIndex - FirstChunkBlocks * ((size_t(1) << chunk) - 1);
+	return m_chunks[chunk][offset];
+}
+
+
+void ConcurrentSlabAllocatorEngine::PushFree(uint32_t blockIndex) {
+	Block& block = BlockAt(blockIndex);
+	if (block.isInFreeStack.exchange(true, std::memory_order_seq_cst)) {
+		return;
+	}
+
+	uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+	uint64_t newHead;
+	do {
+		block.nextBlockIndex.store(uint32_t(head), std::memory_order_relaxed);
+		newHead = (((head >> 32) + 1) << 32) | blockIndex;
+	} while (!m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+void ConcurrentSlabAllocatorEngine::TryPopFull(uint64_t head) {
+	uint32_t blockIndex = uint32_t(head);
+	Block& block = BlockAt(blockIndex);
+
+	// the counter in the upper bits makes the CAS fail if the block was popped and pushed again
+	uint64_t newHead = (((head >> 32) + 1) << 32) | block.nextBlockIndex.load(std::memory_order_relaxed);
+	if (m_freeHead.compare_exchange_strong(head, newHead, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+		block.isInFreeStack.store(false, std::memory_order_seq_cst);
+		// a slot might have been freed before the flag was cleared, in which case the deallocation did not push
+		if (block.slotOccupancy.load(std::memory_order_seq_cst) != FullMask) {
+			PushFree(blockIndex);
+		}
+	}
+}
+
+
+void ConcurrentSlabAllocatorEngine::RebuildFreeStack(size_t blockCount) {
+	uint32_t first = InvalidBlock;
+	for (size_t i = blockCount; i-- > 0;) {
+		Block& block = BlockAt(i);
+		bool hasFree = block.slotOccupancy.load(std::memory_order_relaxed) != FullMask;
+		block.isInFreeStack.store(hasFree, std::memory_order_relaxed);
+		if (hasFree) {
+			block.nextBlockIndex.store(first, std::memory_order_relaxed);
+			first = uint32_t(i);
+		}
+	}
+
+	uint64_t counter = (m_freeHead.load(std::memory_order_relaxed) >> 32) + 1;
+	m_freeHead.store((counter << 32) | first, std::memory_order_release);
+}
+
+
+} // namespace inl
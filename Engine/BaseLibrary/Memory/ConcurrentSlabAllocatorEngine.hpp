@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Thread safe variant of <see cref="SlabAllocatorEngine"/> with the same interface.
+/// Allocate and Deallocate are lock-free and can be called from any number of threads.
+/// Growing the pool can be done concurrently with allocations, existing blocks are never moved.
+/// Shrinking the pool and Reset must not run concurrently with any other call.
+/// This class does NOT handle space allocation for the object, only slot allocation.
+/// </summary>
+class ConcurrentSlabAllocatorEngine {
+	// How it works:
+	// Slots are grouped into blocks of 64 slots, each block has an atomic occupancy mask
+	// which is updated by CAS.
+	// Blocks that may contain free slots are linked into a lock-free stack. Allocation
+	// tries to take a slot from the top block, and pops the block if it's full.
+	// The head of the stack holds an ABA counter in its upper 32 bits.
+	// Blocks are stored in chunks of geometrically increasing size, so growing
+	// only allocates a new chunk and never relocates blocks that other threads may be using.
+	struct Block {
+		std::atomic<uint64_t> slotOccupancy; /// <summary> 0 means the slot if free, 1 is occupied. </summary>
+		std::atomic<uint32_t> nextBlockIndex; /// <summary> Index of the next block in the free-stack. </summary>
+		std::atomic<bool> isInFreeStack;
+	};
+	static constexpr unsigned SlotsPerBlock = 64;
+	static constexpr size_t FirstChunkBlocks = 16;
+	static constexpr size_t MaxChunks = 26;
+	static constexpr uint32_t InvalidBlock = ~uint32_t(0);
+	static constexpr uint64_t FullMask = ~uint64_t(0);
+public:
+	/// <summary>
+	/// Initialize an allocator of specified size.
+	/// </summary>
+	/// <param name="poolSize">The number of available slots in the pool.</param>
+	ConcurrentSlabAllocatorEngine();
+	ConcurrentSlabAllocatorEngine(size_t poolSize);
+	ConcurrentSlabAllocatorEngine(const ConcurrentSlabAllocatorEngine&) = delete;
+	ConcurrentSlabAllocatorEngine& operator=(const ConcurrentSlabAllocatorEngine&) = delete;
+
+	/// <summary> Allocates space from the pool for one item. Thread safe, lock-free. </summary>
+	/// <returns> The index of the allocated slot. </returns>
+	/// <exception cref="std::bad_alloc"> Thrown if pool is full. </exception>
+	size_t Allocate();
+
+	/// <summary> Deallocated the slot specified by the index. Thread safe, lock-free. </summary>
+	void Deallocate(size_t index);
+
+	/// <summary> Resizes the pool, allocated slots won't be cleared, but may become invalid if pool is shrunk. </summary>
+	/// <remarks> Growing is thread safe, shrinking must not be concurrent with any other call. </remarks>
+	/// <param name="newPoolSize"> The number of available slots in the new pool. </param>
+	void Resize(size_t newPoolSize);
+
+	/// <summary> Clears all slots, does not affect pool size. Not thread safe. </summary>
+	void Reset();
+
+
+	/// <summary> Get the total number of slots (free + taken). </summary>
+	size_t Size() const { return m_poolSize.load(std::memory_order_acquire); }
+private:
+	Block& BlockAt(size_t blockIndex) const;
+	static size_t BlockCountOf(size_t poolSize) { return (poolSize + SlotsPerBlock - 1) / SlotsPerBlock; }
+
+	void PushFree(uint32_t blockIndex);
+	void TryPopFull(uint64_t head);
+	void RebuildFreeStack(size_t blockCount);
+private:
+	alignas(64) std::atomic<uint64_t> m_freeHead; // low 32 bits: block index, high 32 bits: ABA counter
+	alignas(64) std::atomic<size_t> m_poolSize;
+	std::unique_ptr<Block[]> m_chunks[MaxChunks];
+	std::mutex m_resizeMutex;
+};
+
+
+} // namespace inl
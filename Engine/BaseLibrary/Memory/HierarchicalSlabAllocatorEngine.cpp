@@ -0,0 +1,175 @@
+#include "HierarchicalSlabAllocatorEngine.hpp"
+#include "../BitOperations.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <new>
+
+
+namespace inl {
+
+
+HierarchicalSlabAllocatorEngine::HierarchicalSlabAllocatorEngine() : m_poolSize(0), m_hintWord(0), m_levels(1) {
+
+}
+
+
+HierarchicalSlabAllocatorEngine::HierarchicalSlabAllocatorEngine(size_t poolSize)
+	: m_poolSize(0), m_hintWord(0), m_levels(1)
+{
+	Resize(poolSize);
+}
+
+
+size_t HierarchicalSlabAllocatorEngine::Allocate() {
+	std::vector<Word>& occupancy = m_levels[0];
+
+	// fast path: the last touched word still has free slots
+	if (m_hintWord < occupancy.size() && occupancy[m_hintWord] != 0) {
+		Word& word = occupancy[m_hintWord];
+		size_t index = (m_hintWord << WordShift) + CountTrailingZeros(word);
+		word &= word - 1; // clear lowest set bit
+		if (word == 0) {
+			PropagateFull(m_hintWord);
+		}
+		assert(index < m_poolSize);
+		return index;
+	}
+
+	const std::vector<Word>& top = m_levels.back();
+	if (top.empty() || top[0] == 0) {
+		throw std::bad_alloc();
+	}
+
+	// descend along the first non-empty word of each level
+	size_t index = 0;
+	for (size_t level = m_levels.size(); level-- > 0;) {
+		int bit = CountTrailingZeros(m_levels[level][index]);
+		assert(bit >= 0);
+		index = (index << WordShift) + bit;
+	}
+	assert(index < m_poolSize);
+
+	// mark slot as taken
+	m_hintWord = index >> WordShift;
+	Word& word = occupancy[m_hintWord];
+	word &= ~(Word(1) << (index & (SlotsPerWord - 1)));
+	if (word == 0) {
+		PropagateFull(m_hintWord);
+	}
+
+	return index;
+}
+
+
+void HierarchicalSlabAllocatorEngine::Deallocate(size_t index) {
+	assert(index < m_poolSize);
+
+	size_t current = index;
+	for (size_t level = 0; level < m_levels.size(); ++level) {
+		Word& word = m_levels[level][current >> WordShift];
+		bool wasFull = word == 0;
+		bool wasFree = BitTestAndSet(word, unsigned(current & (SlotsPerWord - 1)));
+		assert(level > 0 || !wasFree);
+		if (!wasFull) {
+			break;
+		}
+		current >>= WordShift;
+	}
+
+	// freshly freed slots are likely still in cache
+	m_hintWord = index >> WordShift;
+}
+
+
+void HierarchicalSlabAllocatorEngine::Resize(size_t newPoolSize) {
+	size_t oldPoolSize = m_poolSize;
+	size_t newWordCount = (newPoolSize + SlotsPerWord - 1) >> WordShift;
+	std::vector<Word>& occupancy = m_levels[0];
+
+	if (newPoolSize > oldPoolSize) {
+		occupancy.resize(newWordCount, 0);
+		FillFree(oldPoolSize, newPoolSize);
+	}
+	else {
+		occupancy.resize(newWordCount);
+		// lock slots past the end of the NEW last word
+		unsigned numLastSlots = unsigned(newPoolSize & (SlotsPerWord - 1));
+		if (numLastSlots > 0) {
+			occupancy.back() &= ~Word(0) >> (SlotsPerWord - numLastSlots);
+		}
+	}
+	m_poolSize = newPoolSize;
+
+	UpdateSummaries(std::min(oldPoolSize, newPoolSize) >> WordShift);
+}
+
+
+void HierarchicalSlabAllocatorEngine::Reset() {
+	std::fill(m_levels[0].begin(), m_levels[0].end(), Word(0));
+	FillFree(0, m_poolSize);
+	UpdateSummaries(0);
+}
+
+
+void HierarchicalSlabAllocatorEngine::PropagateFull(size_t fullWord) {
+	// clear the summary bits upwards as long as words become full
+	size_t current = fullWord;
+	for (size_t level = 1; level < m_levels.size(); ++level) {
+		Word& word = m_levels[level][current >> WordShift];
+		bool wasFree = BitTestAndClear(word, unsigned(current & (SlotsPerWord - 1)));
+		assert(wasFree);
+		if (word != 0) {
+			break;
+		}
+		current >>= WordShift;
+	}
+}
+
+
+void HierarchicalSlabAllocatorEngine::FillFree(size_t first, size_t last) {
+	std::vector<Word>& occupancy = m_levels[0];
+	while (first < last) {
+		unsigned bit = unsigned(first & (SlotsPerWord - 1));
+		size_t count = std::min(size_t(SlotsPerWord - bit), last - first);
+		Word bits = count == SlotsPerWord ? ~Word(0) : ((Word(1) << count) - 1);
+		occupancy[first >> WordShift] |= bits << bit;
+		first += count;
+	}
+}
+
+
+void HierarchicalSlabAllocatorEngine::UpdateSummaries(size_t firstDirtyWord) {
+	// recompute summary words that cover dirty child words, level by level
+	size_t level = 1;
+	size_t dirty = firstDirtyWord;
+	while (m_levels[level - 1].size() > 1) {
+		if (m_levels.size() <= level) {
+			m_levels.emplace_back();
+		}
+		const std::vector<Word>& children = m_levels[level - 1];
+		std::vector<Word>& parents = m_levels[level];
+
+		size_t parentCount = (children.size() + SlotsPerWord - 1) >> WordShift;
+		size_t firstParent = dirty >> WordShift;
+		parents.resize(parentCount, 0);
+		for (size_t p = firstParent; p < parentCount; ++p) {
+			size_t begin = p << WordShift;
+			size_t end = std::min(begin + SlotsPerWord, children.size());
+			Word summary = 0;
+			for (size_t c = begin; c < end; ++c) {
+				summary |= Word(children[c] != 0) << (c - begin);
+			}
+			parents[p] = summary;
+		}
+
+		dirty = firstParent;
+		++level;
+	}
+
+	// drop levels that are no longer needed after shrinking
+	m_levels.resize(level);
+}
+
+
+} // namespace inl
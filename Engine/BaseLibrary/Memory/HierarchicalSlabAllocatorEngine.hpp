@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Slot allocator with the same interface as <see cref="SlabAllocatorEngine"/>,
+/// but the free slots are found through a hierarchy of summary bitmaps.
+/// Allocation and deallocation costs a few bit scans per level, and growing the pool
+/// does not touch existing blocks, which makes it suitable for pools of millions of slots
+/// that grow often.
+/// This class does NOT handle space allocation for the object, only slot allocation.
+/// </summary>
+class HierarchicalSlabAllocatorEngine {
+	// How it works:
+	// Level 0 is a bitmap with one bit per slot, 1 means the slot is free.
+	// Each bit of level N+1 tells if the corresponding word of level N has any free slots.
+	// Levels are added until the topmost one consists of a single word, so 4 levels
+	// cover 64^4 = 16M slots.
+	// Allocation descends from the top word to level 0 using CTZ, then clears the bits
+	// upwards as long as words become empty. Deallocation does the same, setting bits.
+	// The level 0 word that was touched last is tried first, so most allocations
+	// don't have to descend at all.
+	using Word = uint64_t;
+	static constexpr unsigned SlotsPerWord = 8 * sizeof(Word);
+	static constexpr unsigned WordShift = 6;
+	static_assert((1u << WordShift) == SlotsPerWord, "Word shift does not match word size.");
+public:
+	/// <summary>
+	/// Initialize an allocator of specified size.
+	/// </summary>
+	/// <param name="poolSize">The number of available slots in the pool.</param>
+	HierarchicalSlabAllocatorEngine();
+	HierarchicalSlabAllocatorEngine(size_t poolSize);
+	HierarchicalSlabAllocatorEngine(const HierarchicalSlabAllocatorEngine& rhs) = default;
+	HierarchicalSlabAllocatorEngine(HierarchicalSlabAllocatorEngine&& rhs) = default;
+
+	HierarchicalSlabAllocatorEngine& operator=(const HierarchicalSlabAllocatorEngine& rhs) = default;
+	HierarchicalSlabAllocatorEngine& operator=(HierarchicalSlabAllocatorEngine&& rhs) = default;
+
+	/// <summary> Allocates space from the pool for one item. </summary>
+	/// <returns> The index of the allocated slot. </returns>
+	/// <exception cref="std::bad_alloc"> Thrown if pool is full. </exception>
+	size_t Allocate();
+
+	/// <summary> Deallocated the slot specified by the index. </summary>
+	void Deallocate(size_t index);
+
+	/// <summary> Resizes the pool, allocated slots won't be cleared, but may become invalid if pool is shrunk. </summary>
+	/// <remarks> Growing only writes the words of the new slots and their summaries. </remarks>
+	/// <param name="newPoolSize"> The number of available slots in the new pool. </param>
+	void Resize(size_t newPoolSize);
+
+	/// <summary> Clears all slots, does not affect pool size. </summary>
+	void Reset();
+
+
+	/// <summary> Get the total number of slots (free + taken). </summary>
+	size_t Size() const { return m_poolSize; }
+
+	/// <summary> Get the number of levels in the bitmap hierarchy, including the occupancy level. </summary>
+	size_t LevelCount() const { return m_levels.size(); }
+private:
+	void PropagateFull(size_t fullWord);
+	void FillFree(size_t first, size_t last);
+	void UpdateSummaries(size_t firstDirtyWord);
+private:
+	size_t m_poolSize;
+	size_t m_hintWord; // level 0 word of the last allocation or deallocation, checked before descending
+	std::vector<std::vector<Word>> m_levels; // [0] is the occupancy bitmap, back() is the single top word
+};
+
+
+} // namespace inl
@@ -0,0 +1,71 @@
+#include "LinearAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace inl {
+
+
+LinearAllocator::LinearAllocator(size_t blockSize)
+	: m_currentBlock(0),
+	m_cursor(0),
+	m_end(0),
+	m_blockSize(std::max(blockSize, size_t(64))),
+	m_capacity(0),
+	m_bytesAllocated(0),
+	m_heapAllocations(0)
+{}
+
+
+void LinearAllocator::Reset() {
+	// merge blocks so the same amount of allocations fits in a single block next time
+	if (m_blocks.size() > 1) {
+		size_t totalSize = m_capacity;
+		m_blocks.clear();
+		m_blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[totalSize]), totalSize });
+	}
+
+	m_currentBlock = 0;
+	m_cursor = m_end = 0;
+	if (!m_blocks.empty()) {
+		OpenBlock(0);
+	}
+	m_bytesAllocated = 0;
+	m_heapAllocations = 0;
+}
+
+
+void* LinearAllocator::AllocateSlow(size_t size, size_t alignment) {
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	// move on to the next block that fits the request, new ones are added as needed
+	size_t next = m_cursor == 0 ? 0 : m_currentBlock + 1;
+	while (true) {
+		if (next == m_blocks.size()) {
+			size_t blockSize = std::max({ m_blockSize, m_capacity, size + alignment });
+			m_blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]), blockSize });
+			m_capacity += blockSize;
+			++m_heapAllocations;
+		}
+		OpenBlock(next);
+
+		uintptr_t address = (m_cursor + alignment - 1) & ~uintptr_t(alignment - 1);
+		if (address + size <= m_end) {
+			m_cursor = address + size;
+			m_bytesAllocated += size;
+			return reinterpret_cast<void*>(address);
+		}
+		++next;
+	}
+}
+
+
+void LinearAllocator::OpenBlock(size_t index) {
+	m_currentBlock = index;
+	m_cursor = reinterpret_cast<uintptr_t>(m_blocks[index].memory.get());
+	m_end = m_cursor + m_blocks[index].size;
+}
+
+
+} // namespace inl
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Bump allocator for short lived scratch memory.
+/// Blocks cannot be freed one by one, everything is released at once by <see cref="Reset"/>.
+/// <para />
+/// Memory is requested from the heap in big blocks. On reset, blocks are merged into a single one
+/// big enough for everything that was allocated since the previous reset, so a steady workload
+/// does not touch the heap at all after the first round.
+/// This class is NOT thread safe.
+/// </summary>
+class LinearAllocator {
+	struct Block {
+		std::unique_ptr<uint8_t[]> memory;
+		size_t size;
+	};
+public:
+	/// <param name="blockSize"> Size of the first block requested from the heap. </param>
+	LinearAllocator(size_t blockSize = 64 * 1024);
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator(LinearAllocator&&) = default;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(LinearAllocator&&) = default;
+
+	/// <summary> Allocates size bytes aligned to alignment, which must be a power of two. </summary>
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		uintptr_t address = (m_cursor + alignment - 1) & ~uintptr_t(alignment - 1);
+		if (address + size <= m_end && m_cursor != 0) {
+			m_cursor = address + size;
+			m_bytesAllocated += size;
+			return reinterpret_cast<void*>(address);
+		}
+		return AllocateSlow(size, alignment);
+	}
+
+	/// <summary> Frees all allocations. </summary>
+	void Reset();
+
+	/// <summary> Bytes handed out since the last reset, excluding alignment padding. </summary>
+	size_t GetBytesAllocated() const { return m_bytesAllocated; }
+
+	/// <summary> How many times the heap was used since the last reset. </summary>
+	size_t GetHeapAllocationCount() const { return m_heapAllocations; }
+
+	/// <summary> Total size of the blocks currently owned. </summary>
+	size_t Capacity() const { return m_capacity; }
+private:
+	void* AllocateSlow(size_t size, size_t alignment);
+	void OpenBlock(size_t index);
+private:
+	std::vector<Block> m_blocks;
+	size_t m_currentBlock;
+	uintptr_t m_cursor;
+	uintptr_t m_end;
+
+	size_t m_blockSize;
+	size_t m_capacity;
+	size_t m_bytesAllocated;
+	size_t m_heapAllocations;
+};
+
+
+/// <summary>
+/// STL allocator that takes memory from a <see cref="LinearAllocator"/>. Deallocation is a no-op.
+/// Falls back to the heap if no allocator is given.
+/// </summary>
+template <class T>
+class LinearAllocatorAdaptor {
+	template <class U>
+	friend class LinearAllocatorAdaptor;
+public:
+	using value_type = T;
+
+	LinearAllocatorAdaptor(LinearAllocator* allocator = nullptr) noexcept : m_allocator(allocator) {}
+	template <class U>
+	LinearAllocatorAdaptor(const LinearAllocatorAdaptor<U>& other) noexcept : m_allocator(other.m_allocator) {}
+
+	T* allocate(size_t count) {
+		if (m_allocator) {
+			return static_cast<T*>(m_allocator->Allocate(count * sizeof(T), alignof(T)));
+		}
+		return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+	void deallocate(T* ptr, size_t) noexcept {
+		if (!m_allocator) {
+			::operator delete(ptr);
+		}
+	}
+
+	LinearAllocator* GetAllocator() const { return m_allocator; }
+
+	template <class U>
+	bool operator==(const LinearAllocatorAdaptor<U>& rhs) const { return m_allocator == rhs.m_allocator; }
+	template <class U>
+	bool operator!=(const LinearAllocatorAdaptor<U>& rhs) const { return m_allocator != rhs.m_allocator; }
+private:
+	LinearAllocator* m_allocator;
+};
+
+
+} // namespace inl
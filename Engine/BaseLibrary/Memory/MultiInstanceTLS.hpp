@@ -2,42 +2,71 @@
 
 #include "SlabAllocatorEngine.hpp"
 
-#include <map>
 #include <algorithm>
+#include <cstddef>
 #include <mutex>
-#include <set>
-#include <deque>
+#include <new>
+#include <utility>
+#include <vector>
 
 
-// optional is part of C++17, but not included in VS yet
-// this is a reference implementation by the authors of the proposal
-// uses boost license
-// replace when official is available
-// see https://github.com/akrzemi1/Optional
-//#define TR2_OPTIONAL_DISABLE_EMULATION_OF_TYPE_TRAITS
-//#include "../optional.hpp"
-//namespace std {
-//	template <class T>
-//	using optional = experimental::optional<T>;
-//}
-
-#include <optional>
-
 namespace inl {
 
 
+/// <summary>
+/// A thread local variable that can have multiple instances, unlike the thread_local keyword, which
+/// only works with static variables. Each thread sees its own copy of the value, initialized
+/// from the value given at construction when the thread first touches it.
+/// </summary>
+/// <remarks>
+/// References to a thread's value remain valid until the instance is destroyed or the thread exits.
+/// Destroying an instance destroys every thread's value of it.
+/// </remarks>
 template <class T>
 class mi_tls {
+	// How it works:
+	// Every instance gets a slot index. Each thread has a flat, cache-aligned table of object
+	// pointers indexed by slot, so access is a bounds check and a single load from the table.
+	// Objects are allocated separately, on their own cache lines, so growing the table
+	// does not move them and threads don't falsely share them.
+	// Tables are registered globally: destroying an instance frees its objects in every thread,
+	// so slots are reclaimed when reused, and a thread's table is freed when the thread exits.
+	static constexpr size_t CacheLineSize = 64;
+	static constexpr size_t ObjectAlignment = alignof(T) > CacheLineSize ? alignof(T) : CacheLineSize;
+
+	struct TableView {
+		T** objects;
+		size_t capacity;
+	};
+
+	// Owns the calling thread's table, cleans up on thread exit.
+	struct TableOwner {
+		TableOwner();
+		~TableOwner();
+	};
+
+	struct Registry {
+		std::mutex mutex;
+		SlabAllocatorEngine indexAllocator{ 16 };
+		std::vector<TableView*> tables;
+	};
 public:
 	mi_tls() {
 		AllocateSlot();
 	}
 
 	~mi_tls() {
-		// deallocate our slot
-		std::lock_guard<std::mutex> lkg(indexAllocatorLock);
-
-		indexAllocator.Deallocate(myIndex);
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lkg(registry.mutex);
+
+		// free this instance's objects in all threads
+		for (TableView* table : registry.tables) {
+			if (myIndex < table->capacity && table->objects[myIndex]) {
+				DestroyObject(table->objects[myIndex]);
+				table->objects[myIndex] = nullptr;
+			}
+		}
+		registry.indexAllocator.Deallocate(myIndex);
 	}
 
 	// Construct from in-place arguments
@@ -80,7 +109,7 @@ public:
 		GetRef() = std::move(rhs.GetRef());
 		return *this;
 	}
-	
+
 
 	// Convert to underlying type
 	operator T&() & {
@@ -94,92 +123,119 @@ public:
 	}
 private:
 	void AllocateSlot() {
-		std::lock_guard<std::mutex> lkg(indexAllocatorLock);
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lkg(registry.mutex);
 
 		try {
-			myIndex = indexAllocator.Allocate();
+			myIndex = registry.indexAllocator.Allocate();
 		}
 		catch (std::bad_alloc&) {
-			size_t currentSize = indexAllocator.Size();
-			indexAllocator.Resize(size_t(currentSize * 1.2 + 1));
-			myIndex = indexAllocator.Allocate(); // supposed to have enough space now
+			size_t currentSize = registry.indexAllocator.Size();
+			registry.indexAllocator.Resize(size_t(currentSize * 1.2 + 1));
+			myIndex = registry.indexAllocator.Allocate(); // supposed to have enough space now
 		}
 	}
 
-
-	T& GetRef() {
-		size_t size = threadObjects.size()-1;
-		size_t testIndex = myIndex < size ? myIndex : size;
-		if (!threadObjects[testIndex]) {
-			if (threadObjects.size()-1 <= myIndex) {
-				threadObjects.resize(myIndex + 2);
+	T& GetRef() const {
+		const TableView& table = threadTable;
+		if (myIndex < table.capacity) {
+			T* object = table.objects[myIndex];
+			if (object) {
+				return *object;
 			}
-			threadObjects[myIndex] = defaultRecord;
 		}
-		return threadObjects[myIndex].value();
+		return GetRefSlow();
 	}
 
-	const T& GetRef() const {
-		size_t size = threadObjects.size() - 1;
-		size_t testIndex = myIndex < size ? myIndex : size;
-		if (!threadObjects[testIndex]) {
-			if (threadObjects.size() - 1 <= myIndex) {
-				threadObjects.resize(myIndex + 2);
-			}
-			threadObjects[myIndex] = defaultRecord;
-		}
-		return threadObjects[myIndex].value();
-	}
-
-	void Register() {
-		std::lock_guard<std::mutex> lkg(registryLock);
-		myThreadObjects.insert(&threadObjects);
-		myThreadInstances.insert(&threadInstances);
-		threadInstances.insert(this);
-	}
-
-	//void UnregisterByThread() {
-	//	std::lock_guard<std::mutex> lkg(registryLock);
-	//	threadObjects.clear();
-	//	for (auto& instance : threadInstances) {
-	//		instance->myThreadObjects.erase(&threadObjects);
-	//		instant->myThreadInstances.erase(&threadInstances);
-	//	}
-	//}
-
-	//void UnregisterByInstance() {
-	//	std::lock_guard<std::mutex> lkg(registryLock);
-	//	for (auto& instances : myThreadInstances) {
-	//		instances.erase(this);
-	//	}
-	//	for (auto& objects : myThreadObjects) {
-	//		objects[myIndex].erase()
-	//	}
-	//}
+	T& GetRefSlow() const;
+
+	static void DestroyObject(T* object) {
+		object->~T();
+		::operator delete(object, std::align_val_t(ObjectAlignment));
+	}
+
+	static Registry& GetRegistry() {
+		// function local so that it's constructed before any instance and destroyed after all of them
+		static Registry registry;
+		return registry;
+	}
 private:
-	static thread_local std::deque<std::optional<T>> threadObjects; // vector would be better, but deque.resize does not invalidate refs and ptrs
-	static std::mutex indexAllocatorLock;
-	static SlabAllocatorEngine indexAllocator;
+	// POD, so the fast path does not need to check for initialization
+	static thread_local TableView threadTable;
 
 	size_t myIndex;
 	T defaultRecord;
-
-	//static std::mutex registryLock;
-	//thread_local std::set<mi_tls*> threadInstances;
-	//std::set<decltype(threadObjects)*> myThreadObjects;
-	//std::set<decltype(threadInstances)> myThreadInstances;
 };
 
 
 template <class T>
-thread_local std::deque<std::optional<T>> mi_tls<T>::threadObjects(1);
+thread_local typename mi_tls<T>::TableView mi_tls<T>::threadTable = { nullptr, 0 };
+
+
+template <class T>
+T& mi_tls<T>::GetRefSlow() const {
+	// the owner registers the table on first use and unregisters it on thread exit
+	static thread_local TableOwner tableOwner;
+	(void)tableOwner;
+
+	// construct the object before locking, its constructor might access other instances
+	void* memory = ::operator new(sizeof(T), std::align_val_t(ObjectAlignment));
+	T* object;
+	try {
+		object = new (memory) T(defaultRecord);
+	}
+	catch (...) {
+		::operator delete(memory, std::align_val_t(ObjectAlignment));
+		throw;
+	}
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mutex);
+
+	TableView& table = threadTable;
+	if (myIndex >= table.capacity) {
+		size_t newCapacity = std::max({ myIndex + 1, 2 * table.capacity, CacheLineSize / sizeof(T*) });
+		T** newObjects = static_cast<T**>(::operator new(newCapacity * sizeof(T*), std::align_val_t(CacheLineSize)));
+		std::fill(newObjects, newObjects + newCapacity, nullptr);
+		if (table.objects) {
+			std::copy(table.objects, table.objects + table.capacity, newObjects);
+			::operator delete(table.objects, std::align_val_t(CacheLineSize));
+		}
+		table.objects = newObjects;
+		table.capacity = newCapacity;
+	}
+
+	table.objects[myIndex] = object;
+	return *object;
+}
+
 
 template <class T>
-std::mutex mi_tls<T>::indexAllocatorLock;
+mi_tls<T>::TableOwner::TableOwner() {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mutex);
+	registry.tables.push_back(&threadTable);
+}
+
 
 template <class T>
-SlabAllocatorEngine mi_tls<T>::indexAllocator(10);
+mi_tls<T>::TableOwner::~TableOwner() {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mutex);
+
+	TableView& table = threadTable;
+	for (size_t i = 0; i < table.capacity; ++i) {
+		if (table.objects[i]) {
+			DestroyObject(table.objects[i]);
+		}
+	}
+	if (table.objects) {
+		::operator delete(table.objects, std::align_val_t(CacheLineSize));
+	}
+	table = { nullptr, 0 };
 
+	registry.tables.erase(std::find(registry.tables.begin(), registry.tables.end(), &table));
+}
 
 
 
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "SlabAllocatorEngine.hpp"
+#include "../Exception/Exception.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Refers to an object in an <see cref="ObjectPool"/>. Holds the slot index and the generation
+/// of the slot at the time of creation, so handles to destroyed objects can be detected
+/// even if the slot has been reused since.
+/// </summary>
+class ObjectPoolHandle {
+	template <class T>
+	friend class ObjectPool;
+public:
+	static constexpr unsigned IndexBits = 24;
+	static constexpr unsigned GenerationBits = 32 - IndexBits;
+	static constexpr uint32_t MaxIndex = (uint32_t(1) << IndexBits) - 1;
+	static constexpr uint32_t GenerationMask = (uint32_t(1) << GenerationBits) - 1;
+public:
+	/// <summary> Creates an invalid handle. </summary>
+	ObjectPoolHandle() : m_value(~uint32_t(0)) {}
+
+	uint32_t GetIndex() const { return m_value & MaxIndex; }
+	uint32_t GetGeneration() const { return m_value >> IndexBits; }
+	uint32_t GetValue() const { return m_value; }
+
+	bool operator==(const ObjectPoolHandle& rhs) const { return m_value == rhs.m_value; }
+	bool operator!=(const ObjectPoolHandle& rhs) const { return m_value != rhs.m_value; }
+private:
+	ObjectPoolHandle(uint32_t index, uint32_t generation) : m_value((generation << IndexBits) | index) {}
+	uint32_t m_value;
+};
+
+
+
+/// <summary>
+/// Stores objects of the same type in contiguous chunks.
+/// Objects never move, so pointers stay valid until the object is destroyed.
+/// Objects are referred to by 32 bit handles that detect use after destroy.
+/// Live objects can be iterated without visiting free slots.
+/// Not thread safe.
+/// </summary>
+template <class T>
+class ObjectPool {
+	// How it works:
+	// Slots are allocated by a SlabAllocatorEngine, their storage is in power-of-two sized chunks.
+	// Each slot has a generation that is bumped when its object is destroyed, handles carry
+	// the generation they were created with.
+	// Live slot indices are kept in a dense array, with each slot remembering its position there,
+	// so that destroy can swap the last entry into the hole.
+	using StorageT = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	struct SlotInfo {
+		uint32_t generation;
+		uint32_t denseIndex;
+	};
+
+	template <class PoolT, class ValueT>
+	class generic_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = ValueT;
+		using difference_type = ptrdiff_t;
+		using pointer = ValueT*;
+		using reference = ValueT&;
+
+		generic_iterator() : m_pool(nullptr), m_position(0) {}
+		generic_iterator(PoolT* pool, size_t position) : m_pool(pool), m_position(position) {}
+
+		ValueT& operator*() const { return *m_pool->Slot(m_pool->m_dense[m_position]); }
+		ValueT* operator->() const { return m_pool->Slot(m_pool->m_dense[m_position]); }
+		generic_iterator& operator++() { ++m_position; return *this; }
+		generic_iterator operator++(int) { auto copy = *this; ++m_position; return copy; }
+		bool operator==(const generic_iterator& rhs) const { return m_position == rhs.m_position; }
+		bool operator!=(const generic_iterator& rhs) const { return m_position != rhs.m_position; }
+
+		/// <summary> The handle of the object the iterator points to. </summary>
+		ObjectPoolHandle GetHandle() const { return m_pool->HandleOf(m_pool->m_dense[m_position]); }
+	private:
+		PoolT* m_pool;
+		size_t m_position;
+	};
+public:
+	using iterator = generic_iterator<ObjectPool, T>;
+	using const_iterator = generic_iterator<const ObjectPool, const T>;
+public:
+	/// <param name="chunkSize"> Number of objects allocated at once when the pool grows, rounded up to a power of two. </param>
+	explicit ObjectPool(size_t chunkSize = 1024);
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+	~ObjectPool();
+
+	/// <summary> Constructs a new object in the pool. </summary>
+	/// <exception cref="std::bad_alloc"> Thrown if the pool reached the maximum number of objects. </exception>
+	template <class... Args>
+	ObjectPoolHandle Create(Args&&... args);
+
+	/// <summary> Destroys the object. The handle and all copies of it become invalid. </summary>
+	/// <exception cref="InvalidArgumentException"> Thrown if the handle does not refer to a live object. </exception>
+	void Destroy(ObjectPoolHandle handle);
+
+	/// <summary> Destroys all objects. </summary>
+	void Clear();
+
+	/// <summary> Returns the object or nullptr if the handle is invalid or its object was destroyed. </summary>
+	T* Get(ObjectPoolHandle handle);
+	const T* Get(ObjectPoolHandle handle) const;
+
+	/// <summary> Returns the object. The handle must be valid. </summary>
+	T& operator[](ObjectPoolHandle handle);
+	const T& operator[](ObjectPoolHandle handle) const;
+
+	/// <summary> True if the handle refers to a live object. </summary>
+	bool IsValid(ObjectPoolHandle handle) const;
+
+	/// <summary> Number of live objects. </summary>
+	size_t Count() const { return m_dense.size(); }
+
+	/// <summary> Number of objects that fit without allocating a new chunk. </summary>
+	size_t Capacity() const { return m_slots.size(); }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, m_dense.size()); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, m_dense.size()); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+private:
+	T* Slot(uint32_t index) const {
+		return reinterpret_cast<T*>(&m_chunks[index >> m_chunkShift][index & m_chunkMask]);
+	}
+	ObjectPoolHandle HandleOf(uint32_t index) const {
+		return ObjectPoolHandle(index, m_slots[index].generation);
+	}
+	void Grow();
+private:
+	SlabAllocatorEngine m_slabs;
+	std::vector<std::unique_ptr<StorageT[]>> m_chunks;
+	std::vector<SlotInfo> m_slots;
+	std::vector<uint32_t> m_dense;
+	unsigned m_chunkShift;
+	size_t m_chunkMask;
+};
+
+
+
+template <class T>
+ObjectPool<T>::ObjectPool(size_t chunkSize) {
+	m_chunkShift = 0;
+	while ((size_t(1) << m_chunkShift) < chunkSize) {
+		++m_chunkShift;
+	}
+	m_chunkMask = (size_t(1) << m_chunkShift) - 1;
+}
+
+
+template <class T>
+ObjectPool<T>::~ObjectPool() {
+	Clear();
+}
+
+
+template <class T>
+template <class... Args>
+ObjectPoolHandle ObjectPool<T>::Create(Args&&... args) {
+	if (m_dense.size() == m_slots.size()) {
+		Grow();
+	}
+
+	uint32_t index = uint32_t(m_slabs.Allocate());
+	try {
+		new (Slot(index)) T(std::forward<Args>(args)...);
+	}
+	catch (...) {
+		m_slabs.Deallocate(index);
+		throw;
+	}
+
+	m_slots[index].denseIndex = uint32_t(m_dense.size());
+	m_dense.push_back(index);
+	return HandleOf(index);
+}
+
+
+template <class T>
+void ObjectPool<T>::Destroy(ObjectPoolHandle handle) {
+	if (!IsValid(handle)) {
+		throw InvalidArgumentException("Handle does not refer to a live object.");
+	}
+	uint32_t index = handle.GetIndex();
+	SlotInfo& slot = m_slots[index];
+
+	Slot(index)->~T();
+	slot.generation = (slot.generation + 1) & ObjectPoolHandle::GenerationMask;
+
+	uint32_t lastIndex = m_dense.back();
+	m_dense[slot.denseIndex] = lastIndex;
+	m_slots[lastIndex].denseIndex = slot.denseIndex;
+	m_dense.pop_back();
+
+	m_slabs.Deallocate(index);
+}
+
+
+template <class T>
+void ObjectPool<T>::Clear() {
+	for (uint32_t index : m_dense) {
+		Slot(index)->~T();
+		m_slots[index].generation = (m_slots[index].generation + 1) & ObjectPoolHandle::GenerationMask;
+	}
+	m_dense.clear();
+	m_slabs.Reset();
+}
+
+
+template <class T>
+T* ObjectPool<T>::Get(ObjectPoolHandle handle) {
+	return IsValid(handle) ? Slot(handle.GetIndex()) : nullptr;
+}
+
+template <class T>
+const T* ObjectPool<T>::Get(ObjectPoolHandle handle) const {
+	return IsValid(handle) ? Slot(handle.GetIndex()) : nullptr;
+}
+
+
+template <class T>
+T& ObjectPool<T>::operator[](ObjectPoolHandle handle) {
+	assert(IsValid(handle));
+	return *Slot(handle.GetIndex());
+}
+
+template <class T>
+const T& ObjectPool<T>::operator[](ObjectPoolHandle handle) const {
+	assert(IsValid(handle));
+	return *Slot(handle.GetIndex());
+}
+
+
+template <class T>
+bool ObjectPool<T>::IsValid(ObjectPoolHandle handle) const {
+	uint32_t index = handle.GetIndex();
+	if (index >= m_slots.size() || m_slots[index].generation != handle.GetGeneration()) {
+		return false;
+	}
+	// A free slot has the generation of the next object to be created there, so check liveness too.
+	uint32_t denseIndex = m_slots[index].denseIndex;
+	return denseIndex < m_dense.size() && m_dense[denseIndex] == index;
+}
+
+
+template <class T>
+void ObjectPool<T>::Grow() {
+	size_t chunkSize = m_chunkMask + 1;
+	size_t newCapacity = m_slots.size() + chunkSize;
+	if (newCapacity > size_t(ObjectPoolHandle::MaxIndex)) { // MaxIndex itself is the invalid handle's index
+		throw std::bad_alloc();
+	}
+
+	m_chunks.push_back(std::make_unique<StorageT[]>(chunkSize));
+	m_slots.resize(newCapacity, SlotInfo{ 0, ~uint32_t(0) });
+	m_slabs.Resize(newCapacity);
+}
+
+
+} // namespace inl
@@ -1,47 +1,111 @@
 #include "RingAllocationEngine.hpp"
 
 #include "../Exception/Exception.hpp"
+#include "../BitOperations.hpp"
 
 #include <cassert>
 
 namespace inl {
 
 RingAllocationEngine::CellContainer::CellContainer(size_t size) :
-	m_bitset(size*CELL_SIZE)
+	m_size(size),
+	m_words((size + CELLS_PER_WORD - 1) / CELLS_PER_WORD, 0)
 {}
 
 
 void RingAllocationEngine::CellContainer::Set(size_t index, eCellState value) {
-	bool first = (int(value) >> 1) != 0;
-	bool second = (int(value) & 1) != 0;
-	m_bitset[index*CELL_SIZE] = first;
-	m_bitset[index*CELL_SIZE + 1] = second;
+	uint64_t& word = m_words[index / CELLS_PER_WORD];
+	int shift = int(index % CELLS_PER_WORD) * CELL_SIZE;
+	word = (word & ~(uint64_t(3) << shift)) | (uint64_t(value) << shift);
+}
+
+
+void RingAllocationEngine::CellContainer::SetRange(size_t first, size_t count, eCellState value) {
+	assert(first + count <= m_size);
+	const uint64_t pattern = Pattern(value);
+	while (count > 0) {
+		size_t cell = first % CELLS_PER_WORD;
+		size_t numCells = std::min(size_t(CELLS_PER_WORD) - cell, count);
+		uint64_t bits = numCells == CELLS_PER_WORD ? ~uint64_t(0) : ((uint64_t(1) << (numCells*CELL_SIZE)) - 1);
+		bits <<= cell*CELL_SIZE;
+
+		uint64_t& word = m_words[first / CELLS_PER_WORD];
+		word = (word & ~bits) | (pattern & bits);
+
+		first += numCells;
+		count -= numCells;
+	}
 }
 
 
 RingAllocationEngine::eCellState RingAllocationEngine::CellContainer::At(size_t index) const {
-	uint8_t first = m_bitset[index*CELL_SIZE];
-	uint8_t second = m_bitset[index*CELL_SIZE + 1];
+	uint64_t word = m_words[index / CELLS_PER_WORD];
+	int shift = int(index % CELLS_PER_WORD) * CELL_SIZE;
+	return eCellState((word >> shift) & 3);
+}
 
-	return eCellState((first<<1) + second);
+
+size_t RingAllocationEngine::CellContainer::FindFirst(size_t from, eCellState value) const {
+	return FindFirstMatch(from, value, true);
+}
+
+
+size_t RingAllocationEngine::CellContainer::FindFirstNot(size_t from, eCellState value) const {
+	return FindFirstMatch(from, value, false);
 }
 
 
 size_t RingAllocationEngine::CellContainer::Size() const {
-	return m_bitset.size() / CELL_SIZE;
+	return m_size;
 }
 
 
 void RingAllocationEngine::CellContainer::Resize(size_t size) {
-	m_bitset.resize(size*CELL_SIZE);
+	m_words.resize((size + CELLS_PER_WORD - 1) / CELLS_PER_WORD, 0);
+	m_size = size;
 
+	// clear cells past the end, they might be exposed again by a later grow
+	size_t numLastCells = size % CELLS_PER_WORD;
+	if (numLastCells > 0) {
+		m_words.back() &= (uint64_t(1) << (numLastCells*CELL_SIZE)) - 1;
+	}
 }
 
 
 void RingAllocationEngine::CellContainer::Reset() {
-	size_t size = m_bitset.size();
-	m_bitset.clear();
-	m_bitset.resize(size);
+	std::fill(m_words.begin(), m_words.end(), uint64_t(0));
+}
+
+
+uint64_t RingAllocationEngine::CellContainer::Pattern(eCellState value) {
+	return LOW_BITS * uint64_t(value);
+}
+
+
+uint64_t RingAllocationEngine::CellContainer::MatchMask(uint64_t word, eCellState value) {
+	// the low bit of each cell is set if the cell equals value
+	uint64_t diff = word ^ Pattern(value);
+	return ~(diff | (diff >> 1)) & LOW_BITS;
+}
+
+
+size_t RingAllocationEngine::CellContainer::FindFirstMatch(size_t from, eCellState value, bool equal) const {
+	if (from >= m_size) {
+		return m_size;
+	}
+
+	size_t wordIndex = from / CELLS_PER_WORD;
+	uint64_t firstCellMask = ~uint64_t(0) << ((from % CELLS_PER_WORD) * CELL_SIZE);
+	uint64_t mask = (equal ? MatchMask(m_words[wordIndex], value) : ~MatchMask(m_words[wordIndex], value) & LOW_BITS) & firstCellMask;
+	while (mask == 0) {
+		if (++wordIndex >= m_words.size()) {
+			return m_size;
+		}
+		mask = equal ? MatchMask(m_words[wordIndex], value) : ~MatchMask(m_words[wordIndex], value) & LOW_BITS;
+	}
+
+	size_t index = wordIndex * CELLS_PER_WORD + CountTrailingZeros(mask) / CELL_SIZE;
+	return std::min(index, m_size);
 }
 
 
@@ -78,13 +142,8 @@ size_t RingAllocationEngine::Allocate(size_t allocationSize) {
 	}
 
 	// mark allocated area
-	{
-		size_t end = allocationSize-1;
-		for (size_t i = 0; i < end; i++) {
-			m_container.Set(allocStartIndex + i, eCellState::INSIDE);
-		}
-		m_container.Set(allocStartIndex + end, eCellState::END);
-	}
+	m_container.SetRange(allocStartIndex, allocationSize - 1, eCellState::INSIDE);
+	m_container.Set(allocStartIndex + allocationSize - 1, eCellState::END);
 
 
 	m_nextIndex = (allocStartIndex + allocationSize) % m_container.Size();
@@ -104,41 +163,30 @@ void RingAllocationEngine::Deallocate(size_t index) {
 	bool isPreviousInUse = m_container.At(prevIndex) != eCellState::FREE;
 	bool previousIsNotFront = index != m_nextIndex;
 
+	// allocations never wrap around, so the range ends at the first END cell
+	size_t end = m_container.FindFirst(index, eCellState::END);
+	assert(end < m_container.Size());
+	size_t count = end - index + 1;
+
 	if (previousIsNotFront && isPreviousInUse) {
 		// there are still allocated blocks before this one
-
 		// mark all cells unused inside this allocation
-		size_t current = index;
-		bool isEnd;
-		do {
-			isEnd = m_container.At(current) == eCellState::END;
-			m_container.Set(current, eCellState::PREVIOUS_IN_USE);
-			current = (current+1) % m_container.Size();
-		} while(!isEnd);
+		m_container.SetRange(index, count, eCellState::PREVIOUS_IN_USE);
 	}
 	else {
 		// if it has no allocated space befor this one
 		// in other words if this is the last allocated range, it is time to deallocate
 
-		size_t current = index;
-
 		// lets free this allocation first
-		{
-			bool isEnd;
-			do {
-				isEnd = m_container.At(current) == eCellState::END;
-				m_container.Set(current, eCellState::FREE);
-				current = (current+1) % m_container.Size();
-			} while(!isEnd);
-		}
+		m_container.SetRange(index, count, eCellState::FREE);
 
 		// go forward, and free every cell in a contigous range starting at this cell
 		// that is in the state of "previous in use"
-		{
-			while (m_container.At(current) == eCellState::PREVIOUS_IN_USE) {
-				m_container.Set(current, eCellState::FREE);
-				current = (current+1) % m_container.Size();
-			}
+		size_t current = (end + 1) % m_container.Size();
+		while (m_container.At(current) == eCellState::PREVIOUS_IN_USE) {
+			size_t runEnd = m_container.FindFirstNot(current, eCellState::PREVIOUS_IN_USE);
+			m_container.SetRange(current, runEnd - current, eCellState::FREE);
+			current = runEnd % m_container.Size();
 		}
 	}
 }
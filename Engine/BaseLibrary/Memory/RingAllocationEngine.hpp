@@ -22,14 +22,27 @@ class RingAllocationEngine {
 protected:
 	enum class eCellState { FREE = 0, INSIDE, END, PREVIOUS_IN_USE };
 
+	/// <summary>
+	/// Stores the state of each cell on 2 bits, packed into 64 bit words,
+	/// so that ranges can be set and searched a word at a time.
+	/// </summary>
 	class CellContainer {
 	public:
 		CellContainer(size_t size);
 
 		void Set(size_t index, eCellState value);
 
+		/// <summary> Sets count cells starting at first, the range must not wrap around. </summary>
+		void SetRange(size_t first, size_t count, eCellState value);
+
 		eCellState At(size_t index) const;
 
+		/// <summary> Returns the index of the first cell not before from that has the given state, or Size() if there's none. </summary>
+		size_t FindFirst(size_t from, eCellState value) const;
+
+		/// <summary> Returns the index of the first cell not before from that has a different state, or Size() if there's none. </summary>
+		size_t FindFirstNot(size_t from, eCellState value) const;
+
 		size_t Size() const;
 
 		void Resize(size_t size);
@@ -37,8 +50,15 @@ protected:
 		void Reset();
 
 	protected:
+		static uint64_t Pattern(eCellState value);
+		static uint64_t MatchMask(uint64_t word, eCellState value);
+		size_t FindFirstMatch(size_t from, eCellState value, bool equal) const;
+
 		static constexpr int CELL_SIZE = 2;
-		std::vector<bool> m_bitset;
+		static constexpr int CELLS_PER_WORD = 64 / CELL_SIZE;
+		static constexpr uint64_t LOW_BITS = 0x5555'5555'5555'5555ull;
+		size_t m_size;
+		std::vector<uint64_t> m_words;
 	};
 
 public:
@@ -0,0 +1,111 @@
+#include "RingArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace inl {
+
+
+RingArena::RingArena(size_t capacity, size_t chunkSize)
+	: m_engine(std::max(size_t(1), (capacity + CellSize - 1) / CellSize)),
+	m_chunkCells(std::max(size_t(1), (chunkSize + CellSize - 1) / CellSize)),
+	m_cursor(0),
+	m_chunkEnd(0),
+	m_chunkHead(0),
+	m_chunkTail(0),
+	m_fencedChunks(0),
+	m_frameHead(0),
+	m_frameTail(0)
+{
+	size_t cellCount = m_engine.Size();
+	m_chunkCells = std::min(m_chunkCells, cellCount);
+
+	m_storage.reset(new uint8_t[cellCount * CellSize + CellSize - 1]);
+	uintptr_t address = reinterpret_cast<uintptr_t>(m_storage.get());
+	m_buffer = reinterpret_cast<uint8_t*>((address + CellSize - 1) & ~uintptr_t(CellSize - 1));
+
+	// every chunk is at least m_chunkCells long, and every frame has at least one chunk
+	size_t maxChunks = cellCount / m_chunkCells + 1;
+	m_chunkStarts.resize(maxChunks);
+	m_frames.resize(maxChunks);
+}
+
+
+void* RingArena::Allocate(size_t size, size_t alignment) {
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	size = std::max(size, size_t(1));
+
+	size_t offset = AlignOffset(m_cursor, alignment);
+	if (offset + size > m_chunkEnd) {
+		// chunks are aligned to CellSize, only bigger alignments need padding
+		size_t padding = alignment > CellSize ? alignment - CellSize : 0;
+		OpenChunk((size + padding + CellSize - 1) / CellSize);
+		offset = AlignOffset(m_cursor, alignment);
+	}
+	assert(offset + size <= m_chunkEnd);
+
+	m_cursor = offset + size;
+	return m_buffer + offset;
+}
+
+
+void RingArena::Fence(uint64_t frameId) {
+	if (m_chunkTail > m_fencedChunks) {
+		assert(m_frameTail - m_frameHead < m_frames.size());
+		assert(m_frameTail == m_frameHead || m_frames[(m_frameTail - 1) % m_frames.size()].frameId < frameId);
+
+		m_frames[m_frameTail % m_frames.size()] = { frameId, m_chunkTail };
+		++m_frameTail;
+		m_fencedChunks = m_chunkTail;
+	}
+
+	// close current chunk, the next frame must not share it
+	m_cursor = m_chunkEnd;
+}
+
+
+void RingArena::Release(uint64_t completedFrameId) {
+	while (m_frameHead < m_frameTail) {
+		const FrameRecord& frame = m_frames[m_frameHead % m_frames.size()];
+		if (frame.frameId > completedFrameId) {
+			break;
+		}
+		for (; m_chunkHead < frame.chunkEnd; ++m_chunkHead) {
+			m_engine.Deallocate(m_chunkStarts[m_chunkHead % m_chunkStarts.size()]);
+		}
+		++m_frameHead;
+	}
+}
+
+
+void RingArena::Reset() {
+	m_engine.Reset();
+	m_cursor = m_chunkEnd = 0;
+	m_chunkHead = m_chunkTail = m_fencedChunks = 0;
+	m_frameHead = m_frameTail = 0;
+}
+
+
+size_t RingArena::AlignOffset(size_t offset, size_t alignment) const {
+	// The buffer itself is only aligned to CellSize, so the address is aligned, not the offset.
+	uintptr_t address = reinterpret_cast<uintptr_t>(m_buffer) + offset;
+	uintptr_t aligned = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+	return size_t(aligned - reinterpret_cast<uintptr_t>(m_buffer));
+}
+
+
+void RingArena::OpenChunk(size_t minCells) {
+	size_t numCells = std::max(m_chunkCells, minCells);
+	assert(m_chunkTail - m_chunkHead < m_chunkStarts.size());
+
+	size_t start = m_engine.Allocate(numCells); // throws bad_alloc if the ring is full
+	m_chunkStarts[m_chunkTail % m_chunkStarts.size()] = start;
+	++m_chunkTail;
+
+	m_cursor = start * CellSize;
+	m_chunkEnd = (start + numCells) * CellSize;
+}
+
+
+} // namespace inl
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "RingAllocationEngine.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Owns a contiguous buffer and hands out variable sized, aligned blocks of it in FIFO order.
+/// Blocks are not freed one by one, but all together when the frame they were allocated in completes.
+/// <para />
+/// Usage: allocate during a frame, call <see cref="Fence"/> with the frame's id at the end of it,
+/// and call <see cref="Release"/> when the frame is no longer in use (i.e. the GPU finished it).
+/// After construction, neither allocation nor release touches the heap.
+/// This class is NOT thread safe.
+/// </summary>
+class RingArena {
+	// How it works:
+	// The buffer is divided into cells of CellSize bytes, which are managed by a RingAllocationEngine.
+	// Allocations are bump-allocated from a chunk of cells, when that runs out, a new chunk
+	// is requested from the engine. Fence closes the current chunk, so a chunk belongs to exactly one frame.
+	// Chunk starts and frame boundaries are kept in preallocated circular arrays.
+	struct FrameRecord {
+		uint64_t frameId;
+		uint64_t chunkEnd; // one past the last chunk of the frame, in the chunk counter's domain
+	};
+public:
+	static constexpr size_t CellSize = 64;
+
+	/// <summary> Creates an arena. </summary>
+	/// <param name="capacity"> Size of the backing buffer in bytes, rounded up to CellSize. </param>
+	/// <param name="chunkSize"> Granularity of requests to the ring, in bytes.
+	///		Each frame that allocates anything uses at least this much. </param>
+	RingArena(size_t capacity, size_t chunkSize = 16 * 1024);
+	RingArena(const RingArena&) = delete;
+	RingArena(RingArena&&) = default;
+	RingArena& operator=(const RingArena&) = delete;
+	RingArena& operator=(RingArena&&) = default;
+
+	/// <summary> Allocates size bytes aligned to alignment, which must be a power of two. </summary>
+	/// <exception cref="std::bad_alloc"> Thrown if the ring is full. </exception>
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	/// <summary> Marks every allocation since the previous fence to belong to frameId. Frame ids must increase. </summary>
+	void Fence(uint64_t frameId);
+
+	/// <summary> Frees the allocations of all fenced frames up to and including completedFrameId. </summary>
+	void Release(uint64_t completedFrameId);
+
+	/// <summary> Frees everything, including allocations that were not fenced yet. </summary>
+	void Reset();
+
+	/// <summary> Size of the backing buffer in bytes. </summary>
+	size_t Capacity() const { return m_engine.Size() * CellSize; }
+private:
+	size_t AlignOffset(size_t offset, size_t alignment) const; // rounds offset up so that m_buffer + offset is aligned
+	void OpenChunk(size_t minCells);
+private:
+	std::unique_ptr<uint8_t[]> m_storage;
+	uint8_t* m_buffer; // m_storage aligned to CellSize
+	RingAllocationEngine m_engine;
+	size_t m_chunkCells;
+
+	size_t m_cursor; // next free byte of the current chunk
+	size_t m_chunkEnd; // end of the current chunk in bytes
+
+	std::vector<size_t> m_chunkStarts; // circular, indexed by the chunk counters
+	uint64_t m_chunkHead; // oldest chunk that is not released
+	uint64_t m_chunkTail; // one past the newest chunk
+	uint64_t m_fencedChunks; // chunks that already belong to a frame
+
+	std::vector<FrameRecord> m_frames; // circular, indexed by the frame counters
+	uint64_t m_frameHead;
+	uint64_t m_frameTail;
+};
+
+
+/// <summary>
+/// A <see cref="RingArena"/> that hands out arrays of T.
+/// Destructors are never called, so T must be trivially destructible.
+/// </summary>
+template <class T>
+class TypedRingArena {
+	static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without calling destructors.");
+public:
+	/// <param name="capacity"> The number of objects that fit in the arena. </param>
+	TypedRingArena(size_t capacity, size_t chunkSize = 16 * 1024) : m_arena(capacity * sizeof(T), chunkSize) {}
+
+	/// <summary> Allocates and default constructs count objects. </summary>
+	/// <exception cref="std::bad_alloc"> Thrown if the ring is full. </exception>
+	T* Allocate(size_t count = 1) {
+		T* objects = static_cast<T*>(m_arena.Allocate(count * sizeof(T), alignof(T)));
+		for (size_t i = 0; i < count; ++i) {
+			new (objects + i) T;
+		}
+		return objects;
+	}
+
+	void Fence(uint64_t frameId) { m_arena.Fence(frameId); }
+	void Release(uint64_t completedFrameId) { m_arena.Release(completedFrameId); }
+	void Reset() { m_arena.Reset(); }
+	size_t Capacity() const { return m_arena.Capacity() / sizeof(T); }
+private:
+	RingArena m_arena;
+};
+
+
+} // namespace inl
@@ -110,7 +110,9 @@ void SlabAllocatorEngine::Resize(size_t newPoolSize) {
 		if (m_blocks.size() > 0 && newPoolSize > m_poolSize) {
 			auto last = &newBlocks[m_blocks.size() - 1];
 			int numLastSlots = (m_poolSize % SlotsPerBlock);
-			last->slotOccupancy &= ~size_t(0) >> (sizeof(size_t) * 8 - numLastSlots);
+			if (numLastSlots != 0) { // a full width shift would be undefined
+				last->slotOccupancy &= ~size_t(0) >> (sizeof(size_t) * 8 - numLastSlots);
+			}
 		}
 
 		// lock last slots of the NEW last block
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Unbounded, lock-free queue for handing objects from any number of threads to one consumer.
+/// The consumer takes everything that has been pushed at once, in the order of pushing for each producer.
+/// </summary>
+template <class T>
+class MpscQueue {
+	// How it works:
+	// Pushed nodes are linked into a stack with a compare-exchange on the head. The consumer
+	// takes the whole stack with a single exchange and reverses it. Nodes are never popped
+	// one by one, so the head can't be changed under a producer to a node it has seen before (no ABA).
+	struct Node {
+		T value;
+		Node* next;
+	};
+public:
+	MpscQueue() : m_head(nullptr) {}
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	~MpscQueue() {
+		Node* node = m_head.load(std::memory_order_acquire);
+		while (node != nullptr) {
+			Node* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+
+	// Producers
+
+	/// <summary> Adds an element, can be called from any thread. </summary>
+	template <class U>
+	void Push(U&& element) {
+		Node* node = new Node{ T(std::forward<U>(element)), m_head.load(std::memory_order_relaxed) };
+		while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+		}
+	}
+
+
+	// Consumer
+
+	/// <summary> Removes everything pushed so far and calls func with each element, oldest first. </summary>
+	/// <returns> The number of elements removed. </returns>
+	template <class Func>
+	size_t PopAll(Func&& func) {
+		Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+		Node* oldest = nullptr;
+		while (node != nullptr) {
+			Node* next = node->next;
+			node->next = oldest;
+			oldest = node;
+			node = next;
+		}
+
+		size_t count = 0;
+		while (oldest != nullptr) {
+			Node* next = oldest->next;
+			func(std::move(oldest->value));
+			delete oldest;
+			oldest = next;
+			++count;
+		}
+		return count;
+	}
+
+
+	// Properties
+
+	/// <summary> True if nothing has been pushed since the last PopAll, only exact if producers are idle. </summary>
+	bool IsEmpty() const {
+		return m_head.load(std::memory_order_acquire) == nullptr;
+	}
+private:
+	std::atomic<Node*> m_head;
+};
+
+
+} // namespace inl
@@ -0,0 +1,209 @@
+#include "Profiler.hpp"
+#include "SpscRingBuffer.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+
+namespace inl {
+
+
+//------------------------------------------------------------------------------
+// Thread events
+//------------------------------------------------------------------------------
+
+struct Profiler::ThreadEvents {
+	ThreadEvents() : ring(ThreadCapacity) {}
+
+	// The owner thread pushes, Collect pops under the threads mutex.
+	SpscRingBuffer<ProfileEvent> ring;
+	unsigned index = 0;
+};
+
+
+// Registers the thread's ring on first use and saves what's left in it at thread exit.
+struct Profiler::ThreadEventsOwner {
+	ThreadEventsOwner(Profiler& profiler) : profiler(profiler) {
+		profiler.RegisterThread(&events);
+	}
+	~ThreadEventsOwner() {
+		profiler.UnregisterThread(&events);
+	}
+	Profiler& profiler;
+	ThreadEvents events;
+};
+
+
+namespace {
+
+enum class eThreadState { UNINITIALIZED, ACTIVE, EXITED };
+
+thread_local eThreadState t_threadState = eThreadState::UNINITIALIZED;
+
+void WriteJsonString(std::ostream& os, const char* str) {
+	os << '"';
+	for (; *str != '\0'; ++str) {
+		char c = *str;
+		switch (c) {
+			case '"': os << "\\\""; break;
+			case '\\': os << "\\\\"; break;
+			case '\n': os << "\\n"; break;
+			case '\t': os << "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+				}
+				else {
+					os << c;
+				}
+		}
+	}
+	os << '"';
+}
+
+} // namespace
+
+
+
+//------------------------------------------------------------------------------
+// Profiler
+//------------------------------------------------------------------------------
+
+Profiler& Profiler::GetInstance() {
+	static Profiler* instance = new Profiler();
+	return *instance;
+}
+
+
+Profiler::Profiler()
+	: m_isEnabled(false),
+	m_epoch(Clock::now()),
+	m_numDroppedEvents(0),
+	m_nextThreadIndex(0)
+{}
+
+
+void Profiler::SetEnabled(bool enabled) {
+	m_isEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+
+const char* Profiler::Intern(const std::string& str) {
+	std::lock_guard<std::mutex> lkg(m_stringsMutex);
+	return m_strings.insert(str).first->c_str();
+}
+
+
+void Profiler::Record(const char* category, const char* name, const char* detail, Clock::time_point begin, Clock::time_point end) {
+	if (!IsEnabled()) {
+		return;
+	}
+
+	ProfileEvent event;
+	event.category = category;
+	event.name = name;
+	event.detail = detail;
+	event.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - m_epoch).count();
+	event.end = std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_epoch).count();
+
+	ThreadEvents* events = GetThreadEvents();
+	if (events == nullptr || !events->ring.TryPush(event)) {
+		m_numDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+std::vector<ProfileEvent> Profiler::Collect() {
+	std::vector<ProfileEvent> events;
+	{
+		std::lock_guard<std::mutex> lkg(m_threadsMutex);
+		events = std::move(m_retiredEvents);
+		m_retiredEvents.clear();
+		for (ThreadEvents* threadEvents : m_threads) {
+			DrainThread(threadEvents, events);
+		}
+	}
+
+	std::stable_sort(events.begin(), events.end(), [](const ProfileEvent& lhs, const ProfileEvent& rhs) {
+		return lhs.begin < rhs.begin;
+	});
+	return events;
+}
+
+
+void Profiler::WriteChromeTrace(std::ostream& os) {
+	std::vector<ProfileEvent> events = Collect();
+
+	// Complete events ("X") with microsecond timestamps, nested scopes show up stacked in the viewer.
+	auto flags = os.flags();
+	os << std::fixed << std::setprecision(3);
+	os << "{\"traceEvents\":[";
+	for (size_t i = 0; i < events.size(); ++i) {
+		const ProfileEvent& event = events[i];
+		os << (i == 0 ? "\n" : ",\n");
+		os << "{\"name\":";
+		WriteJsonString(os, event.name);
+		os << ",\"cat\":";
+		WriteJsonString(os, event.category);
+		os << ",\"ph\":\"X\",\"ts\":" << event.begin / 1000.0
+			<< ",\"dur\":" << (event.end - event.begin) / 1000.0
+			<< ",\"pid\":0,\"tid\":" << event.thread;
+		if (event.detail != nullptr) {
+			os << ",\"args\":{\"node\":";
+			WriteJsonString(os, event.detail);
+			os << "}";
+		}
+		os << "}";
+	}
+	os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	os.flags(flags);
+}
+
+
+uint64_t Profiler::GetNumDroppedEvents() const {
+	return m_numDroppedEvents.load(std::memory_order_relaxed);
+}
+
+
+auto Profiler::GetThreadEvents() -> ThreadEvents* {
+	switch (t_threadState) {
+		case eThreadState::ACTIVE: {
+			thread_local ThreadEventsOwner owner(*this);
+			return &owner.events;
+		}
+		case eThreadState::UNINITIALIZED: {
+			t_threadState = eThreadState::ACTIVE;
+			return GetThreadEvents();
+		}
+		default:
+			return nullptr;
+	}
+}
+
+
+void Profiler::RegisterThread(ThreadEvents* events) {
+	std::lock_guard<std::mutex> lkg(m_threadsMutex);
+	events->index = m_nextThreadIndex++;
+	m_threads.push_back(events);
+}
+
+
+void Profiler::UnregisterThread(ThreadEvents* events) {
+	std::lock_guard<std::mutex> lkg(m_threadsMutex);
+	DrainThread(events, m_retiredEvents);
+	m_threads.erase(std::find(m_threads.begin(), m_threads.end(), events));
+	t_threadState = eThreadState::EXITED;
+}
+
+
+void Profiler::DrainThread(ThreadEvents* events, std::vector<ProfileEvent>& output) {
+	ProfileEvent event;
+	while (events->ring.TryPop(event)) {
+		event.thread = events->index;
+		output.push_back(event);
+	}
+}
+
+
+} // namespace inl
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+namespace inl {
+
+
+/// <summary> A timed section of code on one thread. </summary>
+struct ProfileEvent {
+	const char* category; /// <summary> Groups events in the trace viewer, like "Task" or "Queue". </summary>
+	const char* name;
+	const char* detail; /// <summary> Optional, for example the display name of the node that ran, may be null. </summary>
+	int64_t begin; /// <summary> Nanoseconds since the profiler was created. </summary>
+	int64_t end;
+	unsigned thread; /// <summary> Small index in order of the threads' first events. </summary>
+};
+
+
+/// <summary>
+/// Collects timed sections of code from all threads and exports them as a Chrome trace,
+/// which can be opened in chrome://tracing or any viewer that reads the trace event format.
+/// Each thread records into its own lock-free ring, events are moved out of the rings by <see cref="Collect"/>.
+/// If a ring fills up before it's collected, further events of that thread are dropped and counted.
+/// Disabled by default, while disabled a <see cref="ProfileScope"/> costs one atomic load.
+/// Thread safe.
+/// </summary>
+/// <remarks>
+/// Strings in events are not copied, they must be literals or come from <see cref="Intern"/>.
+/// </remarks>
+class Profiler {
+	struct ThreadEvents;
+	struct ThreadEventsOwner;
+public:
+	using Clock = std::chrono::high_resolution_clock;
+	static constexpr size_t ThreadCapacity = 16384;
+public:
+	/// <summary> The profiler is never destroyed, so that threads can record until they exit. </summary>
+	static Profiler& GetInstance();
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled() const { return m_isEnabled.load(std::memory_order_relaxed); }
+
+	/// <summary> Returns a copy of the string that lives as long as the profiler.
+	///		Equal strings give the same pointer. Slow, call it once per name, not once per event. </summary>
+	const char* Intern(const std::string& str);
+
+	/// <summary> Records an event on the calling thread. Does nothing while disabled. </summary>
+	void Record(const char* category, const char* name, const char* detail, Clock::time_point begin, Clock::time_point end);
+
+	/// <summary> Removes and returns the recorded events of all threads, sorted by begin time. </summary>
+	std::vector<ProfileEvent> Collect();
+
+	/// <summary> Collects the recorded events and writes them in Chrome trace event format. </summary>
+	void WriteChromeTrace(std::ostream& os);
+
+	/// <summary> Number of events lost because a thread's ring was full. </summary>
+	uint64_t GetNumDroppedEvents() const;
+private:
+	Profiler();
+
+	ThreadEvents* GetThreadEvents();
+	void RegisterThread(ThreadEvents* events);
+	void UnregisterThread(ThreadEvents* events);
+	void DrainThread(ThreadEvents* events, std::vector<ProfileEvent>& output);
+private:
+	std::atomic_bool m_isEnabled;
+	const Clock::time_point m_epoch;
+	std::atomic<uint64_t> m_numDroppedEvents;
+
+	std::mutex m_threadsMutex;
+	std::vector<ThreadEvents*> m_threads;
+	std::vector<ProfileEvent> m_retiredEvents; // left in the rings of exited threads
+	unsigned m_nextThreadIndex;
+
+	std::mutex m_stringsMutex;
+	std::unordered_set<std::string> m_strings;
+};
+
+
+
+/// <summary> Times the enclosing scope and records it to the <see cref="Profiler"/>.
+///		Does not even read the clock if the profiler is disabled. </summary>
+class ProfileScope {
+public:
+	ProfileScope(const char* category, const char* name, const char* detail = nullptr) {
+		if (Profiler::GetInstance().IsEnabled()) {
+			m_category = category;
+			m_name = name;
+			m_detail = detail;
+			m_begin = Profiler::Clock::now();
+		}
+	}
+	~ProfileScope() {
+		if (m_name != nullptr) {
+			Profiler::GetInstance().Record(m_category, m_name, m_detail, m_begin, Profiler::Clock::now());
+		}
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	const char* m_category = nullptr;
+	const char* m_name = nullptr;
+	const char* m_detail = nullptr;
+	Profiler::Clock::time_point m_begin;
+};
+
+
+} // namespace inl
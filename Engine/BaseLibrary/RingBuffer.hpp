@@ -2,11 +2,28 @@
 
 #include <list>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace inl {
 
 
-template <typename T, typename ContainerT = std::list<T>>
+/// <summary> Selects the contiguous, power-of-two sized storage for <see cref="RingBuffer"/>. </summary>
+struct ContiguousRingStorage;
+
+
+/// <summary>
+/// A ring of elements that can be rotated. The front element is the one after the back element.
+/// With a standard container as ContainerT, elements are stored in that container,
+/// which must support inserting and erasing in the middle, like std::list.
+/// By default, elements are stored contiguously, see RingBuffer&lt;T, ContiguousRingStorage&gt;.
+/// </summary>
+template <typename T, typename ContainerT = ContiguousRingStorage>
 class RingBuffer {
 protected:
 	using ContainerIter = typename ContainerT::iterator;
@@ -177,6 +194,9 @@ public:
 
 	void PopFront() {
 		m_currBegin = m_container.erase(m_currBegin);
+		if (m_currBegin == m_container.end()) {
+			m_currBegin = m_container.begin();
+		}
 	}
 
 	/// After this function, the element at front will become the element at back
@@ -225,6 +245,308 @@ private:
 	}
 };
 
+
+/// <summary>
+/// RingBuffer that keeps its elements in a contiguous, power-of-two sized array.
+/// Positions are computed by masking indices, no pointers are chased.
+/// </summary>
+/// <remarks>
+/// Unlike with a list, rotation moves the front element to the back if the storage is not full,
+/// so references to elements are invalidated by any modification.
+/// Iterators are positions in the ring, they remain comparable across modifications as before.
+/// </remarks>
+template <typename T>
+class RingBuffer<T, ContiguousRingStorage> {
+protected:
+	template <typename IterRingT, typename IterValueT>
+	class TemplateIterator {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = typename std::remove_const<T>::type;
+		using difference_type = ptrdiff_t;
+		using pointer = IterValueT*;
+		using reference = IterValueT&;
+
+		friend class RingBuffer;
+
+		reference operator*() const {
+			return m_pRing->At(m_position);
+		}
+		pointer operator->() const {
+			return &m_pRing->At(m_position);
+		}
+		TemplateIterator& operator++() {
+			m_offset += 1;
+			m_position = m_position + 1 == m_pRing->m_count ? 0 : m_position + 1;
+			return *this;
+		}
+		TemplateIterator operator++(int) {
+			TemplateIterator copy{*this};
+			++(*this);
+			return copy;
+		}
+		TemplateIterator& operator--() {
+			m_offset -= 1;
+			m_position = m_position == 0 ? (m_pRing->m_count == 0 ? 0 : m_pRing->m_count - 1) : m_position - 1;
+			return *this;
+		}
+		TemplateIterator operator--(int) {
+			TemplateIterator copy{*this};
+			--(*this);
+			return copy;
+		}
+		inline bool operator==(const TemplateIterator& other) const {
+			assert(m_pRing == other.m_pRing);
+			return m_offset == other.m_offset;
+		}
+		inline bool operator!=(const TemplateIterator& other) const {
+			assert(m_pRing == other.m_pRing);
+			return !(*this == other);
+		}
+		// Adds "count" number of rounds to the iterator, see the generic RingBuffer.
+		TemplateIterator AddRounds(int32_t count) const {
+			TemplateIterator result{*this};
+			result.m_offset += count * static_cast<int64_t>(m_pRing->m_count);
+			return result;
+		}
+	protected:
+		IterRingT* m_pRing;
+		size_t m_position; // relative to the front
+		int64_t m_offset;
+	}; // TemplateIterator
+
+public:
+
+	using Iterator = TemplateIterator<RingBuffer, T>;
+	using ConstIterator = TemplateIterator<const RingBuffer, const T>;
+
+public:
+
+	// Construction and assignement
+
+	RingBuffer() : m_capacity{0}, m_head{0}, m_count{0}, m_currOffset{0} {}
+
+	/// <summary> Creates an empty ring that does not allocate until it has more than capacity elements. </summary>
+	explicit RingBuffer(size_t capacity) : RingBuffer() {
+		Reserve(capacity);
+	}
+
+	RingBuffer(const RingBuffer& other) : RingBuffer() {
+		Reserve(other.m_count);
+		for (size_t i = 0; i < other.m_count; ++i) {
+			new (Slot(i)) T(other.At(i));
+			++m_count;
+		}
+		m_currOffset = other.m_currOffset;
+	}
+
+	RingBuffer(RingBuffer&& other) noexcept :
+		m_storage{std::move(other.m_storage)},
+		m_capacity{other.m_capacity},
+		m_head{other.m_head},
+		m_count{other.m_count},
+		m_currOffset{other.m_currOffset}
+	{
+		other.m_capacity = other.m_head = other.m_count = 0;
+	}
+
+	RingBuffer& operator=(RingBuffer other) noexcept {
+		Clear();
+		m_storage = std::move(other.m_storage);
+		m_capacity = other.m_capacity;
+		m_head = other.m_head;
+		m_count = other.m_count;
+		m_currOffset = other.m_currOffset;
+		other.m_capacity = other.m_head = other.m_count = 0;
+		return *this;
+	}
+
+	~RingBuffer() {
+		Clear();
+	}
+
+
+	// Properties
+
+	size_t Count() const {
+		return m_count;
+	}
+
+	/// <summary> Number of elements that fit without reallocation, always a power of two or zero. </summary>
+	size_t Capacity() const {
+		return m_capacity;
+	}
+
+	/// <summary> Makes room for at least capacity elements. </summary>
+	void Reserve(size_t capacity) {
+		if (capacity > m_capacity) {
+			size_t newCapacity = m_capacity == 0 ? 4 : m_capacity;
+			while (newCapacity < capacity) {
+				newCapacity *= 2;
+			}
+			Reallocate(newCapacity);
+		}
+	}
+
+
+	// Iterators
+
+	Iterator Begin() {
+		return MakeIterator<Iterator>(this, m_currOffset);
+	}
+
+	Iterator End() {
+		return MakeIterator<Iterator>(this, m_currOffset + static_cast<int64_t>(m_count));
+	}
+
+	ConstIterator Begin() const {
+		return MakeIterator<ConstIterator>(this, m_currOffset);
+	}
+
+	ConstIterator End() const {
+		return MakeIterator<ConstIterator>(this, m_currOffset + static_cast<int64_t>(m_count));
+	}
+
+
+	// Access
+
+	T& Front() {
+		assert(m_count > 0);
+		return At(0);
+	}
+
+	const T& Front() const {
+		assert(m_count > 0);
+		return At(0);
+	}
+
+	T& Back() {
+		assert(m_count > 0);
+		return At(m_count - 1);
+	}
+
+	const T& Back() const {
+		assert(m_count > 0);
+		return At(m_count - 1);
+	}
+
+
+	// Modify
+
+	void PushFront(const T& element) {
+		EmplaceFront(element);
+	}
+
+	void PushFront(T&& element) {
+		EmplaceFront(std::move(element));
+	}
+
+	template <class... Args>
+	void EmplaceFront(Args&&... args) {
+		if (m_count == m_capacity) {
+			Reallocate(m_capacity == 0 ? 4 : 2 * m_capacity);
+		}
+		size_t newHead = (m_head - 1) & (m_capacity - 1);
+		new (Storage() + newHead) T(std::forward<Args>(args)...);
+		m_head = newHead;
+		++m_count;
+	}
+
+	void PopFront() {
+		assert(m_count > 0);
+		Storage()[m_head].~T();
+		m_head = (m_head + 1) & (m_capacity - 1);
+		--m_count;
+	}
+
+	/// After this function, the element at front will become the element at back
+	void RotateFront() {
+		if (m_count == 0) {
+			return;
+		}
+		if (m_count < m_capacity) {
+			T* front = Storage() + m_head;
+			new (Slot(m_count)) T(std::move(*front));
+			front->~T();
+		}
+		m_head = (m_head + 1) & (m_capacity - 1);
+		m_currOffset += 1;
+	}
+
+	void RotateBack() {
+		if (m_count == 0) {
+			return;
+		}
+		size_t newHead = (m_head - 1) & (m_capacity - 1);
+		if (m_count < m_capacity) {
+			T* back = Slot(m_count - 1);
+			new (Storage() + newHead) T(std::move(*back));
+			back->~T();
+		}
+		m_head = newHead;
+		m_currOffset -= 1;
+	}
+
+	/// <summary> Destroys all elements, keeps the storage. </summary>
+	void Clear() {
+		while (m_count > 0) {
+			PopFront();
+		}
+	}
+
+protected:
+	using StorageT = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	T* Storage() const {
+		return reinterpret_cast<T*>(m_storage.get());
+	}
+
+	// Address of the element at position relative to the front, may be uninitialized.
+	T* Slot(size_t position) const {
+		return Storage() + ((m_head + position) & (m_capacity - 1));
+	}
+
+	T& At(size_t position) {
+		return *Slot(position);
+	}
+
+	const T& At(size_t position) const {
+		return *Slot(position);
+	}
+
+	void Reallocate(size_t newCapacity) {
+		assert((newCapacity & (newCapacity - 1)) == 0);
+		assert(newCapacity >= m_count);
+		std::unique_ptr<StorageT[]> newStorage(new StorageT[newCapacity]);
+		T* newElements = reinterpret_cast<T*>(newStorage.get());
+		for (size_t i = 0; i < m_count; ++i) {
+			T* element = Slot(i);
+			new (newElements + i) T(std::move(*element));
+			element->~T();
+		}
+		m_storage = std::move(newStorage);
+		m_capacity = newCapacity;
+		m_head = 0;
+	}
+
+	template <class IteratorT, class RingT>
+	static IteratorT MakeIterator(RingT* ring, int64_t offset) {
+		IteratorT iterator;
+		iterator.m_pRing = ring;
+		iterator.m_position = 0;
+		iterator.m_offset = offset;
+		return iterator;
+	}
+
+protected:
+	std::unique_ptr<StorageT[]> m_storage;
+	size_t m_capacity;
+	size_t m_head; // physical index of the front
+	size_t m_count;
+	int64_t m_currOffset;
+};
+
+
 // begin and end for "range-based for"
 template<typename T, typename C>
 typename RingBuffer<T, C>::Iterator begin(RingBuffer<T, C>& buffer) {
@@ -4,30 +4,107 @@
 #include <cassert>
 #include <stdexcept>
 #include <iostream>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 
 namespace inl {
 
 
-spin_mutex::spin_mutex() {
-	flag = false;
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Backoff tuning: spin 1, 2, 4 ... MaxPauses pauses, then yield a few times before sleeping.
+constexpr unsigned MaxPauses = 64;
+constexpr unsigned NumYields = 16;
+
+
+inline void CpuRelax() {
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+	_mm_pause();
+#endif
+}
+
+
+// Sleeping threads wait in a small global table of wait queues hashed by the address of the lock,
+// like a futex, so the mutex itself stays a few words.
+struct ParkingBucket {
+	std::mutex mutex;
+	std::condition_variable cv;
+};
+
+ParkingBucket& GetBucket(const void* address) {
+	constexpr size_t NumBuckets = 64;
+	static ParkingBucket buckets[NumBuckets];
+	uintptr_t hash = reinterpret_cast<uintptr_t>(address);
+	hash ^= hash >> 17;
+	return buckets[(hash >> 4) % NumBuckets];
+}
+
+
+// Sleeps while the value at address equals expected. May return spuriously.
+void Park(const std::atomic<uint32_t>& value, uint32_t expected) {
+	ParkingBucket& bucket = GetBucket(&value);
+	std::unique_lock<std::mutex> lk(bucket.mutex);
+	// checked under the bucket's lock, so a concurrent UnparkAll can't slip in between
+	if (value.load(std::memory_order_relaxed) == expected) {
+		bucket.cv.wait(lk);
+	}
+}
+
+
+void UnparkAll(const std::atomic<uint32_t>& value) {
+	ParkingBucket& bucket = GetBucket(&value);
+	std::lock_guard<std::mutex> lkg(bucket.mutex);
+	bucket.cv.notify_all(); // the bucket may be shared by other locks, so everyone rechecks
 }
 
+} // namespace
+
+
+
+//------------------------------------------------------------------------------
+// Spin mutex
+//------------------------------------------------------------------------------
+
+spin_mutex::spin_mutex()
+	: m_state(UNLOCKED),
+	m_collectStatistics(false),
+	m_acquisitions(0),
+	m_spins(0),
+	m_yields(0),
+	m_parks(0)
+{}
+
 void spin_mutex::lock() {
-	bool expected;
-	do {
-		while (flag != false)
-			;
-		expected = false;
-		flag.compare_exchange_strong(expected, true);
-	} while (expected);
-	ownerId = std::this_thread::get_id();
+	uint32_t expected = UNLOCKED;
+	if (!m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+		LockContended();
+	}
+	ownerId.store(std::this_thread::get_id(), std::memory_order_relaxed);
+	if (m_collectStatistics.load(std::memory_order_relaxed)) {
+		m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
 bool spin_mutex::try_lock() {
-	bool expected = false;
-	if (flag == false && flag.compare_exchange_strong(expected, true)) {
-		ownerId = std::this_thread::get_id();
+	uint32_t expected = UNLOCKED;
+	if (m_state.load(std::memory_order_relaxed) == UNLOCKED
+		&& m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+	{
+		ownerId.store(std::this_thread::get_id(), std::memory_order_relaxed);
+		if (m_collectStatistics.load(std::memory_order_relaxed)) {
+			m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+		}
 		return true;
 	}
 	else {
@@ -36,9 +113,11 @@ bool spin_mutex::try_lock() {
 }
 
 void spin_mutex::unlock() {
-	if (ownerId == std::this_thread::get_id()) {
-		bool expected = true;
-		flag.compare_exchange_strong(expected, false);
+	if (ownerId.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+		ownerId.store(std::thread::id(), std::memory_order_relaxed);
+		if (m_state.exchange(UNLOCKED, std::memory_order_release) == LOCKED_WITH_WAITERS) {
+			UnparkAll(m_state);
+		}
 	}
 	else {
 		throw InvalidCallException("Unlock must be called from the locking thread.");
@@ -46,4 +125,74 @@ void spin_mutex::unlock() {
 }
 
 
-} // namespace inl
\ No newline at end of file
+void spin_mutex::LockContended() {
+	uint64_t spins = 0;
+	uint64_t yields = 0;
+	uint64_t parks = 0;
+	auto TryAcquire = [this] {
+		uint32_t expected = UNLOCKED;
+		return m_state.load(std::memory_order_relaxed) == UNLOCKED
+			&& m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+	};
+	auto Record = [&, this] {
+		if (m_collectStatistics.load(std::memory_order_relaxed)) {
+			m_spins.fetch_add(spins, std::memory_order_relaxed);
+			m_yields.fetch_add(yields, std::memory_order_relaxed);
+			m_parks.fetch_add(parks, std::memory_order_relaxed);
+		}
+	};
+
+	// Spin with exponential backoff.
+	for (unsigned pauses = 1; pauses <= MaxPauses; pauses *= 2) {
+		for (unsigned i = 0; i < pauses; ++i) {
+			CpuRelax();
+		}
+		spins += pauses;
+		if (TryAcquire()) {
+			Record();
+			return;
+		}
+	}
+
+	// Give the owner a chance to run if it shares our core.
+	for (unsigned i = 0; i < NumYields; ++i) {
+		std::this_thread::yield();
+		++yields;
+		if (TryAcquire()) {
+			Record();
+			return;
+		}
+	}
+
+	// Sleep. Once a thread went this far, the lock is marked as having waiters,
+	// and it keeps that mark when acquired, since others may still be sleeping.
+	while (m_state.exchange(LOCKED_WITH_WAITERS, std::memory_order_acquire) != UNLOCKED) {
+		++parks;
+		Park(m_state, LOCKED_WITH_WAITERS);
+	}
+	Record();
+}
+
+
+void spin_mutex::EnableStatistics(bool enable) {
+	m_collectStatistics.store(enable, std::memory_order_relaxed);
+}
+
+spin_mutex::Statistics spin_mutex::GetStatistics() const {
+	Statistics statistics;
+	statistics.acquisitions = m_acquisitions.load(std::memory_order_relaxed);
+	statistics.spins = m_spins.load(std::memory_order_relaxed);
+	statistics.yields = m_yields.load(std::memory_order_relaxed);
+	statistics.parks = m_parks.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+void spin_mutex::ResetStatistics() {
+	m_acquisitions.store(0, std::memory_order_relaxed);
+	m_spins.store(0, std::memory_order_relaxed);
+	m_yields.store(0, std::memory_order_relaxed);
+	m_parks.store(0, std::memory_order_relaxed);
+}
+
+
+} // namespace inl
@@ -1,13 +1,26 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <thread>
 
 
 namespace inl {
 
 
+/// <summary>
+/// A mutex for short critical sections. Contended lockers spin with exponential backoff first,
+/// then yield their time slice, and finally go to sleep until the lock is released.
+/// Satisfies the Lockable requirements, so it works with std::lock_guard and std::unique_lock.
+/// </summary>
 class spin_mutex {
+public:
+	struct Statistics {
+		uint64_t acquisitions = 0; /// <summary> Number of times the lock was taken. </summary>
+		uint64_t spins = 0; /// <summary> Number of pause instructions executed while waiting. </summary>
+		uint64_t yields = 0; /// <summary> Number of times a waiter gave up its time slice. </summary>
+		uint64_t parks = 0; /// <summary> Number of times a waiter went to sleep. </summary>
+	};
 public:
 	spin_mutex();
 	spin_mutex(const spin_mutex&) = delete;
@@ -19,9 +32,31 @@ public:
 
 	void native_handle() = delete;
 
+	/// <summary> Turns contention counters on or off. They are off by default. </summary>
+	void EnableStatistics(bool enable);
+
+	/// <summary> Returns the counters accumulated while statistics were enabled. </summary>
+	Statistics GetStatistics() const;
+
+	/// <summary> Clears the counters. </summary>
+	void ResetStatistics();
 private:
+	void LockContended();
+private:
+	enum eState : uint32_t {
+		UNLOCKED = 0,
+		LOCKED = 1,
+		LOCKED_WITH_WAITERS = 2, // unlock must wake sleeping threads
+	};
+
+	std::atomic<uint32_t> m_state;
 	std::atomic<std::thread::id> ownerId;
-	std::atomic_bool flag;
+
+	std::atomic_bool m_collectStatistics;
+	std::atomic<uint64_t> m_acquisitions;
+	std::atomic<uint64_t> m_spins;
+	std::atomic<uint64_t> m_yields;
+	std::atomic<uint64_t> m_parks;
 };
 
 
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Fixed capacity, lock-free FIFO queue for handing objects from one thread to another.
+/// Exactly one thread may push and exactly one thread may pop at the same time.
+/// </summary>
+template <class T>
+class SpscRingBuffer {
+	// How it works:
+	// Head and tail are ever increasing counters, masked by the power-of-two capacity to get the slots.
+	// The producer only writes the tail, the consumer only writes the head, each publishes its
+	// counter with release and reads the other's with acquire. Both keep a cached copy of the
+	// other's counter, so they only touch the other's cache line when the ring looks full or empty.
+	static constexpr size_t CacheLineSize = 64;
+	using StorageT = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	struct alignas(CacheLineSize) ProducerState {
+		std::atomic<size_t> tail;
+		size_t cachedHead;
+	};
+	struct alignas(CacheLineSize) ConsumerState {
+		std::atomic<size_t> head;
+		size_t cachedTail;
+	};
+public:
+	/// <param name="capacity"> Rounded up to a power of two. </param>
+	explicit SpscRingBuffer(size_t capacity) {
+		m_capacity = 1;
+		while (m_capacity < capacity) {
+			m_capacity *= 2;
+		}
+		m_mask = m_capacity - 1;
+		m_storage.reset(new StorageT[m_capacity]);
+		m_producer.tail.store(0, std::memory_order_relaxed);
+		m_producer.cachedHead = 0;
+		m_consumer.head.store(0, std::memory_order_relaxed);
+		m_consumer.cachedTail = 0;
+	}
+	SpscRingBuffer(const SpscRingBuffer&) = delete;
+	SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+	~SpscRingBuffer() {
+		size_t tail = m_producer.tail.load(std::memory_order_acquire);
+		for (size_t head = m_consumer.head.load(std::memory_order_relaxed); head != tail; ++head) {
+			Slot(head)->~T();
+		}
+	}
+
+
+	// Producer
+
+	/// <summary> Adds an element to the back. Returns false if the ring is full. </summary>
+	template <class U>
+	bool TryPush(U&& element) {
+		size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+		if (tail - m_producer.cachedHead == m_capacity) {
+			m_producer.cachedHead = m_consumer.head.load(std::memory_order_acquire);
+			if (tail - m_producer.cachedHead == m_capacity) {
+				return false;
+			}
+		}
+		new (Slot(tail)) T(std::forward<U>(element));
+		m_producer.tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+
+	// Consumer
+
+	/// <summary> Moves the front element to the parameter. Returns false if the ring is empty. </summary>
+	bool TryPop(T& element) {
+		size_t head = m_consumer.head.load(std::memory_order_relaxed);
+		if (head == m_consumer.cachedTail) {
+			m_consumer.cachedTail = m_producer.tail.load(std::memory_order_acquire);
+			if (head == m_consumer.cachedTail) {
+				return false;
+			}
+		}
+		T* slot = Slot(head);
+		element = std::move(*slot);
+		slot->~T();
+		m_consumer.head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+
+	// Properties
+
+	size_t Capacity() const {
+		return m_capacity;
+	}
+
+	/// <summary> Number of elements, only exact if neither side is working concurrently. </summary>
+	size_t Count() const {
+		return m_producer.tail.load(std::memory_order_acquire) - m_consumer.head.load(std::memory_order_acquire);
+	}
+private:
+	T* Slot(size_t counter) const {
+		return reinterpret_cast<T*>(m_storage.get()) + (counter & m_mask);
+	}
+private:
+	std::unique_ptr<StorageT[]> m_storage;
+	size_t m_capacity;
+	size_t m_mask;
+
+	ProducerState m_producer;
+	ConsumerState m_consumer;
+};
+
+
+} // namespace inl
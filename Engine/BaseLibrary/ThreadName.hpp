@@ -32,9 +32,16 @@ inline void SetThreadName(LPCSTR szThreadName, CONST DWORD dwThreadID = -1)
 inline void SetCurrentThreadName(const char* name) {
 	SetThreadName(name, GetCurrentThreadId());
 }
+// Binds the calling thread to a single logical processor.
+inline void SetCurrentThreadAffinity(unsigned processorIndex) {
+	SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (processorIndex % (8 * sizeof(DWORD_PTR))));
+}
 #else
-inline void SetCurrentThreadName(const char* name) {
+inline void SetCurrentThreadName(const char* /*name*/) {
 	// thread name can only be set on windows, with visual studio
 }
+inline void SetCurrentThreadAffinity(unsigned /*processorIndex*/) {
+	// affinity is left to the OS on other platforms
+}
 #endif
 
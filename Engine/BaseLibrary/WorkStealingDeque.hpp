@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+
+namespace inl {
+
+
+/// <summary>
+/// Chase-Lev work stealing deque of pointers.
+/// The owner thread pushes and pops at the bottom, any other thread may steal from the top.
+/// Grows on demand, never shrinks.
+/// </summary>
+template <class T>
+class WorkStealingDeque {
+	static_assert(std::is_pointer<T>::value, "Elements must be pointers so that slots can be atomic.");
+
+	// How it works:
+	// Top and bottom are ever increasing indices into a circular array. The owner moves bottom,
+	// thieves move top by CAS. When one element is left, owner and thieves race for it on top.
+	// Arrays replaced by growing are kept until destruction, since a thief may still be reading them.
+	// All top/bottom accesses that need ordering are seq_cst instead of standalone fences,
+	// which is easier on race detectors and costs nothing measurable on x86.
+	static constexpr size_t CacheLineSize = 64;
+
+	struct Array {
+		explicit Array(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+		size_t Capacity() const { return mask + 1; }
+		T Get(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+		void Put(int64_t index, T value) { slots[index & mask].store(value, std::memory_order_relaxed); }
+
+		size_t mask;
+		std::unique_ptr<std::atomic<T>[]> slots;
+	};
+public:
+	/// <param name="capacity"> Initial capacity, rounded up to a power of two. </param>
+	explicit WorkStealingDeque(size_t capacity = 256) {
+		size_t roundedCapacity = 1;
+		while (roundedCapacity < capacity) {
+			roundedCapacity *= 2;
+		}
+		m_arrays.push_back(std::make_unique<Array>(roundedCapacity));
+		m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+		m_top.store(0, std::memory_order_relaxed);
+		m_bottom.store(0, std::memory_order_relaxed);
+	}
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+
+	/// <summary> Adds an element to the bottom. Owner thread only. </summary>
+	void Push(T value) {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		Array* array = m_array.load(std::memory_order_relaxed);
+		if (bottom - top >= int64_t(array->Capacity())) {
+			array = Grow(array, top, bottom);
+		}
+		array->Put(bottom, value);
+		m_bottom.store(bottom + 1, std::memory_order_release);
+	}
+
+	/// <summary> Removes the bottom element. Owner thread only. </summary>
+	/// <returns> The element or nullptr if the deque was empty. </returns>
+	T Pop() {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		Array* array = m_array.load(std::memory_order_relaxed);
+		m_bottom.store(bottom, std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_seq_cst);
+
+		if (top > bottom) {
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		T value = array->Get(bottom);
+		if (top == bottom) {
+			// last element, thieves may be after it too
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				value = nullptr;
+			}
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return value;
+	}
+
+	/// <summary> Removes the top element. Any thread. </summary>
+	/// <returns> The element or nullptr if the deque was empty or another thread won the race. </returns>
+	T Steal() {
+		int64_t top = m_top.load(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+		if (top >= bottom) {
+			return nullptr;
+		}
+		Array* array = m_array.load(std::memory_order_acquire);
+		T value = array->Get(top);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return value;
+	}
+
+
+	/// <summary> Number of elements, only a hint while other threads are working on the deque. </summary>
+	size_t Count() const {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+		return bottom > top ? size_t(bottom - top) : 0;
+	}
+
+	bool IsEmpty() const {
+		return Count() == 0;
+	}
+private:
+	Array* Grow(Array* array, int64_t top, int64_t bottom) {
+		auto grown = std::make_unique<Array>(array->Capacity() * 2);
+		for (int64_t i = top; i < bottom; ++i) {
+			grown->Put(i, array->Get(i));
+		}
+		Array* result = grown.get();
+		m_arrays.push_back(std::move(grown));
+		m_array.store(result, std::memory_order_release);
+		return result;
+	}
+private:
+	alignas(CacheLineSize) std::atomic<int64_t> m_top;
+	alignas(CacheLineSize) std::atomic<int64_t> m_bottom;
+	std::atomic<Array*> m_array;
+	std::vector<std::unique_ptr<Array>> m_arrays; // current and retired arrays, owner only
+};
+
+
+} // namespace inl
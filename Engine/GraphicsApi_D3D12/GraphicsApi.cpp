@@ -4,6 +4,7 @@
 #include "CommandAllocator.hpp"
 #include "CommandList.hpp"
 #include "DescriptorHeap.hpp"
+#include "Heap.hpp"
 #include "NativeCast.hpp"
 #include "ExceptionExpansions.hpp"
 
@@ -130,6 +131,46 @@ gxapi::IResource* GraphicsApi::CreateCommittedResource(gxapi::HeapProperties hea
 }
 
 
+gxapi::IHeap* GraphicsApi::CreateHeap(gxapi::HeapDesc desc) {
+	ComPtr<ID3D12Heap> native;
+
+	D3D12_HEAP_DESC nativeDesc = native_cast(desc);
+	ThrowIfFailed(m_device->CreateHeap(&nativeDesc, IID_PPV_ARGS(&native)));
+
+	return new Heap{ native, desc };
+}
+
+
+gxapi::IResource* GraphicsApi::CreatePlacedResource(gxapi::IHeap* heap,
+													uint64_t heapOffset,
+													gxapi::ResourceDesc desc,
+													gxapi::eResourceState initialState,
+													gxapi::ClearValue* clearValue) {
+	ComPtr<ID3D12Resource> native;
+
+	D3D12_RESOURCE_DESC nativeResourceDesc = native_cast(desc);
+
+	D3D12_CLEAR_VALUE* pNativeClearValue = nullptr;
+	D3D12_CLEAR_VALUE nativeClearValue;
+	if (clearValue != nullptr) {
+		nativeClearValue = native_cast(*clearValue);
+		pNativeClearValue = &nativeClearValue;
+	}
+
+	ThrowIfFailed(m_device->CreatePlacedResource(native_cast(heap), heapOffset, &nativeResourceDesc, native_cast(initialState), pNativeClearValue, IID_PPV_ARGS(&native)));
+
+	return new Resource{ native, m_device };
+}
+
+
+gxapi::ResourceAllocationInfo GraphicsApi::GetResourceAllocationInfo(gxapi::ResourceDesc desc) const {
+	D3D12_RESOURCE_DESC nativeResourceDesc = native_cast(desc);
+	D3D12_RESOURCE_ALLOCATION_INFO nativeInfo = m_device->GetResourceAllocationInfo(0, 1, &nativeResourceDesc);
+
+	return { nativeInfo.SizeInBytes, nativeInfo.Alignment };
+}
+
+
 gxapi::IRootSignature* GraphicsApi::CreateRootSignature(gxapi::RootSignatureDesc desc) {
 	ComPtr<ID3D12RootSignature> native;
 
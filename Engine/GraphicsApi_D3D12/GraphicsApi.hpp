@@ -33,6 +33,13 @@ public:
 											  gxapi::ResourceDesc desc,
 											  gxapi::eResourceState initialState,
 											  gxapi::ClearValue* clearValue = nullptr) override;
+	gxapi::IHeap* CreateHeap(gxapi::HeapDesc desc) override;
+	gxapi::IResource* CreatePlacedResource(gxapi::IHeap* heap,
+										   uint64_t heapOffset,
+										   gxapi::ResourceDesc desc,
+										   gxapi::eResourceState initialState,
+										   gxapi::ClearValue* clearValue = nullptr) override;
+	gxapi::ResourceAllocationInfo GetResourceAllocationInfo(gxapi::ResourceDesc desc) const override;
 
 
 	// Pipeline and binding
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../GraphicsApi_LL/IHeap.hpp"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <wrl.h>
+#include <d3d12.h>
+#include "../GraphicsApi_LL/DisableWin32Macros.h"
+
+namespace inl {
+namespace gxapi_dx12 {
+
+using Microsoft::WRL::ComPtr;
+
+class Heap : public gxapi::IHeap {
+public:
+	Heap(ComPtr<ID3D12Heap>& native, gxapi::HeapDesc desc);
+	Heap(const Heap&) = delete;
+	Heap& operator=(const Heap&) = delete;
+
+	ID3D12Heap* GetNative();
+
+	gxapi::HeapDesc GetDesc() const override;
+protected:
+	ComPtr<ID3D12Heap> m_native;
+	gxapi::HeapDesc m_desc;
+};
+
+
+} // namespace gxapi_dx12
+} // namespace inl
@@ -8,6 +8,7 @@
 #include "DescriptorHeap.hpp"
 #include "CommandList.hpp"
 #include "Fence.hpp"
+#include "Heap.hpp"
 #include "../GraphicsApi_LL/Common.hpp"
 
 #define WIN32_LEAN_AND_MEAN
@@ -53,6 +54,8 @@ ID3D12DescriptorHeap* native_cast(gxapi::IDescriptorHeap* source);
 
 ID3D12Fence* native_cast(gxapi::IFence* source);
 
+ID3D12Heap* native_cast(gxapi::IHeap* source);
+
 ID3D12CommandQueue* native_cast(gxapi::ICommandQueue* source);
 
 //---------------
@@ -155,6 +158,8 @@ D3D12_ROOT_DESCRIPTOR native_cast(gxapi::RootDescriptor source);
 
 D3D12_HEAP_PROPERTIES native_cast(gxapi::HeapProperties source);
 
+D3D12_HEAP_DESC native_cast(gxapi::HeapDesc source);
+
 D3D12_RESOURCE_DESC native_cast(gxapi::ResourceDesc source);
 
 D3D12_STATIC_SAMPLER_DESC native_cast(gxapi::StaticSamplerDesc source);
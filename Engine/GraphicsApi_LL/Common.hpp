@@ -713,6 +713,24 @@ struct HeapProperties {
 	eMemoryPool pool;
 };
 
+struct HeapDesc {
+	HeapDesc(uint64_t sizeInBytes = 0,
+		HeapProperties properties = {},
+		eHeapFlags flags = eHeapFlags::NONE,
+		uint64_t alignment = 0)
+		: sizeInBytes(sizeInBytes), properties(properties), alignment(alignment), flags(flags) {}
+	uint64_t sizeInBytes;
+	HeapProperties properties;
+	uint64_t alignment; // 0 for the default of 64KB
+	eHeapFlags flags;
+};
+
+/// <summary> Size and alignment a resource takes up when it's placed in a heap. </summary>
+struct ResourceAllocationInfo {
+	uint64_t sizeInBytes;
+	uint64_t alignment;
+};
+
 struct BufferDesc {
 	BufferDesc() = default;
 
@@ -1609,11 +1627,20 @@ struct UavBarrier : public ResourceBarrierTag {
 	IResource* resource;
 };
 
+/// <summary> Marks the start of a placed resource's use when it shares memory with others.
+///		Leaving <paramref name="before"/> null means any resource of the same memory may have been used before. </summary>
+struct AliasingBarrier : public ResourceBarrierTag {
+	AliasingBarrier(IResource* before = nullptr, IResource* after = nullptr) : before(before), after(after) {}
+	IResource* before;
+	IResource* after;
+};
+
 struct ResourceBarrier {
 	eResourceBarrierType type;
 	union {
 		TransitionBarrier transition;
 		UavBarrier uav;
+		AliasingBarrier aliasing;
 	};
 	ResourceBarrier() {}
 	ResourceBarrier(const ResourceBarrier& rhs) {
@@ -1627,6 +1654,10 @@ struct ResourceBarrier {
 		type = eResourceBarrierType::UAV;
 		uav = rhs;
 	}
+	ResourceBarrier(const AliasingBarrier& rhs) {
+		type = eResourceBarrierType::ALIASING;
+		aliasing = rhs;
+	}
 
 	ResourceBarrier& operator=(const ResourceBarrier& rhs) {
 		memcpy(this, &rhs, sizeof(*this));
@@ -1643,6 +1674,11 @@ struct ResourceBarrier {
 		uav = rhs;
 		return *this;
 	}
+	ResourceBarrier& operator=(const AliasingBarrier& rhs) {
+		type = eResourceBarrierType::ALIASING;
+		aliasing = rhs;
+		return *this;
+	}
 };
 
 
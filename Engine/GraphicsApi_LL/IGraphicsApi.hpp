@@ -14,6 +14,7 @@ class ICommandAllocator;
 class IFence;
 
 class IResource;
+class IHeap;
 
 class IRootSignature;
 class IPipelineState;
@@ -39,6 +40,15 @@ public:
 											   ResourceDesc desc,
 											   eResourceState initialState,
 											   ClearValue* clearValue = nullptr) = 0;
+	virtual IHeap* CreateHeap(HeapDesc desc) = 0;
+	/// <summary> Creates a resource in the given heap. Resources may overlap in a heap,
+	///		use an aliasing barrier before starting to use the one that was not used last. </summary>
+	virtual IResource* CreatePlacedResource(IHeap* heap,
+											uint64_t heapOffset,
+											ResourceDesc desc,
+											eResourceState initialState,
+											ClearValue* clearValue = nullptr) = 0;
+	virtual ResourceAllocationInfo GetResourceAllocationInfo(ResourceDesc desc) const = 0;
 
 	// Pipeline and binding
 	virtual IRootSignature* CreateRootSignature(RootSignatureDesc desc) = 0;
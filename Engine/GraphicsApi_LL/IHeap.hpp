@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Common.hpp"
+
+namespace inl {
+namespace gxapi {
+
+/// <summary> A block of GPU memory that resources can be placed in at an offset. </summary>
+class IHeap {
+public:
+	virtual ~IHeap() = default;
+
+	virtual HeapDesc GetDesc() const = 0;
+};
+
+} // namespace gxapi
+} // namespace inl
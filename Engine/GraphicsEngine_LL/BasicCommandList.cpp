@@ -56,6 +56,7 @@ void BasicCommandList::NewScratchSpace(size_t sizeHint) {
 
 BasicCommandList::BasicCommandList(BasicCommandList&& rhs)
 	: m_resourceTransitions(std::move(rhs.m_resourceTransitions)),
+	m_trackedResources(std::move(rhs.m_trackedResources)),
 	m_scratchSpacePool(rhs.m_scratchSpacePool),
 	m_commandAllocator(std::move(rhs.m_commandAllocator)),
 	m_commandList(std::move(rhs.m_commandList)),
@@ -66,6 +67,7 @@ BasicCommandList::BasicCommandList(BasicCommandList&& rhs)
 
 BasicCommandList& BasicCommandList::operator=(BasicCommandList&& rhs) {
 	m_resourceTransitions = std::move(rhs.m_resourceTransitions);
+	m_trackedResources = std::move(rhs.m_trackedResources);
 	m_scratchSpacePool = rhs.m_scratchSpacePool;
 	m_commandAllocator = std::move(rhs.m_commandAllocator);
 	m_commandList = std::move(rhs.m_commandList);
@@ -81,13 +83,21 @@ BasicCommandList::Decomposition BasicCommandList::Decompose() {
 	decomposition.commandAllocator = std::move(m_commandAllocator);
 	decomposition.commandList = std::move(m_commandList);
 	decomposition.scratchSpaces = std::move(m_scratchSpaces);
-	decomposition.usedResources.reserve(m_resourceTransitions.size());
+	decomposition.usedResources.reserve(m_resourceTransitions.Count());
 	decomposition.additionalResources = std::move(m_additionalResources);
 
-	// Copy the elements of state transition map to vector w/ transforming types.
-	for (const auto& v : m_resourceTransitions) {
-		decomposition.usedResources.push_back(ResourceUsage{ std::move(v.first.resource), v.first.subresource, v.second.firstState, v.second.lastState, v.second.multipleStates });
+	// The table gives the subresources sorted, the scheduler relies on it.
+	// A resource's MemoryObject is copied for each of its subresources but the last, which takes it.
+	std::vector<ResourceStateTable::Entry> entries = m_resourceTransitions.GetSortedEntries();
+	for (size_t i = 0; i < entries.size(); ++i) {
+		const auto& entry = entries[i];
+		bool isLastOfResource = i + 1 == entries.size() || entries[i + 1].resource != entry.resource;
+		MemoryObject& owner = m_trackedResources[entry.owner];
+		MemoryObject resource = isLastOfResource ? std::move(owner) : MemoryObject(owner);
+		decomposition.usedResources.push_back(ResourceUsage{ std::move(resource), entry.subresource, entry.usage.firstState, entry.usage.lastState, entry.usage.multipleStates });
 	}
+	m_resourceTransitions.Clear();
+	m_trackedResources.clear();
 
 	return decomposition;
 }
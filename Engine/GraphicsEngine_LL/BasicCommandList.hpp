@@ -8,6 +8,7 @@
 #include "CommandListPool.hpp"
 #include "ScratchSpacePool.hpp"
 #include "HostDescHeap.hpp"
+#include "ResourceStateTable.hpp"
 
 #include <vector>
 #include <memory>
@@ -18,24 +19,6 @@
 namespace inl {
 namespace gxeng {
 
-struct SubresourceId {
-	SubresourceId() = default;
-	SubresourceId(const MemoryObject& resource, unsigned subresource) : resource(resource), subresource(subresource) {}
-
-	bool operator==(const SubresourceId& other) const {
-		return resource == other.resource && subresource == other.subresource;
-	}
-
-	MemoryObject resource;
-	unsigned subresource;
-};
-
-struct SubresourceUsageInfo {
-	gxapi::eResourceState firstState; /// <summary> Holds the target state of the first transition. </summary>
-	gxapi::eResourceState lastState; /// <summary> Holds the target state of the last transition. </summary>
-	bool multipleStates; /// <sumamry> True if resource was used in more than one state. </summary>
-};
-
 struct ResourceUsage {
 	MemoryObject resource;
 	unsigned subresource;
@@ -45,29 +28,6 @@ struct ResourceUsage {
 };
 
 
-} // namespace gxeng
-} // namespace inl
-
-
-namespace std {
-
-using namespace inl;
-
-template<>
-struct hash<gxeng::SubresourceId> {
-	std::size_t operator()(const gxeng::SubresourceId& instance) const {
-		return std::hash<const void*>{}(instance.resource._GetResourcePtr()) ^ std::hash<unsigned>{}(instance.subresource);
-	}
-};
-
-} // namespace std
-
-
-
-namespace inl {
-namespace gxeng {
-
-
 class BasicCommandList {
 public:
 
@@ -87,6 +47,7 @@ public:
 
 	gxapi::eCommandListType GetType() const { return m_commandList->GetType(); }
 
+	/// <summary> Hands over the recorded parts, used resources are sorted by resource pointer, then by subresource. </summary>
 	virtual Decomposition Decompose();
 protected:
 	BasicCommandList(
@@ -101,7 +62,8 @@ protected:
 	StackDescHeap* GetCurrentScratchSpace();
 	virtual void NewScratchSpace(size_t sizeHint);
 protected:
-	std::unordered_map<SubresourceId, SubresourceUsageInfo> m_resourceTransitions;
+	ResourceStateTable m_resourceTransitions;
+	std::vector<MemoryObject> m_trackedResources; // indexed by the owner numbers of m_resourceTransitions
 	std::vector<MemoryObject> m_additionalResources;
 	gxapi::IGraphicsApi* m_graphicsApi;
 private:
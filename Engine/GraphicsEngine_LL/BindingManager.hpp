@@ -22,6 +22,7 @@ class BindingManager : protected RootTableManager<Type> {
 	using RootTableManager<Type>::m_binder;
 	using RootTableManager<Type>::m_heap;
 	using RootTableManager<Type>::UpdateBinding;
+	using RootTableManager<Type>::ChangeRootDescriptor;
 public:
 	BindingManager();
 	BindingManager(gxapi::IGraphicsApi* graphicsApi, CommandListT* commandList, MemoryManager* memoryManager, VolatileViewHeap* volatileCbvHeap);
@@ -29,6 +30,8 @@ public:
 	using RootTableManager<Type>::SetBinder;
 	using RootTableManager<Type>::SetDescriptorHeap;
 	using RootTableManager<Type>::CommitDrawCall;
+	using RootTableManager<Type>::ResetBindings;
+	using RootTableManager<Type>::GetSkippedCalls;
 
 	void Bind(BindParameter parameter, const TextureView1D& shaderResource);
 	void Bind(BindParameter parameter, const TextureView2D& shaderResource);
@@ -121,7 +124,10 @@ void BindingManager<Type>::Bind(BindParameter parameter, const ConstBufferView&
 	const auto& rootParam = desc.rootParameters[slot];
 
 	if (rootParam.type == gxapi::RootParameterDesc::CBV) {
-		SetRootConstantBuffer(m_commandList, slot, shaderConstant.GetResource().GetVirtualAddress());
+		void* gpuVirtualAddress = shaderConstant.GetResource().GetVirtualAddress();
+		if (ChangeRootDescriptor(slot, gpuVirtualAddress)) {
+			SetRootConstantBuffer(m_commandList, slot, gpuVirtualAddress);
+		}
 	}
 	else if (rootParam.type == gxapi::RootParameterDesc::DESCRIPTOR_TABLE) {
 		UpdateBinding(shaderConstant.GetHandle(), slot, tableIndex);
@@ -151,6 +157,7 @@ void BindingManager<Type>::Bind(BindParameter parameter, const void* shaderConst
 	else if (desc.rootParameters[slot].type == gxapi::RootParameterDesc::CBV) {
 		// we have to create a volatile CB right here, to accomodate immediate arguments which don't fit in root signature
 		VolatileConstBuffer cbuffer = m_memoryManager->CreateVolatileConstBuffer(shaderConstant, size);
+		ChangeRootDescriptor(slot, cbuffer.GetVirtualAddress()); // always new, but later binds compare to it
 		SetRootConstantBuffer(m_commandList, slot, cbuffer.GetVirtualAddress());
 	}
 	else if (desc.rootParameters[slot].type == gxapi::RootParameterDesc::DESCRIPTOR_TABLE) {
@@ -46,7 +46,9 @@ ComputeCommandList::ComputeCommandList(
 
 ComputeCommandList::ComputeCommandList(ComputeCommandList&& rhs)
 	: CopyCommandList(std::move(rhs)),
-	m_commandList(rhs.m_commandList)
+	m_skippedCalls(rhs.m_skippedCalls),
+	m_commandList(rhs.m_commandList),
+	m_pipelineState(rhs.m_pipelineState)
 {
 	rhs.m_commandList = nullptr;
 }
@@ -54,7 +56,9 @@ ComputeCommandList::ComputeCommandList(ComputeCommandList&& rhs)
 
 ComputeCommandList& ComputeCommandList::operator=(ComputeCommandList&& rhs) {
 	CopyCommandList::operator=(std::move(rhs));
+	m_skippedCalls = rhs.m_skippedCalls;
 	m_commandList = rhs.m_commandList;
+	m_pipelineState = rhs.m_pipelineState;
 	rhs.m_commandList = nullptr;
 
 	return *this;
@@ -81,10 +85,30 @@ void ComputeCommandList::Dispatch(size_t numThreadGroupsX, size_t numThreadGroup
 //------------------------------------------------------------------------------
 void ComputeCommandList::ResetState(gxapi::IPipelineState* newState) {
 	m_commandList->ResetState(newState);
+	ForgetBoundState();
+	m_pipelineState = newState;
 }
 
 void ComputeCommandList::SetPipelineState(gxapi::IPipelineState* pipelineState) {
+	if (pipelineState == m_pipelineState) {
+		++m_skippedCalls.pipelineStates;
+		return;
+	}
 	m_commandList->SetPipelineState(pipelineState);
+	m_pipelineState = pipelineState;
+}
+
+
+SkippedCallCounters ComputeCommandList::GetSkippedCalls() const {
+	SkippedCallCounters counters = m_skippedCalls;
+	counters += m_computeBindingManager.GetSkippedCalls();
+	return counters;
+}
+
+
+void ComputeCommandList::ForgetBoundState() {
+	m_pipelineState = nullptr;
+	m_computeBindingManager.ResetBindings();
 }
 
 
@@ -38,6 +38,9 @@ public:
 	void ResetState(gxapi::IPipelineState* newState = nullptr);
 	void SetPipelineState(gxapi::IPipelineState* pipelineState);
 
+	/// <summary> Returns the native calls left out so far because they would have set what was already bound. </summary>
+	virtual SkippedCallCounters GetSkippedCalls() const;
+
 	// set compute root signature stuff
 	void SetComputeBinder(Binder* binder);
 
@@ -56,8 +59,14 @@ public:
 protected:
 	virtual Decomposition Decompose() override;
 	virtual void NewScratchSpace(size_t hint) override;
+
+	/// <summary> Forgets what was bound, called when the state of the native list was reset. </summary>
+	virtual void ForgetBoundState();
+protected:
+	SkippedCallCounters m_skippedCalls;
 private:
 	gxapi::IComputeCommandList* m_commandList;
+	gxapi::IPipelineState* m_pipelineState = nullptr; // last one set on the native list
 
 	// scratch space managment
 	BindingManager<gxapi::eCommandListType::COMPUTE> m_computeBindingManager;
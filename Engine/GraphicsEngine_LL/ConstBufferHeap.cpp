@@ -145,6 +145,7 @@ void ConstantBufferHeap::OnFrameCompleteDevice(uint64_t frameId) {
 
 
 void ConstantBufferHeap::OnFrameCompleteHost(uint64_t frameId) {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	m_currFrameID++;
 }
 
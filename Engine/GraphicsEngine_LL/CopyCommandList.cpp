@@ -59,18 +59,21 @@ void CopyCommandList::SetResourceState(const MemoryObject& resource, gxapi::eRes
 	}
 	// Do a single subresource
 	else {
-		SubresourceId resId{ resource, subresource };
-		auto iter = m_resourceTransitions.find(resId);
-		bool firstTransition = iter == m_resourceTransitions.end();
+		SubresourceUsageInfo* usage = m_resourceTransitions.Find(resource._GetResourcePtr(), subresource);
+		bool firstTransition = usage == nullptr;
 		if (firstTransition) {
 			SubresourceUsageInfo info;
 			info.lastState = state;
 			info.firstState = state;
 			info.multipleStates = false;
-			m_resourceTransitions.insert({ std::move(resId), info });
+			bool isNewResource;
+			m_resourceTransitions.Insert(resource._GetResourcePtr(), subresource, info, isNewResource);
+			if (isNewResource) {
+				m_trackedResources.push_back(resource);
+			}
 		}
 		else {
-			const auto& prevState = iter->second.lastState;
+			const auto prevState = usage->lastState;
 
 			if (prevState != state) {
 				m_commandList->ResourceBarrier(
@@ -81,8 +84,8 @@ void CopyCommandList::SetResourceState(const MemoryObject& resource, gxapi::eRes
 					subresource
 				}
 				);
-				iter->second.lastState = state;
-				iter->second.multipleStates = true;
+				usage->lastState = state;
+				usage->multipleStates = true;
 			}
 		}
 	}
@@ -148,6 +151,7 @@ void CopyCommandList::ExpectResourceState(const MemoryObject& resource, const st
 		SubresourceIterator(const MemoryObject& resource, const std::vector<uint32_t>& subresources) {
 			count = resource.GetNumSubresources();
 			sub = &subresources;
+			iter = 0;
 			all = false;
 			for (auto s : subresources) {
 				if (s == gxapi::ALL_SUBRESOURCES) {
@@ -176,14 +180,13 @@ void CopyCommandList::ExpectResourceState(const MemoryObject& resource, const st
 	while (subiter.HasNext()) {
 		uint32_t subres = subiter.Get();
 
-		SubresourceId key{ resource, subres };
-		auto iter = m_resourceTransitions.find(key);
+		const SubresourceUsageInfo* usage = m_resourceTransitions.Find(resource._GetResourcePtr(), subres);
 
-		if (iter == m_resourceTransitions.end()) {
+		if (usage == nullptr) {
 			throw InvalidStateException("You must SetSubresourceState before binding the resource view to the pipeline.");
 		}
 		else {
-			gxapi::eResourceState currentState = iter->second.lastState;
+			gxapi::eResourceState currentState = usage->lastState;
 			bool ok = false;
 			for (auto it = anyOfStates.begin(); it != anyOfStates.end(); ++it) {
 				ok = ok || (currentState & *it);
@@ -14,6 +14,9 @@
 
 
 namespace inl {
+
+class JobSystem;
+
 namespace gxeng {
 
 
@@ -23,6 +26,7 @@ class ScratchSpacePool;
 class Scene;
 class PerspectiveCamera;
 class RenderTargetView2D;
+class FrameScratchAllocator;
 
 struct FrameContext {
 	std::chrono::nanoseconds frameTime;
@@ -40,12 +44,16 @@ struct FrameContext {
 	ShaderManager* shaderManager = nullptr;
 
 	CommandQueue* commandQueue = nullptr;
+	CommandQueue* computeQueue = nullptr; // if set, compute tasks run on it, otherwise on the graphics queue
+	CommandQueue* copyQueue = nullptr; // if set, copy tasks run on it, otherwise on the graphics queue
 	RenderTargetView2D* backBuffer = nullptr;
 	const std::set<Scene*>* scenes = nullptr;
 	const std::set<BasicCamera*>* cameras = nullptr;
 	const std::vector<UploadManager::UploadDescription>* uploadRequests = nullptr;
 	
 	ResourceResidencyQueue* residencyQueue = nullptr;
+	FrameScratchAllocator* frameScratchAllocator = nullptr;
+	JobSystem* jobSystem = nullptr; // if set, independent tasks record their command lists in parallel
 
 	uint64_t frame;
 };
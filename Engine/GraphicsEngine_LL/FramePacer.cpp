@@ -0,0 +1,98 @@
+#include "FramePacer.hpp"
+
+#include <BaseLibrary/Exception/Exception.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+
+namespace inl::gxeng {
+
+
+double FramePacer::Statistics::GetAverageLatencyMs() const {
+	return numFrames > 0 ? std::chrono::duration<double, std::milli>(totalLatency).count() / numFrames : 0.0;
+}
+
+
+double FramePacer::Statistics::GetFramesPerSecond() const {
+	return elapsed.count() > 0 ? numFrames / std::chrono::duration<double>(elapsed).count() : 0.0;
+}
+
+
+double FramePacer::Statistics::GetAverageOverlap() const {
+	return elapsed.count() > 0 ? double(totalLatency.count()) / double(elapsed.count()) : 0.0;
+}
+
+
+FramePacer::FramePacer(unsigned maxFramesInFlight) {
+	SetMaxFramesInFlight(maxFramesInFlight);
+}
+
+
+void FramePacer::SetMaxFramesInFlight(unsigned maxFramesInFlight) {
+	if (maxFramesInFlight < 1 || maxFramesInFlight > MaxFramesInFlight) {
+		throw InvalidArgumentException("Frames in flight must be between 1 and " + std::to_string(MaxFramesInFlight) + ".", "maxFramesInFlight");
+	}
+	m_maxFramesInFlight = maxFramesInFlight;
+}
+
+
+void FramePacer::BeginFrame() {
+	assert(m_frames.empty() || m_frames.back().completion);
+
+	Clock::time_point begin = Clock::now();
+	while (!m_frames.empty() && m_frames.front().completion.IsReached()) {
+		Retire(m_frames.front(), begin);
+		m_frames.pop_front();
+	}
+	while (m_frames.size() >= m_maxFramesInFlight) {
+		m_frames.front().completion.Wait();
+		Retire(m_frames.front(), Clock::now());
+		m_frames.pop_front();
+	}
+
+	Clock::time_point unblocked = Clock::now();
+	m_statistics.totalBlocked += unblocked - begin;
+	if (!m_hasBegun) {
+		m_firstBegin = unblocked;
+		m_hasBegun = true;
+	}
+	m_frames.push_back({ unblocked, {} });
+}
+
+
+void FramePacer::EndFrame(SyncPoint completion) {
+	assert(!m_frames.empty() && !m_frames.back().completion);
+	m_frames.back().completion = completion;
+}
+
+
+void FramePacer::WaitIdle() {
+	while (!m_frames.empty() && m_frames.front().completion) {
+		m_frames.front().completion.Wait();
+		Retire(m_frames.front(), Clock::now());
+		m_frames.pop_front();
+	}
+}
+
+
+void FramePacer::ResetStatistics() {
+	m_statistics = Statistics();
+	m_hasBegun = false;
+}
+
+
+void FramePacer::Retire(const Frame& frame, Clock::time_point end) {
+	if (!m_hasBegun || frame.begin < m_firstBegin) {
+		return; // begun before the statistics were reset
+	}
+	auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end - frame.begin);
+	++m_statistics.numFrames;
+	m_statistics.totalLatency += latency;
+	m_statistics.maxLatency = std::max(m_statistics.maxLatency, latency);
+	m_statistics.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_firstBegin);
+}
+
+
+} // namespace inl::gxeng
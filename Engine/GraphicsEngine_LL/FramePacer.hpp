@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SyncPoint.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+
+namespace inl::gxeng {
+
+
+/// <summary>
+/// Lets the CPU record frames while the GPU is still executing earlier ones, but at most a fixed number of frames are in flight.
+/// A frame is in flight from <see cref="BeginFrame"/> until the GPU finishes it.
+/// <see cref="BeginFrame"/> only blocks if the ring of in-flight frames is full.
+/// </summary>
+/// <remarks>
+/// Anything a frame's command lists use must stay alive until the frame completes on the GPU,
+/// per-frame memory is recycled by the device frame-end events, not when the CPU is done with the frame.
+/// Completion is noticed by polling in <see cref="BeginFrame"/>, so latencies may be late by up to one CPU frame
+/// when the ring is not full.
+/// </remarks>
+class FramePacer {
+public:
+	using Clock = std::chrono::high_resolution_clock;
+	static constexpr unsigned MaxFramesInFlight = 3;
+
+	struct Statistics {
+		uint64_t numFrames = 0; /// <summary> Frames completed on the GPU. </summary>
+		std::chrono::nanoseconds totalLatency{ 0 }; /// <summary> Sum of the times from the frames' begin to their GPU completion, not counting the wait for a slot. </summary>
+		std::chrono::nanoseconds maxLatency{ 0 };
+		std::chrono::nanoseconds totalBlocked{ 0 }; /// <summary> Time <see cref="BeginFrame"/> waited for a free slot. </summary>
+		std::chrono::nanoseconds elapsed{ 0 }; /// <summary> From the first frame's begin to the last completion. </summary>
+
+		double GetAverageLatencyMs() const;
+		double GetFramesPerSecond() const;
+		/// <summary> Average number of frames in flight, above 1 if the CPU and the GPU overlapped. </summary>
+		double GetAverageOverlap() const;
+	};
+public:
+	/// <param name="maxFramesInFlight"> 1 to <see cref="MaxFramesInFlight"/>, 1 makes the CPU wait for each frame. </param>
+	FramePacer(unsigned maxFramesInFlight = 2);
+
+	/// <summary> Takes effect at the next <see cref="BeginFrame"/>. </summary>
+	void SetMaxFramesInFlight(unsigned maxFramesInFlight);
+	unsigned GetMaxFramesInFlight() const { return m_maxFramesInFlight; }
+	/// <summary> Frames begun but not yet known to be completed, including the one being recorded. </summary>
+	size_t GetNumFramesInFlight() const { return m_frames.size(); }
+
+	/// <summary> Waits until fewer than the maximum number of frames are in flight, then starts a new frame. </summary>
+	void BeginFrame();
+
+	/// <summary> Ends recording the current frame. <paramref name="completion"/> is signaled when the GPU has finished it. </summary>
+	void EndFrame(SyncPoint completion);
+
+	/// <summary> Waits for all submitted frames to complete. </summary>
+	void WaitIdle();
+
+	const Statistics& GetStatistics() const { return m_statistics; }
+	void ResetStatistics();
+private:
+	struct Frame {
+		Clock::time_point begin;
+		SyncPoint completion; // empty while it's being recorded
+	};
+
+	void Retire(const Frame& frame, Clock::time_point end);
+private:
+	unsigned m_maxFramesInFlight;
+	std::deque<Frame> m_frames; // oldest first
+	Statistics m_statistics;
+	Clock::time_point m_firstBegin;
+	bool m_hasBegun = false; // since the statistics were reset
+};
+
+
+} // namespace inl::gxeng
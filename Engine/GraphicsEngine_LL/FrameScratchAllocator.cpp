@@ -0,0 +1,91 @@
+#include "FrameScratchAllocator.hpp"
+
+#include <BaseLibrary/Memory/AllocationTracker.hpp>
+
+#include <atomic>
+
+
+namespace inl {
+namespace gxeng {
+
+
+static std::atomic<uint64_t> s_nextInstanceId(1);
+
+
+FrameScratchAllocator::FrameScratchAllocator(size_t blockSize)
+	: m_instanceId(s_nextInstanceId++),
+	m_blockSize(blockSize),
+	m_log(nullptr),
+	m_reportedCapacity(0)
+{}
+
+
+FrameScratchAllocator::~FrameScratchAllocator() {
+	AllocationTracker::GetInstance().RecordDeallocation(eAllocationTag::GRAPHICS, m_reportedCapacity);
+}
+
+
+LinearAllocator& FrameScratchAllocator::GetThreadAllocator() {
+	// ids are never reused, so the cache cannot point into a destroyed instance
+	struct Cache {
+		uint64_t instanceId = 0;
+		LinearAllocator* allocator = nullptr;
+	};
+	thread_local Cache cache;
+	if (cache.instanceId == m_instanceId) {
+		return *cache.allocator;
+	}
+
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	auto& allocator = m_threadAllocators[std::this_thread::get_id()];
+	if (!allocator) {
+		allocator = std::make_unique<LinearAllocator>(m_blockSize);
+	}
+	cache.instanceId = m_instanceId;
+	cache.allocator = allocator.get();
+	return *allocator;
+}
+
+
+auto FrameScratchAllocator::GetLastFrameStatistics() const -> Statistics {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_lastFrame;
+}
+
+
+void FrameScratchAllocator::OnFrameCompleteHost(uint64_t frameId) {
+	Statistics statistics;
+	statistics.frameId = frameId;
+	size_t capacity = 0;
+	{
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		for (auto& threadAllocator : m_threadAllocators) {
+			LinearAllocator& allocator = *threadAllocator.second;
+			statistics.bytesAllocated += allocator.GetBytesAllocated();
+			statistics.heapAllocations += allocator.GetHeapAllocationCount();
+			allocator.Reset();
+			capacity += allocator.Capacity();
+		}
+		statistics.threadCount = m_threadAllocators.size();
+		m_lastFrame = statistics;
+
+		if (capacity > m_reportedCapacity) {
+			AllocationTracker::GetInstance().RecordAllocation(eAllocationTag::GRAPHICS, capacity - m_reportedCapacity);
+		}
+		else if (capacity < m_reportedCapacity) {
+			AllocationTracker::GetInstance().RecordDeallocation(eAllocationTag::GRAPHICS, m_reportedCapacity - capacity);
+		}
+		m_reportedCapacity = capacity;
+	}
+
+	if (m_log && statistics.heapAllocations > 0) {
+		m_log->Event(LogEvent{ "Frame scratch memory grown",
+							   EventParameterInt("frameId", (int)frameId),
+							   EventParameterInt("heapAllocations", (int)statistics.heapAllocations),
+							   EventParameterInt("bytesAllocated", (int)statistics.bytesAllocated) });
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
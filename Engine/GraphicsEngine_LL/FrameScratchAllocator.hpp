@@ -0,0 +1,69 @@
+#pragma once
+
+#include "PipelineEventListener.hpp"
+
+#include <BaseLibrary/Memory/LinearAllocator.hpp>
+#include <BaseLibrary/Logging/LogStream.hpp>
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Hands out a <see cref="LinearAllocator"/> to each thread for temporary data that does not outlive the frame,
+/// like command list barriers and material constants. All of them are reset when the host finishes the frame.
+/// </summary>
+/// <remarks> Memory obtained during a frame must not be used after <see cref="OnFrameCompleteHost"/>.
+///		The allocators must not be used while the reset is in progress. </remarks>
+class FrameScratchAllocator : public PipelineEventListener {
+public:
+	struct Statistics {
+		uint64_t frameId = 0;
+		size_t threadCount = 0;
+		size_t bytesAllocated = 0;
+		size_t heapAllocations = 0; /// <summary> Number of times an allocator had to grow during the frame. </summary>
+	};
+public:
+	FrameScratchAllocator(size_t blockSize = 64 * 1024);
+	FrameScratchAllocator(const FrameScratchAllocator&) = delete;
+	FrameScratchAllocator& operator=(const FrameScratchAllocator&) = delete;
+	~FrameScratchAllocator();
+
+	/// <summary> If set, frames that had to use the heap are reported here. </summary>
+	void SetLog(LogStream* log) { m_log = log; }
+
+	/// <summary> Returns the calling thread's allocator. </summary>
+	LinearAllocator& GetThreadAllocator();
+
+	/// <summary> Returns an STL allocator that uses the calling thread's allocator. </summary>
+	template <class T>
+	LinearAllocatorAdaptor<T> GetAdaptor() { return LinearAllocatorAdaptor<T>(&GetThreadAllocator()); }
+
+	/// <summary> Usage of the last completed frame. </summary>
+	Statistics GetLastFrameStatistics() const;
+
+	void OnFrameBeginDevice(uint64_t frameId) override {}
+	void OnFrameBeginHost(uint64_t frameId) override {}
+	void OnFrameBeginAwait(uint64_t frameId) override {}
+	void OnFrameCompleteDevice(uint64_t frameId) override {}
+	void OnFrameCompleteHost(uint64_t frameId) override;
+private:
+	uint64_t m_instanceId;
+	size_t m_blockSize;
+	LogStream* m_log;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::thread::id, std::unique_ptr<LinearAllocator>> m_threadAllocators;
+	Statistics m_lastFrame;
+	size_t m_reportedCapacity; // capacity of all allocators as last reported to the allocation tracker
+};
+
+
+} // namespace gxeng
+} // namespace inl
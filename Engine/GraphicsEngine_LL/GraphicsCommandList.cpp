@@ -28,7 +28,11 @@ GraphicsCommandList::GraphicsCommandList(
 
 GraphicsCommandList::GraphicsCommandList(GraphicsCommandList&& rhs)
 	: ComputeCommandList(std::move(rhs)),
-	m_commandList(rhs.m_commandList)
+	m_commandList(rhs.m_commandList),
+	m_vertexBuffers(std::move(rhs.m_vertexBuffers)),
+	m_indexBufferAddress(rhs.m_indexBufferAddress),
+	m_indexBufferSize(rhs.m_indexBufferSize),
+	m_indexBufferFormat(rhs.m_indexBufferFormat)
 {
 	rhs.m_commandList = nullptr;
 }
@@ -37,6 +41,10 @@ GraphicsCommandList::GraphicsCommandList(GraphicsCommandList&& rhs)
 GraphicsCommandList& GraphicsCommandList::operator=(GraphicsCommandList&& rhs) {
 	ComputeCommandList::operator=(std::move(rhs));
 	m_commandList = rhs.m_commandList;
+	m_vertexBuffers = std::move(rhs.m_vertexBuffers);
+	m_indexBufferAddress = rhs.m_indexBufferAddress;
+	m_indexBufferSize = rhs.m_indexBufferSize;
+	m_indexBufferFormat = rhs.m_indexBufferFormat;
 	rhs.m_commandList = nullptr;
 
 	return *this;
@@ -50,6 +58,21 @@ BasicCommandList::Decomposition GraphicsCommandList::Decompose() {
 }
 
 
+SkippedCallCounters GraphicsCommandList::GetSkippedCalls() const {
+	SkippedCallCounters counters = ComputeCommandList::GetSkippedCalls();
+	counters += m_graphicsBindingManager.GetSkippedCalls();
+	return counters;
+}
+
+
+void GraphicsCommandList::ForgetBoundState() {
+	ComputeCommandList::ForgetBoundState();
+	m_graphicsBindingManager.ResetBindings();
+	m_vertexBuffers.clear();
+	m_indexBufferAddress = nullptr;
+}
+
+
 //------------------------------------------------------------------------------
 // Clear buffers
 //------------------------------------------------------------------------------
@@ -105,9 +128,18 @@ void GraphicsCommandList::DrawInstanced(unsigned numVertices,
 
 void GraphicsCommandList::SetIndexBuffer(const IndexBuffer* resource, bool is32Bit) {
 	ExpectResourceState(*resource, gxapi::eResourceState::INDEX_BUFFER, { gxapi::ALL_SUBRESOURCES });
-	m_commandList->SetIndexBuffer(resource->GetVirtualAddress(),
-		resource->GetSize(),
-		is32Bit ? gxapi::eFormat::R32_UINT : gxapi::eFormat::R16_UINT);
+
+	void* address = resource->GetVirtualAddress();
+	size_t size = resource->GetSize();
+	gxapi::eFormat format = is32Bit ? gxapi::eFormat::R32_UINT : gxapi::eFormat::R16_UINT;
+	if (address == m_indexBufferAddress && size == m_indexBufferSize && format == m_indexBufferFormat) {
+		++m_skippedCalls.indexBuffers;
+		return;
+	}
+	m_commandList->SetIndexBuffer(address, size, format);
+	m_indexBufferAddress = address;
+	m_indexBufferSize = size;
+	m_indexBufferFormat = format;
 }
 
 
@@ -124,9 +156,25 @@ void GraphicsCommandList::SetVertexBuffers(unsigned startSlot,
 {
 	auto virtualAddresses = std::make_unique<void*[]>(count);
 
+	bool isRedundant = startSlot + count <= m_vertexBuffers.size();
 	for (unsigned i = 0; i < count; ++i) {
 		ExpectResourceState(*(resources[i]), gxapi::eResourceState::VERTEX_AND_CONSTANT_BUFFER, { gxapi::ALL_SUBRESOURCES });
 		virtualAddresses[i] = resources[i]->GetVirtualAddress();
+		if (isRedundant) {
+			const VertexBufferBinding& bound = m_vertexBuffers[startSlot + i];
+			isRedundant = bound.address == virtualAddresses[i] && bound.size == sizeInBytes[i] && bound.stride == strideInBytes[i];
+		}
+	}
+
+	if (isRedundant) {
+		++m_skippedCalls.vertexBuffers;
+		return;
+	}
+	if (m_vertexBuffers.size() < startSlot + count) {
+		m_vertexBuffers.resize(startSlot + count);
+	}
+	for (unsigned i = 0; i < count; ++i) {
+		m_vertexBuffers[startSlot + i] = { virtualAddresses[i], sizeInBytes[i], strideInBytes[i] };
 	}
 
 	m_commandList->SetVertexBuffers(startSlot,
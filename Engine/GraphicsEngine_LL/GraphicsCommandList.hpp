@@ -93,12 +93,27 @@ public:
 	void BindGraphics(BindParameter parameter, const RWTextureView2D& rwResource);
 	void BindGraphics(BindParameter parameter, const RWTextureView3D& rwResource);
 	void BindGraphics(BindParameter parameter, const RWBufferView& rwResource);
+
+	SkippedCallCounters GetSkippedCalls() const override;
 protected:
 	virtual Decomposition Decompose() override;
 	virtual void NewScratchSpace(size_t hint) override;
+	void ForgetBoundState() override;
+private:
+	struct VertexBufferBinding {
+		void* address = nullptr;
+		unsigned size = 0;
+		unsigned stride = 0;
+	};
 private:
 	gxapi::IGraphicsCommandList* m_commandList;
 
+	// input assembler state last set on the native list
+	std::vector<VertexBufferBinding> m_vertexBuffers;
+	void* m_indexBufferAddress = nullptr;
+	size_t m_indexBufferSize = 0;
+	gxapi::eFormat m_indexBufferFormat = gxapi::eFormat::UNKNOWN;
+
 	// scratch space managment
 	BindingManager<gxapi::eCommandListType::GRAPHICS> m_graphicsBindingManager;
 };
@@ -3,6 +3,7 @@
 
 #include <BaseLibrary/Graph/Node.hpp>
 #include <BaseLibrary/Graph/NodeLibrary.hpp>
+#include <BaseLibrary/Profiler.hpp>
 
 #include <iostream> // only for debugging
 #include <regex> // as well...
@@ -10,6 +11,7 @@
 
 #include <rapidjson/document.h>
 #include <optional>
+#include <algorithm>
 
 #include "Nodes/Node_GetBackBuffer.hpp"
 #include "Nodes/Node_TextureProperties.hpp"
@@ -84,6 +86,8 @@ GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 	m_scratchSpacePool(desc.graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV),
 	m_textureSpace(desc.graphicsApi),
 	m_masterCommandQueue(desc.graphicsApi->CreateCommandQueue(CommandQueueDesc{ eCommandListType::GRAPHICS }), desc.graphicsApi->CreateFence(0)),
+	m_computeCommandQueue(desc.graphicsApi->CreateCommandQueue(CommandQueueDesc{ eCommandListType::COMPUTE }), desc.graphicsApi->CreateFence(0)),
+	m_copyCommandQueue(desc.graphicsApi->CreateCommandQueue(CommandQueueDesc{ eCommandListType::COPY }), desc.graphicsApi->CreateFence(0)),
 	m_residencyQueue(std::unique_ptr<gxapi::IFence>(desc.graphicsApi->CreateFence(0))),
 	m_memoryManager(desc.graphicsApi),
 	m_dsvHeap(desc.graphicsApi),
@@ -93,19 +97,18 @@ GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 	m_shaderManager(desc.gxapiManager)
 {
 	// Create swapchain
+	m_framePacer.SetMaxFramesInFlight(desc.framesInFlight);
 	SwapChainDesc swapChainDesc;
 	swapChainDesc.format = eFormat::R8G8B8A8_UNORM;
 	swapChainDesc.width = desc.width;
 	swapChainDesc.height = desc.height;
-	swapChainDesc.numBuffers = 2;
+	swapChainDesc.numBuffers = std::max(2u, desc.framesInFlight);
 	swapChainDesc.targetWindow = desc.targetWindow;
 	swapChainDesc.isFullScreen = desc.fullScreen;
 	swapChainDesc.multisampleCount = 1;
 	swapChainDesc.multiSampleQuality = 0;
 	m_swapChain.reset(m_gxapiManager->CreateSwapChain(swapChainDesc, m_masterCommandQueue.GetUnderlyingQueue()));
 
-	m_frameEndFenceValues.resize(m_swapChain->GetDesc().numBuffers, { nullptr, 0 });
-
 	// Init backbuffer heap
 	m_backBufferHeap = std::make_unique<BackBufferManager>(m_graphicsApi, m_swapChain.get());
 
@@ -140,6 +143,9 @@ GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 	m_commandAllocatorPool.SetLogStream(&m_logStreamPipeline);
 
 	m_pipelineEventDispatcher += &m_memoryManager.GetUploadManager();
+	m_pipelineEventDispatcher += &m_memoryManager.GetConstBufferHeap();
+	m_frameScratchAllocator.SetLog(&m_logStreamPipeline);
+	m_pipelineEventDispatcher += &m_frameScratchAllocator;
 	// DELETE THIS
 	m_pipelineEventPrinter.SetLog(&m_logStreamPipeline);
 	m_pipelineEventDispatcher += &m_pipelineEventPrinter;
@@ -160,14 +166,16 @@ GraphicsEngine::~GraphicsEngine() {
 
 
 void GraphicsEngine::Update(float elapsed) {
+	ProfileScope frameScope("Frame", "Update");
 	std::chrono::nanoseconds frameTime(long long(elapsed * 1e9));
 	m_absoluteTime += frameTime;
 
-	// Wait for previous frame on this BB to complete
-	int backBufferIndex = m_swapChain->GetCurrentBufferIndex();
-	if (m_frameEndFenceValues[backBufferIndex]) {
-		m_frameEndFenceValues[backBufferIndex].Wait();
+	// Wait only if too many frames are in flight, that also frees the back buffer
+	{
+		ProfileScope scope("Frame", "Wait for frame slot");
+		m_framePacer.BeginFrame();
 	}
+	int backBufferIndex = m_swapChain->GetCurrentBufferIndex();
 
 	// Set up context
 	FrameContext context;
@@ -187,40 +195,62 @@ void GraphicsEngine::Update(float elapsed) {
 	context.shaderManager = &m_shaderManager;
 
 	context.commandQueue = &m_masterCommandQueue;
+	context.computeQueue = &m_computeCommandQueue;
+	context.copyQueue = &m_copyCommandQueue;
 	context.backBuffer = &m_backBufferHeap->GetBackBuffer(backBufferIndex);
 	context.scenes = &m_scenes;
 	context.cameras = &m_cameras;
 
-	const std::vector<UploadManager::UploadDescription>& uploadRequests = m_memoryManager.GetUploadManager().GetQueuedUploads();
+	const std::vector<UploadManager::UploadDescription>& uploadRequests = m_memoryManager.GetUploadManager().CollectUploads();
 	context.uploadRequests = &uploadRequests;
 
 	context.residencyQueue = &m_residencyQueue;
+	context.frameScratchAllocator = &m_frameScratchAllocator;
+	context.jobSystem = &m_jobSystem;
 
 	// Update special nodes for current frame
 	UpdateSpecialNodes();
 
 	// Execute the pipeline
-	m_pipelineEventDispatcher.DispatchFrameBegin(m_frame).wait();
-	m_scheduler.Execute(context);
-	m_pipelineEventDispatcher.DispatchFrameEnd(m_frame).wait();
+	{
+		ProfileScope scope("Listeners", "Frame begin");
+		m_pipelineEventDispatcher.DispatchFrameBegin(m_frame).wait();
+	}
+	{
+		ProfileScope scope("Frame", "Execute pipeline");
+		m_scheduler.Execute(context);
+	}
+	{
+		ProfileScope scope("Listeners", "Frame end");
+		m_pipelineEventDispatcher.DispatchFrameEnd(m_frame).wait();
+	}
 
 	// Mark frame completion
 	SyncPoint frameEnd = m_masterCommandQueue.Signal();
-	m_frameEndFenceValues[backBufferIndex] = frameEnd;
+	m_framePacer.EndFrame(frameEnd);
 	m_pipelineEventDispatcher.DispatchDeviceFrameEnd(frameEnd, m_frame);
 
 	// Flush log
 	m_logger->Flush();
 
 	// Present frame
-	m_swapChain->Present();
+	{
+		ProfileScope scope("Frame", "Present");
+		m_swapChain->Present();
+	}
 	++m_frame;
 
 	// Await next frame
+	ProfileScope scope("Listeners", "Frame begin await");
 	m_pipelineEventDispatcher.DispachFrameBeginAwait(m_frame).wait(); // m_frame incremented on previous line
 }
 
 
+const FramePacer::Statistics& GraphicsEngine::GetFrameStatistics() const {
+	return m_framePacer.GetStatistics();
+}
+
+
 void GraphicsEngine::SetScreenSize(unsigned width, unsigned height) {
 	if (width == 0 || height == 0) {
 		return;
@@ -364,6 +394,7 @@ OverlayEntity* GraphicsEngine::CreateOverlayEntity() {
 
 bool GraphicsEngine::SetEnvVariable(std::string name, Any obj) {
 	auto res = m_envVariables.insert_or_assign(std::move(name), std::move(obj));
+	m_scheduler.InvalidateConstants(); // env variables are folded into constants
 	return res.second;
 }
 
@@ -383,23 +414,41 @@ const Any& GraphicsEngine::GetEnvVariable(const std::string& name) {
 
 
 void GraphicsEngine::LoadPipeline(const std::string& graphDesc) {
-	Pipeline pipeline;
-	pipeline.CreateFromDescription(graphDesc, m_nodeFactory);
-
-	EngineContext engineContext(1, 1);
-	for (auto& node : pipeline) {
-		if (auto graphicsNode = dynamic_cast<GraphicsNode*>(&node)) {
-			graphicsNode->Initialize(engineContext);
+	Pipeline pipeline = m_scheduler.ReleasePipeline();
+	try {
+		if (pipeline.begin() == pipeline.end()) {
+			pipeline.CreateFromDescription(graphDesc, m_nodeFactory);
+		}
+		else {
+			// Reloading, only nodes that changed are created and initialized again.
+			Pipeline::UpdateStatistics statistics = pipeline.UpdateFromDescription(graphDesc, m_nodeFactory);
+			m_logStreamPipeline.Event(LogEvent{ "Pipeline reloaded",
+				EventParameterInt("kept", (int)statistics.keptNodes),
+				EventParameterInt("created", (int)statistics.createdNodes),
+				EventParameterInt("removed", (int)statistics.removedNodes),
+				EventParameterInt("relinked", (int)statistics.relinkedNodes) });
 		}
 	}
+	catch (...) {
+		// keep rendering with the pipeline as it was
+		m_scheduler.SetPipeline(std::move(pipeline));
+		throw;
+	}
 
-	auto specialNodes = SelectSpecialNodes(pipeline);
+	// Leave out nodes that don't contribute to the back buffer, and evaluate constants only when env variables change.
+	std::unordered_set<const NodeBase*> outputNodes = SelectOutputNodes(pipeline);
+	Pipeline::OptimizeStatistics optimizeStatistics = pipeline.Optimize(
+		[&outputNodes](const NodeBase& node) { return outputNodes.count(&node) > 0; },
+		[](const NodeBase& node) { return dynamic_cast<const nodes::GetEnvVariable*>(&node) != nullptr; });
+	m_logStreamPipeline.Event(LogEvent{ "Pipeline optimized",
+		EventParameterInt("pruned", (int)optimizeStatistics.prunedNodes),
+		EventParameterInt("folded", (int)optimizeStatistics.foldedNodes),
+		EventParameterInt("tasks per frame", (int)optimizeStatistics.activeTasks) });
 
-	m_specialNodes = specialNodes;
-	m_pipeline = std::move(pipeline);
-	m_scheduler.SetPipeline(std::move(m_pipeline));
+	m_specialNodes = SelectSpecialNodes(pipeline);
+	m_scheduler.SetPipeline(std::move(pipeline));
 
-	DumpPipelineGraph(pipeline, "pipeline_graph.dot");
+	DumpPipelineGraph(m_scheduler.GetPipeline(), "pipeline_graph.dot");
 
 	// This code piece was used to debug the pipeline loading.
 	// Leave it here for a while but throw it out later.
@@ -976,6 +1025,51 @@ std::vector<GraphicsNode*> GraphicsEngine::SelectSpecialNodes(Pipeline& pipeline
 }
 
 
+std::unordered_set<const NodeBase*> GraphicsEngine::SelectOutputNodes(const Pipeline& pipeline) {
+	// The back buffer is handed from node to node as they render to it. The nodes that don't
+	// pass it on finish the frame. Nodes that only read it, like its size, don't count.
+	std::unordered_map<const InputPortBase*, const NodeBase*> inputOwners;
+	std::vector<const NodeBase*> stack;
+	for (const NodeBase& node : pipeline) {
+		for (size_t port = 0; port < node.GetNumInputs(); ++port) {
+			inputOwners.insert({ node.GetInput(port), &node });
+		}
+		if (dynamic_cast<const nodes::GetBackBuffer*>(&node)) {
+			stack.push_back(&node);
+		}
+	}
+
+	std::unordered_set<const NodeBase*> visited(stack.begin(), stack.end());
+	std::unordered_set<const NodeBase*> outputNodes;
+	while (!stack.empty()) {
+		const NodeBase* node = stack.back();
+		stack.pop_back();
+
+		bool hasTextureOutput = false;
+		bool isPassedOn = false;
+		for (size_t port = 0; port < node->GetNumOutputs(); ++port) {
+			const OutputPortBase* output = node->GetOutput(port);
+			if (output->GetType() != typeid(Texture2D)) {
+				continue;
+			}
+			hasTextureOutput = true;
+			for (const InputPortBase* input : *output) {
+				isPassedOn = true;
+				const NodeBase* target = inputOwners.at(input);
+				if (visited.insert(target).second) {
+					stack.push_back(target);
+				}
+			}
+		}
+		if (hasTextureOutput && !isPassedOn) {
+			outputNodes.insert(node);
+		}
+	}
+
+	return outputNodes;
+}
+
+
 void GraphicsEngine::UpdateSpecialNodes() {
 	std::vector<const Scene*> scenes;
 	for (auto scene : m_scenes) {
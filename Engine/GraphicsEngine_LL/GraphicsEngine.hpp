@@ -9,6 +9,8 @@
 #include "ResourceResidencyQueue.hpp"
 #include "PipelineEventDispatcher.hpp"
 #include "PipelineEventListener.hpp"
+#include "FrameScratchAllocator.hpp"
+#include "FramePacer.hpp"
 
 #include "CriticalBufferHeap.hpp"
 #include "BackBufferManager.hpp"
@@ -22,9 +24,12 @@
 #include <GraphicsApi_LL/ICommandQueue.hpp>
 
 #include <BaseLibrary/Logging_All.hpp>
+#include <BaseLibrary/JobSystem.hpp>
 
 #include <BaseLibrary/Any.hpp>
 
+#include <unordered_set>
+
 
 namespace inl {
 namespace gxeng {
@@ -53,6 +58,7 @@ struct GraphicsEngineDesc {
 	int width;
 	int height;
 	Logger* logger;
+	unsigned framesInFlight = 2; // frames the CPU may record ahead of the GPU, 1 to 3
 };
 
 
@@ -96,6 +102,8 @@ public:
 
 	// Update scene
 	void Update(float elapsed);
+	/// <summary> Latency and throughput of the frames so far, shows how much the CPU and the GPU overlapped. </summary>
+	const FramePacer::Statistics& GetFrameStatistics() const;
 	void SetScreenSize(unsigned width, unsigned height);
 	void GetScreenSize(unsigned& width, unsigned& height);
 	void SetFullScreen(bool enable);
@@ -139,6 +147,7 @@ private:
 	//void CreatePipeline();
 	void RegisterPipelineClasses();
 	static std::vector<GraphicsNode*> SelectSpecialNodes(Pipeline& pipeline);
+	static std::unordered_set<const NodeBase*> SelectOutputNodes(const Pipeline& pipeline);
 	void UpdateSpecialNodes();
 	static void DumpPipelineGraph(const Pipeline& pipeline, std::string file);
 private:
@@ -164,14 +173,18 @@ private:
 	Pipeline m_pipeline;
 	Scheduler m_scheduler;
 	ShaderManager m_shaderManager;
-	std::vector<SyncPoint> m_frameEndFenceValues;
+	FramePacer m_framePacer; // frames in flight, the swap chain has a back buffer for each
 	std::vector<std::shared_ptr<GraphicsNode>> m_graphicsNodes;
 	std::vector<GraphicsNode*> m_specialNodes;
 
 	// Pipeline elements
 	CommandQueue m_masterCommandQueue;
+	CommandQueue m_computeCommandQueue;
+	CommandQueue m_copyCommandQueue;
 	ResourceResidencyQueue m_residencyQueue;
 	PipelineEventDispatcher m_pipelineEventDispatcher;
+	FrameScratchAllocator m_frameScratchAllocator;
+	JobSystem m_jobSystem; // records command lists of the pipeline's tasks
 	PipelineEventPrinter m_pipelineEventPrinter; // ONLY FOR TEST PURPOSES
 
 	// Logging
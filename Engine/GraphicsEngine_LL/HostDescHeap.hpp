@@ -3,7 +3,7 @@
 #include "../GraphicsApi_LL/IGraphicsApi.hpp"
 #include "../GraphicsApi_LL/Exception.hpp"
 #include "../GraphicsApi_LL/IDescriptorHeap.hpp"
-#include "../BaseLibrary/Memory/SlabAllocatorEngine.hpp"
+#include "../BaseLibrary/Memory/ConcurrentSlabAllocatorEngine.hpp"
 
 #include <vector>
 #include <mutex>
@@ -60,8 +60,7 @@ private:
 	std::unique_ptr<ChunkListItem> m_first;
 	size_t m_descriptorCount;
 
-	std::mutex m_allocMutex;
-	SlabAllocatorEngine m_allocEngine;
+	ConcurrentSlabAllocatorEngine m_allocEngine;
 
 	const size_t heapDim;
 };
@@ -78,19 +77,24 @@ HostDescHeap<HeapType>::HostDescHeap(gxapi::IGraphicsApi* graphicsApi, size_t he
 template <gxapi::eDescriptorHeapType HeapType>
 size_t HostDescHeap<HeapType>::Allocate() {
 	try {
-		std::lock_guard<std::mutex> lkg(m_allocMutex);
 		return m_allocEngine.Allocate();
 	}
 	catch (std::bad_alloc&) {
+		// growing is serialized, the slots added by another thread may already be taken again
 		std::lock_guard<std::mutex> lkg(m_listMutex);
-		Grow();
-		return m_allocEngine.Allocate();
+		while (true) {
+			try {
+				return m_allocEngine.Allocate();
+			}
+			catch (std::bad_alloc&) {
+				Grow();
+			}
+		}
 	}
 }
 
 template <gxapi::eDescriptorHeapType HeapType>
 void HostDescHeap<HeapType>::Deallocate(size_t pos) {
-	std::lock_guard<std::mutex> lkg(m_allocMutex);
 	m_allocEngine.Deallocate(pos);
 }
 
@@ -41,6 +41,11 @@ UploadManager& MemoryManager::GetUploadManager() {
 }
 
 
+ConstantBufferHeap& MemoryManager::GetConstBufferHeap() {
+	return m_constBufferHeap;
+}
+
+
 VolatileConstBuffer MemoryManager::CreateVolatileConstBuffer(const void* data, uint32_t size) {
 	return m_constBufferHeap.CreateVolatileBuffer(data, size);
 }
@@ -141,10 +146,55 @@ TextureCube MemoryManager::CreateTextureCube(eResourceHeapType heap, uint64_t wi
 }
 */
 
+gxapi::ResourceAllocationInfo MemoryManager::GetTextureAllocationInfo(const Texture2DDesc& desc, gxapi::eResourceFlags flags) const {
+	return m_graphicsApi->GetResourceAllocationInfo(gxapi::ResourceDesc::Texture2DArray(desc.width, desc.height, desc.format, desc.arraySize, flags, desc.mipLevels));
+}
+
+
+std::shared_ptr<gxapi::IHeap> MemoryManager::CreateTextureHeap(uint64_t size, bool renderTargets) {
+	gxapi::eHeapFlags flags = renderTargets ? gxapi::eHeapFlags::ALLOW_ONLY_RT_DS_TEXTURES : gxapi::eHeapFlags::ALLOW_ONLY_NON_RT_DS_TEXTURES;
+	gxapi::HeapDesc desc(size, gxapi::HeapProperties(gxapi::eHeapType::DEFAULT), flags);
+	return std::shared_ptr<gxapi::IHeap>(m_graphicsApi->CreateHeap(desc));
+}
+
+
+Texture2D MemoryManager::CreatePlacedTexture2D(const std::shared_ptr<gxapi::IHeap>& heap, uint64_t offset, const Texture2DDesc& desc, gxapi::eResourceFlags flags) {
+	if (desc.arraySize < 1) {
+		throw InvalidArgumentException("Array must have dimension greater than 0.", "arraySize");
+	}
+
+	gxapi::ResourceDesc resourceDesc = gxapi::ResourceDesc::Texture2DArray(desc.width, desc.height, desc.format, desc.arraySize, flags, desc.mipLevels);
+	gxapi::ClearValue clearValue;
+	gxapi::IResource* resource = m_graphicsApi->CreatePlacedResource(heap.get(), offset, resourceDesc, gxapi::eResourceState::COMMON, GetOptimizedClearValue(resourceDesc, clearValue));
+
+	// The heap must outlive the resources placed in it.
+	MemoryObjDesc objdesc(resource, eResourceHeap::CRITICAL);
+	objdesc.resource = MemoryObjDesc::UniqPtr(objdesc.resource.release(), [heap](gxapi::IResource* resource) {
+		delete resource;
+	});
+
+	Texture2D result(std::move(objdesc));
+	return result;
+}
+
+
 MemoryObjDesc MemoryManager::AllocateResource(eResourceHeapType heap, const gxapi::ResourceDesc& desc) {
+	gxapi::ClearValue clearValue;
+	gxapi::ClearValue* pClearValue = GetOptimizedClearValue(desc, clearValue);
 
-	gxapi::ClearValue* pClearValue = nullptr;
+	switch(heap) {
+	case eResourceHeapType::CRITICAL: 
+		return m_criticalHeap.Allocate(std::move(desc), pClearValue);
+		break;
+	default:
+		assert(false);
+	}
 
+	return MemoryObjDesc();
+}
+
+
+gxapi::ClearValue* MemoryManager::GetOptimizedClearValue(const gxapi::ResourceDesc& desc, gxapi::ClearValue& clearValue) {
 	bool depthStencilTexture = (desc.type == gxapi::eResourceType::TEXTURE) && (desc.textureDesc.flags & gxapi::eResourceFlags::ALLOW_DEPTH_STENCIL);
 	bool renderTargetTexture = (desc.type == gxapi::eResourceType::TEXTURE) && (desc.textureDesc.flags & gxapi::eResourceFlags::ALLOW_RENDER_TARGET);
 
@@ -171,24 +221,15 @@ MemoryObjDesc MemoryManager::AllocateResource(eResourceHeapType heap, const gxap
 		}
 	}
 
-	gxapi::ClearValue dsvClearValue(clearFormat, 1, 0);
-	gxapi::ClearValue rtvClearValue(clearFormat, gxapi::ColorRGBA(0, 0, 0, 1));
-	if (depthStencilTexture) {
-		pClearValue = &dsvClearValue;
-	}
 	if (renderTargetTexture) {
-		pClearValue = &rtvClearValue;
+		clearValue = gxapi::ClearValue(clearFormat, gxapi::ColorRGBA(0, 0, 0, 1));
+		return &clearValue;
 	}
-
-	switch(heap) {
-	case eResourceHeapType::CRITICAL: 
-		return m_criticalHeap.Allocate(std::move(desc), pClearValue);
-		break;
-	default:
-		assert(false);
+	if (depthStencilTexture) {
+		clearValue = gxapi::ClearValue(clearFormat, 1, 0);
+		return &clearValue;
 	}
-
-	return MemoryObjDesc();
+	return nullptr;
 }
 
 
@@ -7,10 +7,12 @@
 #include "ConstBufferHeap.hpp"
 
 #include "../GraphicsApi_LL/Common.hpp"
+#include "../GraphicsApi_LL/IHeap.hpp"
 #include "../GraphicsApi_D3D12/DescriptorHeap.hpp"
 #include "../GraphicsApi_D3D12/GraphicsApi.hpp"
 
 #include <iostream>
+#include <memory>
 #include <unordered_set>
 #include <mutex>
 #include <cassert>
@@ -86,6 +88,8 @@ public:
 	void UnlockResident(IterT begin, IterT end);
 
 	UploadManager& GetUploadManager();
+	/// <summary> Must get the pipeline events, volatile buffers are recycled when the frames using them complete. </summary>
+	ConstantBufferHeap& GetConstBufferHeap();
 	VolatileConstBuffer CreateVolatileConstBuffer(const void* data, uint32_t size);
 	PersistentConstBuffer CreatePersistentConstBuffer(const void* data, uint32_t size);
 
@@ -101,6 +105,14 @@ public:
 	Texture3D CreateTexture3D(eResourceHeapType heap, const Texture3DDesc& desc, gxapi::eResourceFlags flags = gxapi::eResourceFlags::NONE);
 	//TextureCube CreateTextureCube(eResourceHeapType heap, uint64_t width, uint32_t height, gxapi::eFormat format, gxapi::eResourceFlags flags = gxapi::eResourceFlags::NONE, uint16_t arraySize = 1);
 
+	/// <summary> Size and alignment of the texture when it's placed in a heap. </summary>
+	gxapi::ResourceAllocationInfo GetTextureAllocationInfo(const Texture2DDesc& desc, gxapi::eResourceFlags flags = gxapi::eResourceFlags::NONE) const;
+	/// <summary> Creates a heap for textures that can be render targets or depth stencils, or for ones that can't be either.
+	///		Some hardware can't mix the two kinds in one heap. </summary>
+	std::shared_ptr<gxapi::IHeap> CreateTextureHeap(uint64_t size, bool renderTargets);
+	/// <summary> Creates a texture at the given offset of the heap. The texture keeps the heap alive. </summary>
+	Texture2D CreatePlacedTexture2D(const std::shared_ptr<gxapi::IHeap>& heap, uint64_t offset, const Texture2DDesc& desc, gxapi::eResourceFlags flags = gxapi::eResourceFlags::NONE);
+
 protected:
 	gxapi::IGraphicsApi* m_graphicsApi;
 
@@ -114,6 +126,8 @@ protected:
 
 protected:
 	MemoryObjDesc AllocateResource(eResourceHeapType heap, const gxapi::ResourceDesc& desc);
+	/// <summary> Fills <paramref name="clearValue"/> and returns it for render targets and depth stencils, returns null for anything else. </summary>
+	static gxapi::ClearValue* GetOptimizedClearValue(const gxapi::ResourceDesc& desc, gxapi::ClearValue& clearValue);
 };
 
 
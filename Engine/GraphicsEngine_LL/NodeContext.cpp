@@ -1,6 +1,7 @@
 #include "NodeContext.hpp"
 
 #include "MemoryManager.hpp" 
+#include "TransientResourcePool.hpp"
 #include "CommandAllocatorPool.hpp"
 #include "ScratchSpacePool.hpp"
 #include "GraphicsCommandList.hpp"
@@ -39,11 +40,17 @@ SetupContext::SetupContext(MemoryManager* memoryManager,
 						   RTVHeap* rtvHeap,
 						   DSVHeap* dsvHeap,
 						   ShaderManager* shaderManager,
-						   gxapi::IGraphicsApi* graphicsApi)
+						   gxapi::IGraphicsApi* graphicsApi,
+						   FrameScratchAllocator* frameScratchAllocator,
+						   TransientResourcePool* transientPool,
+						   size_t taskIndex)
 	: m_memoryManager(memoryManager),
 	m_srvHeap(srvHeap),
 	m_rtvHeap(rtvHeap),
 	m_dsvHeap(dsvHeap),
+	m_frameScratchAllocator(frameScratchAllocator),
+	m_transientPool(transientPool),
+	m_taskIndex(taskIndex),
 	m_shaderManager(shaderManager),
 	m_graphicsApi(graphicsApi)
 {}
@@ -73,6 +80,21 @@ Texture3D SetupContext::CreateTexture3D(const Texture3DDesc& desc, const Texture
 	return texture;
 }
 
+Texture2D SetupContext::CreateTransientTexture2D(const Texture2DDesc& desc, const TextureUsage& usage) const {
+	if (m_transientPool == nullptr) {
+		return CreateTexture2D(desc, usage);
+	}
+
+	gxapi::eResourceFlags flags;
+
+	if (!usage.shaderResource) flags += gxapi::eResourceFlags::DENY_SHADER_RESOURCE;
+	if (usage.renderTarget) flags += gxapi::eResourceFlags::ALLOW_RENDER_TARGET;
+	if (usage.depthStencil) flags += gxapi::eResourceFlags::ALLOW_DEPTH_STENCIL;
+	if (usage.randomAccess) flags += gxapi::eResourceFlags::ALLOW_UNORDERED_ACCESS;
+
+	return m_transientPool->CreateTexture2D(m_taskIndex, desc, flags);
+}
+
 
 TextureView2D SetupContext::CreateSrv(Texture2D& texture, gxapi::eFormat format, gxapi::SrvTexture2DArray desc) const {
 	if (m_srvHeap == nullptr) throw InvalidStateException("Cannot create srv without srv/cbv/uav heap.");
@@ -178,10 +200,12 @@ RenderContext::RenderContext(MemoryManager* memoryManager,
 							 gxapi::IGraphicsApi* graphicsApi,
 							 CommandListPool* commandListPool,
 							 CommandAllocatorPool* commandAllocatorPool,
-							 ScratchSpacePool* scratchSpacePool)
+							 ScratchSpacePool* scratchSpacePool,
+							 FrameScratchAllocator* frameScratchAllocator)
 	: m_memoryManager(memoryManager),
 	m_srvHeap(srvHeap),
 	m_volatileViewHeap(volatileViewHeap),
+	m_frameScratchAllocator(frameScratchAllocator),
 	m_shaderManager(shaderManager),
 	m_graphicsApi(graphicsApi),
 	m_commandListPool(commandListPool),
@@ -242,7 +266,12 @@ GraphicsCommandList& RenderContext::AsGraphics() {
 }
 ComputeCommandList& RenderContext::AsCompute() {
 	if (!m_commandList) {
-		m_commandList.reset(new GraphicsCommandList(m_graphicsApi, *m_commandListPool, *m_commandAllocatorPool, *m_scratchSpacePool, *m_memoryManager, *m_volatileViewHeap)); // only graphics queues now
+		if (m_hasComputeQueue) {
+			m_commandList.reset(new ComputeCommandList(m_graphicsApi, *m_commandListPool, *m_commandAllocatorPool, *m_scratchSpacePool, *m_memoryManager, *m_volatileViewHeap));
+		}
+		else {
+			m_commandList.reset(new GraphicsCommandList(m_graphicsApi, *m_commandListPool, *m_commandAllocatorPool, *m_scratchSpacePool, *m_memoryManager, *m_volatileViewHeap));
+		}
 		m_type = gxapi::eCommandListType::COMPUTE;
 		return *dynamic_cast<ComputeCommandList*>(m_commandList.get());
 	}
@@ -255,7 +284,12 @@ ComputeCommandList& RenderContext::AsCompute() {
 }
 CopyCommandList& RenderContext::AsCopy() {
 	if (!m_commandList) {
-		m_commandList.reset(new GraphicsCommandList(m_graphicsApi, *m_commandListPool, *m_commandAllocatorPool, *m_scratchSpacePool, *m_memoryManager, *m_volatileViewHeap)); // only graphics queues now
+		if (m_hasCopyQueue) {
+			m_commandList.reset(new CopyCommandList(m_graphicsApi, *m_commandListPool, *m_commandAllocatorPool, *m_scratchSpacePool));
+		}
+		else {
+			m_commandList.reset(new GraphicsCommandList(m_graphicsApi, *m_commandListPool, *m_commandAllocatorPool, *m_scratchSpacePool, *m_memoryManager, *m_volatileViewHeap));
+		}
 		m_type = gxapi::eCommandListType::COPY;
 		return *dynamic_cast<CopyCommandList*>(m_commandList.get());
 	}
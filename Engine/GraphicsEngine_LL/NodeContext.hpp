@@ -7,6 +7,7 @@
 #include "ShaderManager.hpp"
 #include "VolatileViewHeap.hpp"
 #include "Binder.hpp"
+#include "FrameScratchAllocator.hpp"
 #include <cstdint>
 
 
@@ -14,6 +15,7 @@ namespace inl::gxeng {
 
 
 class MemoryManager;
+class TransientResourcePool;
 class CbvSrvUavHeap;
 class RTVHeap;
 class DSVHeap;
@@ -80,7 +82,10 @@ public:
 				 RTVHeap* rtvHeap = nullptr,
 				 DSVHeap* dsvHeap = nullptr,
 				 ShaderManager* shaderManager = nullptr,
-				 gxapi::IGraphicsApi* graphicsApi = nullptr);
+				 gxapi::IGraphicsApi* graphicsApi = nullptr,
+				 FrameScratchAllocator* frameScratchAllocator = nullptr,
+				 TransientResourcePool* transientPool = nullptr,
+				 size_t taskIndex = 0);
 	SetupContext(SetupContext&&) = delete;
 	SetupContext& operator=(SetupContext&&) = delete;
 	SetupContext(const SetupContext&) = delete;
@@ -90,6 +95,10 @@ public:
 	// Create resources
 	Texture2D CreateTexture2D(const Texture2DDesc& desc, const TextureUsage& usage) const;
 	Texture3D CreateTexture3D(const Texture3DDesc& desc, const TextureUsage& usage) const;
+	/// <summary> Creates a texture that is only used in this frame and may share memory with other transient textures.
+	///		Its contents are undefined when the frame starts, and it must be requested and its views created again every frame.
+	///		Requests are matched to earlier frames' by their order within the node. </summary>
+	Texture2D CreateTransientTexture2D(const Texture2DDesc& desc, const TextureUsage& usage) const;
 	VertexBuffer CreateVertexBuffer(const void* data, size_t size) const;
 	IndexBuffer CreateIndexBuffer(const void* data, size_t size, size_t indexCount) const;
 
@@ -113,12 +122,20 @@ public:
 	// Binding
 	Binder CreateBinder(const std::vector<BindParameterDesc>& parameters, const std::vector<gxapi::StaticSamplerDesc>& staticSamplers = {}) const;
 
+	// Scratch memory
+	/// <summary> Returns an STL allocator for temporary data that is freed when the frame ends. </summary>
+	template <class T>
+	LinearAllocatorAdaptor<T> GetFrameAllocator() const { return m_frameScratchAllocator ? m_frameScratchAllocator->GetAdaptor<T>() : LinearAllocatorAdaptor<T>(); }
+
 private:
 	// Memory management stuff
 	MemoryManager* m_memoryManager;
 	CbvSrvUavHeap* m_srvHeap;
 	RTVHeap* m_rtvHeap;
 	DSVHeap* m_dsvHeap;
+	FrameScratchAllocator* m_frameScratchAllocator;
+	TransientResourcePool* m_transientPool;
+	size_t m_taskIndex;
 
 	// Shaders and PSOs
 	ShaderManager* m_shaderManager;
@@ -140,7 +157,8 @@ public:
 				  gxapi::IGraphicsApi* graphicsApi = nullptr,
 				  CommandListPool* commandListPool = nullptr,
 				  CommandAllocatorPool* commandAllocatorPool = nullptr,
-				  ScratchSpacePool* scratchSpacePool = nullptr);
+				  ScratchSpacePool* scratchSpacePool = nullptr,
+				  FrameScratchAllocator* frameScratchAllocator = nullptr);
 	RenderContext(RenderContext&&) = delete;
 	RenderContext& operator=(RenderContext&&) = delete;
 	RenderContext(const RenderContext&) = delete;
@@ -165,16 +183,26 @@ public:
 	ComputeCommandList& AsCompute();
 	CopyCommandList& AsCopy();
 	gxapi::eCommandListType GetType() const { return m_type; }
+
+	/// <summary> Compute and copy lists only get their own type if there is a queue to run them on,
+	///		otherwise they are recorded as graphics lists. Call before the first AsType(). </summary>
+	void SetAsyncQueues(bool hasComputeQueue, bool hasCopyQueue) { m_hasComputeQueue = hasComputeQueue; m_hasCopyQueue = hasCopyQueue; }
 	bool IsListInitialized() const { return (bool)m_commandList; }
 
 	// Debug draw
 	void AddDebugObject(std::vector<DebugObject*> objects);
 
+	// Scratch memory
+	/// <summary> Returns an STL allocator for temporary data that is freed when the frame ends. </summary>
+	template <class T>
+	LinearAllocatorAdaptor<T> GetFrameAllocator() const { return m_frameScratchAllocator ? m_frameScratchAllocator->GetAdaptor<T>() : LinearAllocatorAdaptor<T>(); }
+
 private:
 	// Memory management stuff
 	MemoryManager* m_memoryManager;
 	CbvSrvUavHeap* m_srvHeap;
 	VolatileViewHeap* m_volatileViewHeap;
+	FrameScratchAllocator* m_frameScratchAllocator;
 
 	// Shaders and PSOs
 	ShaderManager* m_shaderManager;
@@ -186,6 +214,8 @@ private:
 	ScratchSpacePool* m_scratchSpacePool;
 	std::unique_ptr<BasicCommandList> m_commandList;
 	gxapi::eCommandListType m_type = static_cast<gxapi::eCommandListType>(0xDEADBEEF);
+	bool m_hasComputeQueue = false;
+	bool m_hasCopyQueue = false;
 };
 
 
@@ -111,9 +111,10 @@ void BloomBlur::Setup(SetupContext& context) {
 		m_fsqIndices.SetName("Bloom blur full screen quad index buffer");
 	}
 
-	if (!m_PSO) {
-		InitRenderTarget(context);
+	// The render targets are transient, they have to be requested every frame.
+	InitRenderTarget(context);
 
+	if (!m_PSO) {
 		ShaderParts shaderParts;
 		shaderParts.vs = true;
 		shaderParts.ps = true;
@@ -166,6 +167,8 @@ void BloomBlur::Execute(RenderContext& context) {
 	uniformsCBData.direction = m_dir;
 
 	commandList.SetResourceState(m_blur_rtv.GetResource(), gxapi::eResourceState::RENDER_TARGET);
+	// Transient render targets have undefined contents until cleared.
+	commandList.ClearRenderTarget(m_blur_rtv, gxapi::ColorRGBA(0, 0, 0, 1));
 	commandList.SetResourceState(m_inputTexSrv.GetResource(), { gxapi::eResourceState::PIXEL_SHADER_RESOURCE, gxapi::eResourceState::NON_PIXEL_SHADER_RESOURCE });
 
 	RenderTargetView2D* pRTV = &m_blur_rtv;
@@ -204,38 +207,33 @@ void BloomBlur::Execute(RenderContext& context) {
 
 
 void BloomBlur::InitRenderTarget(SetupContext& context) {
-	if (!m_outputTexturesInited) {
-		m_outputTexturesInited = true;
-
-		using gxapi::eFormat;
-
-		auto formatBlur = eFormat::R16G16B16A16_FLOAT;
-
-		gxapi::RtvTexture2DArray rtvDesc;
-		rtvDesc.activeArraySize = 1;
-		rtvDesc.firstArrayElement = 0;
-		rtvDesc.firstMipLevel = 0;
-		rtvDesc.planeIndex = 0;
-
-		gxapi::SrvTexture2DArray srvDesc;
-		srvDesc.activeArraySize = 1;
-		srvDesc.firstArrayElement = 0;
-		srvDesc.numMipLevels = -1;
-		srvDesc.mipLevelClamping = 0;
-		srvDesc.mostDetailedMip = 0;
-		srvDesc.planeIndex = 0;
-
-		Texture2DDesc desc{
-			m_inputTexSrv.GetResource().GetWidth(),
-			m_inputTexSrv.GetResource().GetHeight(),
-			formatBlur
-		};
+	using gxapi::eFormat;
 
-		Texture2D blur_tex = context.CreateTexture2D(desc, { true, true, false, false });
-		blur_tex.SetName("Bloom blur tex");
-		m_blur_rtv = context.CreateRtv(blur_tex, formatBlur, rtvDesc);
-		
-	}
+	auto formatBlur = eFormat::R16G16B16A16_FLOAT;
+
+	gxapi::RtvTexture2DArray rtvDesc;
+	rtvDesc.activeArraySize = 1;
+	rtvDesc.firstArrayElement = 0;
+	rtvDesc.firstMipLevel = 0;
+	rtvDesc.planeIndex = 0;
+
+	gxapi::SrvTexture2DArray srvDesc;
+	srvDesc.activeArraySize = 1;
+	srvDesc.firstArrayElement = 0;
+	srvDesc.numMipLevels = -1;
+	srvDesc.mipLevelClamping = 0;
+	srvDesc.mostDetailedMip = 0;
+	srvDesc.planeIndex = 0;
+
+	Texture2DDesc desc{
+		m_inputTexSrv.GetResource().GetWidth(),
+		m_inputTexSrv.GetResource().GetHeight(),
+		formatBlur
+	};
+
+	Texture2D blur_tex = context.CreateTransientTexture2D(desc, { true, true, false, false });
+	blur_tex.SetName("Bloom blur tex");
+	m_blur_rtv = context.CreateRtv(blur_tex, formatBlur, rtvDesc);
 }
 
 
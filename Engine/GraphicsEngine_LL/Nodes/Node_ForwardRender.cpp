@@ -378,7 +378,7 @@ void ForwardRender::Execute(RenderContext& context) {
 		commandList.BindGraphics(BindParameter(eBindParameterType::TEXTURE, 600), m_lightCullDataView);
 
 		// Set material parameters
-		std::vector<uint8_t> materialConstants(scenario.constantsSize);
+		std::vector<uint8_t, LinearAllocatorAdaptor<uint8_t>> materialConstants(scenario.constantsSize, context.GetFrameAllocator<uint8_t>());
 		for (size_t paramIdx = 0; paramIdx < material->GetParameterCount(); ++paramIdx) {
 			const Material::Parameter& param = (*material)[paramIdx];
 			switch (param.GetType()) {
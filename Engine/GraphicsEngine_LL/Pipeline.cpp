@@ -13,6 +13,7 @@
 #include <cassert>
 #include <optional>
 #include <typeinfo>
+#include <unordered_set>
 
 
 namespace inl {
@@ -37,6 +38,21 @@ struct LinkCreationInfo {
 	std::optional<std::string> srcpname, dstpname;
 };
 
+struct PipelineDescription {
+	std::vector<NodeCreationInfo> nodes;
+	std::vector<LinkCreationInfo> links;
+	// Lookup dictionary of nodes by name and by id.
+	// {name/id of node, index of node in vector}
+	std::unordered_map<int, size_t> idBook;
+	std::unordered_map<std::string, size_t> nameBook;
+};
+
+struct ResolvedLink {
+	size_t src, dst; // index of nodes in the description
+	OutputPortBase* srcp;
+	InputPortBase* dstp;
+};
+
 struct StringErrorPosition {
 	int lineNumber;
 	int characterNumber;
@@ -47,6 +63,10 @@ struct StringErrorPosition {
 static void AssertThrow(bool condition, const std::string& message);
 static NodeCreationInfo ParseNode(const rapidjson::GenericValue<rapidjson::UTF8<>>& jsonObj);
 static LinkCreationInfo ParseLink(const rapidjson::GenericValue<rapidjson::UTF8<>>& jsonObj);
+static PipelineDescription ParseDescription(const std::string& jsonDescription);
+static std::shared_ptr<NodeBase> CreateNode(const NodeCreationInfo& info, GraphicsNodeFactory& factory);
+static std::vector<ResolvedLink> ResolveLinks(const PipelineDescription& description, const std::vector<std::shared_ptr<NodeBase>>& nodeObjects);
+static std::string GetNodeKey(const NodeCreationInfo& info);
 static StringErrorPosition GetStringErrorPosition(const std::string& str, size_t errorCharacter);
 
 static std::string SerializeNodesAndLinks(std::vector<NodeCreationInfo> nodes, std::vector<LinkCreationInfo> links);
@@ -103,23 +123,52 @@ Pipeline::NodeIterator Pipeline::NodeIterator::operator++(int) const {
 Pipeline::Pipeline()
 	: m_nodeMap(m_dependencyGraph),
 	m_taskFunctionMap(m_taskGraph),
-	m_taskParentMap(m_taskGraph, lemon::INVALID)
+	m_taskParentMap(m_taskGraph, lemon::INVALID),
+	m_nodeRecords(m_dependencyGraph),
+	m_activeTaskMap(m_taskGraph, true)
 {}
 
 
 Pipeline::Pipeline(Pipeline&& rhs) : Pipeline() {
 	// copy graphs and maps
+	lemon::ListDigraph::NodeMap<lemon::ListDigraph::Node> depNodeRef(rhs.m_dependencyGraph);
 	lemon::DigraphCopy<decltype(rhs.m_dependencyGraph), decltype(this->m_dependencyGraph)>
 		depCopy(rhs.m_dependencyGraph, this->m_dependencyGraph);
 	depCopy.nodeMap(rhs.m_nodeMap, this->m_nodeMap);
+	depCopy.nodeMap(rhs.m_nodeRecords, this->m_nodeRecords);
+	depCopy.nodeRef(depNodeRef);
 	depCopy.run();
 
+	lemon::ListDigraph::NodeMap<lemon::ListDigraph::Node> taskNodeRef(rhs.m_taskGraph);
 	lemon::DigraphCopy<decltype(rhs.m_taskGraph), decltype(this->m_taskGraph)>
 		taskCopy(rhs.m_taskGraph, this->m_taskGraph);
 	taskCopy.nodeMap(rhs.m_taskFunctionMap, this->m_taskFunctionMap);
-	taskCopy.nodeMap(rhs.m_taskParentMap, this->m_taskParentMap);
+	taskCopy.nodeMap(rhs.m_activeTaskMap, this->m_activeTaskMap);
+	taskCopy.nodeRef(taskNodeRef);
 	taskCopy.run();
 
+	// maps that point into the other graph still have rhs's nodes, which are numbered differently in the copies
+	for (lemon::ListDigraph::NodeIt taskNode(rhs.m_taskGraph); taskNode != lemon::INVALID; ++taskNode) {
+		lemon::ListDigraph::Node parent = rhs.m_taskParentMap[taskNode];
+		m_taskParentMap[taskNodeRef[taskNode]] = parent != lemon::INVALID
+			? lemon::ListDigraph::NodeIt(m_dependencyGraph, depNodeRef[parent])
+			: lemon::ListDigraph::NodeIt(lemon::INVALID);
+	}
+	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
+		NodeRecord& record = m_nodeRecords[depNode];
+		if (record.source != lemon::INVALID) {
+			record.source = taskNodeRef[record.source];
+			record.sink = taskNodeRef[record.sink];
+		}
+		for (auto& taskNode : record.tasks) {
+			taskNode = taskNodeRef[taskNode];
+		}
+	}
+
+	// the task map points into the wrappers
+	m_taskWrappers = std::move(rhs.m_taskWrappers);
+	m_foldedTasks = std::move(rhs.m_foldedTasks);
+
 	// clear rhs's stuff
 	rhs.m_dependencyGraph.clear();
 	rhs.m_taskGraph.clear();
@@ -143,121 +192,17 @@ Pipeline::~Pipeline() {
 
 
 void Pipeline::CreateFromDescription(const std::string& jsonDescription, GraphicsNodeFactory& factory) {
-	using namespace rapidjson;
-
-	// Parse the JSON file.
-	Document doc;
-	doc.Parse(jsonDescription.c_str());
-	ParseErrorCode ec = doc.GetParseError();
-	if (ec != ParseErrorCode::kParseErrorNone) {
-		size_t errorCharacter = doc.GetErrorOffset();
-		auto [lineNumber, characterNumber, line] = GetStringErrorPosition(jsonDescription, errorCharacter);
-		throw InvalidArgumentException("JSON descripion has syntax errors.", "Check line " + std::to_string(lineNumber) + ":" + std::to_string(characterNumber));
-	}
-
-	AssertThrow(doc.IsObject(), "JSON root must be an object with member arrays \"nodes\" and \"links\".");
-	AssertThrow(doc.HasMember("nodes") && doc["nodes"].IsArray(), "JSON root must have \"nodes\" member array.");
-	AssertThrow(doc.HasMember("links") && doc["links"].IsArray(), "JSON root must have \"links\" member array.");
-
-	auto& nodes = doc["nodes"];
-	auto& links = doc["links"];
-	std::vector<NodeCreationInfo> nodeCreationInfos;
-	std::vector<LinkCreationInfo> linkCreationInfos;
-
-	for (SizeType i = 0; i < nodes.Size(); ++i) {
-		NodeCreationInfo info = ParseNode(nodes[i]);
-		nodeCreationInfos.push_back(info);
-	}
-
-	for (SizeType i = 0; i < links.Size(); ++i) {
-		LinkCreationInfo info = ParseLink(links[i]);
-		linkCreationInfos.push_back(info);
-	}
-
-	// Create lookup dictionary of nodes by name and by id.
-	// {name/id of node, index of node in vector}
-	std::unordered_map<int, size_t> idBook;
-	std::unordered_map<std::string, size_t> nameBook;
-	for (size_t i = 0; i < nodeCreationInfos.size(); ++i) {
-		if (nodeCreationInfos[i].name) {
-			auto ins = nameBook.insert({ nodeCreationInfos[i].name.value(), i });
-			AssertThrow(ins.second == true, "Node names must be unique.");
-		}
-		if (nodeCreationInfos[i].id) {
-			auto ins = idBook.insert({ nodeCreationInfos[i].id.value(), i });
-			AssertThrow(ins.second == true, "Node ids must be unique.");
-		}
-	}
+	PipelineDescription description = ParseDescription(jsonDescription);
 
 	// Create nodes with initial values.
 	std::vector<std::shared_ptr<NodeBase>> nodeObjects;
-	for (auto& info : nodeCreationInfos) {
-		std::shared_ptr<NodeBase> nodeObject(factory.CreateNode(info.cl));
-		if (info.name) {
-			nodeObject->SetDisplayName(info.name.value());
-		}
-
-		for (int i = 0; i < nodeObject->GetNumInputs() && i < info.inputs.size(); ++i) {
-			if (info.inputs[i]) {
-				nodeObject->GetInput(i)->SetConvert(info.inputs[i].value());
-			}
-		}
-
-		nodeObjects.push_back(std::move(nodeObject));
+	for (auto& info : description.nodes) {
+		nodeObjects.push_back(CreateNode(info, factory));
 	}
 
 	// Link nodes above.
-	for (auto& info : linkCreationInfos) {
-		NodeBase *src, *dst;
-		OutputPortBase* srcp = nullptr;
-		InputPortBase* dstp = nullptr;
-
-		// Find src and dst nodes
-		if (info.srcname) {
-			auto it = nameBook.find(info.srcname.value());
-			AssertThrow(it != nameBook.end(), "Node requested to link named " + info.srcname.value() + " not found.");
-			src = nodeObjects[it->second].get();
-		}
-		else {
-			auto it = idBook.find(info.srcid.value());
-			AssertThrow(it != idBook.end(), "Node requested to link id=" + std::to_string(info.srcid.value()) + " not found.");
-			src = nodeObjects[it->second].get();
-		}
-		if (info.dstname) {
-			auto it = nameBook.find(info.dstname.value());
-			AssertThrow(it != nameBook.end(), "Node requested to link named " + info.dstname.value() + " not found.");
-			dst = nodeObjects[it->second].get();
-		}
-		else {
-			auto it = idBook.find(info.dstid.value());
-			AssertThrow(it != idBook.end(), "Node requested to link id=" + std::to_string(info.dstid.value()) + " not found.");
-			dst = nodeObjects[it->second].get();
-		}
-		// Find src and dst ports
-		if (info.srcpname) {
-			for (int i = 0; i < src->GetNumOutputs(); ++i) {
-				if (info.srcpname.value() == src->GetOutputName(i)) {
-					srcp = src->GetOutput(i);
-					break;
-				}
-			}
-		}
-		else {
-			srcp = src->GetOutput(info.srcpidx.value());
-		}
-		if (info.dstpname) {
-			for (int i = 0; i < dst->GetNumInputs(); ++i) {
-				if (info.dstpname.value() == dst->GetInputName(i)) {
-					dstp = dst->GetInput(i);
-					break;
-				}
-			}
-		}
-		else {
-			dstp = dst->GetInput(info.dstpidx.value());
-		}
-		// Link said ports
-		bool linked = srcp->Link(dstp);
+	for (auto& link : ResolveLinks(description, nodeObjects)) {
+		bool linked = link.srcp->Link(link.dstp);
 		AssertThrow(linked, "Ports not compatible.");
 	}
 
@@ -271,6 +216,19 @@ void Pipeline::CreateFromDescription(const std::string& jsonDescription, Graphic
 	}
 
 	CreateFromNodesList(nodeObjects);
+
+	// Remember what the nodes were created from, updates are matched against it.
+	std::unordered_map<NodeBase*, size_t> nodeIndices;
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		nodeIndices.insert({ nodeObjects[i].get(), i });
+	}
+	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
+		const NodeCreationInfo& info = description.nodes[nodeIndices[m_nodeMap[depNode].get()]];
+		NodeRecord& record = m_nodeRecords[depNode];
+		record.key = GetNodeKey(info);
+		record.cl = info.cl;
+		record.inputs = info.inputs;
+	}
 }
 
 
@@ -300,6 +258,177 @@ void Pipeline::CreateFromNodesList(const std::vector<std::shared_ptr<NodeBase>>
 }
 
 
+auto Pipeline::UpdateFromDescription(const std::string& jsonDescription, GraphicsNodeFactory& factory) -> UpdateStatistics {
+	PipelineDescription description = ParseDescription(jsonDescription);
+
+	// Match described nodes with live ones of the same name or id and class, create the rest.
+	std::unordered_map<std::string, lemon::ListDigraph::Node> liveNodes;
+	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
+		if (!m_nodeRecords[depNode].key.empty()) {
+			liveNodes.insert({ m_nodeRecords[depNode].key, depNode });
+		}
+	}
+
+	std::vector<std::shared_ptr<NodeBase>> nodeObjects;
+	std::vector<lemon::ListDigraph::Node> depNodes; // INVALID for nodes not in the graph yet
+	for (auto& info : description.nodes) {
+		auto it = liveNodes.find(GetNodeKey(info));
+		if (it != liveNodes.end() && m_nodeRecords[it->second].cl == info.cl) {
+			nodeObjects.push_back(m_nodeMap[it->second]);
+			depNodes.push_back(it->second);
+			liveNodes.erase(it);
+		}
+		else {
+			nodeObjects.push_back(CreateNode(info, factory));
+			depNodes.push_back(lemon::INVALID);
+		}
+	}
+
+	std::vector<ResolvedLink> links = ResolveLinks(description, nodeObjects);
+	std::unordered_map<const InputPortBase*, OutputPortBase*> newLinks;
+	for (auto& link : links) {
+		newLinks.insert({ link.dstp, link.srcp });
+	}
+
+	// The subgraphs of nodes are checked one by one below, so the task graph
+	// is a DAG if the nodes' graph is.
+	lemon::ListDigraph descriptionGraph;
+	std::vector<lemon::ListDigraph::Node> descriptionNodes;
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		descriptionNodes.push_back(descriptionGraph.addNode());
+	}
+	for (auto& link : links) {
+		descriptionGraph.addArc(descriptionNodes[link.src], descriptionNodes[link.dst]);
+	}
+	AssertThrow(lemon::dag(descriptionGraph), "Supplied nodes do not make a directed acyclic graph.");
+
+	// Only new nodes are initialized, live ones keep their resources.
+	EngineContext engineContext(1, 1);
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		if (depNodes[i] != lemon::INVALID) {
+			continue;
+		}
+		if (auto graphicsNode = dynamic_cast<GraphicsNode*>(nodeObjects[i].get())) {
+			graphicsNode->Initialize(engineContext);
+			CheckNodeTasks(*graphicsNode);
+		}
+	}
+
+	// Update default inputs of live nodes that changed. Created nodes already have them.
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		if (depNodes[i] == lemon::INVALID) {
+			continue;
+		}
+		NodeBase* node = nodeObjects[i].get();
+		const auto& inputs = description.nodes[i].inputs;
+		const auto& oldInputs = m_nodeRecords[depNodes[i]].inputs;
+		for (size_t port = 0; port < node->GetNumInputs(); ++port) {
+			InputPortBase* input = node->GetInput(port);
+			if (newLinks.count(input) > 0) {
+				continue;
+			}
+			std::optional<std::string> value = port < inputs.size() ? inputs[port] : std::nullopt;
+			std::optional<std::string> oldValue = port < oldInputs.size() ? oldInputs[port] : std::nullopt;
+			bool wasLinked = input->GetLink() != nullptr;
+			if (value && (value != oldValue || wasLinked)) {
+				input->SetConvert(value.value());
+			}
+			else if (!value && (oldValue || wasLinked)) {
+				input->Clear();
+			}
+		}
+	}
+
+
+	// The description is valid, change the graphs in place. Nothing throws from here on.
+	UpdateStatistics statistics;
+
+	// Relink ports of nodes. Inputs linked to nodes about to be removed are unlinked here as well.
+	std::vector<bool> isRelinked(nodeObjects.size(), false);
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		NodeBase* node = nodeObjects[i].get();
+		isRelinked[i] = depNodes[i] == lemon::INVALID;
+		for (size_t port = 0; port < node->GetNumInputs(); ++port) {
+			InputPortBase* input = node->GetInput(port);
+			auto it = newLinks.find(input);
+			OutputPortBase* newLink = it != newLinks.end() ? it->second : nullptr;
+			if (input->GetLink() != newLink) {
+				input->Unlink();
+				if (newLink != nullptr) {
+					bool linked = newLink->Link(input);
+					assert(linked);
+				}
+				isRelinked[i] = true;
+			}
+		}
+	}
+
+	// Remove live nodes that have not been matched.
+	lemon::ListDigraph::NodeMap<bool> isMatched(m_dependencyGraph, false);
+	for (auto depNode : depNodes) {
+		if (depNode != lemon::INVALID) {
+			isMatched[depNode] = true;
+			++statistics.keptNodes;
+		}
+	}
+	std::vector<lemon::ListDigraph::Node> removedNodes;
+	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
+		if (!isMatched[depNode]) {
+			removedNodes.push_back(depNode);
+		}
+	}
+	for (auto depNode : removedNodes) {
+		NodeBase* node = m_nodeMap[depNode].get();
+		for (size_t port = 0; port < node->GetNumInputs(); ++port) {
+			node->GetInput(port)->Unlink();
+		}
+		for (size_t port = 0; port < node->GetNumOutputs(); ++port) {
+			node->GetOutput(port)->UnlinkAll();
+		}
+		RemoveNodeTasks(depNode);
+		m_nodeMap[depNode] = nullptr;
+		m_dependencyGraph.erase(depNode); // arcs of the node go with it
+		++statistics.removedNodes;
+	}
+
+	// Add created nodes along with their subgraphs.
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		if (depNodes[i] == lemon::INVALID) {
+			depNodes[i] = m_dependencyGraph.addNode();
+			m_nodeMap[depNodes[i]] = nodeObjects[i];
+			AddNodeTasks(depNodes[i]);
+			++statistics.createdNodes;
+		}
+
+		const NodeCreationInfo& info = description.nodes[i];
+		NodeRecord& record = m_nodeRecords[depNodes[i]];
+		record.key = GetNodeKey(info);
+		record.cl = info.cl;
+		record.inputs = info.inputs;
+	}
+
+	ResetOptimization();
+
+	// Reconnect the subgraphs of relinked nodes.
+	std::unordered_map<const OutputPortBase*, lemon::ListDigraph::Node> outputOwners;
+	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
+		NodeBase* node = m_nodeMap[depNode].get();
+		for (size_t port = 0; port < node->GetNumOutputs(); ++port) {
+			outputOwners.insert({ node->GetOutput(port), depNode });
+		}
+	}
+	for (size_t i = 0; i < nodeObjects.size(); ++i) {
+		if (isRelinked[i]) {
+			RelinkNode(depNodes[i], outputOwners);
+			++statistics.relinkedNodes;
+		}
+	}
+
+	assert(lemon::dag(m_taskGraph));
+	return statistics;
+}
+
+
 std::string Pipeline::SerializeToJSON(const NodeFactory& factory) const {
 	using namespace rapidjson;
 
@@ -386,6 +515,103 @@ void Pipeline::Clear() {
 	}
 	m_dependencyGraph.clear();
 	m_taskGraph.clear();
+	m_taskWrappers.clear();
+	m_foldedTasks.clear();
+}
+
+
+auto Pipeline::Optimize(const std::function<bool(const NodeBase&)>& isOutput, const std::function<bool(const NodeBase&)>& isConstant) -> OptimizeStatistics {
+	ResetOptimization();
+
+	// Walk the nodes in topological order, the dependency graph is a DAG.
+	std::vector<lemon::ListDigraph::Node> order;
+	lemon::ListDigraph::NodeMap<int> remainingInputs(m_dependencyGraph);
+	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
+		remainingInputs[depNode] = lemon::countInArcs(m_dependencyGraph, depNode);
+		if (remainingInputs[depNode] == 0) {
+			order.push_back(depNode);
+		}
+	}
+	for (size_t i = 0; i < order.size(); ++i) {
+		for (lemon::ListDigraph::OutArcIt arc(m_dependencyGraph, order[i]); arc != lemon::INVALID; ++arc) {
+			if (--remainingInputs[m_dependencyGraph.target(arc)] == 0) {
+				order.push_back(m_dependencyGraph.target(arc));
+			}
+		}
+	}
+	assert(order.size() == (size_t)lemon::countNodes(m_dependencyGraph));
+
+	// Live nodes are the outputs and everything they depend on.
+	lemon::ListDigraph::NodeMap<bool> isLive(m_dependencyGraph, false);
+	bool hasOutput = false;
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		if (isOutput(*m_nodeMap[*it])) {
+			isLive[*it] = true;
+			hasOutput = true;
+		}
+		else {
+			for (lemon::ListDigraph::OutArcIt arc(m_dependencyGraph, *it); arc != lemon::INVALID; ++arc) {
+				if (isLive[m_dependencyGraph.target(arc)]) {
+					isLive[*it] = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// Constants only depend on other constants.
+	lemon::ListDigraph::NodeMap<bool> isFolded(m_dependencyGraph, false);
+	for (auto depNode : order) {
+		const NodeBase& node = *m_nodeMap[depNode];
+		bool isConstantNode = dynamic_cast<const GraphicsNode*>(&node) == nullptr || isConstant(node);
+		for (lemon::ListDigraph::InArcIt arc(m_dependencyGraph, depNode); arc != lemon::INVALID && isConstantNode; ++arc) {
+			isConstantNode = isFolded[m_dependencyGraph.source(arc)];
+		}
+		isFolded[depNode] = isConstantNode;
+	}
+
+	OptimizeStatistics statistics;
+	for (auto depNode : order) {
+		if (hasOutput && !isLive[depNode]) {
+			++statistics.prunedNodes;
+		}
+		else if (isFolded[depNode]) {
+			++statistics.foldedNodes;
+		}
+		else {
+			continue;
+		}
+		for (auto taskNode : m_nodeRecords[depNode].tasks) {
+			m_activeTaskMap[taskNode] = false;
+		}
+	}
+
+	// Folded tasks are set up in the order of the task graph.
+	lemon::ListDigraph::NodeMap<int> remainingPredecessors(m_taskGraph);
+	std::vector<lemon::ListDigraph::Node> taskOrder;
+	for (lemon::ListDigraph::NodeIt taskNode(m_taskGraph); taskNode != lemon::INVALID; ++taskNode) {
+		remainingPredecessors[taskNode] = lemon::countInArcs(m_taskGraph, taskNode);
+		if (remainingPredecessors[taskNode] == 0) {
+			taskOrder.push_back(taskNode);
+		}
+		if (m_activeTaskMap[taskNode]) {
+			++statistics.activeTasks;
+		}
+	}
+	for (size_t i = 0; i < taskOrder.size(); ++i) {
+		lemon::ListDigraph::Node taskNode = taskOrder[i];
+		lemon::ListDigraph::Node parent = m_taskParentMap[taskNode];
+		if (parent != lemon::INVALID && isFolded[parent] && (!hasOutput || isLive[parent]) && m_taskFunctionMap[taskNode] != nullptr) {
+			m_foldedTasks.push_back(m_taskFunctionMap[taskNode]);
+		}
+		for (lemon::ListDigraph::OutArcIt arc(m_taskGraph, taskNode); arc != lemon::INVALID; ++arc) {
+			if (--remainingPredecessors[m_taskGraph.target(arc)] == 0) {
+				taskOrder.push_back(m_taskGraph.target(arc));
+			}
+		}
+	}
+
+	return statistics;
 }
 
 
@@ -411,126 +637,185 @@ Pipeline::ConstNodeIterator Pipeline::end() const {
 
 
 void Pipeline::CalculateTaskGraph() {
-	// This structure is used to assign 
-	//		{source,sink} pairs in m_taskGraph
-	//		to
-	//		nodes in m_dependencyGraph
-	struct SourceSinkMapping {
-		lemon::ListDigraph::Node source;
-		lemon::ListDigraph::Node sink;
-	};
-
 	// Reset task graph completely
 	m_taskGraph.clear();
 	m_taskWrappers.clear();
 
-	lemon::ListDigraph::NodeMap<SourceSinkMapping> sourceSinkMapping(m_dependencyGraph); // map targets are in m_taskGraph
-
-	// Iterate over each node in dependency graph
+	// Merge subgraph of each pipeline node into expanded task graph
 	for (lemon::ListDigraph::NodeIt depNode(m_dependencyGraph); depNode != lemon::INVALID; ++depNode) {
-		// Get pipeline node of this graph node
-		NodeBase* pipelineNode = m_nodeMap[depNode].get();
-		assert(pipelineNode != nullptr); // each graph node must have a pipeline node assigned
-
-		// Merge subgraph of graphics pipeline node into expanded task graph
-		if (gxeng::GraphicsNode* graphicsPipelineNode = dynamic_cast<gxeng::GraphicsNode*>(pipelineNode)) {
-			const lemon::ListDigraph& subtaskNodes = graphicsPipelineNode->GetTaskGraph();
-			const lemon::ListDigraph::NodeMap<GraphicsTask*>& subtaskMap = graphicsPipelineNode->GetTaskGraphMapping();
-
-			// Merge-copy Task's graph into m_taskGraph, create mapping of nodes
-			// Copy nodes
-			int numSubtasks = lemon::countNodes(subtaskNodes);
-			if (numSubtasks == 0) {
-				throw InvalidArgumentException("Task has zero subtasks.");
-			}
-			lemon::ListDigraph::NodeMap<decltype(m_taskGraph)::Node> taskNodesToTaskGraphNodes(subtaskNodes); // maps Task's nodes to m_taskGraph's nodes
-			for (lemon::ListDigraph::NodeIt taskNode(subtaskNodes); taskNode != lemon::INVALID; ++taskNode) {
-				auto taskGraphNode = m_taskGraph.addNode(); // add new node
-				taskNodesToTaskGraphNodes[taskNode] = taskGraphNode; // map new node to task.m_nodes' corresponding node
+		AddNodeTasks(depNode);
+	}
 
-				m_taskFunctionMap[taskGraphNode] = subtaskMap[taskNode]; // assign subtask
-				m_taskParentMap[taskGraphNode] = depNode; // assign parent of subtask
-			}
-			// Copy arcs
-			for (lemon::ListDigraph::ArcIt arc(subtaskNodes); arc != lemon::INVALID; ++arc) {
-				m_taskGraph.addArc(
-					taskNodesToTaskGraphNodes[subtaskNodes.source(arc)],
-					taskNodesToTaskGraphNodes[subtaskNodes.target(arc)]
-				);
-			}
+	// Connect sources and sinks according to dependencyGraph
+	for (lemon::ListDigraph::ArcIt depArc(m_dependencyGraph); depArc != lemon::INVALID; ++depArc) {
+		AddDependencyTasks(depArc);
+	}
 
-			// Find sources and sinks
-			std::vector<lemon::ListDigraph::Node> sources; // source are in m_taskGraph
-			std::vector<lemon::ListDigraph::Node> sinks; // sink as well
-			for (lemon::ListDigraph::NodeIt taskNode(subtaskNodes); taskNode != lemon::INVALID; ++taskNode) {
-				// no in arc -> source
-				int inArcCount = lemon::countInArcs(subtaskNodes, taskNode);
-				if (inArcCount == 0) {
-					sources.push_back(taskNodesToTaskGraphNodes[taskNode]);
-				}
-				// no out arc -> sink
-				int outArcCount = lemon::countOutArcs(subtaskNodes, taskNode);
-				if (outArcCount == 0) {
-					sinks.push_back(taskNodesToTaskGraphNodes[taskNode]);
-				}
-			}
-			SourceSinkMapping sourceSinkMapForCurrentNode;
-			// If no sink or no source, it's certainly not a fucking DAG
-			if (sources.size() == 0 || sinks.size() == 0) {
-				std::stringstream ss;
-				for (lemon::ListDigraph::ArcIt arc(subtaskNodes); arc != lemon::INVALID; ++arc) {
-					ss << subtaskNodes.id(subtaskNodes.source(arc)) << " -> " << subtaskNodes.id(subtaskNodes.target(arc)) << std::endl;
-				}
-				throw InvalidArgumentException("Task graph of node has neither sources nor sinks. The graph must not contain circles.", ss.str()); // TODO: which node, which task, which what?
-			}
-			// If there are multiple sources, reduce them to one
-			if (sources.size() > 1) {
-				sourceSinkMapForCurrentNode.source = m_taskGraph.addNode();
-				m_taskParentMap[sourceSinkMapForCurrentNode.source] = lemon::INVALID;
-				m_taskFunctionMap[sourceSinkMapForCurrentNode.source] = nullptr;
-				for (auto& source : sources) {
-					m_taskGraph.addArc(sourceSinkMapForCurrentNode.source, source);
-				}
+	ResetOptimization();
+}
+
+
+void Pipeline::AddNodeTasks(lemon::ListDigraph::Node depNode) {
+	// Get pipeline node of this graph node
+	NodeBase* pipelineNode = m_nodeMap[depNode].get();
+	assert(pipelineNode != nullptr); // each graph node must have a pipeline node assigned
+
+	// Source and sink are the nodes in m_taskGraph to connect to the subgraphs of other nodes.
+	NodeRecord& record = m_nodeRecords[depNode];
+	record.tasks.clear();
+	lemon::ListDigraph::NodeIt parent(m_dependencyGraph, depNode);
+
+	// Merge subgraph of graphics pipeline node into expanded task graph
+	if (gxeng::GraphicsNode* graphicsPipelineNode = dynamic_cast<gxeng::GraphicsNode*>(pipelineNode)) {
+		CheckNodeTasks(*graphicsPipelineNode);
+
+		const lemon::ListDigraph& subtaskNodes = graphicsPipelineNode->GetTaskGraph();
+		const lemon::ListDigraph::NodeMap<GraphicsTask*>& subtaskMap = graphicsPipelineNode->GetTaskGraphMapping();
+
+		// Merge-copy Task's graph into m_taskGraph, create mapping of nodes
+		// Copy nodes
+		lemon::ListDigraph::NodeMap<decltype(m_taskGraph)::Node> taskNodesToTaskGraphNodes(subtaskNodes); // maps Task's nodes to m_taskGraph's nodes
+		for (lemon::ListDigraph::NodeIt taskNode(subtaskNodes); taskNode != lemon::INVALID; ++taskNode) {
+			auto taskGraphNode = m_taskGraph.addNode(); // add new node
+			taskNodesToTaskGraphNodes[taskNode] = taskGraphNode; // map new node to task.m_nodes' corresponding node
+
+			m_taskFunctionMap[taskGraphNode] = subtaskMap[taskNode]; // assign subtask
+			m_taskParentMap[taskGraphNode] = parent; // assign parent of subtask
+			record.tasks.push_back(taskGraphNode);
+		}
+		// Copy arcs
+		for (lemon::ListDigraph::ArcIt arc(subtaskNodes); arc != lemon::INVALID; ++arc) {
+			m_taskGraph.addArc(
+				taskNodesToTaskGraphNodes[subtaskNodes.source(arc)],
+				taskNodesToTaskGraphNodes[subtaskNodes.target(arc)]
+			);
+		}
+
+		// Find sources and sinks
+		std::vector<lemon::ListDigraph::Node> sources; // source are in m_taskGraph
+		std::vector<lemon::ListDigraph::Node> sinks; // sink as well
+		for (lemon::ListDigraph::NodeIt taskNode(subtaskNodes); taskNode != lemon::INVALID; ++taskNode) {
+			// no in arc -> source
+			int inArcCount = lemon::countInArcs(subtaskNodes, taskNode);
+			if (inArcCount == 0) {
+				sources.push_back(taskNodesToTaskGraphNodes[taskNode]);
 			}
-			else {
-				sourceSinkMapForCurrentNode.source = sources[0];
+			// no out arc -> sink
+			int outArcCount = lemon::countOutArcs(subtaskNodes, taskNode);
+			if (outArcCount == 0) {
+				sinks.push_back(taskNodesToTaskGraphNodes[taskNode]);
 			}
-			// If there are multiple sinks, reduce them to one
-			if (sinks.size() > 1) {
-				sourceSinkMapForCurrentNode.sink = m_taskGraph.addNode();
-				m_taskParentMap[sourceSinkMapForCurrentNode.sink] = lemon::INVALID;
-				m_taskFunctionMap[sourceSinkMapForCurrentNode.sink] = nullptr;
-				for (auto& sink : sinks) {
-					m_taskGraph.addArc(sink, sourceSinkMapForCurrentNode.sink);
-				}
+		}
+		// If there are multiple sources, reduce them to one
+		if (sources.size() > 1) {
+			record.source = m_taskGraph.addNode();
+			m_taskParentMap[record.source] = lemon::INVALID;
+			m_taskFunctionMap[record.source] = nullptr;
+			record.tasks.push_back(record.source);
+			for (auto& source : sources) {
+				m_taskGraph.addArc(record.source, source);
 			}
-			else {
-				sourceSinkMapForCurrentNode.sink = sinks[0];
+		}
+		else {
+			record.source = sources[0];
+		}
+		// If there are multiple sinks, reduce them to one
+		if (sinks.size() > 1) {
+			record.sink = m_taskGraph.addNode();
+			m_taskParentMap[record.sink] = lemon::INVALID;
+			m_taskFunctionMap[record.sink] = nullptr;
+			record.tasks.push_back(record.sink);
+			for (auto& sink : sinks) {
+				m_taskGraph.addArc(sink, record.sink);
 			}
-			// Set source-sink mapping
-			sourceSinkMapping[depNode] = sourceSinkMapForCurrentNode;
 		}
 		else {
-			std::unique_ptr<SimpleNodeTask> wrapper = std::make_unique<SimpleNodeTask>(pipelineNode);
-			SourceSinkMapping sourceSinkMapForCurrentNode;
-			lemon::ListDigraph::Node wrapperNode = m_taskGraph.addNode();
-			sourceSinkMapForCurrentNode.sink = sourceSinkMapForCurrentNode.source = wrapperNode;
+			record.sink = sinks[0];
+		}
+	}
+	else {
+		std::unique_ptr<SimpleNodeTask> wrapper = std::make_unique<SimpleNodeTask>(pipelineNode);
+		lemon::ListDigraph::Node wrapperNode = m_taskGraph.addNode();
+		record.sink = record.source = wrapperNode;
+		record.tasks.push_back(wrapperNode);
+
+		m_taskFunctionMap[wrapperNode] = wrapper.get(); // assign subtask
+		m_taskParentMap[wrapperNode] = parent; // assign parent of subtask
+
+		m_taskWrappers[pipelineNode] = std::move(wrapper);
+	}
+}
+
+
+void Pipeline::RemoveNodeTasks(lemon::ListDigraph::Node depNode) {
+	NodeRecord& record = m_nodeRecords[depNode];
+	for (auto taskNode : record.tasks) {
+		m_taskGraph.erase(taskNode); // arcs to other subgraphs go with it
+	}
+	record.tasks.clear();
+	record.source = record.sink = lemon::INVALID;
+
+	m_taskWrappers.erase(m_nodeMap[depNode].get());
+}
+
+
+void Pipeline::AddDependencyTasks(lemon::ListDigraph::Arc depArc) {
+	auto source = m_nodeRecords[m_dependencyGraph.source(depArc)].sink;
+	auto target = m_nodeRecords[m_dependencyGraph.target(depArc)].source;
+	m_taskGraph.addArc(source, target);
+}
 
-			m_taskFunctionMap[wrapperNode] = wrapper.get(); // assign subtask
-			m_taskParentMap[wrapperNode] = depNode; // assign parent of subtask
 
-			m_taskWrappers.push_back(std::move(wrapper));
+void Pipeline::RelinkNode(lemon::ListDigraph::Node depNode, const std::unordered_map<const OutputPortBase*, lemon::ListDigraph::Node>& outputOwners) {
+	// Drop arcs of the previous links. Only other nodes' sinks point to the source of the subgraph.
+	std::vector<lemon::ListDigraph::Arc> arcs;
+	for (lemon::ListDigraph::InArcIt arc(m_dependencyGraph, depNode); arc != lemon::INVALID; ++arc) {
+		arcs.push_back(arc);
+	}
+	for (auto arc : arcs) {
+		m_dependencyGraph.erase(arc);
+	}
+	arcs.clear();
+	for (lemon::ListDigraph::InArcIt arc(m_taskGraph, m_nodeRecords[depNode].source); arc != lemon::INVALID; ++arc) {
+		arcs.push_back(arc);
+	}
+	for (auto arc : arcs) {
+		m_taskGraph.erase(arc);
+	}
 
-			// Set source-sink mapping
-			sourceSinkMapping[depNode] = sourceSinkMapForCurrentNode;
+	// Add one arc for each node linked to the inputs.
+	NodeBase* node = m_nodeMap[depNode].get();
+	std::vector<lemon::ListDigraph::Node> linkedNodes;
+	for (size_t port = 0; port < node->GetNumInputs(); ++port) {
+		OutputPortBase* link = node->GetInput(port)->GetLink();
+		if (link == nullptr) {
+			continue;
+		}
+		auto owner = outputOwners.find(link);
+		assert(owner != outputOwners.end());
+		if (std::find(linkedNodes.begin(), linkedNodes.end(), owner->second) == linkedNodes.end()) {
+			linkedNodes.push_back(owner->second);
+			AddDependencyTasks(m_dependencyGraph.addArc(owner->second, depNode));
 		}
 	}
+}
 
-	// Connect sources and sinks according to dependencyGraph
-	for (lemon::ListDigraph::ArcIt depArc(m_dependencyGraph); depArc != lemon::INVALID; ++depArc) {
-		auto source = sourceSinkMapping[m_dependencyGraph.source(depArc)].sink;
-		auto target = sourceSinkMapping[m_dependencyGraph.target(depArc)].source;
-		m_taskGraph.addArc(source, target);
+
+void Pipeline::CheckNodeTasks(const GraphicsNode& node) {
+	const lemon::ListDigraph& subtaskNodes = node.GetTaskGraph();
+
+	int numSubtasks = lemon::countNodes(subtaskNodes);
+	if (numSubtasks == 0) {
+		throw InvalidArgumentException("Task has zero subtasks.");
+	}
+
+	// The subgraph is merged as is, circles would break the whole task graph
+	if (!lemon::dag(subtaskNodes)) {
+		std::stringstream ss;
+		for (lemon::ListDigraph::ArcIt arc(subtaskNodes); arc != lemon::INVALID; ++arc) {
+			ss << subtaskNodes.id(subtaskNodes.source(arc)) << " -> " << subtaskNodes.id(subtaskNodes.target(arc)) << std::endl;
+		}
+		throw InvalidArgumentException("Task graph of node must not contain circles.", ss.str()); // TODO: which node, which task, which what?
 	}
 }
 
@@ -569,6 +854,14 @@ void Pipeline::CalculateDependencyGraph() {
 }
 
 
+void Pipeline::ResetOptimization() {
+	for (lemon::ListDigraph::NodeIt taskNode(m_taskGraph); taskNode != lemon::INVALID; ++taskNode) {
+		m_activeTaskMap[taskNode] = true;
+	}
+	m_foldedTasks.clear();
+}
+
+
 bool Pipeline::IsLinked(NodeBase* srcNode, NodeBase* dstNode) {
 	for (size_t dstIn = 0; dstIn < dstNode->GetNumInputs(); dstIn++) {
 		OutputPortBase* linked = dstNode->GetInput(dstIn)->GetLink();
@@ -602,6 +895,14 @@ const lemon::ListDigraph::NodeMap<lemon::ListDigraph::NodeIt>& Pipeline::GetTask
 	return m_taskParentMap;
 }
 
+const lemon::ListDigraph::NodeMap<bool>& Pipeline::GetActiveTaskMap() const {
+	return m_activeTaskMap;
+}
+
+const std::vector<GraphicsTask*>& Pipeline::GetFoldedTasks() const {
+	return m_foldedTasks;
+}
+
 
 
 
@@ -710,6 +1011,143 @@ LinkCreationInfo ParseLink(const rapidjson::GenericValue<rapidjson::UTF8<>>& obj
 };
 
 
+PipelineDescription ParseDescription(const std::string& jsonDescription) {
+	using namespace rapidjson;
+
+	// Parse the JSON file.
+	Document doc;
+	doc.Parse(jsonDescription.c_str());
+	ParseErrorCode ec = doc.GetParseError();
+	if (ec != ParseErrorCode::kParseErrorNone) {
+		size_t errorCharacter = doc.GetErrorOffset();
+		auto [lineNumber, characterNumber, line] = GetStringErrorPosition(jsonDescription, errorCharacter);
+		throw InvalidArgumentException("JSON descripion has syntax errors.", "Check line " + std::to_string(lineNumber) + ":" + std::to_string(characterNumber));
+	}
+
+	AssertThrow(doc.IsObject(), "JSON root must be an object with member arrays \"nodes\" and \"links\".");
+	AssertThrow(doc.HasMember("nodes") && doc["nodes"].IsArray(), "JSON root must have \"nodes\" member array.");
+	AssertThrow(doc.HasMember("links") && doc["links"].IsArray(), "JSON root must have \"links\" member array.");
+
+	auto& nodes = doc["nodes"];
+	auto& links = doc["links"];
+	PipelineDescription description;
+
+	for (SizeType i = 0; i < nodes.Size(); ++i) {
+		NodeCreationInfo info = ParseNode(nodes[i]);
+		description.nodes.push_back(info);
+	}
+
+	for (SizeType i = 0; i < links.Size(); ++i) {
+		LinkCreationInfo info = ParseLink(links[i]);
+		description.links.push_back(info);
+	}
+
+	for (size_t i = 0; i < description.nodes.size(); ++i) {
+		if (description.nodes[i].name) {
+			auto ins = description.nameBook.insert({ description.nodes[i].name.value(), i });
+			AssertThrow(ins.second == true, "Node names must be unique.");
+		}
+		if (description.nodes[i].id) {
+			auto ins = description.idBook.insert({ description.nodes[i].id.value(), i });
+			AssertThrow(ins.second == true, "Node ids must be unique.");
+		}
+	}
+
+	return description;
+}
+
+
+std::shared_ptr<NodeBase> CreateNode(const NodeCreationInfo& info, GraphicsNodeFactory& factory) {
+	std::shared_ptr<NodeBase> nodeObject(factory.CreateNode(info.cl));
+	if (info.name) {
+		nodeObject->SetDisplayName(info.name.value());
+	}
+
+	for (int i = 0; i < nodeObject->GetNumInputs() && i < info.inputs.size(); ++i) {
+		if (info.inputs[i]) {
+			nodeObject->GetInput(i)->SetConvert(info.inputs[i].value());
+		}
+	}
+
+	return nodeObject;
+}
+
+
+std::vector<ResolvedLink> ResolveLinks(const PipelineDescription& description, const std::vector<std::shared_ptr<NodeBase>>& nodeObjects) {
+	std::vector<ResolvedLink> resolvedLinks;
+	std::unordered_set<const InputPortBase*> linkedInputs;
+
+	for (auto& info : description.links) {
+		ResolvedLink link;
+		link.srcp = nullptr;
+		link.dstp = nullptr;
+
+		// Find src and dst nodes
+		if (info.srcname) {
+			auto it = description.nameBook.find(info.srcname.value());
+			AssertThrow(it != description.nameBook.end(), "Node requested to link named " + info.srcname.value() + " not found.");
+			link.src = it->second;
+		}
+		else {
+			auto it = description.idBook.find(info.srcid.value());
+			AssertThrow(it != description.idBook.end(), "Node requested to link id=" + std::to_string(info.srcid.value()) + " not found.");
+			link.src = it->second;
+		}
+		if (info.dstname) {
+			auto it = description.nameBook.find(info.dstname.value());
+			AssertThrow(it != description.nameBook.end(), "Node requested to link named " + info.dstname.value() + " not found.");
+			link.dst = it->second;
+		}
+		else {
+			auto it = description.idBook.find(info.dstid.value());
+			AssertThrow(it != description.idBook.end(), "Node requested to link id=" + std::to_string(info.dstid.value()) + " not found.");
+			link.dst = it->second;
+		}
+		NodeBase* src = nodeObjects[link.src].get();
+		NodeBase* dst = nodeObjects[link.dst].get();
+
+		// Find src and dst ports
+		if (info.srcpname) {
+			for (int i = 0; i < src->GetNumOutputs(); ++i) {
+				if (info.srcpname.value() == src->GetOutputName(i)) {
+					link.srcp = src->GetOutput(i);
+					break;
+				}
+			}
+		}
+		else if (info.srcpidx.value() >= 0 && info.srcpidx.value() < src->GetNumOutputs()) {
+			link.srcp = src->GetOutput(info.srcpidx.value());
+		}
+		if (info.dstpname) {
+			for (int i = 0; i < dst->GetNumInputs(); ++i) {
+				if (info.dstpname.value() == dst->GetInputName(i)) {
+					link.dstp = dst->GetInput(i);
+					break;
+				}
+			}
+		}
+		else if (info.dstpidx.value() >= 0 && info.dstpidx.value() < dst->GetNumInputs()) {
+			link.dstp = dst->GetInput(info.dstpidx.value());
+		}
+		AssertThrow(link.srcp != nullptr && link.dstp != nullptr, "Port requested to link not found.");
+
+		// Check said ports without linking them
+		AssertThrow(link.dstp->IsCompatible(link.srcp->GetType()) || link.srcp->GetType() == typeid(Any), "Ports not compatible.");
+		AssertThrow(linkedInputs.insert(link.dstp).second, "Input ports can only be linked once.");
+
+		resolvedLinks.push_back(link);
+	}
+
+	return resolvedLinks;
+}
+
+
+std::string GetNodeKey(const NodeCreationInfo& info) {
+	// Names and ids can't clash, ids are prefixed.
+	return info.name ? info.name.value() : "#" + std::to_string(info.id.value());
+}
+
+
 static StringErrorPosition GetStringErrorPosition(const std::string& str, size_t errorCharacter) {
 	int currentCharacter = 0;
 	int characterNumber = 0;
@@ -2,7 +2,10 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include <iterator>
+#include <optional>
+#include <unordered_map>
 #include <BaseLibrary/Graph/Node.hpp>
 #include <BaseLibrary/Graph/NodeFactory.hpp>
 
@@ -73,6 +76,21 @@ public:
 		NodeBase* m_subject;
 	};
 
+	/// <summary> What <see cref="UpdateFromDescription"/> had to change in the pipeline. </summary>
+	struct UpdateStatistics {
+		size_t keptNodes = 0; // live nodes reused as they were
+		size_t createdNodes = 0; // nodes created and initialized from scratch
+		size_t removedNodes = 0;
+		size_t relinkedNodes = 0; // nodes whose input links changed, including created ones
+	};
+
+	/// <summary> What <see cref="Optimize"/> left out of the frame. </summary>
+	struct OptimizeStatistics {
+		size_t prunedNodes = 0; // nodes that no output depends on
+		size_t foldedNodes = 0; // nodes that only depend on constants
+		size_t activeTasks = 0; // tasks that still run every frame, including merge points
+	};
+
 public:
 	Pipeline();
 	Pipeline(const Pipeline&) = delete;
@@ -83,9 +101,28 @@ public:
 
 	void CreateFromDescription(const std::string& jsonDescription, GraphicsNodeFactory& factory);
 	void CreateFromNodesList(const std::vector<std::shared_ptr<NodeBase>> nodes);
+
+	/// <summary> Changes the pipeline to match a new description, but keeps the nodes that did not change. </summary>
+	/// <remarks> Nodes are matched with the live ones by their name (or id if they have no name) and class.
+	///		Matched nodes keep their state, only their default inputs and links are updated. Unmatched nodes
+	///		are created and initialized, live nodes missing from the description are removed. Only the task subgraphs
+	///		of created, removed and relinked nodes are spliced into the task graph, so the cost is
+	///		proportional to the change rather than to the size of the pipeline.
+	///		If the description is invalid, an exception is thrown and the pipeline is left unchanged. </remarks>
+	UpdateStatistics UpdateFromDescription(const std::string& jsonDescription, GraphicsNodeFactory& factory);
 	std::string SerializeToJSON(const NodeFactory& factory) const;
 	void Clear();
 
+	/// <summary> Leaves the tasks out of the frame that don't need to run every frame. </summary>
+	/// <remarks> Nodes that none of the <paramref name="isOutput"/> nodes depend on are pruned, their tasks don't run at all.
+	///		If there are no output nodes, nothing is pruned.
+	///		Nodes whose linked inputs all come from constant nodes are constant as well, and are folded:
+	///		their tasks are only set up when the constants change, see <see cref="GetFoldedTasks"/>.
+	///		Nodes that aren't graphics nodes are assumed to compute their outputs from their inputs only,
+	///		graphics nodes can only be constant if <paramref name="isConstant"/> says so.
+	///		The nodes and the task graph stay intact, changing the pipeline undoes the optimization. </remarks>
+	OptimizeStatistics Optimize(const std::function<bool(const NodeBase&)>& isOutput, const std::function<bool(const NodeBase&)>& isConstant);
+
 	NodeIterator begin();
 	NodeIterator end();
 	ConstNodeIterator begin() const;
@@ -98,6 +135,10 @@ public:
 	const lemon::ListDigraph& GetTaskGraph() const;
 	const lemon::ListDigraph::NodeMap<GraphicsTask*>& GetTaskFunctionMap() const;
 	const lemon::ListDigraph::NodeMap<lemon::ListDigraph::NodeIt>& GetTaskParentMap() const;
+	/// <summary> False for the tasks that were pruned or folded by <see cref="Optimize"/>. </summary>
+	const lemon::ListDigraph::NodeMap<bool>& GetActiveTaskMap() const;
+	/// <summary> Tasks of the folded nodes in a valid order. Their Setup() computes the constants. </summary>
+	const std::vector<GraphicsTask*>& GetFoldedTasks() const;
 
 	template <class T>
 	void AddNodeMetaData() = delete;
@@ -105,18 +146,38 @@ public:
 	void AddArcMetaData() = delete;
 
 private:
+	// Where a pipeline node came from and which part of the task graph belongs to it.
+	struct NodeRecord {
+		std::string key; // name or id in the description, empty if it wasn't created from one
+		std::string cl;
+		std::vector<std::optional<std::string>> inputs; // default inputs in the description
+		lemon::ListDigraph::Node source = lemon::INVALID; // entry point in m_taskGraph
+		lemon::ListDigraph::Node sink = lemon::INVALID; // exit point in m_taskGraph
+		std::vector<lemon::ListDigraph::Node> tasks; // all nodes in m_taskGraph, including source and sink
+	};
+
 	void CalculateTaskGraph();
 	void CalculateDependencyGraph();
+	void ResetOptimization();
 	bool IsLinked(NodeBase* srcNode, NodeBase* dstNode);
 
+	void AddNodeTasks(lemon::ListDigraph::Node depNode);
+	void RemoveNodeTasks(lemon::ListDigraph::Node depNode);
+	void AddDependencyTasks(lemon::ListDigraph::Arc depArc);
+	void RelinkNode(lemon::ListDigraph::Node depNode, const std::unordered_map<const OutputPortBase*, lemon::ListDigraph::Node>& outputOwners);
+	static void CheckNodeTasks(const GraphicsNode& node);
+
 
 	lemon::ListDigraph m_dependencyGraph;
 	lemon::ListDigraph::NodeMap<std::shared_ptr<NodeBase>> m_nodeMap;
 	lemon::ListDigraph m_taskGraph;
 	lemon::ListDigraph::NodeMap<GraphicsTask*> m_taskFunctionMap;
 	lemon::ListDigraph::NodeMap<lemon::ListDigraph::NodeIt> m_taskParentMap;
+	lemon::ListDigraph::NodeMap<NodeRecord> m_nodeRecords;
+	lemon::ListDigraph::NodeMap<bool> m_activeTaskMap;
+	std::vector<GraphicsTask*> m_foldedTasks;
 
-	std::vector<std::unique_ptr<SimpleNodeTask>> m_taskWrappers;
+	std::unordered_map<NodeBase*, std::unique_ptr<SimpleNodeTask>> m_taskWrappers;
 };
 
 
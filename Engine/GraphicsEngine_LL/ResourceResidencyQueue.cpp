@@ -1,5 +1,6 @@
 #include "ResourceResidencyQueue.hpp"
 #include <BaseLibrary/ThreadName.hpp>
+#include <BaseLibrary/Profiler.hpp>
 
 namespace inl {
 namespace gxeng {
@@ -63,6 +64,7 @@ void ResourceResidencyQueue::InitThreadFunc() {
 		lk.unlock();
 
 		for (auto& task : workingSet) {
+			ProfileScope scope("Residency", "Make resident");
 			for (const MemoryObject& res : task->resources) {
 				// TODO...
 			}
@@ -90,6 +92,7 @@ void ResourceResidencyQueue::CleanThreadFunc() {
 		lk.unlock();
 
 		for (auto& task : workingSet) {
+			ProfileScope scope("Residency", "Wait for GPU");
 			task->syncPoint.m_fence->Wait(task->syncPoint.m_value);
 			for (const MemoryObject& res : task->resources) {
 				// TODO...
@@ -0,0 +1,129 @@
+#include "ResourceStateTable.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+
+namespace inl {
+namespace gxeng {
+
+
+SubresourceUsageInfo* ResourceStateTable::Find(const gxapi::IResource* resource, unsigned subresource) {
+	assert(subresource != RESOURCE_SLOT);
+	Entry* slot = FindSlot(resource, subresource);
+	return slot ? &slot->usage : nullptr;
+}
+
+
+SubresourceUsageInfo& ResourceStateTable::Insert(const gxapi::IResource* resource, unsigned subresource, const SubresourceUsageInfo& usage, bool& isNewResource) {
+	assert(resource != nullptr);
+	assert(subresource != RESOURCE_SLOT);
+	assert(FindSlot(resource, subresource) == nullptr);
+
+	// Make room for both the subresource and possibly the resource slot before looking for them,
+	// growing moves the slots.
+	if ((m_numSlotsUsed + 2) * 2 > m_slots.size()) {
+		Grow();
+	}
+
+	Entry* resourceSlot = FindSlot(resource, RESOURCE_SLOT);
+	isNewResource = resourceSlot == nullptr;
+	if (isNewResource) {
+		resourceSlot = &InsertSlot(resource, RESOURCE_SLOT);
+		resourceSlot->owner = m_numResources++;
+	}
+	uint32_t owner = resourceSlot->owner;
+
+	Entry& slot = InsertSlot(resource, subresource);
+	slot.owner = owner;
+	slot.usage = usage;
+	++m_numSubresources;
+	return slot.usage;
+}
+
+
+std::vector<ResourceStateTable::Entry> ResourceStateTable::GetSortedEntries() const {
+	std::vector<Entry> entries;
+	entries.reserve(m_numSubresources);
+	for (const Entry& slot : m_slots) {
+		if (slot.resource != nullptr && slot.subresource != RESOURCE_SLOT) {
+			entries.push_back(slot);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return std::less<const gxapi::IResource*>()(lhs.resource, rhs.resource)
+			|| (lhs.resource == rhs.resource && lhs.subresource < rhs.subresource);
+	});
+	return entries;
+}
+
+
+void ResourceStateTable::Clear() {
+	m_slots.clear();
+	m_capacityLog2 = 0;
+	m_numSlotsUsed = 0;
+	m_numSubresources = 0;
+	m_numResources = 0;
+}
+
+
+ResourceStateTable::Entry* ResourceStateTable::FindSlot(const gxapi::IResource* resource, unsigned subresource) {
+	if (m_slots.empty()) {
+		return nullptr;
+	}
+	const size_t mask = m_slots.size() - 1;
+	for (size_t index = Hash(resource, subresource);; index = (index + 1) & mask) {
+		Entry& slot = m_slots[index];
+		if (slot.resource == resource && slot.subresource == subresource) {
+			return &slot;
+		}
+		if (slot.resource == nullptr) {
+			return nullptr;
+		}
+	}
+}
+
+
+ResourceStateTable::Entry& ResourceStateTable::InsertSlot(const gxapi::IResource* resource, unsigned subresource) {
+	const size_t mask = m_slots.size() - 1;
+	size_t index = Hash(resource, subresource);
+	while (m_slots[index].resource != nullptr) {
+		index = (index + 1) & mask;
+	}
+	Entry& slot = m_slots[index];
+	slot.resource = resource;
+	slot.subresource = subresource;
+	++m_numSlotsUsed;
+	return slot;
+}
+
+
+size_t ResourceStateTable::Hash(const gxapi::IResource* resource, unsigned subresource) const {
+	// Fibonacci hashing, the top bits of the product are the best mixed.
+	uint64_t key = uint64_t(reinterpret_cast<uintptr_t>(resource)) ^ (uint64_t(subresource) * 0xC2B2AE3D27D4EB4Full);
+	return size_t((key * 0x9E3779B97F4A7C15ull) >> (64 - m_capacityLog2));
+}
+
+
+void ResourceStateTable::Grow() {
+	std::vector<Entry> oldSlots(m_slots.size() == 0 ? INITIAL_CAPACITY : m_slots.size() * 2, Entry{ nullptr, 0, 0, {} });
+	oldSlots.swap(m_slots);
+	m_capacityLog2 = 0;
+	while ((size_t(1) << m_capacityLog2) < m_slots.size()) {
+		++m_capacityLog2;
+	}
+
+	m_numSlotsUsed = 0;
+	for (const Entry& oldSlot : oldSlots) {
+		if (oldSlot.resource != nullptr) {
+			Entry& slot = InsertSlot(oldSlot.resource, oldSlot.subresource);
+			slot.owner = oldSlot.owner;
+			slot.usage = oldSlot.usage;
+		}
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
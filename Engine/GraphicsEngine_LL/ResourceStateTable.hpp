@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../GraphicsApi_LL/Common.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace inl {
+namespace gxapi {
+class IResource;
+}
+}
+
+
+namespace inl {
+namespace gxeng {
+
+
+struct SubresourceUsageInfo {
+	gxapi::eResourceState firstState; /// <summary> Holds the target state of the first transition. </summary>
+	gxapi::eResourceState lastState; /// <summary> Holds the target state of the last transition. </summary>
+	bool multipleStates; /// <sumamry> True if resource was used in more than one state. </summary>
+};
+
+
+/// <summary>
+/// Tracks the states of the subresources a command list uses, keyed by the raw resource pointer.
+/// Resources are numbered in the order they are first seen, so the owner of a resource
+/// (e.g. its MemoryObject) can be stored once in a vector by the user of the table.
+/// </summary>
+class ResourceStateTable {
+public:
+	struct Entry {
+		const gxapi::IResource* resource;
+		unsigned subresource;
+		uint32_t owner; /// <summary> The number of the resource, in the order of first insertion. </summary>
+		SubresourceUsageInfo usage;
+	};
+public:
+	/// <summary> Returns the usage of the subresource, or null if it was not inserted. </summary>
+	SubresourceUsageInfo* Find(const gxapi::IResource* resource, unsigned subresource);
+
+	/// <summary> Adds a subresource that is not in the table yet. </summary>
+	/// <param name="isNewResource"> Set to true if no other subresource of the resource was inserted before. </param>
+	/// <returns> The usage stored in the table. </returns>
+	SubresourceUsageInfo& Insert(const gxapi::IResource* resource, unsigned subresource, const SubresourceUsageInfo& usage, bool& isNewResource);
+
+	/// <summary> Returns all subresources ordered by resource pointer, then by subresource. </summary>
+	std::vector<Entry> GetSortedEntries() const;
+
+	/// <summary> The number of subresources inserted. </summary>
+	size_t Count() const { return m_numSubresources; }
+	/// <summary> The number of distinct resources inserted. </summary>
+	size_t GetNumResources() const { return m_numResources; }
+
+	void Clear();
+private:
+	// Every resource also has a slot of its own with this subresource, it holds the owner number.
+	// ALL_SUBRESOURCES is never stored, callers expand it.
+	static constexpr unsigned RESOURCE_SLOT = gxapi::ALL_SUBRESOURCES;
+	static constexpr size_t INITIAL_CAPACITY = 64;
+
+	Entry* FindSlot(const gxapi::IResource* resource, unsigned subresource);
+	Entry& InsertSlot(const gxapi::IResource* resource, unsigned subresource);
+	size_t Hash(const gxapi::IResource* resource, unsigned subresource) const;
+	void Grow();
+private:
+	std::vector<Entry> m_slots; // linear probing, empty slots have null resource
+	unsigned m_capacityLog2 = 0;
+	size_t m_numSlotsUsed = 0;
+	size_t m_numSubresources = 0;
+	uint32_t m_numResources = 0;
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -12,6 +12,27 @@
 namespace inl::gxeng {
 
 
+/// <summary> Counts the native calls and descriptor copies a command list left out because they would not change anything. </summary>
+struct SkippedCallCounters {
+	size_t pipelineStates = 0;
+	size_t rootSignatures = 0; // binder set again
+	size_t rootDescriptors = 0; // root CBV set to the same address
+	size_t descriptorCopies = 0; // root table entry bound to the same descriptor
+	size_t vertexBuffers = 0;
+	size_t indexBuffers = 0;
+
+	SkippedCallCounters& operator+=(const SkippedCallCounters& rhs) {
+		pipelineStates += rhs.pipelineStates;
+		rootSignatures += rhs.rootSignatures;
+		rootDescriptors += rhs.rootDescriptors;
+		descriptorCopies += rhs.descriptorCopies;
+		vertexBuffers += rhs.vertexBuffers;
+		indexBuffers += rhs.indexBuffers;
+		return *this;
+	}
+};
+
+
 struct DescriptorTableState {
 	DescriptorTableState() : slot(0), committed(false) {}
 	DescriptorTableState(DescriptorArrayRef&& reference, int slot)
@@ -40,6 +61,15 @@ public:
 	void SetDescriptorHeap(StackDescHeap* heap);
 	void CommitDrawCall();
 	void UpdateBinding(gxapi::DescriptorHandle handle, int rootSignatureSlot, int indexInTable);
+
+	/// <summary> Forgets the bound binder and bindings, call it when the native list's state was cleared. </summary>
+	void ResetBindings();
+
+	const SkippedCallCounters& GetSkippedCalls() const { return m_skippedCalls; }
+protected:
+	/// <summary> Records the address of a root descriptor. </summary>
+	/// <returns> False if the root descriptor already points there, setting it can be skipped. </returns>
+	bool ChangeRootDescriptor(int rootSignatureSlot, void* gpuVirtualAddress);
 private:
 	/// <summary> Updates a binding which is managed on the scratch space. </summary>
 	void UpdateRootTable(gxapi::DescriptorHandle, int rootSignatureSlot, int indexInTable);
@@ -68,8 +98,10 @@ protected:
 	CommandListT* m_commandList;
 	Binder* m_binder;
 	StackDescHeap* m_heap;
+	SkippedCallCounters m_skippedCalls;
 private:
 	std::vector<DescriptorTableState> m_rootTableStates;
+	std::vector<void*> m_rootDescriptors; // bound address per root signature slot, null if unknown
 };
 
 
@@ -78,6 +110,8 @@ template <gxapi::eCommandListType Type>
 RootTableManager<Type>::RootTableManager() {
 	m_graphicsApi = nullptr;
 	m_commandList = nullptr;
+	m_binder = nullptr;
+	m_heap = nullptr;
 }
 
 
@@ -85,11 +119,18 @@ template <gxapi::eCommandListType Type>
 RootTableManager<Type>::RootTableManager(gxapi::IGraphicsApi* graphicsApi, CommandListT* commandList) {
 	m_graphicsApi = graphicsApi;
 	m_commandList = commandList;
+	m_binder = nullptr;
+	m_heap = nullptr;
 }
 
 
 template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::SetBinder(Binder* binder) {
+	// The root signature and the tables are still bound, and their contents are valid for the same binder.
+	if (binder == m_binder) {
+		++m_skippedCalls.rootSignatures;
+		return;
+	}
 	m_binder = binder;
 	SetRootSignature(m_commandList, m_binder->GetRootSignature());
 	InitRootTables();
@@ -116,10 +157,36 @@ void RootTableManager<Type>::UpdateBinding(gxapi::DescriptorHandle handle, int r
 }
 
 
+template <gxapi::eCommandListType Type>
+void RootTableManager<Type>::ResetBindings() {
+	m_binder = nullptr;
+	m_rootTableStates.clear();
+	m_rootDescriptors.clear();
+}
+
+
+template <gxapi::eCommandListType Type>
+bool RootTableManager<Type>::ChangeRootDescriptor(int rootSignatureSlot, void* gpuVirtualAddress) {
+	assert(rootSignatureSlot < (int)m_rootDescriptors.size());
+	if (m_rootDescriptors[rootSignatureSlot] == gpuVirtualAddress) {
+		++m_skippedCalls.rootDescriptors;
+		return false;
+	}
+	m_rootDescriptors[rootSignatureSlot] = gpuVirtualAddress;
+	return true;
+}
+
+
 template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::UpdateRootTable(gxapi::DescriptorHandle handle, int rootSignatureSlot, int indexInTable) {
 	DescriptorTableState& table = FindRootTable(rootSignatureSlot);
 
+	// the descriptor is already there, no need to copy it or to duplicate a committed table
+	if (table.bindings[indexInTable].cpuAddress == handle.cpuAddress) {
+		++m_skippedCalls.descriptorCopies;
+		return;
+	}
+
 	// if table is committed, duplicate it so that recent drawcalls won't be broken
 	if (table.committed) {
 		// update handle in advance so that duplicate will copy it instead and we save time
@@ -202,6 +269,7 @@ template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::InitRootTables() {
 	m_rootTableStates.clear();
 	const gxapi::RootSignatureDesc& desc = m_binder->GetRootSignatureDesc();
+	m_rootDescriptors.assign(desc.rootParameters.size(), nullptr);
 
 	for (size_t slot = 0; slot < desc.rootParameters.size(); slot++) {
 		auto& param = desc.rootParameters[slot];
@@ -255,6 +323,9 @@ template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::RenewRootTables() {
 	for (auto& table : m_rootTableStates) {
 		DuplicateRootTable(table);
+
+		// the old tables are in the previous heap, the root parameters must follow
+		SetRootDescriptorTable(m_commandList, table.slot, table.reference.Get(0));
 	}
 }
 
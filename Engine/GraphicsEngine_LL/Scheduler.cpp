@@ -3,8 +3,17 @@
 #include <GraphicsApi_LL/IGraphicsApi.hpp>
 
 #include "GraphicsCommandList.hpp"
+#include "UploadPlanner.hpp"
 
+#include <BaseLibrary/JobSystem.hpp>
+#include <BaseLibrary/Profiler.hpp>
+#include <BaseLibrary/Exception/Exception.hpp>
+
+#include <atomic>
 #include <cassert>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
 #include <iostream> // only for debugging
 
 namespace inl {
@@ -12,10 +21,15 @@ namespace gxeng {
 
 
 Scheduler::Scheduler()
+	: m_schedule(CompileSchedule(m_pipeline.GetTaskGraph(), m_pipeline.GetTaskFunctionMap(), &m_pipeline.GetActiveTaskMap()))
 {}
 
 void Scheduler::SetPipeline(Pipeline&& pipeline) {
 	m_pipeline = std::move(pipeline);
+	m_schedule = CompileSchedule(m_pipeline.GetTaskGraph(), m_pipeline.GetTaskFunctionMap(), &m_pipeline.GetActiveTaskMap());
+	LabelTasks(m_schedule, m_pipeline);
+	m_areConstantsValid = false;
+	m_transientPool.Clear();
 }
 
 const Pipeline& Scheduler::GetPipeline() const {
@@ -23,131 +37,124 @@ const Pipeline& Scheduler::GetPipeline() const {
 }
 
 Pipeline Scheduler::ReleasePipeline() {
-	return std::move(m_pipeline);
+	Pipeline pipeline = std::move(m_pipeline);
+	m_schedule = CompileSchedule(m_pipeline.GetTaskGraph(), m_pipeline.GetTaskFunctionMap(), &m_pipeline.GetActiveTaskMap());
+	m_transientPool.Clear();
+	return pipeline;
 }
 
 void Scheduler::Execute(FrameContext context) {
-	const auto& taskGraph = m_pipeline.GetTaskGraph();
-	const auto& taskFunctionMap = m_pipeline.GetTaskFunctionMap();
-
-	auto tasks = MakeSchedule(taskGraph, taskFunctionMap);
-
-	// Inject copy task to the start.
+	// Put copy task to the start. It does not depend on anything on the CPU,
+	// and on the GPU the tasks that use the uploaded resources wait for it.
 	UploadTask uploadTask(context.uploadRequests);
-	tasks.insert(tasks.begin(), &uploadTask);
+	m_schedule.tasks[Schedule::UploadTaskIndex] = &uploadTask;
+	const Schedule& schedule = m_schedule;
+	auto& tasks = schedule.tasks;
 
 	// Setup and execute the tasks.
 	try {
-		// PHASE I.: Setup() tasks in correct order
-		for (auto& task : tasks) {
-			if (task != nullptr) {
-				SetupContext setupContext(context.memoryManager, context.textureSpace, context.rtvHeap, context.dsvHeap, context.shaderManager, context.gxApi);
+		// PHASE 0.: Setup() tasks of constant nodes if the constants changed
+		if (!m_areConstantsValid) {
+			ProfileScope scope("Setup", "Folded constants");
+			for (GraphicsTask* task : m_pipeline.GetFoldedTasks()) {
+				SetupContext setupContext(context.memoryManager, context.textureSpace, context.rtvHeap, context.dsvHeap, context.shaderManager, context.gxApi, context.frameScratchAllocator);
 				task->Setup(setupContext);
 			}
+			m_areConstantsValid = true;
 		}
 
-
-		// PHASE II.: Execute() tasks in correct
-		for (auto& task : tasks) {
-			VolatileViewHeap volatileHeap(context.gxApi);
-			RenderContext renderContext(context.memoryManager,
-										context.textureSpace,
-										&volatileHeap,
-										context.shaderManager,
-										context.gxApi,
-										context.commandListPool,
-										context.commandAllocatorPool,
-										context.scratchSpacePool);
-
-			// Execute the task on the CPU.
-			if (task != nullptr) {
-				task->Execute(renderContext);
-
-				// Enqueue all command lists on the GPU.
-				if (renderContext.IsListInitialized()) {
-					BasicCommandList* commandList = nullptr;
-					switch (renderContext.GetType()) {
-						case gxapi::eCommandListType::GRAPHICS: commandList = &renderContext.AsGraphics(); break;
-						case gxapi::eCommandListType::COMPUTE: commandList = &renderContext.AsCompute(); break;
-						case gxapi::eCommandListType::COPY: commandList = &renderContext.AsCopy(); break;
-						default: assert(false);
-					}
-					BasicCommandList::Decomposition decomposition = commandList->Decompose();
-
-					std::sort(decomposition.usedResources.begin(), decomposition.usedResources.end(), [](const ResourceUsage& lhs, const ResourceUsage& rhs) {
-						auto lhsPtr = lhs.resource._GetResourcePtr();
-						auto rhsPtr = rhs.resource._GetResourcePtr();
-						return lhsPtr < rhsPtr || (lhs.resource._GetResourcePtr() == rhs.resource._GetResourcePtr() && lhs.subresource < rhs.subresource);
-					});
-
-					// Inject a transition barrier command list.
-					auto barriers = InjectBarriers(decomposition.usedResources.begin(), decomposition.usedResources.end());
-					if (barriers.size() > 0) {
-						CmdAllocPtr injectAlloc = context.commandAllocatorPool->RequestAllocator(gxapi::eCommandListType::GRAPHICS);
-						GraphicsCmdListPtr injectList = context.commandListPool->RequestGraphicsList(injectAlloc.get());
-
-						injectList->ResourceBarrier((unsigned)barriers.size(), barriers.data());
-						injectList->Close();
-
-						EnqueueCommandList(*context.commandQueue,
-										   std::move(injectList),
-										   std::move(injectAlloc),
-										   {},
-										   {},
-										   {},
-										   context);
-					}
-
-					// Update resource states.
-					UpdateResourceStates(decomposition.usedResources.begin(), decomposition.usedResources.end());
-
-					// Enqueue actual command list.
-					std::vector<MemoryObject> usedResourceList;
-					usedResourceList.reserve(decomposition.usedResources.size());
-					for (auto& v : decomposition.usedResources) {
-						usedResourceList.push_back(std::move(v.resource));
-					}
-					for (auto& v : decomposition.additionalResources) {
-						usedResourceList.push_back(std::move(v));
-					}
-
-					dynamic_cast<gxapi::ICopyCommandList*>(decomposition.commandList.get())->Close();
-
-					EnqueueCommandList(*context.commandQueue,
-									   std::move(decomposition.commandList),
-									   std::move(decomposition.commandAllocator),
-									   std::move(decomposition.scratchSpaces),
-									   std::move(usedResourceList),
-									   std::unique_ptr<VolatileViewHeap>(new VolatileViewHeap(std::move(volatileHeap))),
-									   context);
-
+		// PHASE I.: Setup() tasks in correct order
+		m_transientPool.BeginFrame(context.memoryManager);
+		for (size_t i = 0; i < tasks.size(); ++i) {
+			if (tasks[i] != nullptr) {
+				ProfileScope scope("Setup", schedule.taskClassNames[i], schedule.taskDisplayNames[i]);
+				SetupContext setupContext(context.memoryManager, context.textureSpace, context.rtvHeap, context.dsvHeap, context.shaderManager, context.gxApi, context.frameScratchAllocator, &m_transientPool, i);
+				tasks[i]->Setup(setupContext);
+			}
+		}
 
 
+		// PHASE II.: Execute() tasks, on worker threads if possible
+		std::vector<RecordedTask> records(tasks.size());
+		if (context.jobSystem != nullptr) {
+			RecordParallel(schedule, context, records);
+			for (auto& record : records) {
+				if (record.exception) {
+					std::rethrow_exception(record.exception);
 				}
 			}
 		}
+		else {
+			for (size_t i = 0; i < tasks.size(); ++i) {
+				RecordTask(schedule, i, context, records[i]);
+			}
+		}
 
-		// Set backBuffer to PRESENT state.
-		gxapi::eResourceState bbState = context.backBuffer->GetResource().ReadState(0);
-
-		if (bbState != gxapi::eResourceState::PRESENT) {
-			CmdAllocPtr injectAlloc = context.commandAllocatorPool->RequestAllocator(gxapi::eCommandListType::GRAPHICS);
-			GraphicsCmdListPtr injectList = context.commandListPool->RequestGraphicsList(injectAlloc.get());
+		// PHASE III.: Plan barriers for the whole frame, submit command lists in correct order
+		// This also sets the backbuffer to PRESENT state.
+		std::vector<gxapi::eCommandListType> taskQueues = AssignQueues(records, context);
+		BarrierPlan barrierPlan = [&] {
+			ProfileScope scope("Scheduler", "Plan barriers");
+			return PlanBarriers(records, taskQueues, context, m_isBarrierPlanningEnabled);
+		}();
+
+		// Transient textures sharing memory: a texture's first use waits for the last uses of those
+		// that had its memory earlier in the frame, and the memory is handed over by an aliasing barrier.
+		for (size_t i = 0; i < records.size(); ++i) {
+			for (auto& usage : records[i].decomposition.usedResources) {
+				m_transientPool.RecordUse(usage.resource._GetResourcePtr(), i);
+			}
+		}
+		for (auto& activation : m_transientPool.GetActivations()) {
+			auto& gap = barrierPlan.gaps[activation.firstUse];
+			gap.insert(gap.begin(), gxapi::AliasingBarrier{ nullptr, activation.resource });
+			auto& dependencies = barrierPlan.dependencies[activation.firstUse];
+			dependencies.insert(dependencies.end(), activation.waitFor.begin(), activation.waitFor.end());
+		}
 
-			injectList->ResourceBarrier(gxapi::TransitionBarrier{
-				context.backBuffer->GetResource()._GetResourcePtr(),
-				context.backBuffer->GetResource().ReadState(0),
-				gxapi::eResourceState::PRESENT });
-			injectList->Close();
-			context.backBuffer->GetResource().RecordState(gxapi::eResourceState::PRESENT);
+		// Tasks that are independent on the GPU may overlap on different queues.
+		std::vector<QueueTask> queueTasks(records.size());
+		for (size_t i = 0; i < records.size(); ++i) {
+			queueTasks[i].hasCommandList = records[i].hasCommandList;
+			queueTasks[i].queue = taskQueues[i];
+			queueTasks[i].hasBarriers = !barrierPlan.gaps[i].empty();
+			queueTasks[i].dependencies = std::move(barrierPlan.dependencies[i]);
+		}
+		for (size_t i = 0; i < records.size(); ++i) {
+			for (auto it = schedule.SuccessorsBegin(i); it != schedule.SuccessorsEnd(i); ++it) {
+				queueTasks[*it].dependencies.push_back(i);
+			}
+		}
+		QueuePlan queuePlan = [&] {
+			ProfileScope scope("Scheduler", "Plan queues");
+			return PlanQueues(queueTasks);
+		}();
+
+		std::array<std::unique_ptr<SubmissionBatcher>, NumQueues> batchers;
+		batchers[size_t(gxapi::eCommandListType::GRAPHICS)] = std::make_unique<SubmissionBatcher>(*context.commandQueue, *context.residencyQueue, m_maxSubmissionBatchSize);
+		if (context.computeQueue) {
+			batchers[size_t(gxapi::eCommandListType::COMPUTE)] = std::make_unique<SubmissionBatcher>(*context.computeQueue, *context.residencyQueue, m_maxSubmissionBatchSize);
+		}
+		if (context.copyQueue) {
+			batchers[size_t(gxapi::eCommandListType::COPY)] = std::make_unique<SubmissionBatcher>(*context.copyQueue, *context.residencyQueue, m_maxSubmissionBatchSize);
+		}
+		std::array<SubmissionBatcher*, NumQueues> batcherPtrs;
+		std::transform(batchers.begin(), batchers.end(), batcherPtrs.begin(), [](auto& batcher) { return batcher.get(); });
+
+		ProfileScope scope("Scheduler", "Submit tasks");
+		SubmitTasks(records, taskQueues, barrierPlan, queuePlan, context, m_isBarrierPlanningEnabled, batcherPtrs);
+		for (auto& batcher : batchers) {
+			if (batcher) {
+				batcher->Flush();
+			}
+		}
 
-			EnqueueCommandList(*context.commandQueue,
-				std::move(injectList),
-				std::move(injectAlloc),
-				{},
-				{},
-				{},
-				context);
+		if (m_transientPool.EndFrame()) {
+			auto& statistics = m_transientPool.GetStatistics();
+			context.log->Event("Transient textures placed again: " + std::to_string(statistics.numTextures) + " textures, "
+				+ std::to_string(statistics.totalSize / 1024) + " KiB separately, "
+				+ std::to_string(statistics.heapSize / 1024) + " KiB in heaps, "
+				+ std::to_string(statistics.peakLiveSize / 1024) + " KiB peak.");
 		}
 	}
 	catch (std::exception& ex) {
@@ -165,6 +172,28 @@ void Scheduler::Execute(FrameContext context) {
 			context.log->Event(std::string("Fatal pipeline Execute error, could not render error screen: ") + ex.what());
 		}
 	}
+
+	m_schedule.tasks[Schedule::UploadTaskIndex] = nullptr;
+}
+
+
+void Scheduler::SetBarrierPlanning(bool enabled) {
+	m_isBarrierPlanningEnabled = enabled;
+}
+
+
+void Scheduler::SetSubmissionBatchSize(size_t maxBatchSize) {
+	m_maxSubmissionBatchSize = maxBatchSize;
+}
+
+
+const TransientResourcePool::Statistics& Scheduler::GetTransientStatistics() const {
+	return m_transientPool.GetStatistics();
+}
+
+
+void Scheduler::InvalidateConstants() {
+	m_areConstantsValid = false;
 }
 
 
@@ -174,6 +203,9 @@ void Scheduler::ReleaseResources() {
 			ptr->Reset();
 		}
 	}
+	// Reset may clear inputs that were set by folded nodes.
+	m_areConstantsValid = false;
+	m_transientPool.Clear();
 }
 
 
@@ -186,57 +218,489 @@ void Scheduler::Evict(std::vector<MemoryObject*> usedResources) {
 
 }
 
-std::vector<GraphicsTask*> Scheduler::MakeSchedule(const lemon::ListDigraph& taskGraph,
-													const lemon::ListDigraph::NodeMap<GraphicsTask*>& taskFunctionMap
-/*std::vector<CommandQueue*> queues*/)
+auto Scheduler::CompileSchedule(const lemon::ListDigraph& taskGraph,
+								const lemon::ListDigraph::NodeMap<GraphicsTask*>& taskFunctionMap,
+								const lemon::ListDigraph::NodeMap<bool>* activeTasks
+								/*std::vector<CommandQueue*> queues*/) -> Schedule
 {
-	// Topologically sort the tasks.
-	lemon::ListDigraph::NodeMap<int> taskOrderMap(taskGraph);
-	bool isSortable = lemon::checkedTopologicalSort(taskGraph, taskOrderMap);
-	assert(isSortable);
+	Schedule schedule;
+	schedule.tasks.push_back(nullptr); // slot of the upload task
+	schedule.levelOffsets.push_back(0);
 
-	std::vector<lemon::ListDigraph::NodeIt> taskNodes;
+	auto IsActive = [activeTasks](lemon::ListDigraph::Node taskNode) {
+		return activeTasks == nullptr || (*activeTasks)[taskNode];
+	};
+
+	// Sort the tasks level by level: a task goes to the level after its last predecessor's.
+	lemon::ListDigraph::NodeMap<unsigned> remainingPredecessors(taskGraph, 0);
+	std::vector<lemon::ListDigraph::Node> level;
+	size_t numActiveTasks = 0;
 	for (lemon::ListDigraph::NodeIt taskNode(taskGraph); taskNode != lemon::INVALID; ++taskNode) {
-		taskNodes.push_back(taskNode);
+		if (!IsActive(taskNode)) {
+			continue;
+		}
+		++numActiveTasks;
+		for (lemon::ListDigraph::InArcIt arc(taskGraph, taskNode); arc != lemon::INVALID; ++arc) {
+			remainingPredecessors[taskNode] += IsActive(taskGraph.source(arc)) ? 1 : 0;
+		}
+		if (remainingPredecessors[taskNode] == 0) {
+			level.push_back(taskNode);
+		}
 	}
 
-	std::sort(taskNodes.begin(), taskNodes.end(), [&](auto n1, auto n2)
-	{
-		return taskOrderMap[n1] < taskOrderMap[n2];
-	});
+	std::vector<lemon::ListDigraph::Node> taskNodes; // in schedule order, without the upload task
+	lemon::ListDigraph::NodeMap<size_t> taskIndexMap(taskGraph);
+	std::vector<lemon::ListDigraph::Node> nextLevel;
+	while (!level.empty()) {
+		for (auto taskNode : level) {
+			taskIndexMap[taskNode] = schedule.tasks.size();
+			schedule.tasks.push_back(taskFunctionMap[taskNode]);
+			taskNodes.push_back(taskNode);
+			for (lemon::ListDigraph::OutArcIt arc(taskGraph, taskNode); arc != lemon::INVALID; ++arc) {
+				auto successor = taskGraph.target(arc);
+				if (IsActive(successor) && --remainingPredecessors[successor] == 0) {
+					nextLevel.push_back(successor);
+				}
+			}
+		}
+		schedule.levelOffsets.push_back(schedule.tasks.size());
+		level.swap(nextLevel);
+		nextLevel.clear();
+	}
+	if (schedule.levelOffsets.size() == 1) {
+		schedule.levelOffsets.push_back(schedule.tasks.size()); // level of the upload task alone
+	}
+	if (taskNodes.size() != numActiveTasks) {
+		throw InvalidArgumentException("Task graph contains a cycle.");
+	}
+
+	// Record dependencies by index.
+	const size_t numTasks = schedule.tasks.size();
+	schedule.predecessorCounts.resize(numTasks, 0);
+	schedule.successorOffsets.resize(numTasks + 1, 0);
+	for (size_t index = 1; index < numTasks; ++index) {
+		schedule.successorOffsets[index] = schedule.successorIndices.size();
+		for (lemon::ListDigraph::OutArcIt arc(taskGraph, taskNodes[index - 1]); arc != lemon::INVALID; ++arc) {
+			if (!IsActive(taskGraph.target(arc))) {
+				continue;
+			}
+			size_t successor = taskIndexMap[taskGraph.target(arc)];
+			schedule.successorIndices.push_back(successor);
+			++schedule.predecessorCounts[successor];
+		}
+	}
+	schedule.successorOffsets[numTasks] = schedule.successorIndices.size();
+
+	schedule.taskClassNames.resize(numTasks, "Task");
+	schedule.taskDisplayNames.resize(numTasks, nullptr);
+	schedule.taskClassNames[Schedule::UploadTaskIndex] = "Upload";
+
+	return schedule;
+}
+
+
+void Scheduler::LabelTasks(Schedule& schedule, const Pipeline& pipeline) {
+	// Class names are looked up once per pipeline, getting them is too slow to do every frame.
+	Profiler& profiler = Profiler::GetInstance();
+	std::unordered_map<const GraphicsTask*, const NodeBase*> owners;
+	for (lemon::ListDigraph::NodeIt taskNode(pipeline.GetTaskGraph()); taskNode != lemon::INVALID; ++taskNode) {
+		lemon::ListDigraph::Node dependencyNode = pipeline.GetTaskParentMap()[taskNode];
+		owners[pipeline.GetTaskFunctionMap()[taskNode]] = pipeline.GetNodeMap()[dependencyNode].get();
+	}
+
+	for (size_t i = 0; i < schedule.tasks.size(); ++i) {
+		auto it = owners.find(schedule.tasks[i]);
+		if (schedule.tasks[i] != nullptr && it != owners.end() && it->second != nullptr) {
+			const NodeBase* node = it->second;
+			schedule.taskClassNames[i] = profiler.Intern(node->GetClassName(true, { "inl::gxeng::", "inl::" }));
+			schedule.taskDisplayNames[i] = node->GetDisplayName().empty() ? nullptr : profiler.Intern(node->GetDisplayName());
+		}
+	}
+}
+
+
+void Scheduler::RecordTask(const Schedule& schedule, size_t index, const FrameContext& context, RecordedTask& record) {
+	GraphicsTask* task = schedule.tasks[index];
+	if (task == nullptr) {
+		return;
+	}
+	ProfileScope scope("Execute", schedule.taskClassNames[index], schedule.taskDisplayNames[index]);
+
+	record.volatileHeap = std::make_unique<VolatileViewHeap>(context.gxApi);
+	RenderContext renderContext(context.memoryManager,
+								context.textureSpace,
+								record.volatileHeap.get(),
+								context.shaderManager,
+								context.gxApi,
+								context.commandListPool,
+								context.commandAllocatorPool,
+								context.scratchSpacePool,
+								context.frameScratchAllocator);
+	renderContext.SetAsyncQueues(context.computeQueue != nullptr, context.copyQueue != nullptr);
+
+	// Execute the task on the CPU.
+	task->Execute(renderContext);
+
+	if (renderContext.IsListInitialized()) {
+		BasicCommandList* commandList = nullptr;
+		switch (renderContext.GetType()) {
+			case gxapi::eCommandListType::GRAPHICS: commandList = &renderContext.AsGraphics(); break;
+			case gxapi::eCommandListType::COMPUTE: commandList = &renderContext.AsCompute(); break;
+			case gxapi::eCommandListType::COPY: commandList = &renderContext.AsCopy(); break;
+			default: assert(false);
+		}
+		record.decomposition = commandList->Decompose(); // used resources come sorted
+		record.hasCommandList = true;
+	}
+}
+
+
+void Scheduler::RecordParallel(const Schedule& schedule, const FrameContext& context, std::vector<RecordedTask>& records) {
+	JobSystem& jobSystem = *context.jobSystem;
+	const size_t numTasks = schedule.tasks.size();
+
+	std::unique_ptr<std::atomic<unsigned>[]> remainingPredecessors(new std::atomic<unsigned>[numTasks]);
+	for (size_t i = 0; i < numTasks; ++i) {
+		remainingPredecessors[i].store(schedule.predecessorCounts[i], std::memory_order_relaxed);
+	}
+	std::atomic_bool isFailed(false);
+	JobCounter counter;
+
+	// Records a task then releases its successors. One of the successors that became ready
+	// is recorded on the same thread right away, the others are handed to the job system.
+	std::function<void(size_t)> recordFrom = [&](size_t index) {
+		constexpr size_t None = ~size_t(0);
+		while (index != None) {
+			RecordedTask& record = records[index];
+			if (!isFailed.load(std::memory_order_relaxed)) {
+				try {
+					RecordTask(schedule, index, context, record);
+				}
+				catch (...) {
+					record.exception = std::current_exception();
+					isFailed.store(true, std::memory_order_relaxed);
+				}
+			}
+
+			size_t next = None;
+			for (auto it = schedule.SuccessorsBegin(index); it != schedule.SuccessorsEnd(index); ++it) {
+				size_t successor = *it;
+				if (remainingPredecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					if (next == None) {
+						next = successor;
+					}
+					else {
+						jobSystem.Run([&recordFrom, successor] { recordFrom(successor); }, &counter);
+					}
+				}
+			}
+			index = next;
+		}
+	};
+
+	for (size_t i = 0; i < numTasks; ++i) {
+		if (schedule.predecessorCounts[i] == 0) {
+			jobSystem.Run([&recordFrom, i] { recordFrom(i); }, &counter);
+		}
+	}
+	jobSystem.Wait(counter);
+}
+
+
+auto Scheduler::PlanBarriers(std::vector<RecordedTask>& records, const std::vector<gxapi::eCommandListType>& taskQueues, const FrameContext& context, bool splitBarriers) -> BarrierPlan {
+	auto barrierAllocator = context.frameScratchAllocator ? context.frameScratchAllocator->GetAdaptor<gxapi::ResourceBarrier>() : LinearAllocatorAdaptor<gxapi::ResourceBarrier>();
+	const size_t numTasks = records.size();
+
+	BarrierPlan plan;
+	plan.gaps.resize(numTasks + 1, BarrierList(barrierAllocator));
+	plan.dependencies.resize(numTasks);
+
+	// Number of command lists submitted before each task.
+	std::vector<size_t> listsBefore(numTasks + 1, 0);
+	for (size_t i = 0; i < numTasks; ++i) {
+		listsBefore[i + 1] = listsBefore[i] + (records[i].hasCommandList ? 1 : 0);
+	}
+
+	// The last task that used each subresource in this frame.
+	struct SubresourceHash {
+		size_t operator()(const std::pair<const gxapi::IResource*, unsigned>& key) const {
+			return std::hash<const gxapi::IResource*>()(key.first) ^ (size_t(key.second) * 0x9E3779B9u);
+		}
+	};
+	constexpr size_t NoTask = ~size_t(0);
+	std::unordered_map<std::pair<const gxapi::IResource*, unsigned>, size_t, SubresourceHash> lastUses;
+
+	auto Transition = [&](MemoryObject& resource, unsigned subresource, gxapi::eResourceState targetState, size_t task) {
+		size_t& lastUse = lastUses.insert({ { resource._GetResourcePtr(), subresource }, NoTask }).first->second;
+		if (lastUse == task) {
+			return; // already transitioned for an earlier use in the same task
+		}
+		if (lastUse != NoTask && task < numTasks) {
+			auto& dependencies = plan.dependencies[task];
+			if (std::find(dependencies.begin(), dependencies.end(), lastUse) == dependencies.end()) {
+				dependencies.push_back(lastUse);
+			}
+		}
+		gxapi::eResourceState sourceState = resource.ReadState(subresource);
+		if (sourceState != targetState) {
+			bool isIdle = lastUse != NoTask && listsBefore[task] > listsBefore[lastUse + 1];
+			bool isOnGraphicsQueue = lastUse != NoTask && taskQueues[lastUse] == gxapi::eCommandListType::GRAPHICS;
+			if (splitBarriers && isIdle && isOnGraphicsQueue) {
+				plan.gaps[lastUse + 1].push_back(gxapi::TransitionBarrier{ resource._GetResourcePtr(), sourceState, targetState, subresource, gxapi::eResourceBarrierSplit::BEGIN });
+				plan.gaps[task].push_back(gxapi::TransitionBarrier{ resource._GetResourcePtr(), sourceState, targetState, subresource, gxapi::eResourceBarrierSplit::END });
+				++plan.numSplitBarriers;
+			}
+			else {
+				plan.gaps[task].push_back(gxapi::TransitionBarrier{ resource._GetResourcePtr(), sourceState, targetState, subresource });
+			}
+		}
+		lastUse = task;
+	};
+
+	for (size_t i = 0; i < numTasks; ++i) {
+		if (!records[i].hasCommandList) {
+			continue;
+		}
+		auto& usedResources = records[i].decomposition.usedResources;
+		for (auto& usage : usedResources) {
+			if (usage.subresource != gxapi::ALL_SUBRESOURCES) {
+				Transition(usage.resource, usage.subresource, usage.firstState, i);
+			}
+			else {
+				for (unsigned subresource = 0; subresource < usage.resource.GetNumSubresources(); ++subresource) {
+					Transition(usage.resource, subresource, usage.firstState, i);
+				}
+			}
+		}
+		UpdateResourceStates(usedResources.begin(), usedResources.end());
+	}
 
-	// Make a list of them.
-	std::vector<GraphicsTask*> tasks;
-	for (auto node : taskNodes) {
-		auto& task = taskFunctionMap[node];
-		tasks.push_back(task);
+	// Set backBuffer to PRESENT state after all tasks.
+	MemoryObject& backBuffer = context.backBuffer->GetResource();
+	for (unsigned subresource = 0; subresource < backBuffer.GetNumSubresources(); ++subresource) {
+		Transition(backBuffer, subresource, gxapi::eResourceState::PRESENT, numTasks);
 	}
+	backBuffer.RecordState(gxapi::eResourceState::PRESENT);
+
+	return plan;
+}
+
 
-	return tasks;
+auto Scheduler::AssignQueues(const std::vector<RecordedTask>& records, const FrameContext& context) -> std::vector<gxapi::eCommandListType> {
+	std::vector<gxapi::eCommandListType> taskQueues(records.size(), gxapi::eCommandListType::GRAPHICS);
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (!records[i].hasCommandList) {
+			continue;
+		}
+		gxapi::eCommandListType type = records[i].decomposition.commandList->GetType();
+		if ((type == gxapi::eCommandListType::COMPUTE && context.computeQueue) || (type == gxapi::eCommandListType::COPY && context.copyQueue)) {
+			taskQueues[i] = type;
+		}
+	}
+	return taskQueues;
 }
 
 
-void Scheduler::EnqueueCommandList(CommandQueue& commandQueue,
-								   CmdListPtr commandList,
-								   CmdAllocPtr commandAllocator,
-								   std::vector<ScratchSpacePtr> scratchSpaces,
-								   std::vector<MemoryObject> usedResources,
-								   std::unique_ptr<VolatileViewHeap> volatileHeap,
-								   const FrameContext& context)
+auto Scheduler::PlanQueues(const std::vector<QueueTask>& tasks) -> QueuePlan {
+	// For each queue, the last task known to have finished on it, like a vector clock.
+	using Progress = std::array<ptrdiff_t, NumQueues>;
+	constexpr ptrdiff_t Nothing = QueuePosition::FrameStart - 1;
+	constexpr size_t Graphics = size_t(gxapi::eCommandListType::GRAPHICS);
+	const size_t numTasks = tasks.size();
+
+	QueuePlan plan;
+	plan.gapWaits.resize(numTasks + 1);
+	plan.taskWaits.resize(numTasks);
+
+	Progress frameStart;
+	frameStart.fill(Nothing);
+	frameStart[Graphics] = QueuePosition::FrameStart;
+
+	// What each queue has synchronized with so far, and what finishing a position on a queue implies.
+	std::array<Progress, NumQueues> queueProgress;
+	std::array<std::vector<Progress>, NumQueues> positionProgress; // indexed by task + 1, the first is the frame start
+	for (size_t queue = 0; queue < NumQueues; ++queue) {
+		queueProgress[queue].fill(Nothing);
+		queueProgress[queue][queue] = QueuePosition::FrameStart;
+		positionProgress[queue].resize(numTasks + 1, queueProgress[queue]);
+	}
+	positionProgress[Graphics][0] = frameStart;
+	std::vector<Progress> taskProgress(numTasks);
+
+	auto Merge = [](Progress& target, const Progress& source) {
+		for (size_t queue = 0; queue < NumQueues; ++queue) {
+			target[queue] = std::max(target[queue], source[queue]);
+		}
+	};
+	auto Wait = [&](size_t queue, const Progress& needed, std::vector<QueuePosition>& waits) {
+		Progress& progress = queueProgress[queue];
+		for (size_t other = 0; other < NumQueues; ++other) {
+			if (other != queue && needed[other] > progress[other]) {
+				waits.push_back({ gxapi::eCommandListType(other), needed[other] });
+				Merge(progress, positionProgress[other][needed[other] + 1]);
+			}
+		}
+	};
+	auto Finish = [&](size_t queue, size_t task) {
+		queueProgress[queue][queue] = ptrdiff_t(task);
+		positionProgress[queue][task + 1] = queueProgress[queue];
+		return queueProgress[queue];
+	};
+
+	for (size_t task = 0; task < numTasks; ++task) {
+		Progress needed = frameStart;
+		for (size_t dependency : tasks[task].dependencies) {
+			assert(dependency < task);
+			Merge(needed, taskProgress[dependency]);
+		}
+		if (!tasks[task].hasCommandList) {
+			taskProgress[task] = needed; // passes on the dependencies
+			continue;
+		}
+
+		size_t queue = size_t(tasks[task].queue);
+		if (queue == Graphics) {
+			Wait(Graphics, needed, plan.gapWaits[task]);
+		}
+		else {
+			if (tasks[task].hasBarriers) {
+				Wait(Graphics, needed, plan.gapWaits[task]);
+				Merge(needed, Finish(Graphics, task));
+			}
+			Wait(queue, needed, plan.taskWaits[task]);
+		}
+		taskProgress[task] = Finish(queue, task);
+	}
+
+	// Join all queues at the end of the frame, so the next one starts from a clean slate.
+	Progress all;
+	all.fill(Nothing);
+	for (size_t queue = 0; queue < NumQueues; ++queue) {
+		if (queueProgress[queue][queue] != QueuePosition::FrameStart) {
+			all[queue] = queueProgress[queue][queue];
+		}
+	}
+	Wait(Graphics, all, plan.gapWaits[numTasks]);
+
+	return plan;
+}
+
+
+void Scheduler::SubmitTasks(std::vector<RecordedTask>& records,
+							const std::vector<gxapi::eCommandListType>& taskQueues,
+							BarrierPlan& barrierPlan,
+							const QueuePlan& queuePlan,
+							const FrameContext& context,
+							bool mergeBarriers,
+							const std::array<SubmissionBatcher*, NumQueues>& batchers)
 {
-	// Enqueue CPU task to make resources resident before the command list runs.
-	SyncPoint residentPoint = context.residencyQueue->EnqueueInit(usedResources);
+	constexpr size_t Graphics = size_t(gxapi::eCommandListType::GRAPHICS);
+	SubmissionBatcher& graphicsBatcher = *batchers[Graphics];
+	RecordedTask* previous = nullptr; // last graphics task, not yet closed so that barriers can be appended
+
+	// Last position enqueued to each queue, and the last one signaled.
+	std::array<ptrdiff_t, NumQueues> enqueued;
+	std::array<ptrdiff_t, NumQueues> signaled;
+	std::array<SyncPoint, NumQueues> signalPoints;
+	enqueued.fill(ptrdiff_t(QueuePosition::FrameStart));
+	signaled.fill(ptrdiff_t(QueuePosition::FrameStart - 1));
+
+	// Mark the start of the frame before anything is enqueued, so that waiting for it does not include this frame's work.
+	bool waitsForFrameStart = std::any_of(queuePlan.taskWaits.begin(), queuePlan.taskWaits.end(), [](const std::vector<QueuePosition>& waits) {
+		return std::any_of(waits.begin(), waits.end(), [](const QueuePosition& position) { return position.task == QueuePosition::FrameStart; });
+	});
+	if (waitsForFrameStart) {
+		signalPoints[Graphics] = graphicsBatcher.Signal();
+		signaled[Graphics] = QueuePosition::FrameStart;
+	}
 
-	// Enqueue the command list itself on the GPU.
-	gxapi::ICommandList* execLists[] = {
-		commandList.get(),
+	auto SubmitPrevious = [&] {
+		if (previous != nullptr) {
+			SubmitTask(*previous, graphicsBatcher);
+			previous = nullptr;
+		}
 	};
-	context.commandQueue->Wait(residentPoint);
-	context.commandQueue->ExecuteCommandLists(1, execLists);
-	SyncPoint completionPoint = context.commandQueue->Signal();
+	auto Wait = [&](size_t queue, const std::vector<QueuePosition>& waits) {
+		for (const QueuePosition& position : waits) {
+			size_t other = size_t(position.queue);
+			if (signaled[other] < position.task) {
+				if (other == Graphics) {
+					SubmitPrevious();
+				}
+				signalPoints[other] = batchers[other]->Signal();
+				signaled[other] = enqueued[other];
+			}
+			if (queue == Graphics) {
+				SubmitPrevious();
+			}
+			batchers[queue]->Wait(signalPoints[other]);
+		}
+	};
+
+	for (size_t gap = 0; gap < barrierPlan.gaps.size(); ++gap) {
+		Wait(Graphics, queuePlan.gapWaits[gap]);
 
-	// Enqueue CPU task to clean up resources after command list finished.
-	context.residencyQueue->EnqueueClean(completionPoint, std::move(usedResources), std::move(commandAllocator), std::move(scratchSpaces), std::move(volatileHeap));
+		const BarrierList& barriers = barrierPlan.gaps[gap];
+		if (!barriers.empty()) {
+			bool canMerge = mergeBarriers
+				&& previous != nullptr
+				&& previous->decomposition.commandList->GetType() == gxapi::eCommandListType::GRAPHICS;
+			if (canMerge) {
+				dynamic_cast<gxapi::ICopyCommandList*>(previous->decomposition.commandList.get())->ResourceBarrier((unsigned)barriers.size(), const_cast<gxapi::ResourceBarrier*>(barriers.data()));
+			}
+			else {
+				SubmitPrevious();
+				SubmitBarriers(barriers, context, graphicsBatcher);
+			}
+			enqueued[Graphics] = gap;
+		}
+
+		if (gap < records.size() && records[gap].hasCommandList) {
+			size_t queue = size_t(taskQueues[gap]);
+			if (queue == Graphics) {
+				SubmitPrevious();
+				previous = &records[gap];
+			}
+			else {
+				Wait(queue, queuePlan.taskWaits[gap]);
+				SubmitTask(records[gap], *batchers[queue]);
+			}
+			enqueued[queue] = gap;
+		}
+	}
+	SubmitPrevious();
+}
+
+
+void Scheduler::SubmitTask(RecordedTask& record, SubmissionBatcher& batcher) {
+	BasicCommandList::Decomposition& decomposition = record.decomposition;
+	dynamic_cast<gxapi::ICopyCommandList*>(decomposition.commandList.get())->Close();
+
+	std::vector<MemoryObject> usedResourceList;
+	usedResourceList.reserve(decomposition.usedResources.size() + decomposition.additionalResources.size());
+	for (auto& v : decomposition.usedResources) {
+		usedResourceList.push_back(std::move(v.resource));
+	}
+	for (auto& v : decomposition.additionalResources) {
+		usedResourceList.push_back(std::move(v));
+	}
+
+	batcher.Enqueue(std::move(decomposition.commandList),
+					std::move(decomposition.commandAllocator),
+					std::move(decomposition.scratchSpaces),
+					std::move(usedResourceList),
+					std::move(record.volatileHeap));
+}
+
+
+void Scheduler::SubmitBarriers(const BarrierList& barriers, const FrameContext& context, SubmissionBatcher& batcher) {
+	CmdAllocPtr injectAlloc = context.commandAllocatorPool->RequestAllocator(gxapi::eCommandListType::GRAPHICS);
+	GraphicsCmdListPtr injectList = context.commandListPool->RequestGraphicsList(injectAlloc.get());
+
+	injectList->ResourceBarrier((unsigned)barriers.size(), const_cast<gxapi::ResourceBarrier*>(barriers.data()));
+	injectList->Close();
+
+	batcher.Enqueue(std::move(injectList), std::move(injectAlloc), {}, {}, {});
 }
 
 
@@ -304,7 +768,9 @@ void Scheduler::RenderFailureScreen(FrameContext context) {
 
 	// Enqueue command list.
 	commandList->Close();
-	EnqueueCommandList(*context.commandQueue, std::move(commandList), std::move(commandAllocator), {}, {}, {}, context);
+	SubmissionBatcher batcher(*context.commandQueue, *context.residencyQueue);
+	batcher.Enqueue(std::move(commandList), std::move(commandAllocator), {}, {}, {});
+	batcher.Flush();
 }
 
 
@@ -312,26 +778,46 @@ void Scheduler::UploadTask::Setup(SetupContext& context) {
 	return;
 }
 void Scheduler::UploadTask::Execute(RenderContext& context) {
-	CopyCommandList& commandList = context.AsGraphics();
-
-	for (auto& request : *m_uploads) {
-		// Init copy parameters
-		auto& source = request.source;
-		auto& destination = const_cast<MemoryObject&>(request.destination);
-
-		// Set resource states
-		commandList.SetResourceState(destination, gxapi::eResourceState::COPY_DEST);
-
-		auto destType = request.destType;
+	CopyCommandList& commandList = context.AsCopy();
+	const std::vector<UploadManager::UploadDescription>& uploads = *m_uploads;
+
+	// Split the requests by destination type, the planner identifies resources by their address.
+	std::vector<BufferUploadRange> bufferRanges;
+	std::vector<size_t> bufferRequests;
+	std::vector<TextureUploadRegion> textureRegions;
+	std::vector<size_t> textureRequests;
+	for (size_t i = 0; i < uploads.size(); ++i) {
+		auto& request = uploads[i];
+		if (request.destType == UploadManager::DestType::BUFFER) {
+			bufferRanges.push_back({ request.destination._GetResourcePtr(), request.dstOffsetX, request.size, request.source._GetResourcePtr(), request.srcOffset });
+			bufferRequests.push_back(i);
+		}
+		else if (request.destType == UploadManager::DestType::TEXTURE_2D) {
+			textureRegions.push_back({ request.destination._GetResourcePtr(), request.dstSubresource, request.dstOffsetX, request.dstOffsetY, request.textureBufferDesc.width, request.textureBufferDesc.height });
+			textureRequests.push_back(i);
+		}
+	}
 
-		if (destType == UploadManager::DestType::BUFFER) {
-			auto& dstBuffer = static_cast<LinearBuffer&>(destination);
-			commandList.CopyBuffer(dstBuffer, request.dstOffsetX, source, 0, dstBuffer.GetSize());
+	// Copies come grouped by destination, each destination is transitioned once.
+	const gxapi::IResource* lastDestination = nullptr;
+	for (const BufferUploadCopy& copy : PlanBufferCopies(bufferRanges)) {
+		auto& request = uploads[bufferRequests[copy.upload]];
+		auto& dstBuffer = static_cast<LinearBuffer&>(const_cast<MemoryObject&>(request.destination));
+		if (dstBuffer._GetResourcePtr() != lastDestination) {
+			commandList.SetResourceState(dstBuffer, gxapi::eResourceState::COPY_DEST);
+			lastDestination = dstBuffer._GetResourcePtr();
 		}
-		else if (destType == UploadManager::DestType::TEXTURE_2D) {
-			auto& dstTexture = static_cast<Texture2D&>(destination);
-			commandList.CopyTexture(dstTexture, source, SubTexture2D(request.dstSubresource, Vector<intptr_t, 2>((intptr_t)request.dstOffsetX, (intptr_t)request.dstOffsetY)), request.textureBufferDesc);
+		commandList.CopyBuffer(dstBuffer, copy.dstOffset, request.source, copy.srcOffset, copy.size);
+	}
+
+	for (size_t textureIndex : PlanTextureCopies(textureRegions)) {
+		auto& request = uploads[textureRequests[textureIndex]];
+		auto& dstTexture = static_cast<Texture2D&>(const_cast<MemoryObject&>(request.destination));
+		if (dstTexture._GetResourcePtr() != lastDestination) {
+			commandList.SetResourceState(dstTexture, gxapi::eResourceState::COPY_DEST);
+			lastDestination = dstTexture._GetResourcePtr();
 		}
+		commandList.CopyTexture(dstTexture, request.source, SubTexture2D(request.dstSubresource, Vector<intptr_t, 2>((intptr_t)request.dstOffsetX, (intptr_t)request.dstOffsetY)), request.textureBufferDesc);
 	}
 }
 
@@ -6,12 +6,18 @@
 #include "ScratchSpacePool.hpp"
 #include "CommandListPool.hpp"
 #include "MemoryObject.hpp"
+#include "BasicCommandList.hpp"
+#include "SubmissionBatcher.hpp"
+#include "TransientResourcePool.hpp"
 
 #include <BaseLibrary/optional.hpp>
+#include <BaseLibrary/Memory/LinearAllocator.hpp>
 #include <GraphicsApi_LL/IFence.hpp>
 #include <GraphicsApi_LL/Common.hpp>
+#include <array>
 #include <memory>
 #include <cstdint>
+#include <exception>
 #include <vector>
 
 namespace inl {
@@ -29,6 +35,21 @@ public:
 	Pipeline ReleasePipeline();
 	void Execute(FrameContext context);
 	void ReleaseResources();
+
+	/// <summary> Sets up the tasks of the pipeline's folded nodes again before the next frame.
+	///		Call it when anything the constant nodes depend on changed. </summary>
+	void InvalidateConstants();
+
+	/// <summary> When enabled, which is the default, barriers are appended to the command list of the previous task,
+	///		and resources that are idle between two tasks are transitioned with split barriers.
+	///		Otherwise the barriers of each task are submitted in a separate command list right before it. </summary>
+	void SetBarrierPlanning(bool enabled);
+
+	/// <summary> Command lists are submitted in batches of at most this many. Zero, the default, submits the whole frame at once. </summary>
+	void SetSubmissionBatchSize(size_t maxBatchSize);
+
+	/// <summary> Memory of the transient textures nodes requested in the last frames. </summary>
+	const TransientResourcePool::Statistics& GetTransientStatistics() const;
 protected:
 	struct UsedResource {
 		MemoryObject* resource;
@@ -37,28 +58,127 @@ protected:
 		bool multipleUse;
 	};
 
+	/// <summary> Tasks in a valid execution order along with their dependencies.
+	///		Compiled once per pipeline, executing a frame only walks the arrays. </summary>
+	struct Schedule {
+		static constexpr size_t UploadTaskIndex = 0;
+
+		/// <summary> Grouped by level, may contain nullptrs for merge points of the graph.
+		///		The first slot is reserved for the upload task of the frame. </summary>
+		std::vector<GraphicsTask*> tasks;
+		std::vector<unsigned> predecessorCounts; /// <summary> Number of tasks each task depends on. </summary>
+		std::vector<size_t> successorOffsets; /// <summary> Successors of task i are successorIndices[successorOffsets[i]..successorOffsets[i+1]). </summary>
+		std::vector<size_t> successorIndices;
+		/// <summary> Tasks of level l are [levelOffsets[l], levelOffsets[l+1]).
+		///		A task's predecessors are all on lower levels, so tasks of the same level are independent. </summary>
+		std::vector<size_t> levelOffsets;
+		/// <summary> Class name of the node that owns each task, and the node's display name, for the profiler.
+		///		Interned by the profiler, the display name may be null. </summary>
+		std::vector<const char*> taskClassNames;
+		std::vector<const char*> taskDisplayNames;
+
+		size_t GetNumTasks() const { return tasks.size(); }
+		size_t GetNumLevels() const { return levelOffsets.size() - 1; }
+		const size_t* SuccessorsBegin(size_t task) const { return successorIndices.data() + successorOffsets[task]; }
+		const size_t* SuccessorsEnd(size_t task) const { return successorIndices.data() + successorOffsets[task + 1]; }
+	};
 
-	static void MakeResident(std::vector<MemoryObject*> usedResources);
-	static void Evict(std::vector<MemoryObject*> usedResources);
+	/// <summary> The output of a task's Execute(), waiting to be submitted. </summary>
+	struct RecordedTask {
+		std::unique_ptr<VolatileViewHeap> volatileHeap;
+		bool hasCommandList = false;
+		BasicCommandList::Decomposition decomposition; /// <summary> Open command list, used resources sorted by address. </summary>
+		std::exception_ptr exception;
+	};
 
+	using BarrierList = std::vector<gxapi::ResourceBarrier, LinearAllocatorAdaptor<gxapi::ResourceBarrier>>;
 
-	static std::vector<GraphicsTask*> MakeSchedule(const lemon::ListDigraph& taskGraph,
-												   const lemon::ListDigraph::NodeMap<GraphicsTask*>& taskFunctionMap
-													/*std::vector<CommandQueue*> queues*/);
+	/// <summary> Barriers of a frame, placed between the tasks. </summary>
+	struct BarrierPlan {
+		/// <summary> Barriers before task i are in gaps[i], the last one holds the barriers after all tasks. </summary>
+		std::vector<BarrierList> gaps;
+		/// <summary> Earlier tasks that used any of the subresources of task i. </summary>
+		std::vector<std::vector<size_t>> dependencies;
+		size_t numSplitBarriers = 0;
+	};
 
-	static void EnqueueCommandList(CommandQueue& commandQueue,
-								   CmdListPtr commandList,
-								   CmdAllocPtr commandAllocator,
-								   std::vector<ScratchSpacePtr> scratchSpaces,
-								   std::vector<MemoryObject> usedResources,
-								   std::unique_ptr<VolatileViewHeap> volatileHeap,
-								   const FrameContext& context);
+	static constexpr size_t NumQueues = 3; /// <summary> Queues are indexed by their gxapi::eCommandListType. </summary>
 
-	template <class UsedResourceIter>
-	static std::vector<gxapi::ResourceBarrier> InjectBarriers(UsedResourceIter firstResource, UsedResourceIter lastResource);
+	/// <summary> What queue planning needs to know about a task. </summary>
+	struct QueueTask {
+		bool hasCommandList = false;
+		gxapi::eCommandListType queue = gxapi::eCommandListType::GRAPHICS;
+		bool hasBarriers = false; /// <summary> Barriers before the task, these are always submitted to the graphics queue. </summary>
+		std::vector<size_t> dependencies; /// <summary> Earlier tasks that must finish on the GPU first. </summary>
+	};
 
-	template <class UsedResourceIter1, class UsedResourceIter2>
-	static bool CanExecuteParallel(UsedResourceIter1 first1, UsedResourceIter1 last1, UsedResourceIter2 first2, UsedResourceIter2 last2);
+	/// <summary> Everything submitted to a queue up to and including the given task. </summary>
+	struct QueuePosition {
+		static constexpr ptrdiff_t FrameStart = -1; /// <summary> Work of previous frames. </summary>
+
+		gxapi::eCommandListType queue;
+		ptrdiff_t task;
+	};
+
+	/// <summary> Cross-queue waits of a frame. </summary>
+	struct QueuePlan {
+		/// <summary> Waits of the graphics queue before the barriers in gap i, and before task i as well if it's a graphics task.
+		///		The last one joins all queues at the end of the frame. </summary>
+		std::vector<std::vector<QueuePosition>> gapWaits;
+		/// <summary> Waits of a compute or copy task's queue before the task. </summary>
+		std::vector<std::vector<QueuePosition>> taskWaits;
+	};
+
+	static void MakeResident(std::vector<MemoryObject*> usedResources);
+	static void Evict(std::vector<MemoryObject*> usedResources);
+
+
+	/// <summary> Sorts the task graph into levels. Throws if the graph has a cycle.
+	///		Tasks mapped to false in <paramref name="activeTasks"/> are left out along with their arcs, if it's given. </summary>
+	static Schedule CompileSchedule(const lemon::ListDigraph& taskGraph,
+									const lemon::ListDigraph::NodeMap<GraphicsTask*>& taskFunctionMap,
+									const lemon::ListDigraph::NodeMap<bool>* activeTasks = nullptr);
+
+	/// <summary> Names the tasks of the schedule after the nodes of the pipeline they belong to. </summary>
+	static void LabelTasks(Schedule& schedule, const Pipeline& pipeline);
+
+	/// <summary> Runs Execute() of the schedule's task at <paramref name="index"/> and decomposes its command list,
+	///		which is left open so that barriers can be appended.
+	///		Safe to call from multiple threads for different tasks. </summary>
+	static void RecordTask(const Schedule& schedule, size_t index, const FrameContext& context, RecordedTask& record);
+
+	/// <summary> Runs Execute() of all tasks on the job system. A task is started once all its predecessors finished recording.
+	///		Exceptions are stored in the records, tasks that were not started by the time one occurred are skipped. </summary>
+	static void RecordParallel(const Schedule& schedule, const FrameContext& context, std::vector<RecordedTask>& records);
+
+	/// <summary> Works out the transitions of the whole frame in submission order, including the one of the backbuffer
+	///		to PRESENT, and records the resulting resource states.
+	///		A transition is split if the resource is idle for at least one command list before it's needed.
+	///		Only transitions after graphics tasks are split, as all barriers are submitted to the graphics queue. </summary>
+	static BarrierPlan PlanBarriers(std::vector<RecordedTask>& records, const std::vector<gxapi::eCommandListType>& taskQueues, const FrameContext& context, bool splitBarriers);
+
+	/// <summary> Compute and copy lists go to their own queues if the frame has them, everything else to the graphics queue. </summary>
+	static std::vector<gxapi::eCommandListType> AssignQueues(const std::vector<RecordedTask>& records, const FrameContext& context);
+
+	/// <summary> Finds the cross-queue waits needed to honor the dependencies of the tasks, skipping those that are
+	///		already implied by earlier waits or by the order of submissions within a queue.
+	///		Compute and copy queues also wait for the work of previous frames on the graphics queue before their first task. </summary>
+	static QueuePlan PlanQueues(const std::vector<QueueTask>& tasks);
+
+	/// <summary> Closes and enqueues the command lists in schedule order, with the planned barriers and waits between them.
+	///		Barriers are appended to the previous graphics list if <paramref name="mergeBarriers"/> is set,
+	///		otherwise, or if there is no such list, they get a list of their own.
+	///		Batchers are indexed by queue, the ones of unused queues may be null. </summary>
+	static void SubmitTasks(std::vector<RecordedTask>& records,
+							const std::vector<gxapi::eCommandListType>& taskQueues,
+							BarrierPlan& barrierPlan,
+							const QueuePlan& queuePlan,
+							const FrameContext& context,
+							bool mergeBarriers,
+							const std::array<SubmissionBatcher*, NumQueues>& batchers);
+
+	static void SubmitTask(RecordedTask& record, SubmissionBatcher& batcher);
+	static void SubmitBarriers(const BarrierList& barriers, const FrameContext& context, SubmissionBatcher& batcher);
 
 	template <class UsedResourceIter>
 	static void UpdateResourceStates(UsedResourceIter firstResource, UsedResourceIter lastResource);
@@ -66,6 +186,11 @@ protected:
 	static void RenderFailureScreen(FrameContext context);
 private:
 	Pipeline m_pipeline;
+	Schedule m_schedule; // of m_pipeline, only changes with the pipeline
+	bool m_isBarrierPlanningEnabled = true;
+	size_t m_maxSubmissionBatchSize = 0;
+	bool m_areConstantsValid = false; // folded tasks of m_pipeline have been set up
+	TransientResourcePool m_transientPool; // textures requested by the tasks of m_schedule
 private:
 	class UploadTask : public GraphicsTask {
 	public:
@@ -79,66 +204,6 @@ private:
 
 
 
-template <class UsedResourceIter>
-std::vector<gxapi::ResourceBarrier> Scheduler::InjectBarriers(UsedResourceIter firstResource, UsedResourceIter lastResource) {
-	std::vector<gxapi::ResourceBarrier> barriers;
-
-	// Collect all necessary barriers.
-	for (UsedResourceIter it = firstResource; it != lastResource; ++it) {
-		MemoryObject& resource = it->resource;
-		unsigned subresource = it->subresource;
-		gxapi::eResourceState targetState = it->firstState;
-
-		if (subresource != gxapi::ALL_SUBRESOURCES) {
-			gxapi::eResourceState sourceState = resource.ReadState(subresource);
-			if (sourceState != targetState) {
-				barriers.push_back(gxapi::TransitionBarrier{ resource._GetResourcePtr(), sourceState, targetState, subresource });
-			}
-		}
-		else {
-			for (unsigned subresourceIdx = 0; subresourceIdx < resource.GetNumSubresources(); ++subresourceIdx) {
-				gxapi::eResourceState sourceState = resource.ReadState(subresourceIdx);
-				if (sourceState != targetState) {
-					barriers.push_back(gxapi::TransitionBarrier{ resource._GetResourcePtr(), sourceState, targetState, subresourceIdx });
-				}
-			}
-		}
-	}
-
-	return barriers;
-}
-
-
-template <class UsedResourceIter1, class UsedResourceIter2>
-bool Scheduler::CanExecuteParallel(UsedResourceIter1 first1, UsedResourceIter1 last1, UsedResourceIter2 first2, UsedResourceIter2 last2) {
-	UsedResourceIter1 it1 = first1;
-	UsedResourceIter2 it2 = first2;
-
-	// Advance the two iterators on the sorted ranges simultaneously.
-	while (it1 != last1 && it2 != last2) {
-		if (MemoryObject::PtrLess(it1->resource, it2->resource)) {
-			++it1;
-		}
-		else if (MemoryObject::PtrGreater(it1->resource, it2->resource)) {
-			++it2;
-		}
-		else {
-			// If the resources are the same, but uses are incompatible, return false.
-			if (it1->firstState != it2->firstState
-				|| it1->multipleUse
-				|| it2->multipleUse)
-			{
-				return false;
-			}
-			++it1;
-			++it2;
-		}
-	}
-
-	return true;
-}
-
-
 template <class UsedResourceIter>
 void Scheduler::UpdateResourceStates(UsedResourceIter firstResource, UsedResourceIter lastResource) {
 	for (auto it = firstResource; it != lastResource; ++it) {
@@ -0,0 +1,102 @@
+#include "SubmissionBatcher.hpp"
+
+#include <BaseLibrary/Profiler.hpp>
+
+
+namespace inl {
+namespace gxeng {
+
+
+SubmissionBatcher::SubmissionBatcher(CommandQueue& commandQueue, ResourceResidencyQueue& residencyQueue, size_t maxBatchSize)
+	: m_commandQueue(commandQueue),
+	m_residencyQueue(residencyQueue),
+	m_maxBatchSize(maxBatchSize)
+{}
+
+
+SubmissionBatcher::~SubmissionBatcher() {
+	try {
+		Flush();
+	}
+	catch (...) {
+		// Can't report from here, the lists are dropped.
+	}
+}
+
+
+void SubmissionBatcher::Enqueue(CmdListPtr commandList,
+								CmdAllocPtr commandAllocator,
+								std::vector<ScratchSpacePtr> scratchSpaces,
+								std::vector<MemoryObject> usedResources,
+								std::unique_ptr<VolatileViewHeap> volatileHeap)
+{
+	m_commandLists.push_back(std::move(commandList));
+	m_commandAllocators.push_back(std::move(commandAllocator));
+	for (auto& scratchSpace : scratchSpaces) {
+		m_scratchSpaces.push_back(std::move(scratchSpace));
+	}
+	for (auto& resource : usedResources) {
+		m_usedResources.push_back(std::move(resource));
+	}
+	if (volatileHeap) {
+		m_volatileHeaps.push_back(std::move(volatileHeap));
+	}
+
+	if (m_maxBatchSize != 0 && m_commandLists.size() >= m_maxBatchSize) {
+		Flush();
+	}
+}
+
+
+void SubmissionBatcher::Flush() {
+	if (m_commandLists.empty()) {
+		return;
+	}
+	ProfileScope scope("Queue", "Submit");
+
+	// Enqueue CPU task to make resources resident before the command lists run.
+	SyncPoint residentPoint = m_residencyQueue.EnqueueInit(m_usedResources);
+
+	// Enqueue the command lists themselves on the GPU.
+	std::vector<gxapi::ICommandList*> execLists;
+	execLists.reserve(m_commandLists.size());
+	for (auto& commandList : m_commandLists) {
+		execLists.push_back(commandList.get());
+	}
+	m_commandQueue.Wait(residentPoint);
+	m_commandQueue.ExecuteCommandLists((uint32_t)execLists.size(), execLists.data());
+	SyncPoint completionPoint = m_commandQueue.Signal();
+
+	// Enqueue CPU task to clean up resources after the command lists finished.
+	m_lastCompletion = completionPoint;
+	m_residencyQueue.EnqueueClean(completionPoint,
+								  std::move(m_usedResources),
+								  std::move(m_commandAllocators),
+								  std::move(m_scratchSpaces),
+								  std::move(m_volatileHeaps));
+
+	m_commandLists.clear();
+	m_commandAllocators.clear();
+	m_scratchSpaces.clear();
+	m_usedResources.clear();
+	m_volatileHeaps.clear();
+}
+
+
+SyncPoint SubmissionBatcher::Signal() {
+	Flush();
+	if (!m_lastCompletion) {
+		m_lastCompletion = m_commandQueue.Signal();
+	}
+	return m_lastCompletion;
+}
+
+
+void SubmissionBatcher::Wait(SyncPoint syncPoint) {
+	Flush();
+	m_commandQueue.Wait(syncPoint);
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CommandQueue.hpp"
+#include "ResourceResidencyQueue.hpp"
+#include "CommandAllocatorPool.hpp"
+#include "CommandListPool.hpp"
+#include "ScratchSpacePool.hpp"
+#include "VolatileViewHeap.hpp"
+#include "MemoryObject.hpp"
+
+#include <memory>
+#include <vector>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Collects closed command lists and submits them together: the residency queue gets one init and
+/// one clean task per batch, and the command queue one wait, one ExecuteCommandLists and one signal.
+/// </summary>
+/// <remarks> Lists are executed in the order they were enqueued. Not thread safe. </remarks>
+class SubmissionBatcher {
+public:
+	/// <param name="maxBatchSize"> The batch is submitted when it reaches this many lists. Zero means no limit,
+	///		lists are only submitted by <see cref="Flush"/>. </param>
+	SubmissionBatcher(CommandQueue& commandQueue, ResourceResidencyQueue& residencyQueue, size_t maxBatchSize = 0);
+	SubmissionBatcher(const SubmissionBatcher&) = delete;
+	SubmissionBatcher& operator=(const SubmissionBatcher&) = delete;
+
+	/// <summary> Submits whatever is left, so that lists whose resource states were already recorded reach the GPU. </summary>
+	~SubmissionBatcher();
+
+	/// <summary> Adds a closed command list to the batch. The other objects are kept alive until the list finishes on the GPU. </summary>
+	void Enqueue(CmdListPtr commandList,
+				 CmdAllocPtr commandAllocator,
+				 std::vector<ScratchSpacePtr> scratchSpaces,
+				 std::vector<MemoryObject> usedResources,
+				 std::unique_ptr<VolatileViewHeap> volatileHeap);
+
+	/// <summary> Submits the current batch. Does nothing if the batch is empty. </summary>
+	void Flush();
+
+	/// <summary> Submits the current batch and returns a sync point that is signaled once everything
+	///		submitted to the queue so far has finished. Signals the queue only if necessary. </summary>
+	SyncPoint Signal();
+
+	/// <summary> Makes the queue wait for <paramref name="syncPoint"/>. Lists enqueued so far are submitted before the wait. </summary>
+	void Wait(SyncPoint syncPoint);
+
+	size_t GetNumPending() const { return m_commandLists.size(); }
+	size_t GetMaxBatchSize() const { return m_maxBatchSize; }
+private:
+	CommandQueue& m_commandQueue;
+	ResourceResidencyQueue& m_residencyQueue;
+	size_t m_maxBatchSize;
+
+	std::vector<CmdListPtr> m_commandLists;
+	std::vector<CmdAllocPtr> m_commandAllocators;
+	std::vector<ScratchSpacePtr> m_scratchSpaces;
+	std::vector<MemoryObject> m_usedResources;
+	std::vector<std::unique_ptr<VolatileViewHeap>> m_volatileHeaps;
+	SyncPoint m_lastCompletion; // of the last batch, as long as nothing else was submitted since
+};
+
+
+} // namespace gxeng
+} // namespace inl
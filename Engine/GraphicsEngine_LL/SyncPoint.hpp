@@ -29,6 +29,12 @@ public:
 		m_fence->Wait(m_value);		
 	}
 
+	/// <summary> True if the fence has reached the value, does not block. </summary>
+	bool IsReached() const {
+		assert((bool)m_fence);
+		return m_fence->Fetch() >= m_value;
+	}
+
 	operator bool() {
 		return (bool)m_fence;
 	}
@@ -0,0 +1,88 @@
+#include "TransientHeapPlanner.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+
+namespace inl::gxeng {
+
+
+TransientHeapLayout PlanTransientHeap(const std::vector<TransientResourceDesc>& resources) {
+	const size_t numResources = resources.size();
+
+	TransientHeapLayout layout;
+	layout.offsets.resize(numResources, 0);
+	layout.aliasedPredecessors.resize(numResources);
+
+	auto AreAliveTogether = [&resources](size_t lhs, size_t rhs) {
+		return resources[lhs].firstUse <= resources[rhs].lastUse && resources[rhs].firstUse <= resources[lhs].lastUse;
+	};
+	auto AlignUp = [](uint64_t offset, uint64_t alignment) {
+		return alignment <= 1 ? offset : (offset + alignment - 1) / alignment * alignment;
+	};
+
+	// Large resources are the hardest to fit in gaps, place them first.
+	std::vector<size_t> order(numResources);
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::stable_sort(order.begin(), order.end(), [&resources](size_t lhs, size_t rhs) {
+		return resources[lhs].size > resources[rhs].size;
+	});
+
+	std::vector<size_t> placed;
+	std::vector<size_t> collisions;
+	for (size_t resource : order) {
+		const TransientResourceDesc& desc = resources[resource];
+
+		collisions.clear();
+		for (size_t other : placed) {
+			if (AreAliveTogether(resource, other)) {
+				collisions.push_back(other);
+			}
+		}
+		std::sort(collisions.begin(), collisions.end(), [&layout](size_t lhs, size_t rhs) {
+			return layout.offsets[lhs] < layout.offsets[rhs];
+		});
+
+		// Everything below offset is taken, the first gap before a colliding resource that's large enough is used.
+		uint64_t offset = 0;
+		for (size_t other : collisions) {
+			if (offset + desc.size <= layout.offsets[other]) {
+				break;
+			}
+			offset = std::max(offset, AlignUp(layout.offsets[other] + resources[other].size, desc.alignment));
+		}
+
+		layout.offsets[resource] = offset;
+		layout.heapSize = std::max(layout.heapSize, offset + desc.size);
+		layout.totalSize += desc.size;
+		placed.push_back(resource);
+	}
+
+	// Resources that shared memory earlier in the frame.
+	for (size_t resource = 0; resource < numResources; ++resource) {
+		for (size_t other = 0; other < numResources; ++other) {
+			bool isEarlier = resources[other].lastUse < resources[resource].firstUse;
+			bool isOverlapping = layout.offsets[other] < layout.offsets[resource] + resources[resource].size
+				&& layout.offsets[resource] < layout.offsets[other] + resources[other].size;
+			if (isEarlier && isOverlapping) {
+				layout.aliasedPredecessors[resource].push_back(other);
+			}
+		}
+	}
+
+	// The live set only grows when a resource is first used.
+	for (const TransientResourceDesc& desc : resources) {
+		uint64_t liveSize = 0;
+		for (const TransientResourceDesc& other : resources) {
+			if (other.firstUse <= desc.firstUse && desc.firstUse <= other.lastUse) {
+				liveSize += other.size;
+			}
+		}
+		layout.peakLiveSize = std::max(layout.peakLiveSize, liveSize);
+	}
+
+	return layout;
+}
+
+
+} // namespace inl::gxeng
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace inl::gxeng {
+
+
+/// <summary> A resource that is only needed by a range of tasks of a frame. </summary>
+struct TransientResourceDesc {
+	uint64_t size;
+	uint64_t alignment;
+	size_t firstUse; /// <summary> Index of the first task that uses it, in schedule order. </summary>
+	size_t lastUse; /// <summary> Index of the last task that uses it, inclusive. </summary>
+};
+
+
+/// <summary> Where transient resources go in a heap they share. </summary>
+struct TransientHeapLayout {
+	std::vector<uint64_t> offsets; /// <summary> Offset of each resource in the heap. </summary>
+	/// <summary> For each resource, the resources that use some of its memory before its first use. </summary>
+	std::vector<std::vector<size_t>> aliasedPredecessors;
+	uint64_t heapSize = 0;
+	uint64_t totalSize = 0; /// <summary> Memory the resources take without aliasing. </summary>
+	uint64_t peakLiveSize = 0; /// <summary> Most memory used by resources alive at the same task, no layout can be smaller. </summary>
+};
+
+
+/// <summary>
+/// Packs resources into one heap so that resources that are never alive at the same time may share memory.
+/// Resources are placed from the largest to the smallest, each at the lowest offset that does not
+/// collide with an already placed resource whose lifetime overlaps its own.
+/// </summary>
+TransientHeapLayout PlanTransientHeap(const std::vector<TransientResourceDesc>& resources);
+
+
+} // namespace inl::gxeng
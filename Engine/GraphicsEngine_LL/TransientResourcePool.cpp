@@ -0,0 +1,165 @@
+#include "TransientResourcePool.hpp"
+
+#include <algorithm>
+
+
+namespace inl::gxeng {
+
+
+void TransientResourcePool::BeginFrame(MemoryManager* memoryManager) {
+	m_memoryManager = memoryManager;
+	m_numRequests.clear();
+	for (auto& item : m_entries) {
+		item.second.isRequested = false;
+		item.second.firstUse = NoTask;
+		item.second.lastUse = NoTask;
+	}
+}
+
+
+Texture2D TransientResourcePool::CreateTexture2D(size_t task, const Texture2DDesc& desc, gxapi::eResourceFlags flags) {
+	Key key{ task, m_numRequests[task]++ };
+
+	auto it = m_entries.find(key);
+	bool isSame = it != m_entries.end()
+		&& it->second.desc.width == desc.width
+		&& it->second.desc.height == desc.height
+		&& it->second.desc.arraySize == desc.arraySize
+		&& it->second.desc.mipLevels == desc.mipLevels
+		&& it->second.desc.format == desc.format
+		&& it->second.flags == flags;
+	if (!isSame) {
+		if (it != m_entries.end()) {
+			m_entriesByResource.erase(it->second.texture._GetResourcePtr());
+			m_entries.erase(it);
+		}
+		Entry entry;
+		entry.desc = desc;
+		entry.flags = flags;
+		entry.allocation = m_memoryManager->GetTextureAllocationInfo(desc, flags);
+		entry.texture = m_memoryManager->CreateTexture2D(eResourceHeapType::CRITICAL, desc, flags);
+		it = m_entries.insert({ key, std::move(entry) }).first;
+		m_entriesByResource[it->second.texture._GetResourcePtr()] = &it->second;
+	}
+
+	Entry& entry = it->second;
+	entry.isRequested = true;
+	Use(entry, task);
+	return entry.texture;
+}
+
+
+void TransientResourcePool::RecordUse(const gxapi::IResource* resource, size_t task) {
+	auto it = m_entriesByResource.find(resource);
+	if (it != m_entriesByResource.end() && it->second->isRequested) {
+		Use(*it->second, task);
+	}
+}
+
+
+auto TransientResourcePool::GetActivations() const -> std::vector<Activation> {
+	std::vector<Activation> activations;
+	for (auto& item : m_entries) {
+		const Entry& entry = item.second;
+		if (!entry.isPlaced || !entry.isRequested) {
+			continue;
+		}
+		Activation activation{ entry.texture._GetResourcePtr(), entry.firstUse, {} };
+		for (const Key& predecessorKey : entry.aliasedPredecessors) {
+			auto predecessor = m_entries.find(predecessorKey);
+			if (predecessor != m_entries.end()
+				&& predecessor->second.isPlaced
+				&& predecessor->second.isRequested
+				&& predecessor->second.lastUse < entry.firstUse)
+			{
+				activation.waitFor.push_back(predecessor->second.lastUse);
+			}
+		}
+		activations.push_back(std::move(activation));
+	}
+	return activations;
+}
+
+
+bool TransientResourcePool::EndFrame() {
+	bool isChanged = false;
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		Entry& entry = it->second;
+		if (!entry.isRequested) {
+			m_entriesByResource.erase(entry.texture._GetResourcePtr());
+			it = m_entries.erase(it);
+			isChanged = true;
+			continue;
+		}
+		isChanged = isChanged
+			|| !entry.isPlaced
+			|| entry.firstUse != entry.plannedFirstUse
+			|| entry.lastUse != entry.plannedLastUse;
+		++it;
+	}
+
+	if (isChanged) {
+		PlaceTextures();
+	}
+	return isChanged;
+}
+
+
+void TransientResourcePool::Clear() {
+	m_entries.clear();
+	m_entriesByResource.clear();
+	m_numRequests.clear();
+	m_statistics = Statistics();
+}
+
+
+void TransientResourcePool::PlaceTextures() {
+	m_statistics = Statistics();
+	m_entriesByResource.clear();
+
+	// Some hardware can't have render targets or depth stencils in the same heap as other textures.
+	for (bool renderTargets : { true, false }) {
+		std::vector<std::pair<const Key, Entry>*> group;
+		std::vector<TransientResourceDesc> resources;
+		for (auto& item : m_entries) {
+			const Entry& entry = item.second;
+			bool isRenderTarget = (entry.flags & gxapi::eResourceFlags::ALLOW_RENDER_TARGET) || (entry.flags & gxapi::eResourceFlags::ALLOW_DEPTH_STENCIL);
+			if (isRenderTarget == renderTargets) {
+				group.push_back(&item);
+				resources.push_back({ entry.allocation.sizeInBytes, entry.allocation.alignment, entry.firstUse, entry.lastUse });
+			}
+		}
+		if (group.empty()) {
+			continue;
+		}
+
+		TransientHeapLayout layout = PlanTransientHeap(resources);
+		std::shared_ptr<gxapi::IHeap> heap = m_memoryManager->CreateTextureHeap(layout.heapSize, renderTargets);
+		for (size_t i = 0; i < group.size(); ++i) {
+			Entry& entry = group[i]->second;
+			entry.texture = m_memoryManager->CreatePlacedTexture2D(heap, layout.offsets[i], entry.desc, entry.flags);
+			entry.isPlaced = true;
+			entry.plannedFirstUse = entry.firstUse;
+			entry.plannedLastUse = entry.lastUse;
+			entry.aliasedPredecessors.clear();
+			for (size_t predecessor : layout.aliasedPredecessors[i]) {
+				entry.aliasedPredecessors.push_back(group[predecessor]->first);
+			}
+			m_entriesByResource[entry.texture._GetResourcePtr()] = &entry;
+		}
+
+		m_statistics.numTextures += group.size();
+		m_statistics.totalSize += layout.totalSize;
+		m_statistics.heapSize += layout.heapSize;
+		m_statistics.peakLiveSize += layout.peakLiveSize; // of each heap, the peaks may be at different tasks
+	}
+}
+
+
+void TransientResourcePool::Use(Entry& entry, size_t task) {
+	entry.firstUse = entry.firstUse == NoTask ? task : std::min(entry.firstUse, task);
+	entry.lastUse = entry.lastUse == NoTask ? task : std::max(entry.lastUse, task);
+}
+
+
+} // namespace inl::gxeng
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "MemoryObject.hpp"
+#include "MemoryManager.hpp"
+#include "TransientHeapPlanner.hpp"
+
+#include <GraphicsApi_LL/IHeap.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace inl::gxeng {
+
+
+/// <summary>
+/// Textures that nodes only need for part of a frame. They are placed in shared heaps,
+/// textures that are not used at the same time get the same memory.
+/// A texture is identified by the task that requests it and the order of requests within the task,
+/// so the same texture is returned every frame as long as the schedule and the requests don't change.
+/// A newly requested texture is committed for its first frame, that frame tells which tasks use it,
+/// and from the next frame on it's placed in a heap along with the others.
+/// </summary>
+/// <remarks>
+/// The contents of a transient texture are undefined at the start of each frame.
+/// Nodes must request their transient textures and create views of them in every Setup,
+/// as a texture may be replaced between frames.
+/// </remarks>
+class TransientResourcePool {
+public:
+	struct Statistics {
+		size_t numTextures = 0;
+		uint64_t totalSize = 0; /// <summary> Memory the textures would take without aliasing. </summary>
+		uint64_t heapSize = 0; /// <summary> Memory of the heaps the textures are placed in. </summary>
+		uint64_t peakLiveSize = 0; /// <summary> Most memory used by textures alive at the same task. </summary>
+	};
+
+	/// <summary> The first use of a placed texture in this frame, which needs an aliasing barrier before it. </summary>
+	struct Activation {
+		gxapi::IResource* resource;
+		size_t firstUse;
+		std::vector<size_t> waitFor; /// <summary> Last uses of the textures that had some of its memory earlier in the frame. </summary>
+	};
+public:
+	/// <summary> Starts collecting the requests and uses of a frame. </summary>
+	void BeginFrame(MemoryManager* memoryManager);
+
+	/// <summary> Returns the texture of the task's next request in this frame. </summary>
+	Texture2D CreateTexture2D(size_t task, const Texture2DDesc& desc, gxapi::eResourceFlags flags);
+
+	/// <summary> Records that the task uses the resource on the GPU. Does nothing if it's not a transient texture. </summary>
+	void RecordUse(const gxapi::IResource* resource, size_t task);
+
+	/// <summary> Placed textures used in this frame. </summary>
+	std::vector<Activation> GetActivations() const;
+
+	/// <summary> Places the textures of this frame in new heaps if the requests or their uses changed.
+	///		Returns true if the textures were placed again. </summary>
+	bool EndFrame();
+
+	/// <summary> Releases all textures. Nodes and command lists may keep using the ones they hold. </summary>
+	void Clear();
+
+	const Statistics& GetStatistics() const { return m_statistics; }
+private:
+	static constexpr size_t NoTask = ~size_t(0);
+
+	struct Entry {
+		Texture2DDesc desc;
+		gxapi::eResourceFlags flags;
+		gxapi::ResourceAllocationInfo allocation;
+		Texture2D texture;
+		bool isRequested = false; // in this frame
+		bool isPlaced = false; // false until the first frame is over
+		size_t firstUse = NoTask, lastUse = NoTask; // in this frame
+		size_t plannedFirstUse = NoTask, plannedLastUse = NoTask; // the frame the textures were placed after
+		std::vector<std::pair<size_t, unsigned>> aliasedPredecessors; // keys of the entries
+	};
+	using Key = std::pair<size_t, unsigned>; // task, request within task
+
+	void PlaceTextures();
+	static void Use(Entry& entry, size_t task);
+private:
+	MemoryManager* m_memoryManager = nullptr;
+	std::map<Key, Entry> m_entries;
+	std::unordered_map<const gxapi::IResource*, Entry*> m_entriesByResource;
+	std::unordered_map<size_t, unsigned> m_numRequests; // of each task in this frame
+	Statistics m_statistics;
+};
+
+
+} // namespace inl::gxeng
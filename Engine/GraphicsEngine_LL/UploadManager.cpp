@@ -2,10 +2,11 @@
 
 #include <GraphicsApi_LL/Common.hpp>
 #include <BaseLibrary/Exception/Exception.hpp>
+#include <BaseLibrary/Memory/AllocationTracker.hpp>
 
+#include <algorithm>
 #include <cassert>
-#include <sstream>
-#include <atomic>
+#include <cstring>
 
 namespace inl {
 namespace gxeng {
@@ -29,48 +30,17 @@ void UploadManager::Upload(const LinearBuffer& target, size_t offset, const void
 		throw InvalidArgumentException("Target buffer is not large enough for the uploaded data to fit.", "target");
 	}
 
-	MemoryObjDesc uploadObjDesc(
-		m_graphicsApi->CreateCommittedResource(
-			gxapi::HeapProperties(gxapi::eHeapType::UPLOAD),
-			gxapi::eHeapFlags::NONE,
-			gxapi::ResourceDesc::Buffer(size),
-			//NOTE: GENERIC_READ is the required starting state for upload heap resources according to msdn
-			// (also there is no need for resource state transition)
-			gxapi::eResourceState::GENERIC_READ
-		),
-		eResourceHeap::UPLOAD
-	);
-
-	// DEBUG
-	static std::atomic_uint64_t counter = 0;
-	std::stringstream ss;
-	ss << "Buffer upload source" << counter++;
-	uploadObjDesc.resource->SetName(ss.str().c_str());
-	// DEBUG
-
-	auto uploadResource = uploadObjDesc.resource.get();
-
-	{
-		std::lock_guard<std::mutex> lock(m_mtx);
+	StagingRegion staging = ReserveStaging(size, BUFFER_STAGING_ALIGNMENT);
+	memcpy(staging.cpuAddress, data, size);
 
-		//auto& currQueue = m_uploadQueues.back();
-		std::vector<UploadDescription>& currQueue = m_uploadFrames.back().uploads;
-
-		UploadDescription uploadDesc(
-			LinearBuffer(std::move(uploadObjDesc)),
-			target,
-			offset
-		);
-
-		currQueue.push_back(std::move(uploadDesc));
-	}
-
-	gxapi::MemoryRange noReadRange{ 0, 0 };
-	void* stagePtr = uploadResource->Map(0, &noReadRange);
-	memcpy(stagePtr, data, size);
-	// Theres no need to unmap but leaving a resource mapped has a performance hit while debugging
-	// see https://msdn.microsoft.com/en-us/library/windows/desktop/dn899215(v=vs.85).aspx#mapping_and_unmapping
-	uploadResource->Unmap(0, nullptr);
+	UploadDescription uploadDesc(
+		std::move(staging.buffer),
+		staging.offset,
+		size,
+		target,
+		offset
+	);
+	Publish(std::move(uploadDesc), staging);
 }
 
 
@@ -92,58 +62,29 @@ void UploadManager::Upload(
 	auto pixelSize = gxapi::GetFormatSizeInBytes(format);
 	auto rowSize = width * pixelSize;
 	size_t rowPitch = SnapUpwrads(rowSize, DUP_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
-	auto requiredSize = bytesPerRow > 0 ? bytesPerRow : rowPitch * height;
+	auto requiredSize = std::max(bytesPerRow, rowPitch * height);
 
-	MemoryObjDesc uploadObjDesc = MemoryObjDesc(
-		m_graphicsApi->CreateCommittedResource(
-			gxapi::HeapProperties(gxapi::eHeapType::UPLOAD),
-			gxapi::eHeapFlags::NONE,
-			gxapi::ResourceDesc::Buffer(requiredSize),
-			//NOTE: GENERIC_READ is the required starting state for upload heap resources according to msdn
-			// (also there is no need for resource state transition)
-			gxapi::eResourceState::GENERIC_READ
-		),
-		eResourceHeap::UPLOAD
-	);
+	StagingRegion staging = ReserveStaging(requiredSize, TEXTURE_STAGING_ALIGNMENT);
 
-	// DEBUG
-	static std::atomic_uint64_t counter = 0;
-	std::stringstream ss;
-	ss << "Texture upload source" << counter++;
-	uploadObjDesc.resource->SetName(ss.str().c_str());
-	// DEBUG
-
-	auto uploadResource = uploadObjDesc.resource.get();
-
-	{
-		std::lock_guard<std::mutex> lock(m_mtx);
-
-		//auto& currQueue = m_uploadQueues.back();
-		std::vector<UploadDescription>& currQueue = m_uploadFrames.back().uploads;
-
-		UploadDescription uploadDesc(
-			LinearBuffer(std::move(uploadObjDesc)),
-			target,
-			subresource,
-			offsetX,
-			offsetY,
-			0,
-			gxapi::TextureCopyDesc::Buffer(format, width, height, 1, 0)
-		);
-
-		currQueue.push_back(std::move(uploadDesc));
-
-		currQueue.back().source._SetResident(true);
-	}
-
-	gxapi::MemoryRange noReadRange{ 0, 0 };
-	auto stagePtr = reinterpret_cast<uint8_t*>(uploadResource->Map(0, &noReadRange));
 	auto byteData = reinterpret_cast<const uint8_t*>(data);
 	//copy texture row-by-row
 	for (size_t y = 0; y < height; y++) {
-		memcpy(stagePtr + rowPitch*y, byteData + rowSize*y, rowSize);
+		memcpy(staging.cpuAddress + rowPitch*y, byteData + rowSize*y, rowSize);
 	}
-	uploadResource->Unmap(0, nullptr);
+
+	UploadDescription uploadDesc(
+		std::move(staging.buffer),
+		staging.offset,
+		requiredSize,
+		target,
+		subresource,
+		offsetX,
+		offsetY,
+		0,
+		gxapi::TextureCopyDesc::Buffer(format, width, height, 1, staging.offset)
+	);
+	uploadDesc.source._SetResident(true);
+	Publish(std::move(uploadDesc), staging);
 }
 
 
@@ -161,10 +102,30 @@ void UploadManager::OnFrameCompleteDevice(uint64_t frameId) {
 	// loop may be removed
 	int framesPopped = 0;
 	while (!m_uploadFrames.empty() && m_uploadFrames.front().frameId <= frameId) {
+		AllocationTracker::GetInstance().RecordDeallocation(eAllocationTag::UPLOAD, m_uploadFrames.front().dedicatedSize);
 		m_uploadFrames.pop_front();
 		++framesPopped;
 	}
 	assert(framesPopped == 1);
+
+	// The GPU is done copying from the pages of this frame, they can be refilled.
+	m_numCompletedFrames = frameId + 1;
+
+	bool foundVictim = true;
+	while (m_pages.Count() > MAX_RETAINED_PAGE_COUNT && foundVictim) {
+		foundVictim = false;
+
+		for (auto roundEnd = m_pages.End();
+			m_pages.Begin() != roundEnd && !foundVictim;
+			m_pages.RotateFront())
+		{
+			if (HasBecomeAvailable(*m_pages.Front())) {
+				foundVictim = true;
+				AllocationTracker::GetInstance().RecordDeallocation(eAllocationTag::UPLOAD, m_pages.Front()->pageSize);
+				m_pages.PopFront();
+			}
+		}
+	}
 }
 
 
@@ -181,15 +142,163 @@ void UploadManager::OnFrameBeginAwait(uint64_t frameId) {
 }
 
 
-const std::vector<UploadManager::UploadDescription>& UploadManager::GetQueuedUploads() const {
+const std::vector<UploadManager::UploadDescription>& UploadManager::CollectUploads() {
 	std::lock_guard<std::mutex> lock(m_mtx);
 
 	assert(m_uploadFrames.size() > 0);
-	return m_uploadFrames.back().uploads;
+	UploadFrame& currFrame = m_uploadFrames.back();
+	m_publishedUploads.PopAll([&](PublishedUpload&& published) {
+		if (published.page) {
+			// The page has to outlive this frame on the GPU, the pin of the upload is not needed any more.
+			published.page->ownerFrameId = std::max(published.page->ownerFrameId, currFrame.frameId);
+			published.page->pins.fetch_sub(1, std::memory_order_relaxed);
+		}
+		currFrame.dedicatedSize += published.dedicatedSize;
+		currFrame.uploads.push_back(std::move(published.description));
+	});
+	return currFrame.uploads;
 }
 
 
 
+size_t UploadManager::GetNumStagingPages() const {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return m_pages.Count();
+}
+
+
+UploadManager::StagingRegion UploadManager::ReserveStaging(size_t size, size_t alignment) {
+	if (size > MAX_BLOCK_UPLOAD_SIZE) {
+		std::lock_guard<std::mutex> lock(m_mtx);
+		return AllocateStaging(size, alignment);
+	}
+
+	StagingBlock& block = m_threadBlocks;
+	size_t offset = SnapUpwrads(block.offset, alignment);
+	if (block.page == nullptr || offset + size > block.end) {
+		StagingRegion blockRegion;
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			blockRegion = AllocateStaging(STAGING_BLOCK_SIZE, TEXTURE_STAGING_ALIGNMENT);
+		}
+		// The new block keeps the pin AllocateStaging took, the old block lets its pin go.
+		if (block.page) {
+			block.page->pins.fetch_sub(1, std::memory_order_release);
+		}
+		block.page = blockRegion.page;
+		block.buffer = std::move(blockRegion.buffer);
+		block.offset = blockRegion.offset;
+		block.end = blockRegion.offset + STAGING_BLOCK_SIZE;
+		offset = block.offset;
+	}
+
+	block.offset = offset + size;
+	block.page->pins.fetch_add(1, std::memory_order_relaxed);
+	return { block.buffer, offset, block.page->cpuAddress + offset, block.page, 0 };
+}
+
+
+UploadManager::StagingRegion UploadManager::AllocateStaging(size_t size, size_t alignment) {
+	if (size > STAGING_PAGE_SIZE) {
+		MemoryObjDesc uploadObjDesc(
+			m_graphicsApi->CreateCommittedResource(
+				gxapi::HeapProperties(gxapi::eHeapType::UPLOAD),
+				gxapi::eHeapFlags::NONE,
+				gxapi::ResourceDesc::Buffer(size),
+				//NOTE: GENERIC_READ is the required starting state for upload heap resources according to msdn
+				// (also there is no need for resource state transition)
+				gxapi::eResourceState::GENERIC_READ
+			),
+			eResourceHeap::UPLOAD
+		);
+		uploadObjDesc.resource->SetName("Oversized upload source");
+		AllocationTracker::GetInstance().RecordAllocation(eAllocationTag::UPLOAD, size);
+
+		// Stays mapped until it is released with the upload frame.
+		gxapi::MemoryRange noReadRange{ 0, 0 };
+		uint8_t* cpuAddress = reinterpret_cast<uint8_t*>(uploadObjDesc.resource->Map(0, &noReadRange));
+		return { LinearBuffer(std::move(uploadObjDesc)), 0, cpuAddress, nullptr, size };
+	}
+
+	size_t offset = 0;
+	if (m_pages.Count() == 0) {
+		m_pages.PushFront(CreatePage());
+	}
+	else {
+		if (HasBecomeAvailable(*m_pages.Front())) {
+			m_pages.Front()->consumedSize = 0;
+		}
+		offset = SnapUpwrads(m_pages.Front()->consumedSize, alignment);
+		if (offset + size > m_pages.Front()->pageSize) {
+			// Continue with the oldest page if the GPU is done with it, otherwise grow the ring.
+			m_pages.RotateFront();
+			if (HasBecomeAvailable(*m_pages.Front())) {
+				m_pages.Front()->consumedSize = 0;
+			}
+			else {
+				m_pages.PushFront(CreatePage());
+			}
+			offset = SnapUpwrads(m_pages.Front()->consumedSize, alignment);
+		}
+	}
+
+	StagingPage& page = *m_pages.Front();
+	assert(offset + size <= page.pageSize);
+
+	page.consumedSize = offset + size;
+	page.pins.fetch_add(1, std::memory_order_relaxed);
+
+	return { page.buffer, offset, page.cpuAddress + offset, &page, 0 };
+}
+
+
+void UploadManager::Publish(UploadDescription&& description, const StagingRegion& staging) {
+	m_publishedUploads.Push(PublishedUpload{ std::move(description), staging.page, staging.dedicatedSize });
+}
+
+
+std::unique_ptr<UploadManager::StagingPage> UploadManager::CreatePage() {
+	MemoryObjDesc pageObjDesc(
+		m_graphicsApi->CreateCommittedResource(
+			gxapi::HeapProperties(gxapi::eHeapType::UPLOAD),
+			gxapi::eHeapFlags::NONE,
+			gxapi::ResourceDesc::Buffer(STAGING_PAGE_SIZE),
+			gxapi::eResourceState::GENERIC_READ
+		),
+		eResourceHeap::UPLOAD
+	);
+	pageObjDesc.resource->SetName("Upload staging page");
+	AllocationTracker::GetInstance().RecordAllocation(eAllocationTag::UPLOAD, STAGING_PAGE_SIZE);
+
+	// Pages stay mapped for their whole life, upload heaps are write-combined and never read back.
+	gxapi::MemoryRange noReadRange{ 0, 0 };
+	uint8_t* cpuAddress = reinterpret_cast<uint8_t*>(pageObjDesc.resource->Map(0, &noReadRange));
+
+	auto page = std::make_unique<StagingPage>();
+	page->buffer = LinearBuffer(std::move(pageObjDesc));
+	page->buffer._SetResident(true);
+	page->cpuAddress = cpuAddress;
+	page->pageSize = STAGING_PAGE_SIZE;
+	page->consumedSize = 0;
+	page->ownerFrameId = 0;
+	page->pins.store(0, std::memory_order_relaxed);
+	return page;
+}
+
+
+bool UploadManager::HasBecomeAvailable(const StagingPage& page) const {
+	// Frames are numbered from zero, nothing is complete until the GPU finished the first one.
+	return page.pins.load(std::memory_order_acquire) == 0 && page.ownerFrameId < m_numCompletedFrames;
+}
+
+
+UploadManager::StagingBlock::~StagingBlock() {
+	if (page) {
+		page->pins.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+
 size_t UploadManager::SnapUpwrads(size_t value, size_t gridSize) {
 	// alignement should be power of two
 	assert(((gridSize - 1) & gridSize) == 0);
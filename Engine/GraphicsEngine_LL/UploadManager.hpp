@@ -3,7 +3,14 @@
 #include "PipelineEventListener.hpp"
 #include "MemoryObject.hpp"
 
+#include "../BaseLibrary/MpscQueue.hpp"
+#include "../BaseLibrary/RingBuffer.hpp"
+#include "../BaseLibrary/ScalarLiterals.hpp"
+#include "../BaseLibrary/Memory/MultiInstanceTLS.hpp"
+
+#include <atomic>
 #include <utility>
+#include <memory>
 #include <mutex>
 #include <deque>
 #include <list>
@@ -11,31 +18,40 @@
 namespace inl {
 namespace gxeng {
 
+using namespace inl::prefix;
+
 
 class UploadManager : public PipelineEventListener {
 public:
 	enum class DestType { BUFFER, TEXTURE_2D };
 	struct UploadDescription {
-		UploadDescription(LinearBuffer&& source,
+		UploadDescription(LinearBuffer&& source, size_t srcOffset, size_t size,
 						  const LinearBuffer& destination,
 						  size_t bufferOffset) :
 			source(std::move(source)),
+			srcOffset(srcOffset),
+			size(size),
 			destination(destination),
 			destType(DestType::BUFFER),
 			dstOffsetX(bufferOffset) {}
 
-		UploadDescription(LinearBuffer&& source,
+		UploadDescription(LinearBuffer&& source, size_t srcOffset, size_t size,
 						  const Texture2D& destination, unsigned dstSubresource,
 						  size_t dstOffsetX, uint32_t dstOffsetY, uint32_t dstOffsetZ,
 						  gxapi::TextureCopyDesc textureBufferDesc) :
 			source(std::move(source)),
+			srcOffset(srcOffset),
+			size(size),
 			destination(destination),
 			dstSubresource(dstSubresource),
 			destType(DestType::TEXTURE_2D),
 			dstOffsetX(dstOffsetX), dstOffsetY(dstOffsetY), dstOffsetZ(dstOffsetZ),
 			textureBufferDesc(textureBufferDesc) {}
 		
+		// Staging memory, usually a page shared with other uploads of the same frame.
 		LinearBuffer source;
+		size_t srcOffset;
+		size_t size;
 
 		// Destination is a weak pointer because it might get deleted before
 		// the graphics engine starts to process the request.
@@ -53,11 +69,55 @@ private:
 	struct UploadFrame {
 		std::vector<UploadDescription> uploads;
 		uint64_t frameId;
+		size_t dedicatedSize = 0; // bytes of oversized uploads that got their own resource
+	};
+
+	// A persistently mapped upload buffer that uploads are sub-allocated from linearly.
+	struct StagingPage {
+		LinearBuffer buffer;
+		uint8_t* cpuAddress;
+		size_t pageSize;
+		size_t consumedSize;
+		uint64_t ownerFrameId; // the last frame that has collected uploads from the page
+		// Open thread blocks and published but not yet collected uploads on the page.
+		// The page is not reused until it drops to zero.
+		std::atomic<size_t> pins;
+	};
+
+	// Where an upload's data has to be written.
+	struct StagingRegion {
+		LinearBuffer buffer;
+		size_t offset;
+		uint8_t* cpuAddress;
+		StagingPage* page; // null for dedicated resources
+		size_t dedicatedSize;
+	};
+
+	// A part of a page that one producer thread fills without locking.
+	struct StagingBlock {
+		StagingBlock() = default;
+		StagingBlock(const StagingBlock&) : StagingBlock() {} // copies of the default record start without a block
+		StagingBlock& operator=(const StagingBlock&) = delete;
+		~StagingBlock();
+
+		StagingPage* page = nullptr;
+		LinearBuffer buffer;
+		size_t offset = 0;
+		size_t end = 0;
+	};
+
+	// An upload whose staging memory is filled, waiting for a frame to collect it.
+	struct PublishedUpload {
+		UploadDescription description;
+		StagingPage* page;
+		size_t dedicatedSize;
 	};
 
 public:
 	UploadManager(gxapi::IGraphicsApi* graphicsApi);
 
+	/// <summary> Copies the data to staging memory and queues it for upload. Thread safe, lock-free unless
+	///		the calling thread needs a new staging block or the data is large. </summary>
 	void Upload(const LinearBuffer& target, size_t offset, const void* data, size_t size);
 
 	// The pixels from the source image must be in row-major order inside memory.
@@ -69,17 +129,51 @@ public:
 	void OnFrameCompleteDevice(uint64_t frameId) override;
 	void OnFrameCompleteHost(uint64_t frameId) override;
 
-	const std::vector<UploadDescription>& GetQueuedUploads() const;
+	/// <summary>
+	/// Moves the uploads published so far to the current frame and returns all uploads of the frame.
+	/// Uploads published later go to the next frame. Producers don't touch the returned vector,
+	/// it stays valid until the frame completes on the device.
+	/// </summary>
+	const std::vector<UploadDescription>& CollectUploads();
+
+	/// <summary> Returns the number of staging pages, busy or free. </summary>
+	size_t GetNumStagingPages() const;
 protected:
 	gxapi::IGraphicsApi* m_graphicsApi;
 	std::list<UploadFrame> m_uploadFrames;
+	RingBuffer<std::unique_ptr<StagingPage>> m_pages; // the front page is the one being filled, blocks point into pages
+	uint64_t m_numCompletedFrames = 0; // frames below this are done on the GPU
+	MpscQueue<PublishedUpload> m_publishedUploads;
+	mi_tls<StagingBlock> m_threadBlocks; // destroyed before the pages, closing all blocks
 
-	mutable std::mutex m_mtx;
+	mutable std::mutex m_mtx; // protects the frames and the pages, except for pins
 
 protected:
 	static constexpr int DUP_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT = 256;
+	// Texture footprints in buffers must be aligned to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+	static constexpr size_t TEXTURE_STAGING_ALIGNMENT = 512;
+	// Buffer copies have no alignment requirement, packing them tightly keeps
+	// consecutive updates of a buffer contiguous, so their copies can be merged.
+	static constexpr size_t BUFFER_STAGING_ALIGNMENT = 4;
+	// Uploads larger than this get a dedicated resource.
+	static constexpr size_t STAGING_PAGE_SIZE = 4_Mi;
+	// Producer threads take staging memory from pages in blocks of this size.
+	static constexpr size_t STAGING_BLOCK_SIZE = 256_Ki;
+	// Larger uploads are allocated from pages directly, they would leave too much of a block unused.
+	static constexpr size_t MAX_BLOCK_UPLOAD_SIZE = 64_Ki;
+	// Free pages above this count are released when a frame completes.
+	static constexpr size_t MAX_RETAINED_PAGE_COUNT = 16;
 
 private:
+	/// <summary> Reserves staging memory on the calling thread's block, or on a page if the data is large.
+	///		Pins the page until the upload is collected. </summary>
+	StagingRegion ReserveStaging(size_t size, size_t alignment);
+	/// <summary> Reserves staging memory on a page, or in a dedicated resource. Must be called with the mutex locked. </summary>
+	StagingRegion AllocateStaging(size_t size, size_t alignment);
+	void Publish(UploadDescription&& description, const StagingRegion& staging);
+	std::unique_ptr<StagingPage> CreatePage();
+	bool HasBecomeAvailable(const StagingPage& page) const;
+
 	static size_t SnapUpwrads(size_t value, size_t gridSize);
 };
 
@@ -0,0 +1,128 @@
+#include "UploadPlanner.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <numeric>
+
+
+namespace inl::gxeng {
+
+
+namespace {
+
+// Orders the uploads by destination, uploads to the same destination keep their order.
+template <class UploadT>
+std::vector<size_t> GroupByDestination(const std::vector<UploadT>& uploads) {
+	std::vector<size_t> order(uploads.size());
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::stable_sort(order.begin(), order.end(), [&uploads](size_t lhs, size_t rhs) {
+		return std::less<const void*>()(uploads[lhs].destination, uploads[rhs].destination);
+	});
+	return order;
+}
+
+} // namespace
+
+
+std::vector<BufferUploadCopy> PlanBufferCopies(const std::vector<BufferUploadRange>& uploads) {
+	// The part of an upload that has not been overwritten yet.
+	struct Segment {
+		uint64_t end;
+		size_t upload;
+		uint64_t srcOffset;
+	};
+
+	std::vector<BufferUploadCopy> copies;
+	std::vector<size_t> order = GroupByDestination(uploads);
+	std::map<uint64_t, Segment> segments; // keyed by the first byte in the destination
+
+	for (auto groupBegin = order.begin(); groupBegin != order.end();) {
+		const void* destination = uploads[*groupBegin].destination;
+		auto groupEnd = std::find_if(groupBegin, order.end(), [&](size_t index) { return uploads[index].destination != destination; });
+
+		// Play the uploads in order, each one cuts what it overwrites out of the earlier ones.
+		segments.clear();
+		for (auto it = groupBegin; it != groupEnd; ++it) {
+			const BufferUploadRange& upload = uploads[*it];
+			if (upload.size == 0) {
+				continue;
+			}
+			const uint64_t begin = upload.dstOffset;
+			const uint64_t end = upload.dstOffset + upload.size;
+
+			auto overlapped = segments.upper_bound(begin);
+			if (overlapped != segments.begin() && std::prev(overlapped)->second.end > begin) {
+				--overlapped;
+			}
+			while (overlapped != segments.end() && overlapped->first < end) {
+				const uint64_t segmentBegin = overlapped->first;
+				const Segment segment = overlapped->second;
+				overlapped = segments.erase(overlapped);
+				if (segmentBegin < begin) {
+					segments.insert({ segmentBegin, { begin, segment.upload, segment.srcOffset } });
+				}
+				if (segment.end > end) {
+					overlapped = segments.insert({ end, { segment.end, segment.upload, segment.srcOffset + (end - segmentBegin) } }).first;
+				}
+			}
+			segments.insert({ begin, { end, *it, upload.srcOffset } });
+		}
+
+		// Merge what follows each other in both the destination and the staging memory.
+		for (auto& [begin, segment] : segments) {
+			if (!copies.empty()) {
+				BufferUploadCopy& last = copies.back();
+				bool isSameDestination = uploads[last.upload].destination == destination;
+				if (isSameDestination
+					&& last.dstOffset + last.size == begin
+					&& uploads[last.upload].source == uploads[segment.upload].source
+					&& last.srcOffset + last.size == segment.srcOffset)
+				{
+					last.size += segment.end - begin;
+					continue;
+				}
+			}
+			copies.push_back({ segment.upload, begin, segment.srcOffset, segment.end - begin });
+		}
+
+		groupBegin = groupEnd;
+	}
+
+	return copies;
+}
+
+
+std::vector<size_t> PlanTextureCopies(const std::vector<TextureUploadRegion>& uploads) {
+	auto Contains = [](const TextureUploadRegion& outer, const TextureUploadRegion& inner) {
+		return outer.subresource == inner.subresource
+			&& outer.x <= inner.x && inner.x + inner.width <= outer.x + outer.width
+			&& outer.y <= inner.y && inner.y + inner.height <= outer.y + outer.height;
+	};
+
+	std::vector<size_t> order = GroupByDestination(uploads);
+	std::vector<size_t> copies;
+	copies.reserve(order.size());
+
+	for (auto groupBegin = order.begin(); groupBegin != order.end();) {
+		const void* destination = uploads[*groupBegin].destination;
+		auto groupEnd = std::find_if(groupBegin, order.end(), [&](size_t index) { return uploads[index].destination != destination; });
+
+		for (auto it = groupBegin; it != groupEnd; ++it) {
+			bool isOverwritten = std::any_of(std::next(it), groupEnd, [&](size_t later) {
+				return Contains(uploads[later], uploads[*it]);
+			});
+			if (!isOverwritten) {
+				copies.push_back(*it);
+			}
+		}
+
+		groupBegin = groupEnd;
+	}
+
+	return copies;
+}
+
+
+} // namespace inl::gxeng
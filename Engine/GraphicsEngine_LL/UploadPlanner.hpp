@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace inl::gxeng {
+
+
+/// <summary> A buffer upload as far as planning the copies is concerned. </summary>
+struct BufferUploadRange {
+	const void* destination; /// <summary> Identifies the destination buffer. </summary>
+	uint64_t dstOffset;
+	uint64_t size;
+	const void* source; /// <summary> Identifies the staging buffer. </summary>
+	uint64_t srcOffset;
+};
+
+
+/// <summary> A texture upload as far as planning the copies is concerned. </summary>
+struct TextureUploadRegion {
+	const void* destination; /// <summary> Identifies the destination texture. </summary>
+	uint32_t subresource;
+	uint64_t x;
+	uint64_t y;
+	uint64_t width;
+	uint64_t height;
+};
+
+
+/// <summary> A copy from a staging buffer to a destination buffer. </summary>
+struct BufferUploadCopy {
+	size_t upload; /// <summary> Index of the upload that gives the destination and the source. </summary>
+	uint64_t dstOffset;
+	uint64_t srcOffset;
+	uint64_t size;
+};
+
+
+/// <summary>
+/// Plans the buffer copies of a frame, the uploads are given in the order they were made.
+/// Where uploads to the same buffer overlap, the later one wins, uploads that are overwritten entirely are dropped.
+/// Ranges that follow each other both in the destination and in the same staging buffer are merged into one copy.
+/// The copies are grouped by destination and are sorted by offset within a destination.
+/// </summary>
+std::vector<BufferUploadCopy> PlanBufferCopies(const std::vector<BufferUploadRange>& uploads);
+
+
+/// <summary>
+/// Returns the indices of the texture uploads that are not overwritten entirely by a later upload
+/// to the same subresource. They are grouped by destination and keep their order within a destination.
+/// </summary>
+std::vector<size_t> PlanTextureCopies(const std::vector<TextureUploadRegion>& uploads);
+
+
+} // namespace inl::gxeng
@@ -9,6 +9,8 @@
 #include "Socket.hpp"
 #include "SecureSocket.hpp"
 
+#include <BaseLibrary/Memory/AllocationTracker.hpp>
+
 #undef DELETE
 
 namespace inl::net::http
@@ -45,7 +47,7 @@ namespace inl::net::http
 		int32_t sent;
 		secure ? secure_socket->Recv((uint8_t*)string.c_str(), string.size(), sent) : socket->Send((uint8_t*)string.c_str(), string.size(), sent);
 
-		std::vector<char> buffer(16384); // 16 KiB
+		std::vector<char, TrackedAllocator<char, eAllocationTag::NET>> buffer(16384); // 16 KiB
 		std::stringstream ss;
 
 		int32_t read;
@@ -0,0 +1,335 @@
+#include "RecordingGraphicsApi.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+using namespace inl;
+
+
+//------------------------------------------------------------------------------
+// Fence
+//------------------------------------------------------------------------------
+
+uint64_t RecordingFence::Fetch() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_value;
+}
+
+
+void RecordingFence::Signal(uint64_t value) {
+	{
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		m_value = value;
+	}
+	m_cv.notify_all();
+}
+
+
+void RecordingFence::Wait(uint64_t value, uint64_t timeoutMillis) const {
+	std::unique_lock<std::mutex> lk(m_mutex);
+	if (timeoutMillis == FOREVER) {
+		m_cv.wait(lk, [this, value] { return m_value >= value; });
+	}
+	else {
+		m_cv.wait_for(lk, std::chrono::milliseconds(timeoutMillis), [this, value] { return m_value >= value; });
+	}
+}
+
+
+void RecordingFence::WaitAny(const IFence** fences, uint64_t* values, size_t count, uint64_t timeoutMillis) const {
+	// Queues signal immediately, so nothing is ever pending for long.
+	auto start = std::chrono::steady_clock::now();
+	while (true) {
+		for (size_t i = 0; i < count; ++i) {
+			if (fences[i]->Fetch() >= values[i]) {
+				return;
+			}
+		}
+		if (timeoutMillis != FOREVER && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeoutMillis)) {
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+
+void RecordingFence::WaitAll(const IFence** fences, uint64_t* values, size_t count, uint64_t timeoutMillis) const {
+	for (size_t i = 0; i < count; ++i) {
+		fences[i]->Wait(values[i], timeoutMillis);
+	}
+}
+
+
+
+//------------------------------------------------------------------------------
+// Resource
+//------------------------------------------------------------------------------
+
+RecordingResource::RecordingResource(gxapi::ResourceDesc desc) : m_desc(desc) {
+	if (desc.type == gxapi::eResourceType::BUFFER) {
+		m_numMipLevels = 1;
+		m_numArrayLevels = 1;
+		m_memory.resize(desc.bufferDesc.sizeInBytes);
+	}
+	else {
+		m_numMipLevels = std::max<unsigned>(1, desc.textureDesc.mipLevels);
+		m_numArrayLevels = desc.textureDesc.dimension == gxapi::eTextueDimension::THREE ? 1 : std::max<unsigned>(1, desc.textureDesc.depthOrArraySize);
+	}
+}
+
+
+unsigned RecordingResource::GetSubresourceIndex(unsigned mipLevel, unsigned arrayIdx, unsigned planeIdx) const {
+	return mipLevel + arrayIdx * m_numMipLevels + planeIdx * m_numMipLevels * m_numArrayLevels;
+}
+
+
+Vec3u64 RecordingResource::GetSize(unsigned mipLevel) const {
+	if (m_desc.type == gxapi::eResourceType::BUFFER) {
+		return { m_desc.bufferDesc.sizeInBytes, 0, 0 };
+	}
+
+	auto& texture = m_desc.textureDesc;
+	Vec3u64 size = { texture.width, texture.height, texture.dimension == gxapi::eTextueDimension::THREE ? texture.depthOrArraySize : 1 };
+	for (unsigned i = 0; i < mipLevel; ++i) {
+		size = { std::max<uint64_t>(1, size.x / 2), std::max<uint64_t>(1, size.y / 2), std::max<uint64_t>(1, size.z / 2) };
+	}
+	return size;
+}
+
+
+
+//------------------------------------------------------------------------------
+// Descriptor heap
+//------------------------------------------------------------------------------
+
+RecordingDescriptorHeap::RecordingDescriptorHeap(gxapi::DescriptorHeapDesc desc) : m_desc(desc) {
+	static std::atomic<uintptr_t> nextAddress(0x10000);
+	m_baseAddress = nextAddress.fetch_add((desc.numDescriptors + 1) * IncrementSize);
+}
+
+
+gxapi::DescriptorHandle RecordingDescriptorHeap::At(size_t index) const {
+	gxapi::DescriptorHandle handle;
+	handle.cpuAddress = reinterpret_cast<void*>(m_baseAddress + index * IncrementSize);
+	handle.gpuAddress = m_desc.isShaderVisible ? handle.cpuAddress : nullptr;
+	return handle;
+}
+
+
+
+//------------------------------------------------------------------------------
+// Command list
+//------------------------------------------------------------------------------
+
+void RecordingCommandList::Close() {
+	m_isClosed = true;
+}
+
+
+void RecordingCommandList::Reset(gxapi::ICommandAllocator* allocator, gxapi::IPipelineState* newState) {
+	m_recorded.commands.clear();
+	m_isClosed = false;
+}
+
+
+void RecordingCommandList::ResourceBarrier(unsigned numBarriers, gxapi::ResourceBarrier* barriers) {
+	RecordedCommand command;
+	command.name = "ResourceBarrier";
+	command.argument = numBarriers;
+	command.barriers.assign(barriers, barriers + numBarriers);
+	m_recorded.commands.push_back(std::move(command));
+}
+
+
+void RecordingCommandList::Record(const char* name, uint64_t argument) {
+	RecordedCommand command;
+	command.name = name;
+	command.argument = argument;
+	m_recorded.commands.push_back(std::move(command));
+}
+
+
+
+//------------------------------------------------------------------------------
+// Command queue
+//------------------------------------------------------------------------------
+
+void RecordingCommandQueue::ExecuteCommandLists(uint32_t numCommandLists, gxapi::ICommandList* const* commandLists) {
+	m_api->OnExecute(this, numCommandLists, commandLists);
+}
+
+
+void RecordingCommandQueue::Signal(gxapi::IFence* fence, uint64_t value) {
+	m_api->OnSignal();
+	fence->Signal(value);
+}
+
+
+void RecordingCommandQueue::Wait(gxapi::IFence* fence, uint64_t value) {
+	// Everything previously submitted has already finished.
+	m_api->OnWait();
+}
+
+
+
+//------------------------------------------------------------------------------
+// Graphics API
+//------------------------------------------------------------------------------
+
+std::vector<RecordedSubmission> RecordingGraphicsApi::GetSubmissions() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_submissions;
+}
+
+
+RecordingGraphicsApi::Statistics RecordingGraphicsApi::GetStatistics() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_statistics;
+}
+
+
+void RecordingGraphicsApi::ClearRecording() {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	m_submissions.clear();
+	m_statistics = {};
+}
+
+
+gxapi::ICommandQueue* RecordingGraphicsApi::CreateCommandQueue(gxapi::CommandQueueDesc desc) {
+	return new RecordingCommandQueue(this, desc);
+}
+
+
+gxapi::ICommandAllocator* RecordingGraphicsApi::CreateCommandAllocator(gxapi::eCommandListType type) {
+	return new RecordingCommandAllocator(type);
+}
+
+
+gxapi::IGraphicsCommandList* RecordingGraphicsApi::CreateGraphicsCommandList(gxapi::CommandListDesc desc) {
+	return new RecordingCommandList(gxapi::eCommandListType::GRAPHICS);
+}
+
+
+gxapi::IComputeCommandList* RecordingGraphicsApi::CreateComputeCommandList(gxapi::CommandListDesc desc) {
+	return new RecordingCommandList(gxapi::eCommandListType::COMPUTE);
+}
+
+
+gxapi::ICopyCommandList* RecordingGraphicsApi::CreateCopyCommandList(gxapi::CommandListDesc desc) {
+	return new RecordingCommandList(gxapi::eCommandListType::COPY);
+}
+
+
+gxapi::ICommandList* RecordingGraphicsApi::CreateCommandList(gxapi::eCommandListType type, gxapi::CommandListDesc desc) {
+	return static_cast<gxapi::IGraphicsCommandList*>(new RecordingCommandList(type));
+}
+
+
+gxapi::IResource* RecordingGraphicsApi::CreateCommittedResource(gxapi::HeapProperties heapProperties,
+																gxapi::eHeapFlags heapFlags,
+																gxapi::ResourceDesc desc,
+																gxapi::eResourceState initialState,
+																gxapi::ClearValue* clearValue)
+{
+	{
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		++m_statistics.resources;
+	}
+	return new RecordingResource(desc);
+}
+
+
+gxapi::IResource* RecordingGraphicsApi::CreatePlacedResource(gxapi::IHeap* heap,
+															 uint64_t heapOffset,
+															 gxapi::ResourceDesc desc,
+															 gxapi::eResourceState initialState,
+															 gxapi::ClearValue* clearValue)
+{
+	{
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		++m_statistics.resources;
+	}
+	auto resource = new RecordingResource(desc);
+	resource->SetPlacement(heap, heapOffset);
+	return resource;
+}
+
+
+gxapi::ResourceAllocationInfo RecordingGraphicsApi::GetResourceAllocationInfo(gxapi::ResourceDesc desc) const {
+	constexpr uint64_t Alignment = 65536;
+	if (desc.type == gxapi::eResourceType::BUFFER) {
+		return { desc.bufferDesc.sizeInBytes, Alignment };
+	}
+	auto& texture = desc.textureDesc;
+	uint64_t size = texture.width * texture.height * std::max<uint64_t>(1, texture.depthOrArraySize) * gxapi::GetFormatSizeInBytes(texture.format);
+	return { (size + Alignment - 1) / Alignment * Alignment, Alignment };
+}
+
+
+void RecordingGraphicsApi::CopyDescriptors(size_t numSrcDescRanges, gxapi::DescriptorHandle* srcRangeStarts,
+										   size_t numDstDescRanges, gxapi::DescriptorHandle* dstRangeStarts,
+										   uint32_t* rangeCounts, gxapi::eDescriptorHeapType descHeapsType)
+{
+	size_t numDescriptors = 0;
+	for (size_t i = 0; i < numDstDescRanges; ++i) {
+		numDescriptors += rangeCounts[i];
+	}
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	m_statistics.descriptorCopies += numDescriptors;
+}
+
+
+void RecordingGraphicsApi::CopyDescriptors(size_t numSrcDescRanges, gxapi::DescriptorHandle* srcRangeStarts, uint32_t* srcRangeLengths,
+										   size_t numDstDescRanges, gxapi::DescriptorHandle* dstRangeStarts, uint32_t* dstRangeLengths,
+										   gxapi::eDescriptorHeapType descHeapsType)
+{
+	size_t numDescriptors = 0;
+	for (size_t i = 0; i < numDstDescRanges; ++i) {
+		numDescriptors += dstRangeLengths[i];
+	}
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	m_statistics.descriptorCopies += numDescriptors;
+}
+
+
+void RecordingGraphicsApi::CopyDescriptors(gxapi::DescriptorHandle srcStart, gxapi::DescriptorHandle dstStart,
+										   size_t rangeCount, gxapi::eDescriptorHeapType descHeapsType)
+{
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	m_statistics.descriptorCopies += rangeCount;
+}
+
+
+void RecordingGraphicsApi::OnExecute(const RecordingCommandQueue* queue, uint32_t numCommandLists, gxapi::ICommandList* const* commandLists) {
+	RecordedSubmission submission;
+	submission.queue = queue;
+	size_t numBarriers = 0;
+	for (uint32_t i = 0; i < numCommandLists; ++i) {
+		auto list = dynamic_cast<const RecordingCommandList*>(commandLists[i]);
+		submission.commandLists.push_back(list->GetRecorded());
+		for (auto& command : list->GetRecorded().commands) {
+			numBarriers += command.barriers.size();
+		}
+	}
+
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	++m_statistics.executeCalls;
+	m_statistics.commandLists += numCommandLists;
+	m_statistics.barriers += numBarriers;
+	m_submissions.push_back(std::move(submission));
+}
+
+
+void RecordingGraphicsApi::OnSignal() {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	++m_statistics.signals;
+}
+
+
+void RecordingGraphicsApi::OnWait() {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	++m_statistics.waits;
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <GraphicsApi_LL/IGraphicsApi.hpp>
+#include <GraphicsApi_LL/ICommandQueue.hpp>
+#include <GraphicsApi_LL/ICommandAllocator.hpp>
+#include <GraphicsApi_LL/IResource.hpp>
+#include <GraphicsApi_LL/IHeap.hpp>
+#include <GraphicsApi_LL/IFence.hpp>
+#include <GraphicsApi_LL/IDescriptorHeap.hpp>
+#include <GraphicsApi_LL/IPipelineState.hpp>
+#include <GraphicsApi_LL/IRootSignature.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Stand-in for the graphics API that runs nothing on a GPU, but keeps the commands
+// that were submitted to its queues, so that tests can check what the engine produced.
+// The GPU is infinitely fast: fences signaled by a queue are signaled immediately.
+
+
+//------------------------------------------------------------------------------
+// Recorded data
+//------------------------------------------------------------------------------
+
+struct RecordedCommand {
+	std::string name; // name of the ICommandList method, like "ResourceBarrier"
+	uint64_t argument = 0; // first integer argument, like the stencil ref or the number of vertices
+	std::vector<inl::gxapi::ResourceBarrier> barriers; // only for ResourceBarrier
+};
+
+
+struct RecordedCommandList {
+	inl::gxapi::eCommandListType type;
+	std::vector<RecordedCommand> commands;
+};
+
+
+struct RecordedSubmission {
+	const inl::gxapi::ICommandQueue* queue;
+	std::vector<RecordedCommandList> commandLists; // lists passed in one ExecuteCommandLists call
+};
+
+
+
+//------------------------------------------------------------------------------
+// Objects
+//------------------------------------------------------------------------------
+
+class RecordingFence : public inl::gxapi::IFence {
+public:
+	RecordingFence(uint64_t initialValue) : m_value(initialValue) {}
+
+	uint64_t Fetch() const override;
+	void Signal(uint64_t value) override;
+	void Wait(uint64_t value, uint64_t timeoutMillis = FOREVER) const override;
+	void WaitAny(const IFence** fences, uint64_t* values, size_t count, uint64_t timeoutMillis = FOREVER) const override;
+	void WaitAll(const IFence** fences, uint64_t* values, size_t count, uint64_t timeoutMillis = FOREVER) const override;
+private:
+	mutable std::mutex m_mutex;
+	mutable std::condition_variable m_cv;
+	uint64_t m_value;
+};
+
+
+class RecordingResource : public inl::gxapi::IResource {
+public:
+	RecordingResource(inl::gxapi::ResourceDesc desc);
+
+	inl::gxapi::ResourceDesc GetDesc() const override { return m_desc; }
+	void* Map(unsigned subresourceIndex, const inl::gxapi::MemoryRange* readRange = nullptr) override { return m_memory.data(); }
+	void Unmap(unsigned subresourceIndex, const inl::gxapi::MemoryRange* writtenRange = nullptr) override {}
+	void* GetGPUAddress() const override { return const_cast<uint8_t*>(m_memory.data()); }
+
+	unsigned GetNumMipLevels() const override { return m_numMipLevels; }
+	unsigned GetNumTexturePlanes() const override { return 1; }
+	unsigned GetNumArrayLevels() const override { return m_numArrayLevels; }
+	unsigned GetNumSubresources() const override { return m_numMipLevels * m_numArrayLevels; }
+	unsigned GetSubresourceIndex(unsigned mipLevel, unsigned arrayIdx, unsigned planeIdx) const override;
+	inl::Vec3u64 GetSize(unsigned mipLevel = 0) const override;
+
+	void SetName(const char* name) override { m_name = name; }
+	const std::string& GetName() const { return m_name; }
+
+	void SetPlacement(const inl::gxapi::IHeap* heap, uint64_t heapOffset) { m_heap = heap; m_heapOffset = heapOffset; }
+	const inl::gxapi::IHeap* GetHeap() const { return m_heap; } // null for committed resources
+	uint64_t GetHeapOffset() const { return m_heapOffset; }
+private:
+	inl::gxapi::ResourceDesc m_desc;
+	unsigned m_numMipLevels;
+	unsigned m_numArrayLevels;
+	std::vector<uint8_t> m_memory; // only for buffers, they get mapped and written
+	std::string m_name;
+	const inl::gxapi::IHeap* m_heap = nullptr;
+	uint64_t m_heapOffset = 0;
+};
+
+
+class RecordingHeap : public inl::gxapi::IHeap {
+public:
+	RecordingHeap(inl::gxapi::HeapDesc desc) : m_desc(desc) {}
+	inl::gxapi::HeapDesc GetDesc() const override { return m_desc; }
+private:
+	inl::gxapi::HeapDesc m_desc;
+};
+
+
+class RecordingDescriptorHeap : public inl::gxapi::IDescriptorHeap {
+public:
+	RecordingDescriptorHeap(inl::gxapi::DescriptorHeapDesc desc);
+
+	inl::gxapi::DescriptorHandle At(size_t index) const override;
+	inl::gxapi::DescriptorHeapDesc GetDesc() const override { return m_desc; }
+	uint32_t GetIncrementSize() const override { return IncrementSize; }
+private:
+	static constexpr uint32_t IncrementSize = 32;
+	inl::gxapi::DescriptorHeapDesc m_desc;
+	uintptr_t m_baseAddress; // descriptors are never dereferenced, they just need distinct addresses
+};
+
+
+class RecordingCommandAllocator : public inl::gxapi::ICommandAllocator {
+public:
+	RecordingCommandAllocator(inl::gxapi::eCommandListType type) : m_type(type) {}
+	void Reset() override {}
+	inl::gxapi::eCommandListType GetType() const override { return m_type; }
+private:
+	inl::gxapi::eCommandListType m_type;
+};
+
+
+class RecordingPipelineState : public inl::gxapi::IPipelineState {};
+class RecordingRootSignature : public inl::gxapi::IRootSignature {};
+
+
+/// Used for all three types of command lists, it only reports the type it was created with.
+class RecordingCommandList : public inl::gxapi::IGraphicsCommandList {
+public:
+	RecordingCommandList(inl::gxapi::eCommandListType type) { m_recorded.type = type; }
+
+	const RecordedCommandList& GetRecorded() const { return m_recorded; }
+	bool IsClosed() const { return m_isClosed; }
+
+	// ICommandList
+	inl::gxapi::eCommandListType GetType() const override { return m_recorded.type; }
+
+	// ICopyCommandList
+	void Close() override;
+	void Reset(inl::gxapi::ICommandAllocator* allocator, inl::gxapi::IPipelineState* newState = nullptr) override;
+
+	void CopyBuffer(inl::gxapi::IResource* dst, size_t dstOffset, inl::gxapi::IResource* src, size_t srcOffset, size_t numBytes) override { Record("CopyBuffer", numBytes); }
+	void CopyResource(inl::gxapi::IResource* dst, inl::gxapi::IResource* src) override { Record("CopyResource"); }
+	void CopyTexture(inl::gxapi::IResource* dst, unsigned dstSubresourceIndex, int dstX, int dstY, int dstZ,
+					 inl::gxapi::IResource* src, unsigned srcSubresourceIndex, inl::gxapi::Cube srcRegion) override { Record("CopyTexture", dstSubresourceIndex); }
+	void CopyTexture(inl::gxapi::IResource* dst, inl::gxapi::TextureCopyDesc dstDesc, int dstX, int dstY, int dstZ,
+					 inl::gxapi::IResource* src, inl::gxapi::TextureCopyDesc srcDesc, inl::gxapi::Cube srcRegion) override { Record("CopyTexture", dstDesc.subresourceIndex); }
+	void CopyTexture(inl::gxapi::IResource* dst, inl::gxapi::TextureCopyDesc dstDesc, int dstX, int dstY, int dstZ,
+					 inl::gxapi::IResource* src, inl::gxapi::TextureCopyDesc srcDesc) override { Record("CopyTexture", dstDesc.subresourceIndex); }
+
+	void ResourceBarrier(unsigned numBarriers, inl::gxapi::ResourceBarrier* barriers) override;
+	using ICopyCommandList::ResourceBarrier;
+
+	// IComputeCommandList
+	void Dispatch(size_t dimx, size_t dimy = 1, size_t dimz = 1) override { Record("Dispatch", dimx * dimy * dimz); }
+
+	void SetComputeRootConstant(unsigned parameterIndex, unsigned destOffset, uint32_t value) override { Record("SetComputeRootConstant", value); }
+	void SetComputeRootConstants(unsigned parameterIndex, unsigned destOffset, unsigned numValues, const uint32_t* value) override { Record("SetComputeRootConstants", numValues); }
+	void SetComputeRootConstantBuffer(unsigned parameterIndex, void* gpuVirtualAddress) override { Record("SetComputeRootConstantBuffer", parameterIndex); }
+	void SetComputeRootDescriptorTable(unsigned parameterIndex, inl::gxapi::DescriptorHandle baseHandle) override { Record("SetComputeRootDescriptorTable", parameterIndex); }
+	void SetComputeRootShaderResource(unsigned parameterIndex, void* gpuVirtualAddress) override { Record("SetComputeRootShaderResource", parameterIndex); }
+	void SetComputeRootUnorderedResource(unsigned parameterIndex, void* gpuVirtualAddress) override { Record("SetComputeRootUnorderedResource", parameterIndex); }
+	void SetComputeRootSignature(inl::gxapi::IRootSignature* rootSignature) override { Record("SetComputeRootSignature"); }
+
+	void SetPipelineState(inl::gxapi::IPipelineState* pipelineState) override { Record("SetPipelineState"); }
+	void ResetState(inl::gxapi::IPipelineState* initialPipelineState) override { Record("ResetState"); }
+
+	void SetDescriptorHeaps(inl::gxapi::IDescriptorHeap* const* heaps, uint32_t count) override { Record("SetDescriptorHeaps", count); }
+
+	// IGraphicsCommandList
+	void ClearDepthStencil(inl::gxapi::DescriptorHandle dsv, float depth, uint8_t stencil, size_t numRects = 0, inl::gxapi::Rectangle* rects = nullptr,
+						   bool clearDepth = true, bool clearStencil = false) override { Record("ClearDepthStencil", numRects); }
+	void ClearRenderTarget(inl::gxapi::DescriptorHandle rtv, inl::gxapi::ColorRGBA color, size_t numRects = 0, inl::gxapi::Rectangle* rects = nullptr) override { Record("ClearRenderTarget", numRects); }
+
+	void DrawIndexedInstanced(unsigned numIndices, unsigned startIndex = 0, int vertexOffset = 0, unsigned numInstances = 1, unsigned startInstance = 0) override { Record("DrawIndexedInstanced", numIndices); }
+	void DrawInstanced(unsigned numVertices, unsigned startVertex = 0, unsigned numInstances = 1, unsigned startInstance = 0) override { Record("DrawInstanced", numVertices); }
+	void ExecuteBundle(inl::gxapi::IGraphicsCommandList* bundle) override { Record("ExecuteBundle"); }
+
+	void SetIndexBuffer(void* gpuVirtualAddress, size_t sizeInBytes, inl::gxapi::eFormat format) override { Record("SetIndexBuffer", sizeInBytes); }
+	void SetPrimitiveTopology(inl::gxapi::ePrimitiveTopology topology) override { Record("SetPrimitiveTopology", uint64_t(topology)); }
+	void SetVertexBuffers(unsigned startSlot, unsigned count, void** gpuVirtualAddress, unsigned* sizeInBytes, unsigned* strideInBytes) override { Record("SetVertexBuffers", count); }
+
+	void SetRenderTargets(unsigned numRenderTargets, inl::gxapi::DescriptorHandle* renderTargets, inl::gxapi::DescriptorHandle* depthStencil = nullptr) override { Record("SetRenderTargets", numRenderTargets); }
+	void SetBlendFactor(float r, float g, float b, float a) override { Record("SetBlendFactor"); }
+	void SetStencilRef(unsigned stencilRef) override { Record("SetStencilRef", stencilRef); }
+
+	void SetScissorRects(unsigned numRects, inl::gxapi::Rectangle* rects) override { Record("SetScissorRects", numRects); }
+	void SetViewports(unsigned numViewports, inl::gxapi::Viewport* viewports) override { Record("SetViewports", numViewports); }
+
+	void SetGraphicsRootConstant(unsigned parameterIndex, unsigned destOffset, uint32_t value) override { Record("SetGraphicsRootConstant", value); }
+	void SetGraphicsRootConstants(unsigned parameterIndex, unsigned destOffset, unsigned numValues, const uint32_t* value) override { Record("SetGraphicsRootConstants", numValues); }
+	void SetGraphicsRootConstantBuffer(unsigned parameterIndex, void* gpuVirtualAddress) override { Record("SetGraphicsRootConstantBuffer", parameterIndex); }
+	void SetGraphicsRootDescriptorTable(unsigned parameterIndex, inl::gxapi::DescriptorHandle baseHandle) override { Record("SetGraphicsRootDescriptorTable", parameterIndex); }
+	void SetGraphicsRootShaderResource(unsigned parameterIndex, void* gpuVirtualAddress) override { Record("SetGraphicsRootShaderResource", parameterIndex); }
+	void SetGraphicsRootSignature(inl::gxapi::IRootSignature* rootSignature) override { Record("SetGraphicsRootSignature"); }
+private:
+	void Record(const char* name, uint64_t argument = 0);
+private:
+	RecordedCommandList m_recorded;
+	bool m_isClosed = false;
+};
+
+
+class RecordingGraphicsApi;
+
+class RecordingCommandQueue : public inl::gxapi::ICommandQueue {
+public:
+	RecordingCommandQueue(RecordingGraphicsApi* api, inl::gxapi::CommandQueueDesc desc) : m_api(api), m_desc(desc) {}
+
+	void ExecuteCommandLists(uint32_t numCommandLists, inl::gxapi::ICommandList* const* commandLists) override;
+	void Signal(inl::gxapi::IFence* fence, uint64_t value) override;
+	void Wait(inl::gxapi::IFence* fence, uint64_t value) override;
+	inl::gxapi::CommandQueueDesc GetDesc() const override { return m_desc; }
+private:
+	RecordingGraphicsApi* m_api;
+	inl::gxapi::CommandQueueDesc m_desc;
+};
+
+
+
+//------------------------------------------------------------------------------
+// Graphics API
+//------------------------------------------------------------------------------
+
+class RecordingGraphicsApi : public inl::gxapi::IGraphicsApi {
+	friend class RecordingCommandQueue;
+public:
+	struct Statistics {
+		size_t executeCalls = 0; // number of ExecuteCommandLists calls
+		size_t commandLists = 0; // number of lists executed
+		size_t signals = 0;
+		size_t waits = 0;
+		size_t barriers = 0; // number of barriers in all executed lists
+		size_t resources = 0; // number of committed and placed resources created
+		size_t descriptorCopies = 0; // number of descriptors copied by CopyDescriptors
+	};
+public:
+	// Recorded data
+	std::vector<RecordedSubmission> GetSubmissions() const;
+	Statistics GetStatistics() const;
+	void ClearRecording();
+
+	// Command submission
+	inl::gxapi::ICommandQueue* CreateCommandQueue(inl::gxapi::CommandQueueDesc desc) override;
+	inl::gxapi::ICommandAllocator* CreateCommandAllocator(inl::gxapi::eCommandListType type) override;
+	inl::gxapi::IGraphicsCommandList* CreateGraphicsCommandList(inl::gxapi::CommandListDesc desc) override;
+	inl::gxapi::IComputeCommandList* CreateComputeCommandList(inl::gxapi::CommandListDesc desc) override;
+	inl::gxapi::ICopyCommandList* CreateCopyCommandList(inl::gxapi::CommandListDesc desc) override;
+	inl::gxapi::ICommandList* CreateCommandList(inl::gxapi::eCommandListType type, inl::gxapi::CommandListDesc desc) override;
+
+	// Resources
+	inl::gxapi::IResource* CreateCommittedResource(inl::gxapi::HeapProperties heapProperties,
+												   inl::gxapi::eHeapFlags heapFlags,
+												   inl::gxapi::ResourceDesc desc,
+												   inl::gxapi::eResourceState initialState,
+												   inl::gxapi::ClearValue* clearValue = nullptr) override;
+	inl::gxapi::IHeap* CreateHeap(inl::gxapi::HeapDesc desc) override { return new RecordingHeap(desc); }
+	inl::gxapi::IResource* CreatePlacedResource(inl::gxapi::IHeap* heap,
+												uint64_t heapOffset,
+												inl::gxapi::ResourceDesc desc,
+												inl::gxapi::eResourceState initialState,
+												inl::gxapi::ClearValue* clearValue = nullptr) override;
+	// Textures take their size in bytes aligned to 64 KiB, buffers their size.
+	inl::gxapi::ResourceAllocationInfo GetResourceAllocationInfo(inl::gxapi::ResourceDesc desc) const override;
+
+	// Pipeline and binding
+	inl::gxapi::IRootSignature* CreateRootSignature(inl::gxapi::RootSignatureDesc desc) override { return new RecordingRootSignature(); }
+	inl::gxapi::IPipelineState* CreateGraphicsPipelineState(const inl::gxapi::GraphicsPipelineStateDesc& desc) override { return new RecordingPipelineState(); }
+	inl::gxapi::IPipelineState* CreateComputePipelineState(const inl::gxapi::ComputePipelineStateDesc& desc) override { return new RecordingPipelineState(); }
+	inl::gxapi::IDescriptorHeap* CreateDescriptorHeap(inl::gxapi::DescriptorHeapDesc desc) override { return new RecordingDescriptorHeap(desc); }
+
+	// Views, they don't do anything
+	void CreateConstantBufferView(inl::gxapi::ConstantBufferViewDesc desc, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateDepthStencilView(inl::gxapi::DepthStencilViewDesc desc, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateDepthStencilView(const inl::gxapi::IResource* resource, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateDepthStencilView(const inl::gxapi::IResource* resource, inl::gxapi::DepthStencilViewDesc desc, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateRenderTargetView(const inl::gxapi::IResource* resource, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateRenderTargetView(const inl::gxapi::IResource* resource, inl::gxapi::RenderTargetViewDesc desc, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateShaderResourceView(inl::gxapi::ShaderResourceViewDesc descriptor, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateShaderResourceView(const inl::gxapi::IResource* resource, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateShaderResourceView(const inl::gxapi::IResource* resource, inl::gxapi::ShaderResourceViewDesc descriptor, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateUnorderedAccessView(inl::gxapi::UnorderedAccessViewDesc descriptor, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateUnorderedAccessView(const inl::gxapi::IResource* resource, inl::gxapi::DescriptorHandle destination) override {}
+	void CreateUnorderedAccessView(const inl::gxapi::IResource* resource, inl::gxapi::UnorderedAccessViewDesc descriptor, inl::gxapi::DescriptorHandle destination) override {}
+
+	// Descriptor copies are only counted
+	void CopyDescriptors(size_t numSrcDescRanges, inl::gxapi::DescriptorHandle* srcRangeStarts,
+						 size_t numDstDescRanges, inl::gxapi::DescriptorHandle* dstRangeStarts,
+						 uint32_t* rangeCounts, inl::gxapi::eDescriptorHeapType descHeapsType) override;
+	void CopyDescriptors(size_t numSrcDescRanges, inl::gxapi::DescriptorHandle* srcRangeStarts, uint32_t* srcRangeLengths,
+						 size_t numDstDescRanges, inl::gxapi::DescriptorHandle* dstRangeStarts, uint32_t* dstRangeLengths,
+						 inl::gxapi::eDescriptorHeapType descHeapsType) override;
+	void CopyDescriptors(inl::gxapi::DescriptorHandle srcStart, inl::gxapi::DescriptorHandle dstStart,
+						 size_t rangeCount, inl::gxapi::eDescriptorHeapType descHeapsType) override;
+
+	// Misc
+	inl::gxapi::IFence* CreateFence(uint64_t initialValue) override { return new RecordingFence(initialValue); }
+	void MakeResident(const std::vector<inl::gxapi::IResource*>& objects) override {}
+	void Evict(const std::vector<inl::gxapi::IResource*>& objects) override {}
+
+	// Debug
+	void ReportLiveObjects() const override {}
+private:
+	void OnExecute(const RecordingCommandQueue* queue, uint32_t numCommandLists, inl::gxapi::ICommandList* const* commandLists);
+	void OnSignal();
+	void OnWait();
+private:
+	mutable std::mutex m_mutex;
+	std::vector<RecordedSubmission> m_submissions;
+	Statistics m_statistics;
+};
@@ -0,0 +1,156 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/Memory/AllocationTracker.hpp>
+#include <BaseLibrary/Logging/Logger.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+using std::cout;
+using std::endl;
+using inl::AllocationTracker;
+using inl::eAllocationTag;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestAllocationTracker : public AutoRegisterTest<TestAllocationTracker> {
+public:
+	TestAllocationTracker() {}
+
+	static std::string Name() {
+		return "Allocation tracker";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestAllocationTracker::Run() {
+	AllocationTracker& tracker = AllocationTracker::GetInstance();
+	// other code in the process may use the tracker as well, only look at differences
+	auto before = tracker.GetSnapshot();
+
+	// counters of exited threads are kept, allocations freed on other threads are matched up
+	{
+		constexpr int NumThreads = 4;
+		constexpr int NumAllocations = 10000;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < NumThreads; ++t) {
+			threads.emplace_back([&tracker] {
+				for (int i = 0; i < NumAllocations; ++i) {
+					tracker.RecordAllocation(eAllocationTag::PHYSICS, 100);
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		auto afterAllocation = tracker.GetSnapshot();
+		auto& physics = afterAllocation[eAllocationTag::PHYSICS];
+		auto& physicsBefore = before[eAllocationTag::PHYSICS];
+		if (physics.bytes - physicsBefore.bytes != NumThreads * NumAllocations * 100
+			|| physics.allocationCount - physicsBefore.allocationCount != NumThreads * NumAllocations
+			|| physics.peakBytes < physics.bytes)
+		{
+			cout << "Counters of exited threads lost." << endl;
+			return -1;
+		}
+
+		for (int i = 0; i < NumThreads * NumAllocations; ++i) {
+			tracker.RecordDeallocation(eAllocationTag::PHYSICS, 100);
+		}
+		auto afterFree = tracker.GetSnapshot();
+		if (afterFree[eAllocationTag::PHYSICS].bytes != physicsBefore.bytes
+			|| afterFree[eAllocationTag::PHYSICS].peakBytes < physics.bytes - AllocationTracker::FlushThreshold * (NumThreads + 1))
+		{
+			cout << "Deallocation on another thread not accounted." << endl;
+			return -1;
+		}
+	}
+
+	// tracked containers
+	{
+		int64_t assetBefore = tracker.GetSnapshot()[eAllocationTag::ASSET].bytes;
+		{
+			std::vector<float, inl::TrackedAllocator<float, eAllocationTag::ASSET>> vertices(1000);
+			if (tracker.GetSnapshot()[eAllocationTag::ASSET].bytes - assetBefore != int64_t(1000 * sizeof(float))) {
+				cout << "TrackedAllocator did not report." << endl;
+				return -1;
+			}
+		}
+		if (tracker.GetSnapshot()[eAllocationTag::ASSET].bytes != assetBefore) {
+			cout << "TrackedAllocator did not report freeing." << endl;
+			return -1;
+		}
+	}
+
+	// stack sampling
+	{
+		tracker.ClearStackSamples();
+		tracker.SetStackSamplingInterval(10);
+		for (int i = 0; i < 100; ++i) {
+			tracker.RecordAllocation(eAllocationTag::GENERAL, 8);
+			tracker.RecordDeallocation(eAllocationTag::GENERAL, 8);
+		}
+		tracker.SetStackSamplingInterval(0);
+		auto samples = tracker.GetStackSamples();
+		if (samples.size() != 10 || samples[0].tag != eAllocationTag::GENERAL || samples[0].bytes != 8) {
+			cout << "Expected 10 stack samples, got " << samples.size() << "." << endl;
+			return -1;
+		}
+		tracker.ClearStackSamples();
+	}
+
+	// report through the logger
+	{
+		std::stringstream output;
+		{
+			inl::Logger logger;
+			logger.OpenStream(&output);
+			inl::LogStream log = logger.CreateLogStream("memory");
+			tracker.LogSnapshot(log);
+			logger.Flush();
+		}
+		if (output.str().find("upload") == std::string::npos) {
+			cout << "Snapshot not logged." << endl;
+			return -1;
+		}
+	}
+
+	// overhead
+	{
+		constexpr int NumRecords = 10'000'000;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < NumRecords; ++i) {
+			tracker.RecordAllocation(eAllocationTag::GENERAL, 64);
+			tracker.RecordDeallocation(eAllocationTag::GENERAL, 64);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(end - start).count() / (2.0 * NumRecords);
+		cout << "Recording overhead: " << std::fixed << std::setprecision(2) << ns << " ns per call" << endl;
+	}
+
+	auto snapshot = tracker.GetSnapshot();
+	cout << std::setw(10) << "tag" << std::setw(14) << "bytes" << std::setw(14) << "peak" << std::setw(10) << "alive" << std::setw(12) << "total" << endl;
+	for (size_t tag = 0; tag < size_t(eAllocationTag::COUNT); ++tag) {
+		auto& statistics = snapshot.tags[tag];
+		cout << std::setw(10) << AllocationTracker::GetTagName(eAllocationTag(tag))
+			<< std::setw(14) << statistics.bytes << std::setw(14) << statistics.peakBytes
+			<< std::setw(10) << statistics.allocationCount << std::setw(12) << statistics.totalAllocations << endl;
+	}
+
+	return 0;
+}
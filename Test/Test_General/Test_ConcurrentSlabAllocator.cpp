@@ -0,0 +1,205 @@
+#include "Test.hpp"
+#include <BaseLibrary/Memory/SlabAllocatorEngine.hpp>
+#include <BaseLibrary/Memory/ConcurrentSlabAllocatorEngine.hpp>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestConcurrentSlabAllocator : public AutoRegisterTest<TestConcurrentSlabAllocator> {
+public:
+	TestConcurrentSlabAllocator() {}
+
+	static std::string Name() {
+		return "Allocator - Concurrent Slab";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// The current way of sharing an engine: lock the whole thing.
+class LockedSlabAllocator {
+public:
+	LockedSlabAllocator(size_t poolSize) : m_engine(poolSize) {}
+	size_t Allocate() {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		return m_engine.Allocate();
+	}
+	void Deallocate(size_t index) {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		m_engine.Deallocate(index);
+	}
+private:
+	std::mutex m_mutex;
+	inl::SlabAllocatorEngine m_engine;
+};
+
+
+// Each thread keeps a window of live allocations and replaces them randomly.
+// Returns million operations per second.
+template <class AllocatorT>
+static double MeasureThroughput(int numThreads, size_t opsPerThread) {
+	constexpr size_t WindowSize = 64;
+	AllocatorT allocator(numThreads * WindowSize * 2);
+
+	std::vector<std::thread> threads;
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+	for (int t = 0; t < numThreads; ++t) {
+		threads.emplace_back([&, t] {
+			std::mt19937 rne(t);
+			std::vector<size_t> window;
+			for (size_t i = 0; i < WindowSize; ++i) {
+				window.push_back(allocator.Allocate());
+			}
+			++ready;
+			while (!go) {
+				std::this_thread::yield();
+			}
+			for (size_t i = 0; i < opsPerThread; ++i) {
+				size_t& slot = window[rne() % WindowSize];
+				allocator.Deallocate(slot);
+				slot = allocator.Allocate();
+			}
+			for (auto index : window) {
+				allocator.Deallocate(index);
+			}
+		});
+	}
+
+	while (ready < numThreads) {
+		std::this_thread::yield();
+	}
+	auto startTime = std::chrono::high_resolution_clock::now();
+	go = true;
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	double elapsed = std::chrono::duration<double>(endTime - startTime).count();
+	return 2.0 * numThreads * opsPerThread / elapsed / 1e6;
+}
+
+
+// Hammer the engine from many threads, growing it meanwhile, and check that no slot is handed out twice.
+static bool StressTest(int numThreads, size_t opsPerThread) {
+	constexpr size_t MaxSlots = 1 << 20;
+	inl::ConcurrentSlabAllocatorEngine engine(100);
+	std::unique_ptr<std::atomic<int>[]> owners(new std::atomic<int>[MaxSlots]);
+	for (size_t i = 0; i < MaxSlots; ++i) {
+		owners[i] = 0;
+	}
+	std::mutex growMutex;
+	std::atomic<bool> isOk(true);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; ++t) {
+		threads.emplace_back([&, t] {
+			std::mt19937 rne(t);
+			std::vector<size_t> mine;
+			for (size_t i = 0; i < opsPerThread; ++i) {
+				if (mine.empty() || (rne() % 3 != 0 && mine.size() < 500)) {
+					size_t index;
+					try {
+						index = engine.Allocate();
+					}
+					catch (std::bad_alloc&) {
+						// growers serialize and only ever grow, so no stale size shrinks the pool
+						std::lock_guard<std::mutex> lkg(growMutex);
+						engine.Resize(std::min(MaxSlots, engine.Size() + 77));
+						continue;
+					}
+					if (index >= MaxSlots || owners[index].exchange(t + 1) != 0) {
+						isOk = false;
+					}
+					mine.push_back(index);
+				}
+				else {
+					size_t pos = rne() % mine.size();
+					size_t index = mine[pos];
+					mine[pos] = mine.back();
+					mine.pop_back();
+					if (owners[index].exchange(0) != t + 1) {
+						isOk = false;
+					}
+					engine.Deallocate(index);
+				}
+			}
+			for (auto index : mine) {
+				owners[index] = 0;
+				engine.Deallocate(index);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	// everything was freed, so the whole pool must be allocatable again
+	size_t poolSize = engine.Size();
+	std::vector<char> taken(poolSize, 0);
+	try {
+		for (size_t i = 0; i < poolSize; ++i) {
+			size_t index = engine.Allocate();
+			if (index >= poolSize || taken[index]++ != 0) {
+				isOk = false;
+			}
+		}
+	}
+	catch (std::bad_alloc&) {
+		cout << "  Slots were lost." << endl;
+		isOk = false;
+	}
+
+	return isOk;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestConcurrentSlabAllocator::Run() {
+	cout << "Stress test:" << endl;
+	bool isOk = true;
+	for (int numThreads : { 2, 8, 32 }) {
+		bool ok = StressTest(numThreads, 200'000);
+		cout << "  " << std::setw(2) << numThreads << " threads: " << (ok ? "OK." : "Double allocation.") << endl;
+		isOk = isOk && ok;
+	}
+	cout << endl;
+
+	cout << "Scaling (million alloc+dealloc per second):" << endl;
+	cout << std::setw(8) << "threads" << std::setw(16) << "mutex + slab" << std::setw(16) << "concurrent" << endl;
+	for (int numThreads : { 1, 2, 4, 8, 16, 32, 64 }) {
+		constexpr size_t TotalOps = 4'000'000;
+		size_t opsPerThread = TotalOps / numThreads;
+		double locked = MeasureThroughput<LockedSlabAllocator>(numThreads, opsPerThread);
+		double concurrent = MeasureThroughput<inl::ConcurrentSlabAllocatorEngine>(numThreads, opsPerThread);
+		cout << std::fixed << std::setprecision(2)
+			<< std::setw(8) << numThreads << std::setw(16) << locked << std::setw(16) << concurrent << endl;
+	}
+
+	return isOk ? 0 : -1;
+}
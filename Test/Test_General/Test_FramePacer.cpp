@@ -0,0 +1,205 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/FramePacer.hpp>
+#include <BaseLibrary/Exception/Exception.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using std::cout;
+using std::endl;
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestFramePacer : public AutoRegisterTest<TestFramePacer> {
+public:
+	TestFramePacer() {}
+
+	static std::string Name() {
+		return "Frame pacer";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Stand-in device
+//------------------------------------------------------------------------------
+
+// A fence the delayed GPU signals from its own thread.
+class DelayedFence : public gxapi::IFence {
+public:
+	uint64_t Fetch() const override {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		return m_value;
+	}
+	void Signal(uint64_t value) override {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		m_value = value;
+		m_cv.notify_all();
+	}
+	void Wait(uint64_t value, uint64_t timeoutMillis = FOREVER) const override {
+		std::unique_lock<std::mutex> lk(m_mutex);
+		m_cv.wait(lk, [&] { return m_value >= value; });
+	}
+	void WaitAny(const IFence** fences, uint64_t* values, size_t count, uint64_t timeoutMillis = FOREVER) const override {}
+	void WaitAll(const IFence** fences, uint64_t* values, size_t count, uint64_t timeoutMillis = FOREVER) const override {}
+private:
+	mutable std::mutex m_mutex;
+	mutable std::condition_variable m_cv;
+	uint64_t m_value = 0;
+};
+
+
+// Executes submitted frames one after the other, each takes the given time.
+class DelayedGpu {
+public:
+	DelayedGpu() : m_fence(std::make_shared<DelayedFence>()), m_thread([this] { Run(); }) {}
+	~DelayedGpu() {
+		{
+			std::lock_guard<std::mutex> lkg(m_mutex);
+			m_quit = true;
+			m_cv.notify_all();
+		}
+		m_thread.join();
+	}
+
+	SyncPoint Submit(std::chrono::microseconds duration) {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		m_work.push_back(duration);
+		m_maxQueued = std::max(m_maxQueued, m_work.size());
+		m_cv.notify_all();
+		return { m_fence, ++m_numSubmitted };
+	}
+
+	// Most frames that were submitted but not finished at the same time.
+	size_t GetMaxQueued() const {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		return m_maxQueued;
+	}
+private:
+	void Run() {
+		uint64_t numFinished = 0;
+		std::unique_lock<std::mutex> lk(m_mutex);
+		while (true) {
+			m_cv.wait(lk, [this] { return m_quit || !m_work.empty(); });
+			if (m_work.empty()) {
+				return;
+			}
+			auto duration = m_work.front();
+			lk.unlock();
+			std::this_thread::sleep_for(duration);
+			m_fence->Signal(++numFinished);
+			lk.lock();
+			m_work.pop_front();
+		}
+	}
+private:
+	std::shared_ptr<DelayedFence> m_fence;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<std::chrono::microseconds> m_work; // the front is executing
+	uint64_t m_numSubmitted = 0;
+	size_t m_maxQueued = 0;
+	bool m_quit = false;
+	std::thread m_thread;
+};
+
+
+// Renders frames that take cpuTime to record and gpuTime to execute.
+static FramePacer::Statistics RenderFrames(unsigned framesInFlight, int numFrames, std::chrono::microseconds cpuTime, std::chrono::microseconds gpuTime, size_t& maxQueued) {
+	DelayedGpu gpu;
+	FramePacer pacer(framesInFlight);
+	for (int frame = 0; frame < numFrames; ++frame) {
+		pacer.BeginFrame();
+		std::this_thread::sleep_for(cpuTime);
+		pacer.EndFrame(gpu.Submit(gpuTime));
+	}
+	pacer.WaitIdle();
+	maxQueued = gpu.GetMaxQueued();
+	return pacer.GetStatistics();
+}
+
+
+static void Print(const char* name, const FramePacer::Statistics& statistics) {
+	cout << std::fixed << std::setprecision(2) << "  " << name << ": "
+		<< statistics.GetFramesPerSecond() << " fps, "
+		<< statistics.GetAverageLatencyMs() << " ms average latency, "
+		<< std::chrono::duration<double, std::milli>(statistics.maxLatency).count() << " ms max latency, "
+		<< statistics.GetAverageOverlap() << " frames in flight on average, "
+		<< std::chrono::duration<double, std::milli>(statistics.totalBlocked).count() << " ms blocked" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestFramePacer::Run() {
+	// invalid ring sizes
+	for (unsigned framesInFlight : { 0u, FramePacer::MaxFramesInFlight + 1 }) {
+		try {
+			FramePacer pacer(framesInFlight);
+			cout << "Accepted " << framesInFlight << " frames in flight." << endl;
+			return -1;
+		}
+		catch (InvalidArgumentException&) {
+		}
+	}
+
+	constexpr int NumFrames = 40;
+	const auto cpuTime = std::chrono::milliseconds(4);
+	const auto gpuTime = std::chrono::milliseconds(4);
+	cout << "CPU and GPU both 4 ms per frame:" << endl;
+
+	// one frame in flight: the CPU waits for the GPU every frame
+	size_t sequentialQueued;
+	FramePacer::Statistics sequential = RenderFrames(1, NumFrames, cpuTime, gpuTime, sequentialQueued);
+	Print("1 in flight", sequential);
+	if (sequential.numFrames != NumFrames || sequentialQueued != 1) {
+		cout << "Sequential frames overlapped." << endl;
+		return -1;
+	}
+
+	// more frames in flight: recording overlaps execution
+	for (unsigned framesInFlight = 2; framesInFlight <= FramePacer::MaxFramesInFlight; ++framesInFlight) {
+		size_t maxQueued;
+		FramePacer::Statistics pipelined = RenderFrames(framesInFlight, NumFrames, cpuTime, gpuTime, maxQueued);
+		Print(framesInFlight == 2 ? "2 in flight" : "3 in flight", pipelined);
+		if (pipelined.numFrames != NumFrames || maxQueued > framesInFlight) {
+			cout << "More than " << framesInFlight << " frames in flight." << endl;
+			return -1;
+		}
+		if (pipelined.GetFramesPerSecond() < 1.3 * sequential.GetFramesPerSecond() || pipelined.GetAverageOverlap() <= sequential.GetAverageOverlap()) {
+			cout << "Frames in flight did not overlap." << endl;
+			return -1;
+		}
+	}
+
+	// GPU bound: the CPU only blocks when the ring is full
+	{
+		cout << "CPU 1 ms, GPU 6 ms per frame:" << endl;
+		size_t maxQueued;
+		FramePacer::Statistics gpuBound = RenderFrames(3, NumFrames / 2, std::chrono::milliseconds(1), std::chrono::milliseconds(6), maxQueued);
+		Print("3 in flight", gpuBound);
+		if (maxQueued != 3 || gpuBound.totalBlocked.count() == 0) {
+			cout << "GPU bound frames did not fill the ring." << endl;
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/Memory/LinearAllocator.hpp>
+#include <GraphicsEngine_LL/FrameScratchAllocator.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestFrameScratchAllocator : public AutoRegisterTest<TestFrameScratchAllocator> {
+public:
+	TestFrameScratchAllocator() {}
+
+	static std::string Name() {
+		return "Allocator - Frame Scratch";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// Mimics what a frame does with temporaries: a few vectors per task, like barriers and material constants.
+static constexpr int NumFrames = 2000;
+static constexpr int TasksPerFrame = 200;
+
+
+struct Barrier {
+	void* resource;
+	unsigned subresource;
+	unsigned before, after;
+};
+
+
+template <class BarrierAllocT, class ByteAllocT>
+static size_t SimulateTask(std::mt19937& rne, const BarrierAllocT& barrierAlloc, const ByteAllocT& byteAlloc) {
+	std::vector<Barrier, BarrierAllocT> barriers(barrierAlloc);
+	size_t numBarriers = rne() % 24;
+	for (size_t i = 0; i < numBarriers; ++i) {
+		barriers.push_back({ nullptr, unsigned(i), 1, 2 });
+	}
+	std::vector<uint8_t, ByteAllocT> constants(16 + rne() % 256, 0, byteAlloc);
+	constants.back() = uint8_t(barriers.size());
+	return barriers.size() + constants.back();
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestFrameScratchAllocator::Run() {
+	// Alignment and reuse sanity check.
+	{
+		inl::LinearAllocator allocator(256);
+		for (int round = 0; round < 3; ++round) {
+			for (size_t i = 0; i < 100; ++i) {
+				size_t alignment = size_t(1) << (i % 8);
+				void* ptr = allocator.Allocate(i + 1, alignment);
+				if (reinterpret_cast<uintptr_t>(ptr) % alignment != 0) {
+					cout << "Misaligned allocation." << endl;
+					return -1;
+				}
+			}
+			if (round > 0 && allocator.GetHeapAllocationCount() != 0) {
+				cout << "Allocator did not keep its memory after reset." << endl;
+				return -1;
+			}
+			allocator.Reset();
+		}
+	}
+
+	volatile size_t sink = 0;
+
+	// Heap.
+	auto startTime = std::chrono::high_resolution_clock::now();
+	{
+		std::mt19937 rne(42);
+		for (int frame = 0; frame < NumFrames; ++frame) {
+			for (int task = 0; task < TasksPerFrame; ++task) {
+				sink = sink + SimulateTask(rne, std::allocator<Barrier>(), std::allocator<uint8_t>());
+			}
+		}
+	}
+	auto heapTime = std::chrono::high_resolution_clock::now() - startTime;
+
+	// Frame scratch, reset by the frame completion event.
+	inl::gxeng::FrameScratchAllocator scratch(4 * 1024);
+	size_t heapAllocationsAfterWarmup = 0;
+	startTime = std::chrono::high_resolution_clock::now();
+	{
+		std::mt19937 rne(42);
+		for (int frame = 0; frame < NumFrames; ++frame) {
+			for (int task = 0; task < TasksPerFrame; ++task) {
+				sink = sink + SimulateTask(rne, scratch.GetAdaptor<Barrier>(), scratch.GetAdaptor<uint8_t>());
+			}
+			scratch.OnFrameCompleteHost(frame);
+			if (frame >= 10) {
+				heapAllocationsAfterWarmup += scratch.GetLastFrameStatistics().heapAllocations;
+			}
+		}
+	}
+	auto scratchTime = std::chrono::high_resolution_clock::now() - startTime;
+
+	auto statistics = scratch.GetLastFrameStatistics();
+	size_t allocsPerRun = size_t(NumFrames) * TasksPerFrame;
+	cout << std::fixed << std::setprecision(2);
+	cout << "Per-task transient vectors (" << TasksPerFrame << " tasks per frame):" << endl;
+	cout << "  heap:          " << std::setw(8) << std::chrono::duration<double, std::nano>(heapTime).count() / allocsPerRun << " ns/task" << endl;
+	cout << "  frame scratch: " << std::setw(8) << std::chrono::duration<double, std::nano>(scratchTime).count() / allocsPerRun << " ns/task" << endl;
+	cout << "  last frame: " << statistics.bytesAllocated << " bytes, " << statistics.heapAllocations << " heap allocations" << endl;
+	cout << "  heap allocations after warmup: " << heapAllocationsAfterWarmup << endl;
+
+	return heapAllocationsAfterWarmup == 0 ? 0 : -1;
+}
@@ -0,0 +1,222 @@
+#include "Test.hpp"
+#include "RecordingGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/GraphicsCommandList.hpp>
+#include <GraphicsEngine_LL/CommandAllocatorPool.hpp>
+#include <GraphicsEngine_LL/CommandListPool.hpp>
+#include <GraphicsEngine_LL/ScratchSpacePool.hpp>
+#include <GraphicsEngine_LL/MemoryManager.hpp>
+#include <GraphicsEngine_LL/VolatileViewHeap.hpp>
+#include <GraphicsEngine_LL/ResourceView.hpp>
+#include <GraphicsEngine_LL/Binder.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestGraphicsCommandList : public AutoRegisterTest<TestGraphicsCommandList> {
+public:
+	TestGraphicsCommandList() {}
+
+	static std::string Name() {
+		return "Graphics command list - redundant state";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+static constexpr unsigned NumEntities = 100;
+static constexpr unsigned EntitiesPerMesh = 10; // entities are sorted by mesh and material like in the forward pass
+static constexpr unsigned NumSharedTextures = 5; // shadow maps and such, the same for every entity
+
+
+static size_t CountCommands(const RecordedCommandList& recorded, const std::string& name) {
+	return std::count_if(recorded.commands.begin(), recorded.commands.end(), [&](const RecordedCommand& command) {
+		return command.name == name;
+	});
+}
+
+
+// The engine objects a command list needs, on top of the recording API.
+struct TestDevice {
+	TestDevice() :
+		memoryManager(&api),
+		textureSpace(&api),
+		commandAllocatorPool(&api),
+		commandListPool(&api),
+		scratchSpacePool(&api, gxapi::eDescriptorHeapType::CBV_SRV_UAV),
+		volatileCbvHeap(&api)
+	{}
+
+	RecordingGraphicsApi api;
+	MemoryManager memoryManager;
+	CbvSrvUavHeap textureSpace;
+	CommandAllocatorPool commandAllocatorPool;
+	CommandListPool commandListPool;
+	ScratchSpacePool scratchSpacePool;
+	VolatileViewHeap volatileCbvHeap;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestGraphicsCommandList::Run() {
+	TestDevice device;
+
+	// t0..t5 go into the same descriptor table, b0 is a root CBV
+	std::vector<BindParameterDesc> parameters;
+	for (unsigned reg = 0; reg <= NumSharedTextures; ++reg) {
+		BindParameterDesc desc;
+		desc.parameter = BindParameter(eBindParameterType::TEXTURE, reg);
+		parameters.push_back(desc);
+	}
+	BindParameterDesc cbDesc;
+	cbDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 0);
+	cbDesc.constantSize = 0;
+	parameters.push_back(cbDesc);
+	Binder binder(&device.api, parameters);
+
+	std::unique_ptr<gxapi::IPipelineState> pso(device.api.CreateGraphicsPipelineState(gxapi::GraphicsPipelineStateDesc{}));
+
+	// textures: the shared ones, then an albedo per mesh
+	constexpr unsigned NumMeshes = NumEntities / EntitiesPerMesh;
+	std::vector<Texture2D> textures;
+	std::vector<TextureView2D> textureViews;
+	for (unsigned i = 0; i < NumSharedTextures + NumMeshes; ++i) {
+		textures.push_back(device.memoryManager.CreateTexture2D(eResourceHeapType::CRITICAL, Texture2DDesc(256, 256, gxapi::eFormat::R8G8B8A8_UNORM)));
+		textureViews.push_back(TextureView2D(textures.back(), device.textureSpace, gxapi::eFormat::R8G8B8A8_UNORM, gxapi::SrvTexture2DArray{ 0, 1, 0.0f, 0, 0, 1 }));
+	}
+
+	// two materials, alternating per mesh
+	std::vector<PersistentConstBuffer> materials;
+	std::vector<ConstBufferView> materialViews;
+	for (unsigned i = 0; i < 2; ++i) {
+		float color[4] = { float(i), 0.5f, 0.5f, 1.0f };
+		materials.push_back(device.memoryManager.CreatePersistentConstBuffer(color, sizeof(color)));
+		materialViews.push_back(ConstBufferView(materials.back(), device.textureSpace));
+	}
+
+	std::vector<VertexBuffer> vertexBuffers;
+	std::vector<IndexBuffer> indexBuffers;
+	for (unsigned i = 0; i < NumMeshes; ++i) {
+		vertexBuffers.push_back(device.memoryManager.CreateVertexBuffer(eResourceHeapType::CRITICAL, 36 * 32));
+		indexBuffers.push_back(device.memoryManager.CreateIndexBuffer(eResourceHeapType::CRITICAL, 36 * 4, 36));
+	}
+
+	GraphicsCommandList commandList(&device.api,
+									device.commandListPool,
+									device.commandAllocatorPool,
+									device.scratchSpacePool,
+									device.memoryManager,
+									device.volatileCbvHeap);
+
+	// the forward pass: everything is set again for each entity
+	for (unsigned entity = 0; entity < NumEntities; ++entity) {
+		unsigned mesh = entity / EntitiesPerMesh;
+
+		commandList.SetPipelineState(pso.get());
+		commandList.SetGraphicsBinder(&binder);
+		for (unsigned i = 0; i < NumSharedTextures; ++i) {
+			commandList.SetResourceState(textures[i], gxapi::eResourceState::PIXEL_SHADER_RESOURCE);
+		}
+		commandList.SetResourceState(textures[NumSharedTextures + mesh], gxapi::eResourceState::PIXEL_SHADER_RESOURCE);
+		commandList.SetResourceState(vertexBuffers[mesh], gxapi::eResourceState::VERTEX_AND_CONSTANT_BUFFER);
+		commandList.SetResourceState(indexBuffers[mesh], gxapi::eResourceState::INDEX_BUFFER);
+
+		for (unsigned i = 0; i < NumSharedTextures; ++i) {
+			commandList.BindGraphics(BindParameter(eBindParameterType::TEXTURE, i), textureViews[i]);
+		}
+		commandList.BindGraphics(BindParameter(eBindParameterType::TEXTURE, NumSharedTextures), textureViews[NumSharedTextures + mesh]);
+		commandList.BindGraphics(BindParameter(eBindParameterType::CONSTANT, 0), materialViews[mesh % 2]);
+
+		const VertexBuffer* vertexBuffer = &vertexBuffers[mesh];
+		unsigned size = 36 * 32;
+		unsigned stride = 32;
+		commandList.SetVertexBuffers(0, 1, &vertexBuffer, &size, &stride);
+		commandList.SetIndexBuffer(&indexBuffers[mesh], true);
+		commandList.DrawIndexedInstanced(36);
+	}
+
+	// after a reset nothing is known about the native list
+	commandList.ResetState();
+	commandList.SetPipelineState(pso.get());
+	commandList.SetGraphicsBinder(&binder);
+
+	SkippedCallCounters skipped = commandList.GetSkippedCalls();
+	size_t descriptorCopies = device.api.GetStatistics().descriptorCopies;
+
+	BasicCommandList& basicList = commandList;
+	BasicCommandList::Decomposition decomposition = basicList.Decompose();
+	auto recordingList = dynamic_cast<RecordingCommandList*>(decomposition.commandList.get());
+	if (!recordingList) {
+		cout << "Command list was not created by the recording API." << endl;
+		return -1;
+	}
+	const RecordedCommandList& recorded = recordingList->GetRecorded();
+
+	cout << "Forward pass of " << NumEntities << " entities, native calls (skipped):" << endl;
+	cout << "    SetPipelineState:              " << CountCommands(recorded, "SetPipelineState") << " (" << skipped.pipelineStates << ")" << endl;
+	cout << "    SetGraphicsRootSignature:      " << CountCommands(recorded, "SetGraphicsRootSignature") << " (" << skipped.rootSignatures << ")" << endl;
+	cout << "    SetGraphicsRootConstantBuffer: " << CountCommands(recorded, "SetGraphicsRootConstantBuffer") << " (" << skipped.rootDescriptors << ")" << endl;
+	cout << "    SetGraphicsRootDescriptorTable:" << CountCommands(recorded, "SetGraphicsRootDescriptorTable") << endl;
+	cout << "    SetVertexBuffers:              " << CountCommands(recorded, "SetVertexBuffers") << " (" << skipped.vertexBuffers << ")" << endl;
+	cout << "    SetIndexBuffer:                " << CountCommands(recorded, "SetIndexBuffer") << " (" << skipped.indexBuffers << ")" << endl;
+	cout << "    descriptors copied:            " << descriptorCopies << " (" << skipped.descriptorCopies << ")" << endl;
+
+	// the state is set once, then again after the reset
+	if (CountCommands(recorded, "SetPipelineState") != 2 || skipped.pipelineStates != NumEntities - 1) {
+		cout << "Redundant pipeline states were not skipped." << endl;
+		return -1;
+	}
+	if (CountCommands(recorded, "SetGraphicsRootSignature") != 2 || skipped.rootSignatures != NumEntities - 1) {
+		cout << "Redundant binders were not skipped." << endl;
+		return -1;
+	}
+
+	// the material changes with the mesh
+	if (CountCommands(recorded, "SetGraphicsRootConstantBuffer") != NumMeshes
+		|| skipped.rootDescriptors != NumEntities - NumMeshes) {
+		cout << "Redundant root CBVs were not skipped, or changed ones were." << endl;
+		return -1;
+	}
+	if (CountCommands(recorded, "SetVertexBuffers") != NumMeshes || skipped.vertexBuffers != NumEntities - NumMeshes
+		|| CountCommands(recorded, "SetIndexBuffer") != NumMeshes || skipped.indexBuffers != NumEntities - NumMeshes) {
+		cout << "Redundant vertex or index buffers were not skipped, or changed ones were." << endl;
+		return -1;
+	}
+
+	// The first entity fills the table one by one, each new mesh duplicates the committed table with the new albedo.
+	// Without the filter, every entity would duplicate the table and copy the rest one by one.
+	constexpr unsigned TableSize = NumSharedTextures + 1;
+	if (descriptorCopies != TableSize * NumMeshes
+		|| skipped.descriptorCopies != TableSize * NumEntities - TableSize - (NumMeshes - 1)) {
+		cout << "Redundant descriptor copies were not skipped, or changed ones were." << endl;
+		return -1;
+	}
+	if (CountCommands(recorded, "DrawIndexedInstanced") != NumEntities) {
+		cout << "Draw calls are missing." << endl;
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/JobSystem.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+using std::cout;
+using std::endl;
+using inl::JobSystem;
+using inl::JobCounter;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestJobSystem : public AutoRegisterTest<TestJobSystem> {
+public:
+	TestJobSystem() {}
+
+	static std::string Name() {
+		return "Job system";
+	}
+	virtual int Run() override;
+private:
+	static bool TestCorrectness();
+	static void BenchmarkSpawn();
+	static void BenchmarkParallelFor();
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double Seconds(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration<double>(end - start).count();
+}
+
+
+// Some floating point work that the compiler can't throw away.
+static double Work(size_t index) {
+	double x = double(index);
+	for (int i = 0; i < 64; ++i) {
+		x = std::sqrt(x * 1.0001 + 1.0);
+	}
+	return x;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestJobSystem::Run() {
+	if (!TestCorrectness()) {
+		return -1;
+	}
+	BenchmarkSpawn();
+	BenchmarkParallelFor();
+	return 0;
+}
+
+
+bool TestJobSystem::TestCorrectness() {
+	JobSystem jobSystem(4);
+
+	// many independent jobs
+	{
+		std::atomic<int> sum(0);
+		JobCounter counter;
+		for (int i = 0; i < 10000; ++i) {
+			jobSystem.Run([&sum, i] { sum += i; }, &counter);
+		}
+		jobSystem.Wait(counter);
+		if (sum != 10000 * 9999 / 2) {
+			cout << "Independent jobs: wrong sum." << endl;
+			return false;
+		}
+	}
+
+	// jobs spawning jobs
+	{
+		std::atomic<int> count(0);
+		JobCounter counter;
+		for (int i = 0; i < 100; ++i) {
+			jobSystem.Run([&] {
+				for (int j = 0; j < 100; ++j) {
+					jobSystem.Run([&count] { ++count; }, &counter);
+				}
+			}, &counter);
+		}
+		jobSystem.Wait(counter);
+		if (count != 100 * 100) {
+			cout << "Nested jobs: not all jobs ran." << endl;
+			return false;
+		}
+	}
+
+	// dependencies: fill, then sum, then check, each stage waiting for the previous
+	{
+		std::vector<int> values(1000, 0);
+		int sum = 0;
+		bool isOrdered = false;
+		JobCounter fillDone, sumDone, allDone;
+		for (size_t i = 0; i < values.size(); ++i) {
+			jobSystem.Run([&values, i] { values[i] = int(i); }, &fillDone);
+		}
+		jobSystem.Run([&] { sum = std::accumulate(values.begin(), values.end(), 0); }, &sumDone, fillDone);
+		jobSystem.Run([&] { isOrdered = sum == 1000 * 999 / 2; }, &allDone, sumDone);
+		jobSystem.Wait(allDone);
+		if (!isOrdered || !fillDone.IsZero() || !sumDone.IsZero()) {
+			cout << "Dependencies: jobs ran out of order." << endl;
+			return false;
+		}
+
+		// depending on a finished counter runs right away
+		JobCounter late;
+		jobSystem.Run([&] { sum = 0; }, &late, fillDone);
+		jobSystem.Wait(late);
+		if (sum != 0) {
+			cout << "Dependencies: job on finished counter did not run." << endl;
+			return false;
+		}
+	}
+
+	// parallel for covers every index exactly once
+	{
+		std::vector<std::atomic<int>> visits(100003);
+		for (auto& v : visits) {
+			v = 0;
+		}
+		jobSystem.ParallelFor(0, visits.size(), 100, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				++visits[i];
+			}
+		});
+		for (auto& v : visits) {
+			if (v != 1) {
+				cout << "ParallelFor: index visited " << v << " times." << endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void TestJobSystem::BenchmarkSpawn() {
+	constexpr int NumJobs = 200'000;
+	JobSystem jobSystem;
+	std::atomic<int> sink(0);
+
+	cout << "Spawn overhead with " << jobSystem.GetWorkerCount() << " workers (ns per job):" << endl;
+
+	// from an outside thread, jobs go through the shared queue
+	{
+		JobCounter counter;
+		auto start = Clock::now();
+		for (int i = 0; i < NumJobs; ++i) {
+			jobSystem.Run([&sink] { sink.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		}
+		jobSystem.Wait(counter);
+		auto end = Clock::now();
+		cout << "    from outside:   " << std::fixed << std::setprecision(1) << Seconds(start, end) / NumJobs * 1e9 << endl;
+	}
+
+	// from a worker, jobs go to its own deque
+	{
+		JobCounter outer;
+		double seconds = 0;
+		jobSystem.Run([&] {
+			JobCounter counter;
+			auto start = Clock::now();
+			for (int i = 0; i < NumJobs; ++i) {
+				jobSystem.Run([&sink] { sink.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			}
+			jobSystem.Wait(counter);
+			seconds = Seconds(start, Clock::now());
+		}, &outer);
+		jobSystem.Wait(outer);
+		cout << "    from worker:    " << std::fixed << std::setprecision(1) << seconds / NumJobs * 1e9 << endl;
+	}
+
+	// for reference
+	{
+		auto start = Clock::now();
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 1000; ++i) {
+			threads.emplace_back([&sink] { sink.fetch_add(1, std::memory_order_relaxed); });
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		auto end = Clock::now();
+		cout << "    std::thread:    " << std::fixed << std::setprecision(1) << Seconds(start, end) / 1000 * 1e9 << endl;
+	}
+	cout << endl;
+}
+
+
+void TestJobSystem::BenchmarkParallelFor() {
+	constexpr size_t Count = 1'000'000;
+	std::vector<double> results(Count);
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < Count; ++i) {
+		results[i] = Work(i);
+	}
+	double serialSeconds = Seconds(start, Clock::now());
+
+	cout << "ParallelFor scaling, " << Count << " items (hardware threads: " << std::thread::hardware_concurrency() << "):" << endl;
+	cout << std::setw(10) << "workers" << std::setw(10) << "grain" << std::setw(12) << "time [ms]" << std::setw(10) << "speedup" << endl;
+	cout << std::setw(10) << "serial" << std::setw(10) << "-" << std::setw(12) << std::fixed << std::setprecision(2) << serialSeconds * 1000 << std::setw(10) << 1.0 << endl;
+
+	unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned numWorkers = 1; numWorkers <= maxWorkers; numWorkers *= 2) {
+		JobSystem jobSystem(numWorkers);
+		for (size_t grain : { 256, 4096 }) {
+			auto start = Clock::now();
+			jobSystem.ParallelFor(0, Count, grain, [&results](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i) {
+					results[i] = Work(i);
+				}
+			});
+			double seconds = Seconds(start, Clock::now());
+			cout << std::setw(10) << numWorkers << std::setw(10) << grain << std::setw(12) << seconds * 1000 << std::setw(10) << serialSeconds / seconds << endl;
+		}
+	}
+	cout << endl;
+}
@@ -0,0 +1,151 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/MpscQueue.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestMpscQueue : public AutoRegisterTest<TestMpscQueue> {
+public:
+	TestMpscQueue() {}
+
+	static std::string Name() {
+		return "Queue - MPSC";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// The usual way of collecting things from many threads.
+class LockedQueue {
+public:
+	template <class U>
+	void Push(U&& element) {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		m_elements.push_back(std::forward<U>(element));
+	}
+	template <class Func>
+	size_t PopAll(Func&& func) {
+		{
+			std::lock_guard<std::mutex> lkg(m_mutex);
+			m_elements.swap(m_popped);
+		}
+		for (auto& element : m_popped) {
+			func(std::move(element));
+		}
+		size_t count = m_popped.size();
+		m_popped.clear();
+		return count;
+	}
+private:
+	std::mutex m_mutex;
+	std::vector<uint64_t> m_elements;
+	std::vector<uint64_t> m_popped;
+};
+
+
+// Every producer sends a sequence of numbers, the high bits tell the producer.
+// Checks order per producer and completeness. Returns million elements per second.
+template <class QueueT>
+static double Transfer(int numProducers, uint64_t elementsPerProducer, bool& isOk) {
+	QueueT queue;
+	isOk = true;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < numProducers; ++producer) {
+		producers.emplace_back([&queue, producer, elementsPerProducer] {
+			for (uint64_t i = 0; i < elementsPerProducer; ++i) {
+				queue.Push((uint64_t(producer) << 48) | i);
+			}
+		});
+	}
+
+	std::vector<uint64_t> expected(numProducers, 0);
+	uint64_t numReceived = 0;
+	while (numReceived < numProducers * elementsPerProducer) {
+		size_t count = queue.PopAll([&](uint64_t value) {
+			uint64_t producer = value >> 48;
+			isOk = isOk && producer < uint64_t(numProducers) && (value & 0xFFFF'FFFF'FFFF) == expected[producer];
+			if (producer < uint64_t(numProducers)) {
+				++expected[producer];
+			}
+		});
+		numReceived += count;
+		if (count == 0) {
+			std::this_thread::yield();
+		}
+	}
+	for (auto& producer : producers) {
+		producer.join();
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	return numReceived / std::chrono::duration<double>(endTime - startTime).count() / 1e6;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestMpscQueue::Run() {
+	// elements left in the queue must be destroyed
+	{
+		auto shared = std::make_shared<int>(0);
+		{
+			inl::MpscQueue<std::shared_ptr<int>> queue;
+			for (int i = 0; i < 8; ++i) {
+				queue.Push(shared);
+			}
+			size_t count = queue.PopAll([](std::shared_ptr<int>) {});
+			if (count != 8 || !queue.IsEmpty()) {
+				cout << "Not everything was popped." << endl;
+				return -1;
+			}
+			queue.Push(shared);
+		}
+		if (shared.use_count() != 1) {
+			cout << "Elements leaked." << endl;
+			return -1;
+		}
+	}
+
+	constexpr uint64_t NumElements = 4'000'000;
+	bool isLockedOk, isMpscOk;
+	cout << "Many producers, single consumer (million elements per second):" << endl;
+	cout << std::setw(10) << "producers" << std::setw(16) << "mutex + vector" << std::setw(10) << "mpsc" << endl;
+	for (int numProducers : { 1, 2, 4, 8 }) {
+		double locked = Transfer<LockedQueue>(numProducers, NumElements / numProducers, isLockedOk);
+		double mpsc = Transfer<inl::MpscQueue<uint64_t>>(numProducers, NumElements / numProducers, isMpscOk);
+		cout << std::fixed << std::setprecision(2)
+			<< std::setw(10) << numProducers << std::setw(16) << locked << std::setw(10) << mpsc << endl;
+		if (!isLockedOk || !isMpscOk) {
+			cout << "Elements arrived out of order or from nowhere." << endl;
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,266 @@
+#include "Test.hpp"
+#include <BaseLibrary/Memory/MultiInstanceTLS.hpp>
+#include <BaseLibrary/Memory/SlabAllocatorEngine.hpp>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestMultiInstanceTLSBenchmark : public AutoRegisterTest<TestMultiInstanceTLSBenchmark> {
+public:
+	TestMultiInstanceTLSBenchmark() {}
+
+	static std::string Name() {
+		return "Multi Instance TLS - Benchmark";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// The previous implementation: per-thread deque of optionals, slots are never reclaimed.
+template <class T>
+class LegacyMultiInstanceTLS {
+public:
+	LegacyMultiInstanceTLS() {
+		std::lock_guard<std::mutex> lkg(indexAllocatorLock);
+		try {
+			myIndex = indexAllocator.Allocate();
+		}
+		catch (std::bad_alloc&) {
+			indexAllocator.Resize(size_t(indexAllocator.Size() * 1.2 + 1));
+			myIndex = indexAllocator.Allocate();
+		}
+	}
+	~LegacyMultiInstanceTLS() {
+		std::lock_guard<std::mutex> lkg(indexAllocatorLock);
+		indexAllocator.Deallocate(myIndex);
+	}
+	operator T&() & {
+		size_t size = threadObjects.size() - 1;
+		size_t testIndex = myIndex < size ? myIndex : size;
+		if (!threadObjects[testIndex]) {
+			if (threadObjects.size() - 1 <= myIndex) {
+				threadObjects.resize(myIndex + 2);
+			}
+			threadObjects[myIndex] = defaultRecord;
+		}
+		return threadObjects[myIndex].value();
+	}
+private:
+	static thread_local std::deque<std::optional<T>> threadObjects;
+	static std::mutex indexAllocatorLock;
+	static inl::SlabAllocatorEngine indexAllocator;
+
+	size_t myIndex;
+	T defaultRecord = T();
+};
+
+template <class T>
+thread_local std::deque<std::optional<T>> LegacyMultiInstanceTLS<T>::threadObjects(1);
+template <class T>
+std::mutex LegacyMultiInstanceTLS<T>::indexAllocatorLock;
+template <class T>
+inl::SlabAllocatorEngine LegacyMultiInstanceTLS<T>::indexAllocator(10);
+
+
+// Counts live objects to detect leaks.
+struct Counted {
+	static std::atomic<long long> liveCount;
+	long long value = 0;
+	Counted() { ++liveCount; }
+	Counted(const Counted& rhs) : value(rhs.value) { ++liveCount; }
+	~Counted() { --liveCount; }
+};
+std::atomic<long long> Counted::liveCount(0);
+
+
+static thread_local long long plainThreadLocal;
+
+
+// Each thread increments its value of every instance in turn. Returns nanoseconds per access.
+template <class InstanceT>
+static double MeasureAccess(int numThreads, int numInstances, long long accessesPerThread) {
+	std::vector<std::unique_ptr<InstanceT>> instances;
+	for (int i = 0; i < numInstances; ++i) {
+		instances.push_back(std::make_unique<InstanceT>());
+	}
+
+	std::vector<std::thread> threads;
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+	std::atomic<long long> sink(0);
+	for (int t = 0; t < numThreads; ++t) {
+		threads.emplace_back([&] {
+			for (auto& instance : instances) {
+				(long long&)*instance = 0; // first touch is not measured
+			}
+			++ready;
+			while (!go) {
+				std::this_thread::yield();
+			}
+			long long rounds = accessesPerThread / numInstances;
+			for (long long r = 0; r < rounds; ++r) {
+				for (auto& instance : instances) {
+					++(long long&)*instance;
+				}
+			}
+			sink += (long long&)*instances[0];
+		});
+	}
+
+	while (ready < numThreads) {
+		std::this_thread::yield();
+	}
+	auto startTime = std::chrono::high_resolution_clock::now();
+	go = true;
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(endTime - startTime).count() / accessesPerThread;
+}
+
+
+static double MeasureThreadLocal(int numThreads, long long accessesPerThread) {
+	std::vector<std::thread> threads;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < numThreads; ++t) {
+		threads.emplace_back([&] {
+			plainThreadLocal = 0;
+			for (long long i = 0; i < accessesPerThread; ++i) {
+				++*(volatile long long*)&plainThreadLocal;
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(endTime - startTime).count() / accessesPerThread;
+}
+
+
+// Destroys instances while the threads that touched them are still alive.
+static bool ReclamationTest() {
+	constexpr int NumThreads = 4;
+	constexpr int NumInstances = 100;
+	bool isOk = true;
+
+	auto instances = std::make_unique<std::vector<std::unique_ptr<inl::mi_tls<Counted>>>>();
+	for (int i = 0; i < NumInstances; ++i) {
+		instances->push_back(std::make_unique<inl::mi_tls<Counted>>());
+	}
+	long long baseline = Counted::liveCount; // default records
+
+	std::atomic<int> phase(0);
+	std::atomic<int> done(0);
+	std::atomic<bool> isStale(false);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < NumThreads; ++t) {
+		threads.emplace_back([&] {
+			// touch every instance
+			for (auto& instance : *instances) {
+				((Counted&)*instance).value = 42;
+			}
+			++done;
+			while (phase != 1) {
+				std::this_thread::yield();
+			}
+			// slots are reused by new instances, values must start fresh
+			for (auto& instance : *instances) {
+				if (((Counted&)*instance).value != 0) {
+					isStale = true;
+				}
+			}
+			++done;
+			while (phase != 2) {
+				std::this_thread::yield();
+			}
+		});
+	}
+
+	while (done < NumThreads) {
+		std::this_thread::yield();
+	}
+	if (Counted::liveCount != baseline + NumThreads * NumInstances) {
+		cout << "  Unexpected number of thread values." << endl;
+		isOk = false;
+	}
+
+	// destroy and recreate the instances, all thread values must go away meanwhile
+	instances->clear();
+	if (Counted::liveCount != 0) {
+		cout << "  Thread values of destroyed instances leaked." << endl;
+		isOk = false;
+	}
+	for (int i = 0; i < NumInstances; ++i) {
+		instances->push_back(std::make_unique<inl::mi_tls<Counted>>());
+	}
+	phase = 1;
+	while (done < 2 * NumThreads) {
+		std::this_thread::yield();
+	}
+	if (isStale) {
+		cout << "  Reused slot kept the value of a destroyed instance." << endl;
+		isOk = false;
+	}
+
+	// exiting threads free their values too
+	phase = 2;
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	if (Counted::liveCount != baseline) {
+		cout << "  Thread values leaked after thread exit." << endl;
+		isOk = false;
+	}
+	instances.reset();
+	return isOk;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestMultiInstanceTLSBenchmark::Run() {
+	bool isOk = ReclamationTest();
+	cout << "Reclamation: " << (isOk ? "OK." : "FAILED.") << endl << endl;
+
+	constexpr long long AccessesPerThread = 50'000'000;
+	cout << "Access latency (ns per access):" << endl;
+	cout << std::setw(8) << "threads" << std::setw(11) << "instances"
+		<< std::setw(14) << "thread_local" << std::setw(10) << "legacy" << std::setw(10) << "mi_tls" << endl;
+	for (int numThreads : { 1, 4 }) {
+		for (int numInstances : { 1, 16, 256 }) {
+			double plain = MeasureThreadLocal(numThreads, AccessesPerThread);
+			double legacy = MeasureAccess<LegacyMultiInstanceTLS<long long>>(numThreads, numInstances, AccessesPerThread);
+			double current = MeasureAccess<inl::mi_tls<long long>>(numThreads, numInstances, AccessesPerThread);
+			cout << std::fixed << std::setprecision(2)
+				<< std::setw(8) << numThreads << std::setw(11) << numInstances
+				<< std::setw(14) << plain << std::setw(10) << legacy << std::setw(10) << current << endl;
+		}
+	}
+
+	return isOk ? 0 : -1;
+}
@@ -0,0 +1,283 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/Memory/ObjectPool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+using std::cout;
+using std::endl;
+using inl::ObjectPool;
+using inl::ObjectPoolHandle;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestObjectPool : public AutoRegisterTest<TestObjectPool> {
+public:
+	TestObjectPool() {}
+
+	static std::string Name() {
+		return "Object pool";
+	}
+	virtual int Run() override;
+private:
+	static bool TestCorrectness();
+	static void BenchmarkChurn();
+	static void BenchmarkIteration();
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double Milliseconds(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+
+// About the size of a scene entity: a transform and a couple of pointers.
+struct Entity {
+	Entity() = default;
+	Entity(float value) { for (auto& v : transform) { v = value; } }
+	float transform[16] = {};
+	void* mesh = nullptr;
+	void* material = nullptr;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestObjectPool::Run() {
+	if (!TestCorrectness()) {
+		return -1;
+	}
+	BenchmarkChurn();
+	BenchmarkIteration();
+	return 0;
+}
+
+
+bool TestObjectPool::TestCorrectness() {
+	// handles, generations and destruction
+	{
+		auto tracker = std::make_shared<int>(0);
+		ObjectPool<std::shared_ptr<int>> pool(16);
+
+		std::vector<ObjectPoolHandle> handles;
+		for (int i = 0; i < 100; ++i) {
+			handles.push_back(pool.Create(tracker));
+		}
+		if (pool.Count() != 100 || pool.Capacity() != 112 || tracker.use_count() != 101) {
+			cout << "Wrong count after create." << endl;
+			return false;
+		}
+
+		ObjectPoolHandle stale = handles[10];
+		std::shared_ptr<int>* address = pool.Get(stale);
+		pool.Destroy(stale);
+		if (pool.Get(stale) != nullptr || pool.IsValid(stale) || tracker.use_count() != 100) {
+			cout << "Destroyed object still accessible." << endl;
+			return false;
+		}
+
+		// the slot is reused, but the old handle must stay invalid
+		ObjectPoolHandle reused = pool.Create(tracker);
+		if (pool.Get(reused) != address || reused.GetIndex() != stale.GetIndex() || pool.IsValid(stale)) {
+			cout << "Slot reuse does not bump generation." << endl;
+			return false;
+		}
+
+		bool isThrown = false;
+		try {
+			pool.Destroy(stale);
+		}
+		catch (inl::InvalidArgumentException&) {
+			isThrown = true;
+		}
+		if (!isThrown || pool.IsValid(ObjectPoolHandle())) {
+			cout << "Stale or default handle accepted." << endl;
+			return false;
+		}
+
+		// iteration visits each live object once
+		size_t visited = 0;
+		for (auto it = pool.begin(); it != pool.end(); ++it) {
+			if (pool.Get(it.GetHandle()) != &*it) {
+				cout << "Iterator handle mismatch." << endl;
+				return false;
+			}
+			++visited;
+		}
+		if (visited != pool.Count()) {
+			cout << "Iteration skipped objects." << endl;
+			return false;
+		}
+
+		pool.Clear();
+		if (pool.Count() != 0 || tracker.use_count() != 1 || pool.IsValid(reused)) {
+			cout << "Clear did not destroy objects." << endl;
+			return false;
+		}
+	}
+
+	// random create/destroy against a reference
+	{
+		ObjectPool<int> pool(64);
+		std::vector<std::pair<ObjectPoolHandle, int>> live;
+		std::mt19937 rne(42);
+		for (int i = 0; i < 200000; ++i) {
+			if (live.empty() || rne() % 3 != 0) {
+				live.push_back({ pool.Create(i), i });
+			}
+			else {
+				size_t victim = rne() % live.size();
+				pool.Destroy(live[victim].first);
+				live[victim] = live.back();
+				live.pop_back();
+			}
+		}
+		if (pool.Count() != live.size()) {
+			cout << "Random: count mismatch." << endl;
+			return false;
+		}
+		for (auto& entry : live) {
+			const int* value = pool.Get(entry.first);
+			if (!value || *value != entry.second) {
+				cout << "Random: wrong object behind handle." << endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void TestObjectPool::BenchmarkChurn() {
+	constexpr size_t NumLive = 10000;
+	constexpr size_t NumOperations = 2'000'000;
+
+	cout << "Create/destroy churn, " << NumLive << " live entities, " << NumOperations << " replacements:" << endl;
+
+	// new/delete, like the factories do today
+	{
+		std::vector<Entity*> entities;
+		for (size_t i = 0; i < NumLive; ++i) {
+			entities.push_back(new Entity(1.0f));
+		}
+		std::mt19937 rne(1);
+		auto start = Clock::now();
+		for (size_t i = 0; i < NumOperations; ++i) {
+			size_t victim = rne() % NumLive;
+			delete entities[victim];
+			entities[victim] = new Entity(float(i));
+		}
+		auto end = Clock::now();
+		cout << "    new/delete:   " << std::fixed << std::setprecision(2) << Milliseconds(start, end) << " ms" << endl;
+		for (auto entity : entities) {
+			delete entity;
+		}
+	}
+
+	{
+		ObjectPool<Entity> pool;
+		std::vector<ObjectPoolHandle> entities;
+		for (size_t i = 0; i < NumLive; ++i) {
+			entities.push_back(pool.Create(1.0f));
+		}
+		std::mt19937 rne(1);
+		auto start = Clock::now();
+		for (size_t i = 0; i < NumOperations; ++i) {
+			size_t victim = rne() % NumLive;
+			pool.Destroy(entities[victim]);
+			entities[victim] = pool.Create(float(i));
+		}
+		auto end = Clock::now();
+		cout << "    ObjectPool:   " << std::fixed << std::setprecision(2) << Milliseconds(start, end) << " ms" << endl;
+	}
+	cout << endl;
+}
+
+
+void TestObjectPool::BenchmarkIteration() {
+	constexpr size_t NumEntities = 1'000'000;
+	constexpr int NumPasses = 10;
+
+	cout << "Iterating " << NumEntities << " entities " << NumPasses << " times:" << endl;
+
+	// Allocate entities interleaved with other garbage, as it happens in a real scene,
+	// then free a third of them at random.
+	std::vector<Entity*> heapEntities;
+	std::vector<std::unique_ptr<char[]>> garbage;
+	ObjectPool<Entity> pool;
+	std::vector<ObjectPoolHandle> handles;
+	for (size_t i = 0; i < NumEntities * 3 / 2; ++i) {
+		heapEntities.push_back(new Entity(1.0f));
+		handles.push_back(pool.Create(1.0f));
+		garbage.push_back(std::make_unique<char[]>(48 + i % 64));
+	}
+	std::mt19937 rne(2);
+	for (size_t i = 0; i < NumEntities / 2; ++i) {
+		size_t victim = rne() % heapEntities.size();
+		delete heapEntities[victim];
+		heapEntities[victim] = heapEntities.back();
+		heapEntities.pop_back();
+		pool.Destroy(handles[victim]);
+		handles[victim] = handles.back();
+		handles.pop_back();
+	}
+	std::set<Entity*> entitySet(heapEntities.begin(), heapEntities.end());
+
+	auto Consume = [](const Entity& entity) {
+		return entity.transform[0] + entity.transform[15];
+	};
+
+	float sum = 0;
+	auto start = Clock::now();
+	for (int pass = 0; pass < NumPasses; ++pass) {
+		for (Entity* entity : entitySet) {
+			sum += Consume(*entity);
+		}
+	}
+	auto end = Clock::now();
+	cout << "    std::set<Entity*>:    " << std::fixed << std::setprecision(2) << Milliseconds(start, end) << " ms" << endl;
+
+	start = Clock::now();
+	for (int pass = 0; pass < NumPasses; ++pass) {
+		for (Entity* entity : heapEntities) {
+			sum += Consume(*entity);
+		}
+	}
+	end = Clock::now();
+	cout << "    std::vector<Entity*>: " << std::fixed << std::setprecision(2) << Milliseconds(start, end) << " ms" << endl;
+
+	start = Clock::now();
+	for (int pass = 0; pass < NumPasses; ++pass) {
+		for (const Entity& entity : pool) {
+			sum += Consume(entity);
+		}
+	}
+	end = Clock::now();
+	cout << "    ObjectPool:           " << std::fixed << std::setprecision(2) << Milliseconds(start, end) << " ms" << endl;
+	cout << "    (checksum " << sum << ")" << endl << endl;
+
+	for (auto entity : heapEntities) {
+		delete entity;
+	}
+}
@@ -5,8 +5,11 @@
 #include <GraphicsEngine_LL/GraphicsNode.hpp>
 #include <BaseLibrary/Graph_All.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <set>
 #include <GraphicsEngine_LL/Scheduler.hpp>
 
 using namespace std;
@@ -87,6 +90,53 @@ private:
 };
 
 
+// Counts how many times nodes had to be initialized.
+class CountingNode :
+	virtual public GraphicsNode,
+	public GraphicsTask,
+	public InputPortConfig<int>,
+	public OutputPortConfig<int>
+{
+public:
+	static const char* Info_GetName() { return "CountingNode"; }
+	void Update() override {}
+	void Notify(InputPortBase*) override {}
+	void Initialize(EngineContext& context) override { ++numInitializations; SetTaskSingle(this); }
+	void Reset() override {}
+	void Setup(SetupContext& context) override {}
+	void Execute(RenderContext& context) override {}
+
+	static int numInitializations;
+};
+
+int CountingNode::numInitializations = 0;
+
+
+// Has two parallel tasks, so the pipeline has to add a common source and sink.
+class ParallelNode :
+	virtual public GraphicsNode,
+	public InputPortConfig<int>,
+	public OutputPortConfig<int>
+{
+public:
+	static const char* Info_GetName() { return "ParallelNode"; }
+	void Update() override {}
+	void Notify(InputPortBase*) override {}
+	void Initialize(EngineContext& context) override {
+		GraphicsTask* tasks[] = { &m_tasks[0], &m_tasks[1] };
+		SetTaskParallel(std::begin(tasks), std::end(tasks));
+	}
+	void Reset() override {}
+private:
+	class EmptyTask : public GraphicsTask {
+	public:
+		void Setup(SetupContext& context) override {}
+		void Execute(RenderContext& context) override {}
+	};
+	EmptyTask m_tasks[2];
+};
+
+
 //------------------------------------------------------------------------------
 // Helpers
 //------------------------------------------------------------------------------
@@ -116,6 +166,8 @@ public:
 	}
 	virtual int Run() override;
 private:
+	static bool TestUpdate();
+	static bool TestOptimize();
 	static int a;
 };
 
@@ -222,5 +274,266 @@ int TestPipeline::Run() {
 		cout << "Failed to create pipeline: " << ex.what() << endl;
 	}
 	*/
+
+	if (!TestUpdate()) {
+		return -1;
+	}
+	if (!TestOptimize()) {
+		return -1;
+	}
+
 	return 0;
-}
\ No newline at end of file
+}
+
+
+// Node names linked to each other, and the shape of the task graph.
+static std::set<std::pair<std::string, std::string>> GetDependencies(const Pipeline& pipeline) {
+	std::set<std::pair<std::string, std::string>> dependencies;
+	auto& graph = pipeline.GetDependencyGraph();
+	for (lemon::ListDigraph::ArcIt arc(graph); arc != lemon::INVALID; ++arc) {
+		dependencies.insert({ pipeline.GetNodeMap()[graph.source(arc)]->GetDisplayName(), pipeline.GetNodeMap()[graph.target(arc)]->GetDisplayName() });
+	}
+	return dependencies;
+}
+
+static bool IsSameGraph(const Pipeline& lhs, const Pipeline& rhs) {
+	return GetDependencies(lhs) == GetDependencies(rhs)
+		&& lemon::countNodes(lhs.GetTaskGraph()) == lemon::countNodes(rhs.GetTaskGraph())
+		&& lemon::countArcs(lhs.GetTaskGraph()) == lemon::countArcs(rhs.GetTaskGraph())
+		&& lemon::dag(lhs.GetTaskGraph());
+}
+
+static std::map<std::string, NodeBase*> GetNodes(Pipeline& pipeline) {
+	std::map<std::string, NodeBase*> nodes;
+	for (auto& node : pipeline) {
+		nodes[node.GetDisplayName()] = &node;
+	}
+	return nodes;
+}
+
+
+bool TestPipeline::TestUpdate() {
+	GraphicsNodeFactory factory;
+	factory.RegisterNodeClass<CountingNode>("Test");
+	factory.RegisterNodeClass<ParallelNode>("Test");
+	factory.RegisterNodeClass<TestNode>("Test");
+
+	const std::string original = R"({
+		"nodes": [
+			{ "name": "a", "class": "Test/CountingNode" },
+			{ "name": "b", "class": "Test/ParallelNode" },
+			{ "name": "c", "class": "Test/CountingNode", "inputs": [ 5 ] },
+			{ "name": "d", "class": "Test/TestNode" },
+			{ "name": "x", "class": "Test/CountingNode" }
+		],
+		"links": [
+			{ "src": "a", "srcp": 0, "dst": "b", "dstp": 0 },
+			{ "src": "b", "srcp": 0, "dst": "d", "dstp": 0 },
+			{ "src": "c", "srcp": 0, "dst": "d", "dstp": 1 },
+			{ "src": "x", "srcp": 0, "dst": "c", "dstp": 0 }
+		]
+	})";
+	// c gets a new default input instead of x's output, x is replaced by y, d reads from y instead of c
+	const std::string changed = R"({
+		"nodes": [
+			{ "name": "a", "class": "Test/CountingNode" },
+			{ "name": "b", "class": "Test/ParallelNode" },
+			{ "name": "c", "class": "Test/CountingNode", "inputs": [ 7 ] },
+			{ "name": "d", "class": "Test/TestNode" },
+			{ "name": "y", "class": "Test/CountingNode" }
+		],
+		"links": [
+			{ "src": "a", "srcp": 0, "dst": "b", "dstp": 0 },
+			{ "src": "b", "srcp": 0, "dst": "d", "dstp": 0 },
+			{ "src": "c", "srcp": 0, "dst": "y", "dstp": 0 },
+			{ "src": "y", "srcp": 0, "dst": "d", "dstp": 1 }
+		]
+	})";
+
+	Pipeline pipeline;
+	pipeline.CreateFromDescription(original, factory);
+	auto before = GetNodes(pipeline);
+
+	int numInitializations = CountingNode::numInitializations;
+	Pipeline::UpdateStatistics statistics = pipeline.UpdateFromDescription(changed, factory);
+	auto after = GetNodes(pipeline);
+
+	if (statistics.keptNodes != 4 || statistics.createdNodes != 1 || statistics.removedNodes != 1 || statistics.relinkedNodes != 3) {
+		cout << "Update changed more than necessary: kept " << statistics.keptNodes << ", created " << statistics.createdNodes
+			<< ", removed " << statistics.removedNodes << ", relinked " << statistics.relinkedNodes << "." << endl;
+		return false;
+	}
+	for (auto name : { "a", "b", "c", "d" }) {
+		if (before[name] != after[name]) {
+			cout << "Unchanged node " << name << " was recreated." << endl;
+			return false;
+		}
+	}
+	if (after.count("x") > 0 || after.count("y") == 0 || CountingNode::numInitializations != numInitializations + 1) {
+		cout << "Only the new node should have been initialized." << endl;
+		return false;
+	}
+	auto c = dynamic_cast<CountingNode*>(after["c"]);
+	if (c->GetInput<0>().GetLink() != nullptr || c->GetInput<0>().Get() != 7) {
+		cout << "Default input of a kept node was not updated." << endl;
+		return false;
+	}
+
+	Pipeline reference;
+	reference.CreateFromDescription(changed, factory);
+	if (!IsSameGraph(pipeline, reference)) {
+		cout << "Updated graphs differ from ones built from scratch." << endl;
+		return false;
+	}
+
+	// A moved pipeline must still know which tasks belong to which node.
+	Pipeline moved = std::move(pipeline);
+	auto& taskGraph = moved.GetTaskGraph();
+	for (lemon::ListDigraph::NodeIt task(taskGraph); task != lemon::INVALID; ++task) {
+		lemon::ListDigraph::Node parent = moved.GetTaskParentMap()[task];
+		GraphicsTask* function = moved.GetTaskFunctionMap()[task];
+		if (parent != lemon::INVALID) {
+			if (auto node = dynamic_cast<CountingNode*>(moved.GetNodeMap()[parent].get()); node && node != function) {
+				cout << "Task parents are mixed up after moving the pipeline." << endl;
+				return false;
+			}
+		}
+	}
+	moved.UpdateFromDescription(original, factory);
+	Pipeline originalReference;
+	originalReference.CreateFromDescription(original, factory);
+	if (!IsSameGraph(moved, originalReference)) {
+		cout << "Update after moving the pipeline went wrong." << endl;
+		return false;
+	}
+
+	// Invalid descriptions leave the pipeline as it was.
+	const std::string circular = R"({
+		"nodes": [
+			{ "name": "a", "class": "Test/CountingNode" },
+			{ "name": "z", "class": "Test/CountingNode" }
+		],
+		"links": [
+			{ "src": "a", "srcp": 0, "dst": "z", "dstp": 0 },
+			{ "src": "z", "srcp": 0, "dst": "a", "dstp": 0 }
+		]
+	})";
+	try {
+		moved.UpdateFromDescription(circular, factory);
+		cout << "Circular pipeline was accepted." << endl;
+		return false;
+	}
+	catch (InvalidArgumentException&) {
+		// expected
+	}
+	if (!IsSameGraph(moved, originalReference)) {
+		cout << "Failed update changed the pipeline." << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool TestPipeline::TestOptimize() {
+	GraphicsNodeFactory factory;
+	factory.RegisterNodeClass<CountingNode>("Test");
+	factory.RegisterNodeClass<ParallelNode>("Test");
+	factory.RegisterNodeClass<TestNode>("Test");
+
+	// out <- b <- (env, sum <- (one, two)) are live, env is a constant graphics node, the rest plain nodes.
+	// a -> dead don't reach out.
+	const std::string description = R"({
+		"nodes": [
+			{ "name": "one", "class": "Test/TestNode", "inputs": [ 1, 0 ] },
+			{ "name": "two", "class": "Test/TestNode", "inputs": [ 2, 0 ] },
+			{ "name": "sum", "class": "Test/TestNode" },
+			{ "name": "env", "class": "Test/CountingNode" },
+			{ "name": "b", "class": "Test/TestNode" },
+			{ "name": "out", "class": "Test/CountingNode" },
+			{ "name": "a", "class": "Test/CountingNode" },
+			{ "name": "dead", "class": "Test/ParallelNode" }
+		],
+		"links": [
+			{ "src": "one", "srcp": 0, "dst": "sum", "dstp": 0 },
+			{ "src": "two", "srcp": 0, "dst": "sum", "dstp": 1 },
+			{ "src": "env", "srcp": 0, "dst": "b", "dstp": 0 },
+			{ "src": "sum", "srcp": 0, "dst": "b", "dstp": 1 },
+			{ "src": "b", "srcp": 0, "dst": "out", "dstp": 0 },
+			{ "src": "a", "srcp": 0, "dst": "dead", "dstp": 0 }
+		]
+	})";
+	auto isOut = [](const NodeBase& node) { return node.GetDisplayName() == "out"; };
+	auto isEnv = [](const NodeBase& node) { return node.GetDisplayName() == "env"; };
+
+	auto CountActiveTasks = [](const Pipeline& pipeline) {
+		size_t count = 0;
+		for (lemon::ListDigraph::NodeIt taskNode(pipeline.GetTaskGraph()); taskNode != lemon::INVALID; ++taskNode) {
+			count += pipeline.GetActiveTaskMap()[taskNode] ? 1 : 0;
+		}
+		return count;
+	};
+	auto GetFoldedNames = [](const Pipeline& pipeline) {
+		std::map<const GraphicsTask*, std::string> owners;
+		for (lemon::ListDigraph::NodeIt taskNode(pipeline.GetTaskGraph()); taskNode != lemon::INVALID; ++taskNode) {
+			lemon::ListDigraph::Node parent = pipeline.GetTaskParentMap()[taskNode];
+			if (parent != lemon::INVALID) {
+				owners[pipeline.GetTaskFunctionMap()[taskNode]] = pipeline.GetNodeMap()[parent]->GetDisplayName();
+			}
+		}
+		std::vector<std::string> names;
+		for (auto task : pipeline.GetFoldedTasks()) {
+			names.push_back(owners[task]);
+		}
+		return names;
+	};
+
+	Pipeline pipeline;
+	pipeline.CreateFromDescription(description, factory);
+	size_t numTasks = lemon::countNodes(pipeline.GetTaskGraph());
+	if (CountActiveTasks(pipeline) != numTasks || !pipeline.GetFoldedTasks().empty()) {
+		cout << "Pipeline is optimized without asking." << endl;
+		return false;
+	}
+
+	Pipeline::OptimizeStatistics statistics = pipeline.Optimize(isOut, isEnv);
+	if (statistics.prunedNodes != 2 || statistics.foldedNodes != 5 || statistics.activeTasks != 1 || CountActiveTasks(pipeline) != 1) {
+		cout << "Optimize pruned " << statistics.prunedNodes << " and folded " << statistics.foldedNodes << " nodes, "
+			<< statistics.activeTasks << " tasks remain." << endl;
+		return false;
+	}
+
+	// Folded tasks come in dependency order.
+	std::vector<std::string> folded = GetFoldedNames(pipeline);
+	auto Position = [&folded](const std::string& name) { return std::find(folded.begin(), folded.end(), name) - folded.begin(); };
+	if (folded.size() != 5 || Position("sum") < Position("one") || Position("sum") < Position("two")
+		|| Position("b") < Position("sum") || Position("b") < Position("env"))
+	{
+		cout << "Folded tasks are out of order." << endl;
+		return false;
+	}
+
+	// The optimization moves with the pipeline.
+	Pipeline moved = std::move(pipeline);
+	if (CountActiveTasks(moved) != 1 || GetFoldedNames(moved) != folded) {
+		cout << "Optimization lost when moving the pipeline." << endl;
+		return false;
+	}
+
+	// Without outputs nothing is pruned.
+	statistics = moved.Optimize([](const NodeBase&) { return false; }, isEnv);
+	if (statistics.prunedNodes != 0 || statistics.foldedNodes != 5 || statistics.activeTasks != numTasks - 5) {
+		cout << "Nodes pruned without outputs." << endl;
+		return false;
+	}
+
+	// Changing the pipeline undoes the optimization.
+	moved.Optimize(isOut, isEnv);
+	moved.UpdateFromDescription(description, factory);
+	if (CountActiveTasks(moved) != numTasks || !moved.GetFoldedTasks().empty()) {
+		cout << "Optimization kept after update." << endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,173 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/Profiler.hpp>
+
+#include <rapidjson/document.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+using std::cout;
+using std::endl;
+using inl::Profiler;
+using inl::ProfileScope;
+using inl::ProfileEvent;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestProfiler : public AutoRegisterTest<TestProfiler> {
+public:
+	TestProfiler() {}
+
+	static std::string Name() {
+		return "Profiler";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestProfiler::Run() {
+	Profiler& profiler = Profiler::GetInstance();
+	// other code in the process may have recorded, start from a clean slate
+	profiler.SetEnabled(false);
+	profiler.Collect();
+
+	// nothing is recorded while disabled
+	{
+		ProfileScope scope("Test", "Disabled");
+	}
+	if (!profiler.Collect().empty()) {
+		cout << "Recorded while disabled." << endl;
+		return -1;
+	}
+
+	// nested scopes and events of exited threads
+	const char* nodeName = profiler.Intern("Node \"A\"");
+	if (nodeName != profiler.Intern(std::string("Node \"A\""))) {
+		cout << "Interned strings differ." << endl;
+		return -1;
+	}
+	{
+		profiler.SetEnabled(true);
+		uint64_t droppedBefore = profiler.GetNumDroppedEvents();
+
+		constexpr int NumThreads = 4;
+		constexpr int NumEvents = 1000;
+		{
+			ProfileScope outer("Test", "Outer");
+			ProfileScope inner("Test", "Inner", nodeName);
+		}
+		std::vector<std::thread> threads;
+		for (int t = 0; t < NumThreads; ++t) {
+			threads.emplace_back([] {
+				for (int i = 0; i < NumEvents; ++i) {
+					ProfileScope scope("Test", "Worker");
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		profiler.SetEnabled(false);
+
+		std::vector<ProfileEvent> events = profiler.Collect();
+		const ProfileEvent* outer = nullptr;
+		const ProfileEvent* inner = nullptr;
+		int numWorkerEvents = 0;
+		for (auto& event : events) {
+			outer = std::strcmp(event.name, "Outer") == 0 ? &event : outer;
+			inner = std::strcmp(event.name, "Inner") == 0 ? &event : inner;
+			numWorkerEvents += std::strcmp(event.name, "Worker") == 0;
+		}
+		if (!outer || !inner || inner->begin < outer->begin || inner->end > outer->end || inner->detail != nodeName || inner->thread != outer->thread) {
+			cout << "Nested scopes not recorded properly." << endl;
+			return -1;
+		}
+		if (numWorkerEvents != NumThreads * NumEvents || profiler.GetNumDroppedEvents() != droppedBefore) {
+			cout << "Expected " << NumThreads * NumEvents << " events of exited threads, got " << numWorkerEvents << "." << endl;
+			return -1;
+		}
+	}
+
+	// full rings drop events instead of blocking
+	{
+		profiler.SetEnabled(true);
+		uint64_t droppedBefore = profiler.GetNumDroppedEvents();
+		for (size_t i = 0; i < Profiler::ThreadCapacity + 10; ++i) {
+			ProfileScope scope("Test", "Overflow");
+		}
+		profiler.SetEnabled(false);
+		size_t numCollected = profiler.Collect().size();
+		if (numCollected != Profiler::ThreadCapacity || profiler.GetNumDroppedEvents() - droppedBefore != 10) {
+			cout << "Overflowing events not dropped." << endl;
+			return -1;
+		}
+	}
+
+	// chrome trace
+	{
+		profiler.SetEnabled(true);
+		{
+			ProfileScope scope("Task", "Execute", nodeName);
+		}
+		profiler.SetEnabled(false);
+
+		std::stringstream trace;
+		profiler.WriteChromeTrace(trace);
+		rapidjson::Document document;
+		document.Parse(trace.str().c_str());
+		if (document.HasParseError() || !document.HasMember("traceEvents") || document["traceEvents"].Size() != 1) {
+			cout << "Trace is not valid JSON." << endl;
+			return -1;
+		}
+		auto& event = document["traceEvents"][0];
+		if (std::string(event["name"].GetString()) != "Execute"
+			|| std::string(event["ph"].GetString()) != "X"
+			|| std::string(event["args"]["node"].GetString()) != nodeName
+			|| event["dur"].GetDouble() < 0)
+		{
+			cout << "Trace event is wrong." << endl;
+			return -1;
+		}
+	}
+
+	// overhead
+	{
+		constexpr int NumScopes = 10'000'000;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < NumScopes; ++i) {
+			ProfileScope scope("Test", "Overhead");
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(end - start).count() / NumScopes;
+		cout << "Disabled scope overhead: " << std::fixed << std::setprecision(2) << ns << " ns" << endl;
+
+		profiler.SetEnabled(true);
+		constexpr int NumEnabledScopes = int(Profiler::ThreadCapacity);
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < NumEnabledScopes; ++i) {
+			ProfileScope scope("Test", "Overhead");
+		}
+		end = std::chrono::high_resolution_clock::now();
+		profiler.SetEnabled(false);
+		profiler.Collect();
+		ns = std::chrono::duration<double, std::nano>(end - start).count() / NumEnabledScopes;
+		cout << "Enabled scope overhead: " << std::fixed << std::setprecision(2) << ns << " ns" << endl;
+	}
+
+	return 0;
+}
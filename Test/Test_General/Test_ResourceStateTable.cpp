@@ -0,0 +1,249 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/ResourceStateTable.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestResourceStateTable : public AutoRegisterTest<TestResourceStateTable> {
+public:
+	TestResourceStateTable() {}
+
+	static std::string Name() {
+		return "Resource state table";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// Only the addresses of the resources matter, they are never dereferenced.
+static const gxapi::IResource* FakeResource(const std::vector<char>& storage, size_t index) {
+	return reinterpret_cast<const gxapi::IResource*>(storage.data() + index * 64);
+}
+
+
+// A recorded frame: each draw sets the state of a few subresources.
+struct StateCall {
+	size_t resource;
+	unsigned subresource;
+	gxapi::eResourceState state;
+};
+
+
+static std::vector<StateCall> RecordFrame(size_t numResources, size_t numDraws, size_t callsPerDraw) {
+	std::mt19937 rne(42);
+	const gxapi::eResourceState states[] = {
+		gxapi::eResourceState::PIXEL_SHADER_RESOURCE,
+		gxapi::eResourceState::VERTEX_AND_CONSTANT_BUFFER,
+		gxapi::eResourceState::INDEX_BUFFER,
+		gxapi::eResourceState::RENDER_TARGET,
+	};
+	std::vector<StateCall> calls;
+	calls.reserve(numDraws * callsPerDraw);
+	for (size_t draw = 0; draw < numDraws; ++draw) {
+		for (size_t call = 0; call < callsPerDraw; ++call) {
+			size_t resource = rne() % numResources;
+			unsigned subresource = resource % 8 == 0 ? rne() % 6 : 0; // every eighth is a mip chain
+			calls.push_back({ resource, subresource, states[rne() % 16 == 0 ? rne() % 4 : resource % 3] });
+		}
+	}
+	return calls;
+}
+
+
+// What the command lists did before: the key holds a counted reference to the resource.
+struct SharedSubresourceId {
+	std::shared_ptr<int> resource;
+	unsigned subresource;
+	bool operator==(const SharedSubresourceId& other) const {
+		return resource == other.resource && subresource == other.subresource;
+	}
+};
+
+struct SharedSubresourceIdHash {
+	size_t operator()(const SharedSubresourceId& id) const {
+		return std::hash<const void*>{}(id.resource.get()) ^ std::hash<unsigned>{}(id.subresource);
+	}
+};
+
+struct SharedUsage {
+	std::shared_ptr<int> resource;
+	unsigned subresource;
+	SubresourceUsageInfo usage;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestResourceStateTable::Run() {
+	constexpr size_t NumResources = 2000;
+	std::vector<char> storage(NumResources * 64);
+
+	// random inserts against a sorted map
+	{
+		std::mt19937 rne(1337);
+		ResourceStateTable table;
+		std::map<std::pair<const gxapi::IResource*, unsigned>, gxapi::eResourceState> reference;
+		std::vector<const gxapi::IResource*> owners;
+		for (int i = 0; i < 20000; ++i) {
+			const gxapi::IResource* resource = FakeResource(storage, rne() % NumResources);
+			unsigned subresource = rne() % 4;
+			auto state = gxapi::eResourceState(1u << (rne() % 8));
+
+			SubresourceUsageInfo* usage = table.Find(resource, subresource);
+			auto it = reference.find({ resource, subresource });
+			if ((usage == nullptr) != (it == reference.end())) {
+				cout << "Find disagrees with the reference." << endl;
+				return -1;
+			}
+			if (usage) {
+				usage->lastState = state;
+				it->second = state;
+			}
+			else {
+				bool isNewResource;
+				table.Insert(resource, subresource, { state, state, false }, isNewResource);
+				reference.insert({ { resource, subresource }, state });
+				if (isNewResource != (std::find(owners.begin(), owners.end(), resource) == owners.end())) {
+					cout << "Resource is reported new wrongly." << endl;
+					return -1;
+				}
+				if (isNewResource) {
+					owners.push_back(resource);
+				}
+			}
+		}
+
+		auto entries = table.GetSortedEntries();
+		if (entries.size() != reference.size() || table.Count() != reference.size() || table.GetNumResources() != owners.size()) {
+			cout << "Table has " << entries.size() << " subresources, expected " << reference.size() << "." << endl;
+			return -1;
+		}
+		auto it = reference.begin();
+		for (auto& entry : entries) {
+			if (entry.resource != it->first.first || entry.subresource != it->first.second
+				|| entry.usage.lastState != it->second || owners[entry.owner] != entry.resource)
+			{
+				cout << "Entries are not sorted or are wrong." << endl;
+				return -1;
+			}
+			++it;
+		}
+
+		table.Clear();
+		if (table.Count() != 0 || table.Find(owners[0], 0) != nullptr) {
+			cout << "Table is not empty after clearing." << endl;
+			return -1;
+		}
+	}
+
+	// benchmark: tracking the states of a 10k draw frame and decomposing it
+	{
+		constexpr size_t NumDraws = 10000;
+		constexpr size_t CallsPerDraw = 10;
+		constexpr int NumFrames = 10;
+		std::vector<StateCall> frameCalls = RecordFrame(NumResources, NumDraws, CallsPerDraw);
+		std::vector<std::shared_ptr<int>> resources; // stand-ins for the MemoryObjects
+		for (size_t i = 0; i < NumResources; ++i) {
+			resources.push_back(std::make_shared<int>(int(i)));
+		}
+		// Sorting by address like the scheduler does, the shared pointers are ordered by their control blocks.
+		auto AddressOf = [&](const std::shared_ptr<int>& resource) { return FakeResource(storage, size_t(*resource)); };
+
+		size_t checksum = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < NumFrames; ++frame) {
+			std::unordered_map<SharedSubresourceId, SubresourceUsageInfo, SharedSubresourceIdHash> transitions;
+			for (auto& call : frameCalls) {
+				SharedSubresourceId id{ resources[call.resource], call.subresource };
+				auto it = transitions.find(id);
+				if (it == transitions.end()) {
+					transitions.insert({ std::move(id), { call.state, call.state, false } });
+				}
+				else if (it->second.lastState != call.state) {
+					it->second.lastState = call.state;
+					it->second.multipleStates = true;
+				}
+			}
+			std::vector<SharedUsage> used;
+			used.reserve(transitions.size());
+			for (auto& v : transitions) {
+				used.push_back({ v.first.resource, v.first.subresource, v.second });
+			}
+			std::sort(used.begin(), used.end(), [&](const SharedUsage& lhs, const SharedUsage& rhs) {
+				return AddressOf(lhs.resource) < AddressOf(rhs.resource) || (lhs.resource == rhs.resource && lhs.subresource < rhs.subresource);
+			});
+			checksum += used.size();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double unorderedMap = std::chrono::duration<double, std::milli>(end - start).count() / NumFrames;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < NumFrames; ++frame) {
+			ResourceStateTable transitions;
+			std::vector<std::shared_ptr<int>> tracked;
+			for (auto& call : frameCalls) {
+				const gxapi::IResource* resource = FakeResource(storage, call.resource);
+				SubresourceUsageInfo* usage = transitions.Find(resource, call.subresource);
+				if (usage == nullptr) {
+					bool isNewResource;
+					transitions.Insert(resource, call.subresource, { call.state, call.state, false }, isNewResource);
+					if (isNewResource) {
+						tracked.push_back(resources[call.resource]);
+					}
+				}
+				else if (usage->lastState != call.state) {
+					usage->lastState = call.state;
+					usage->multipleStates = true;
+				}
+			}
+			std::vector<SharedUsage> used;
+			used.reserve(transitions.Count());
+			auto entries = transitions.GetSortedEntries();
+			for (size_t i = 0; i < entries.size(); ++i) {
+				bool isLastOfResource = i + 1 == entries.size() || entries[i + 1].resource != entries[i].resource;
+				auto& owner = tracked[entries[i].owner];
+				used.push_back({ isLastOfResource ? std::move(owner) : owner, entries[i].subresource, entries[i].usage });
+			}
+			checksum -= used.size();
+		}
+		end = std::chrono::high_resolution_clock::now();
+		double flatTable = std::chrono::duration<double, std::milli>(end - start).count() / NumFrames;
+
+		if (checksum != 0) {
+			cout << "The two trackers found a different number of subresources." << endl;
+			return -1;
+		}
+		cout << "Tracking " << NumDraws << " draws x " << CallsPerDraw << " states (ms per frame):" << endl;
+		cout << "    unordered_map + sort:  " << std::fixed << std::setprecision(3) << unorderedMap << endl;
+		cout << "    flat table:            " << std::fixed << std::setprecision(3) << flatTable << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,207 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/Memory/RingArena.hpp>
+#include <BaseLibrary/Memory/RingAllocationEngine.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestRingArena : public AutoRegisterTest<TestRingArena> {
+public:
+	TestRingArena() {}
+
+	static std::string Name() {
+		return "Allocator - Ring Arena";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// Simulated frames: every frame allocates a bunch of transient blocks,
+// which are released when the frame FramesInFlight frames earlier completes.
+static constexpr int NumFrames = 3000;
+static constexpr int AllocsPerFrame = 300;
+static constexpr int FramesInFlight = 3;
+static constexpr size_t MaxAllocSize = 1024;
+
+
+struct FrameWorkload {
+	std::vector<size_t> sizes; // NumFrames * AllocsPerFrame
+	std::vector<size_t> alignments;
+};
+
+
+static FrameWorkload MakeWorkload() {
+	FrameWorkload workload;
+	std::mt19937 rne(42);
+	for (int i = 0; i < NumFrames * AllocsPerFrame; ++i) {
+		workload.sizes.push_back(16 + rne() % (MaxAllocSize - 16));
+		workload.alignments.push_back(size_t(4) << (rne() % 5)); // 4 to 64
+	}
+	return workload;
+}
+
+
+static double BenchNewDelete(const FrameWorkload& workload) {
+	std::vector<std::vector<uint8_t*>> frames(FramesInFlight + 1);
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < NumFrames; ++frame) {
+		auto& current = frames[frame % frames.size()];
+		for (auto ptr : current) {
+			delete[] ptr;
+		}
+		current.clear();
+		for (int i = 0; i < AllocsPerFrame; ++i) {
+			uint8_t* ptr = new uint8_t[workload.sizes[frame*AllocsPerFrame + i]];
+			ptr[0] = uint8_t(frame);
+			current.push_back(ptr);
+		}
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	for (auto& frame : frames) {
+		for (auto ptr : frame) {
+			delete[] ptr;
+		}
+	}
+	return std::chrono::duration<double, std::nano>(endTime - startTime).count() / (NumFrames * AllocsPerFrame);
+}
+
+
+static double BenchEngine(const FrameWorkload& workload) {
+	constexpr size_t CellSize = 64;
+	inl::RingAllocationEngine engine(2 * AllocsPerFrame * (FramesInFlight + 1) * (MaxAllocSize / CellSize + 1));
+	std::vector<std::vector<size_t>> frames(FramesInFlight + 1);
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < NumFrames; ++frame) {
+		auto& current = frames[frame % frames.size()];
+		for (auto index : current) {
+			engine.Deallocate(index);
+		}
+		current.clear();
+		for (int i = 0; i < AllocsPerFrame; ++i) {
+			size_t size = workload.sizes[frame*AllocsPerFrame + i];
+			current.push_back(engine.Allocate((size + CellSize - 1) / CellSize));
+		}
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(endTime - startTime).count() / (NumFrames * AllocsPerFrame);
+}
+
+
+static double BenchArena(const FrameWorkload& workload, bool& isOk) {
+	inl::RingArena arena(2 * AllocsPerFrame * (FramesInFlight + 1) * (MaxAllocSize + 64), 64 * 1024);
+	struct Block { uint8_t* ptr; size_t size; };
+	std::vector<std::vector<Block>> frames(FramesInFlight + 1);
+	for (auto& frame : frames) {
+		frame.reserve(AllocsPerFrame);
+	}
+	isOk = true;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < NumFrames; ++frame) {
+		// blocks of the oldest frame still in flight must be intact
+		auto& current = frames[frame % frames.size()];
+		for (auto& block : current) {
+			isOk = isOk && block.ptr[0] == uint8_t(frame - FramesInFlight - 1) && block.ptr[block.size - 1] == uint8_t(frame - FramesInFlight - 1);
+		}
+		current.clear();
+		if (frame > FramesInFlight) {
+			arena.Release(frame - FramesInFlight - 1);
+		}
+
+		for (int i = 0; i < AllocsPerFrame; ++i) {
+			size_t size = workload.sizes[frame*AllocsPerFrame + i];
+			size_t alignment = workload.alignments[frame*AllocsPerFrame + i];
+			uint8_t* ptr = static_cast<uint8_t*>(arena.Allocate(size, alignment));
+			isOk = isOk && reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+			ptr[0] = ptr[size - 1] = uint8_t(frame);
+			current.push_back({ ptr, size });
+		}
+		arena.Fence(frame);
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(endTime - startTime).count() / (NumFrames * AllocsPerFrame);
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestRingArena::Run() {
+	// typed arena sanity check
+	{
+		struct Vec4 { float x, y, z, w; };
+		inl::TypedRingArena<Vec4> arena(1000, 1024);
+		for (uint64_t frame = 0; frame < 100; ++frame) {
+			if (frame >= 3) {
+				arena.Release(frame - 3);
+			}
+			Vec4* vectors = arena.Allocate(200);
+			vectors[199] = { 1, 2, 3, 4 };
+			arena.Fence(frame);
+		}
+		try {
+			arena.Allocate(2000);
+			cout << "Oversized allocation did not fail." << endl;
+			return -1;
+		}
+		catch (std::bad_alloc&) {}
+	}
+
+	// alignments larger than the cells of the ring
+	{
+		inl::RingArena arena(1024 * 1024, 16 * 1024);
+		for (uint64_t frame = 0; frame < 100; ++frame) {
+			if (frame >= 3) {
+				arena.Release(frame - 3);
+			}
+			for (size_t alignment : { 128, 256, 4096 }) {
+				for (size_t i = 0; i < 10; ++i) {
+					size_t size = 40 + i * 100;
+					uint8_t* ptr = static_cast<uint8_t*>(arena.Allocate(size, alignment));
+					if (reinterpret_cast<uintptr_t>(ptr) % alignment != 0) {
+						cout << "Allocation is not aligned to " << alignment << " bytes." << endl;
+						return -1;
+					}
+					std::memset(ptr, int(frame), size);
+				}
+			}
+			arena.Fence(frame);
+		}
+	}
+
+	FrameWorkload workload = MakeWorkload();
+	bool isOk;
+	double newDelete = BenchNewDelete(workload);
+	double engine = BenchEngine(workload);
+	double arena = BenchArena(workload, isOk);
+
+	cout << "Per-frame transient allocations (" << AllocsPerFrame << " per frame, " << FramesInFlight << " frames in flight):" << endl;
+	cout << std::fixed << std::setprecision(2);
+	cout << "  new/delete:           " << std::setw(8) << newDelete << " ns/alloc" << endl;
+	cout << "  RingAllocationEngine: " << std::setw(8) << engine << " ns/alloc (index only, no storage)" << endl;
+	cout << "  RingArena:            " << std::setw(8) << arena << " ns/alloc" << endl;
+	cout << (isOk ? "OK." : "Overlapping or misaligned allocations.") << endl;
+
+	return isOk ? 0 : -1;
+}
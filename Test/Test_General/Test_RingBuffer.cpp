@@ -7,6 +7,9 @@
 #include <chrono>
 #include <functional>
 #include <array>
+#include <list>
+#include <vector>
+#include <random>
 
 using namespace std;
 using namespace inl::prefix;
@@ -14,10 +17,10 @@ using inl::RingBuffer;
 using std::chrono::high_resolution_clock;
 
 template <typename T>
-using container_type = std::list<T>;
+using ListRingBuffer = RingBuffer<T, std::list<T>>;
 
 template <typename T>
-using TestRingBuffer = RingBuffer<T, container_type<T>>;
+using ContiguousRingBuffer = RingBuffer<T>;
 
 static void TestAssertFunc(bool val, const char* expression) {
 	if (!val) {
@@ -36,117 +39,195 @@ chrono::duration<float, chrono::seconds::period> TimedExecution(std::function<vo
 }
 
 
-class Test_RingBuffer : public AutoRegisterTest<Test_RingBuffer> {
-public:
-	static std::string Name() {
-		return "RingBuffer";
-	}
+// Runs the same workload on a ring buffer type, prints timings.
+template <template <typename> class TestRingBuffer>
+static void RunSuite(const char* containerName) {
+	constexpr int count = int(1_mega);
 
-	virtual int Run() override {
+	cout << "Testing RingBuffer with container type: " << containerName << endl << endl;
 
-		try {
-			constexpr int count = int(1_mega);
-
-			string containerName{typeid(container_type<int>).name()};
-			containerName = containerName.substr(0, containerName.find('<'));
-			cout << "Testing RingBuffer with container type: " << containerName << endl << endl;
-
-			////////////////////////////////
-			
-			TestRingBuffer<int> intBuffer;
-			auto duration = TimedExecution(
-				[&intBuffer, count]() {
-					for (int i = 0; i < count; i++) {
-						intBuffer.PushFront(i);
-					}
-				}
-			);
-			cout << "Pushed " << count << " integers in " << duration.count() << " sec" << endl;
-
-			intBuffer.RotateFront();
-			TestAssert(intBuffer.Back() == count-1);
-			TestAssert(intBuffer.Front() == count-2);
-			
-			////////////////////////////////
-
-			TestRingBuffer<std::array<int, 100>> arrayBuffer;
-			std::array<int, 100> testArray;
-
-			//just fill with some data
-			int i = 0;
-			for (auto& curr : testArray) {
-				curr = i*3;
+	////////////////////////////////
+
+	TestRingBuffer<int> intBuffer;
+	auto duration = TimedExecution(
+		[&intBuffer, count]() {
+			for (int i = 0; i < count; i++) {
+				intBuffer.PushFront(i);
 			}
+		}
+	);
+	cout << "Pushed " << count << " integers in " << duration.count() << " sec" << endl;
 
-			duration = TimedExecution(
-				[&arrayBuffer, &testArray, count]() {
-					for (int i = 0; i < count; i++) {
-						testArray[0] = i;
-						arrayBuffer.PushFront(testArray);
-					}
-				}
-			);
-			cout << "Pushed " << count << " std::array<int, 100> in " << duration.count() << " sec" << endl;
+	intBuffer.RotateFront();
+	TestAssert(intBuffer.Back() == count-1);
+	TestAssert(intBuffer.Front() == count-2);
 
-			arrayBuffer.RotateFront();
-			TestAssert(arrayBuffer.Back()[0] == count-1);
+	////////////////////////////////
 
-			////////////////////////////////
+	TestRingBuffer<std::array<int, 100>> arrayBuffer;
+	std::array<int, 100> testArray;
 
-			cout << "----" << endl;
+	//just fill with some data
+	int i = 0;
+	for (auto& curr : testArray) {
+		curr = i*3;
+	}
 
-			std::vector<int> intVector;
-			intVector.reserve(intBuffer.Count());
+	duration = TimedExecution(
+		[&arrayBuffer, &testArray, count]() {
+			for (int i = 0; i < count; i++) {
+				testArray[0] = i;
+				arrayBuffer.PushFront(testArray);
+			}
+		}
+	);
+	cout << "Pushed " << count << " std::array<int, 100> in " << duration.count() << " sec" << endl;
 
-			duration = TimedExecution(
-				[&intBuffer, &intVector]() {
-					auto targetPos = intBuffer.End();
-					auto currPos = intBuffer.Begin();
-					do {
-						intVector.push_back(intBuffer.Front());
-						intBuffer.RotateFront();
-					} while (++currPos != targetPos);
-				}
-			);
-			cout << "Rotated and copied " << count << " int in " << duration.count() << " sec" << endl;
+	arrayBuffer.RotateFront();
+	TestAssert(arrayBuffer.Back()[0] == count-1);
 
-			TestAssert(intVector[0] == intBuffer.Front());
+	////////////////////////////////
 
-			////////////////////////////////
+	cout << "----" << endl;
 
-			std::vector<std::array<int, 100>> arrayVector;
-			arrayVector.reserve(arrayBuffer.Count());
+	std::vector<int> intVector;
+	intVector.reserve(intBuffer.Count());
 
-			duration = TimedExecution(
-				[&arrayBuffer, &arrayVector]() {
-					auto targetPos = arrayBuffer.End();
-					auto currPos = arrayBuffer.Begin();
-					do {
-						arrayVector.push_back(arrayBuffer.Front());
-						arrayBuffer.RotateFront();
-					} while (++currPos != targetPos);
-				}
-			);
-			cout << "Rotated and copied " << count << " std::array<int, 100> in " << duration.count() << " sec" << endl;
+	duration = TimedExecution(
+		[&intBuffer, &intVector]() {
+			auto targetPos = intBuffer.End();
+			auto currPos = intBuffer.Begin();
+			do {
+				intVector.push_back(intBuffer.Front());
+				intBuffer.RotateFront();
+			} while (++currPos != targetPos);
+		}
+	);
+	cout << "Rotated and copied " << count << " int in " << duration.count() << " sec" << endl;
+
+	TestAssert(intVector[0] == intBuffer.Front());
+
+	////////////////////////////////
 
+	std::vector<std::array<int, 100>> arrayVector;
+	arrayVector.reserve(arrayBuffer.Count());
 
-			// Test iterator
-			int countedSize = 0;
-			int last;
-			for (int curr : intBuffer) {
-				last = curr;
-				countedSize += 1;
+	duration = TimedExecution(
+		[&arrayBuffer, &arrayVector]() {
+			auto targetPos = arrayBuffer.End();
+			auto currPos = arrayBuffer.Begin();
+			do {
+				arrayVector.push_back(arrayBuffer.Front());
+				arrayBuffer.RotateFront();
+			} while (++currPos != targetPos);
+		}
+	);
+	cout << "Rotated and copied " << count << " std::array<int, 100> in " << duration.count() << " sec" << endl;
+
+	////////////////////////////////
+
+	// A few pages that are rotated all the time, like the constant buffer heap does.
+	TestRingBuffer<std::array<size_t, 5>> pages;
+	for (size_t page = 0; page < 8; ++page) {
+		pages.PushFront({ page, 0, 0, 0, 0 });
+	}
+	size_t checksum = 0;
+	duration = TimedExecution(
+		[&pages, &checksum, count]() {
+			for (int i = 0; i < 10 * count; i++) {
+				pages.Front()[1] += 1;
+				checksum += pages.Front()[0];
+				pages.RotateFront();
 			}
+		}
+	);
+	cout << "Rotated " << 10 * count << " times through 8 pages in " << duration.count() << " sec" << endl;
+	TestAssert(checksum == size_t(10 * count / 8) * (0 + 1 + 2 + 3 + 4 + 5 + 6 + 7));
+
 
-			TestAssert(countedSize == intBuffer.Count());
-			TestAssert(last == intBuffer.Back());
+	// Test iterator
+	int countedSize = 0;
+	int last;
+	for (int curr : intBuffer) {
+		last = curr;
+		countedSize += 1;
+	}
+
+	TestAssert(countedSize == intBuffer.Count());
+	TestAssert(last == intBuffer.Back());
+
+	countedSize = 0;
+	for (auto curr = intBuffer.Begin(); curr != intBuffer.End().AddRounds(2); ++curr) {
+		countedSize += 1;
+	}
+
+	TestAssert(countedSize == intBuffer.Count()*3);
+
+	cout << endl;
+}
 
-			countedSize = 0;
-			for (auto curr = intBuffer.Begin(); curr != intBuffer.End().AddRounds(2); ++curr) {
-				countedSize += 1;
+
+// Applies random operations to both backends and compares their contents.
+static void CompareBackends() {
+	ListRingBuffer<int> listBuffer;
+	ContiguousRingBuffer<int> contiguousBuffer;
+	std::mt19937 rne(7);
+
+	for (int i = 0; i < 100000; ++i) {
+		switch (rne() % 5) {
+			case 0:
+			case 1:
+				listBuffer.PushFront(i);
+				contiguousBuffer.PushFront(i);
+				break;
+			case 2:
+				if (listBuffer.Count() > 0) {
+					listBuffer.PopFront();
+					contiguousBuffer.PopFront();
+				}
+				break;
+			case 3:
+				listBuffer.RotateFront();
+				contiguousBuffer.RotateFront();
+				break;
+			case 4:
+				listBuffer.RotateBack();
+				contiguousBuffer.RotateBack();
+				break;
+		}
+
+		TestAssert(listBuffer.Count() == contiguousBuffer.Count());
+		if (i % 97 == 0 && listBuffer.Count() > 0) {
+			TestAssert(listBuffer.Front() == contiguousBuffer.Front());
+			TestAssert(listBuffer.Back() == contiguousBuffer.Back());
+			auto it = contiguousBuffer.Begin();
+			for (int value : listBuffer) {
+				TestAssert(value == *it);
+				++it;
 			}
+			TestAssert(it == contiguousBuffer.End());
+		}
+	}
 
-			TestAssert(countedSize == intBuffer.Count()*3);
+	ContiguousRingBuffer<int> copy = contiguousBuffer;
+	TestAssert(copy.Count() == contiguousBuffer.Count());
+	TestAssert(copy.Count() == 0 || copy.Front() == contiguousBuffer.Front());
+	cout << "List and contiguous backends match." << endl << endl;
+}
+
+
+class Test_RingBuffer : public AutoRegisterTest<Test_RingBuffer> {
+public:
+	static std::string Name() {
+		return "RingBuffer";
+	}
+
+	virtual int Run() override {
+
+		try {
+			CompareBackends();
+			RunSuite<ListRingBuffer>("std::list");
+			RunSuite<ContiguousRingBuffer>("contiguous");
 		}
 		catch(std::exception& e) {
 			std::cerr << "ERROR: " << e.what() << std::endl;
@@ -158,4 +239,4 @@ public:
 
 		return 0;
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,881 @@
+#include "Test.hpp"
+#include "RecordingGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/Scheduler.hpp>
+#include <GraphicsEngine_LL/GraphicsNode.hpp>
+#include <GraphicsEngine_LL/NodeContext.hpp>
+#include <GraphicsEngine_LL/GraphicsCommandList.hpp>
+#include <GraphicsEngine_LL/CommandAllocatorPool.hpp>
+#include <GraphicsEngine_LL/CommandListPool.hpp>
+#include <GraphicsEngine_LL/ScratchSpacePool.hpp>
+#include <GraphicsEngine_LL/FrameScratchAllocator.hpp>
+#include <GraphicsEngine_LL/ResourceView.hpp>
+#include <BaseLibrary/JobSystem.hpp>
+#include <BaseLibrary/Logging/Logger.hpp>
+
+#include <lemon/connectivity.h>
+#include <rapidjson/document.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestScheduler : public AutoRegisterTest<TestScheduler> {
+public:
+	TestScheduler() {}
+
+	static std::string Name() {
+		return "Scheduler";
+	}
+	virtual int Run() override;
+private:
+	static bool TestParallelRecording();
+	static bool TestCompiledSchedule();
+	static bool TestQueuePlan();
+	static bool TestAsyncQueues();
+	static bool TestTransientAliasing();
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+using Clock = std::chrono::high_resolution_clock;
+
+static constexpr auto WorkDuration = std::chrono::microseconds(500);
+
+// Stands in for the CPU work a real node does while recording.
+static void BusyWork() {
+	auto start = Clock::now();
+	while (Clock::now() - start < WorkDuration) {}
+}
+
+
+// Marks its commands with its id and uses its own texture as a render target.
+class SourceNode :
+	virtual public GraphicsNode,
+	public GraphicsTask,
+	public InputPortConfig<>,
+	public OutputPortConfig<Texture2D>
+{
+public:
+	SourceNode(unsigned id, Texture2D texture) : m_id(id), m_texture(std::move(texture)) {}
+
+	static const char* Info_GetName() { return "SourceNode"; }
+	void Update() override {}
+	void Notify(InputPortBase* sender) override {}
+	void Initialize(EngineContext& context) override { GraphicsNode::SetTaskSingle(this); }
+	void Reset() override {}
+
+	void Setup(SetupContext& context) override {
+		GetOutput<0>().Set(m_texture);
+	}
+
+	void Execute(RenderContext& context) override {
+		GraphicsCommandList& commandList = context.AsGraphics();
+		commandList.SetStencilRef(m_id);
+		commandList.SetResourceState(m_texture, gxapi::eResourceState::RENDER_TARGET);
+		BusyWork();
+	}
+private:
+	unsigned m_id;
+	Texture2D m_texture;
+};
+
+
+// Reads its input as a shader resource and renders into its own texture.
+class WorkNode :
+	virtual public GraphicsNode,
+	public GraphicsTask,
+	public InputPortConfig<Texture2D>,
+	public OutputPortConfig<Texture2D>
+{
+public:
+	WorkNode(unsigned id, Texture2D texture) : m_id(id), m_texture(std::move(texture)) {}
+
+	static const char* Info_GetName() { return "WorkNode"; }
+	void Update() override {}
+	void Notify(InputPortBase* sender) override {}
+	void Initialize(EngineContext& context) override { GraphicsNode::SetTaskSingle(this); }
+	void Reset() override { m_input = {}; }
+
+	void Setup(SetupContext& context) override {
+		m_input = GetInput<0>().Get();
+		GetOutput<0>().Set(m_texture);
+	}
+
+	void Execute(RenderContext& context) override {
+		GraphicsCommandList& commandList = context.AsGraphics();
+		commandList.SetStencilRef(m_id);
+		commandList.SetResourceState(m_input, gxapi::eResourceState::PIXEL_SHADER_RESOURCE);
+		commandList.SetResourceState(m_texture, gxapi::eResourceState::RENDER_TARGET);
+		BusyWork();
+	}
+private:
+	unsigned m_id;
+	Texture2D m_texture;
+	Texture2D m_input;
+};
+
+
+// Reads its input and writes its own texture in a compute shader.
+class ComputeNode :
+	virtual public GraphicsNode,
+	public GraphicsTask,
+	public InputPortConfig<Texture2D>,
+	public OutputPortConfig<Texture2D>
+{
+public:
+	ComputeNode(Texture2D texture) : m_texture(std::move(texture)) {}
+
+	static const char* Info_GetName() { return "ComputeNode"; }
+	void Update() override {}
+	void Notify(InputPortBase* sender) override {}
+	void Initialize(EngineContext& context) override { GraphicsNode::SetTaskSingle(this); }
+	void Reset() override { m_input = {}; }
+
+	void Setup(SetupContext& context) override {
+		m_input = GetInput<0>().Get();
+		GetOutput<0>().Set(m_texture);
+	}
+
+	void Execute(RenderContext& context) override {
+		ComputeCommandList& commandList = context.AsCompute();
+		commandList.SetResourceState(m_input, gxapi::eResourceState::NON_PIXEL_SHADER_RESOURCE);
+		commandList.SetResourceState(m_texture, gxapi::eResourceState::UNORDERED_ACCESS);
+	}
+private:
+	Texture2D m_texture;
+	Texture2D m_input;
+};
+
+
+// Reads its input and renders into a transient texture it requests every frame.
+class TransientNode :
+	virtual public GraphicsNode,
+	public GraphicsTask,
+	public InputPortConfig<Texture2D>,
+	public OutputPortConfig<Texture2D>
+{
+public:
+	TransientNode(unsigned id) : m_id(id) {}
+
+	static const char* Info_GetName() { return "TransientNode"; }
+	void Update() override {}
+	void Notify(InputPortBase* sender) override {}
+	void Initialize(EngineContext& context) override { GraphicsNode::SetTaskSingle(this); }
+	void Reset() override { m_input = {}; m_texture = {}; }
+
+	void Setup(SetupContext& context) override {
+		m_input = GetInput<0>().Get();
+		m_texture = context.CreateTransientTexture2D(Texture2DDesc(256, 256, gxapi::eFormat::R8G8B8A8_UNORM), { true, true, false, false });
+		GetOutput<0>().Set(m_texture);
+	}
+
+	void Execute(RenderContext& context) override {
+		GraphicsCommandList& commandList = context.AsGraphics();
+		commandList.SetStencilRef(m_id);
+		commandList.SetResourceState(m_input, gxapi::eResourceState::PIXEL_SHADER_RESOURCE);
+		commandList.SetResourceState(m_texture, gxapi::eResourceState::RENDER_TARGET);
+	}
+
+	const Texture2D& GetTexture() const { return m_texture; }
+private:
+	unsigned m_id;
+	Texture2D m_texture;
+	Texture2D m_input;
+};
+
+
+// Exposes the schedule compiler.
+class ScheduleCompiler : public Scheduler {
+public:
+	using Scheduler::Schedule;
+	using Scheduler::CompileSchedule;
+};
+
+
+// Exposes the queue planning.
+class QueuePlanner : public Scheduler {
+public:
+	using Scheduler::QueueTask;
+	using Scheduler::QueuePosition;
+	using Scheduler::QueuePlan;
+	using Scheduler::PlanQueues;
+};
+
+
+// Does nothing, only its address matters.
+class EmptyTask : public GraphicsTask {
+public:
+	void Setup(SetupContext& context) override {}
+	void Execute(RenderContext& context) override {}
+};
+
+
+// The scheduling that used to run every frame: topological sort, then sort the nodes by their order.
+static std::vector<GraphicsTask*> SortTasksPerFrame(const lemon::ListDigraph& taskGraph, const lemon::ListDigraph::NodeMap<GraphicsTask*>& taskFunctionMap) {
+	lemon::ListDigraph::NodeMap<int> taskOrderMap(taskGraph);
+	lemon::checkedTopologicalSort(taskGraph, taskOrderMap);
+
+	std::vector<lemon::ListDigraph::NodeIt> taskNodes;
+	for (lemon::ListDigraph::NodeIt taskNode(taskGraph); taskNode != lemon::INVALID; ++taskNode) {
+		taskNodes.push_back(taskNode);
+	}
+	std::sort(taskNodes.begin(), taskNodes.end(), [&](auto n1, auto n2) {
+		return taskOrderMap[n1] < taskOrderMap[n2];
+	});
+
+	std::vector<GraphicsTask*> tasks;
+	for (auto node : taskNodes) {
+		tasks.push_back(taskFunctionMap[node]);
+	}
+	return tasks;
+}
+
+
+static std::string GetShippedPipelinePath() {
+	std::string path = __FILE__;
+	path = path.substr(0, path.find_last_of("/\\") + 1);
+	return path + "../../Engine/GraphicsEngine_LL/pipeline.json";
+}
+
+
+// One line per command, so that two frames can be compared.
+static std::vector<std::string> FlattenSubmissions(const std::vector<RecordedSubmission>& submissions) {
+	std::vector<std::string> lines;
+	for (auto& submission : submissions) {
+		for (auto& list : submission.commandLists) {
+			for (auto& command : list.commands) {
+				std::stringstream ss;
+				ss << command.name << " " << command.argument;
+				for (auto& barrier : command.barriers) {
+					if (barrier.type == gxapi::eResourceBarrierType::TRANSITION) {
+						ss << " [" << barrier.transition.resource << " " << int(barrier.transition.beforeState) << "->" << int(barrier.transition.afterState) << " " << int(barrier.transition.splitMode) << "]";
+					}
+				}
+				lines.push_back(ss.str());
+			}
+		}
+	}
+	return lines;
+}
+
+
+// Order in which nodes' command lists reached the queue.
+static std::map<uint64_t, size_t> GetMarkerPositions(const std::vector<RecordedSubmission>& submissions) {
+	std::map<uint64_t, size_t> positions;
+	for (auto& submission : submissions) {
+		for (auto& list : submission.commandLists) {
+			for (auto& command : list.commands) {
+				if (command.name == "SetStencilRef") {
+					positions.insert({ command.argument, positions.size() });
+				}
+			}
+		}
+	}
+	return positions;
+}
+
+
+// The engine objects a frame needs, on top of the recording API.
+// The pools must outlive the residency queue, it returns objects to them.
+struct TestDevice {
+	TestDevice() :
+		log(logger.CreateLogStream("scheduler")),
+		memoryManager(&api),
+		textureSpace(&api),
+		rtvHeap(&api),
+		dsvHeap(&api),
+		commandAllocatorPool(&api),
+		commandListPool(&api),
+		scratchSpacePool(&api, gxapi::eDescriptorHeapType::CBV_SRV_UAV),
+		commandQueue(&api, gxapi::eCommandListType::GRAPHICS),
+		computeQueue(&api, gxapi::eCommandListType::COMPUTE),
+		copyQueue(&api, gxapi::eCommandListType::COPY),
+		residencyQueue(std::unique_ptr<gxapi::IFence>(api.CreateFence(0))),
+		backBufferTexture(MakeTexture()),
+		backBuffer(backBufferTexture, gxapi::DescriptorHandle{}, &api, gxapi::eFormat::R8G8B8A8_UNORM, gxapi::RtvTexture2DArray{ 0, 0, 1, 0 })
+	{}
+
+	Texture2D MakeTexture() {
+		textures.push_back(memoryManager.CreateTexture2D(eResourceHeapType::CRITICAL, Texture2DDesc(256, 256, gxapi::eFormat::R8G8B8A8_UNORM)));
+		return textures.back();
+	}
+
+	std::vector<gxapi::eResourceState> ReadStates() const {
+		std::vector<gxapi::eResourceState> states;
+		for (auto& texture : textures) {
+			states.push_back(texture.ReadState(0));
+		}
+		return states;
+	}
+
+	// Returns the time Execute() took in milliseconds. Clears the recording of the previous frame.
+	double RenderFrame(Scheduler& scheduler, JobSystem* jobSystem, bool useAsyncQueues = false) {
+		FrameContext context;
+		context.frameTime = std::chrono::milliseconds(16);
+		context.absoluteTime = std::chrono::milliseconds(16 * frame);
+		context.log = &log;
+		context.frame = frame;
+		context.gxApi = &api;
+		context.commandAllocatorPool = &commandAllocatorPool;
+		context.commandListPool = &commandListPool;
+		context.scratchSpacePool = &scratchSpacePool;
+		context.memoryManager = &memoryManager;
+		context.textureSpace = &textureSpace;
+		context.rtvHeap = &rtvHeap;
+		context.dsvHeap = &dsvHeap;
+		context.commandQueue = &commandQueue;
+		context.computeQueue = useAsyncQueues ? &computeQueue : nullptr;
+		context.copyQueue = useAsyncQueues ? &copyQueue : nullptr;
+		context.backBuffer = &backBuffer;
+		context.uploadRequests = &uploadRequests;
+		context.residencyQueue = &residencyQueue;
+		context.frameScratchAllocator = &frameScratchAllocator;
+		context.jobSystem = jobSystem;
+
+		api.ClearRecording();
+		auto start = Clock::now();
+		scheduler.Execute(context);
+		auto end = Clock::now();
+		frameScratchAllocator.OnFrameCompleteHost(frame);
+		++frame;
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	RecordingGraphicsApi api;
+	Logger logger;
+	LogStream log;
+	MemoryManager memoryManager;
+	CbvSrvUavHeap textureSpace;
+	RTVHeap rtvHeap;
+	DSVHeap dsvHeap;
+	CommandAllocatorPool commandAllocatorPool;
+	CommandListPool commandListPool;
+	ScratchSpacePool scratchSpacePool;
+	FrameScratchAllocator frameScratchAllocator;
+	CommandQueue commandQueue;
+	CommandQueue computeQueue;
+	CommandQueue copyQueue;
+	ResourceResidencyQueue residencyQueue;
+	std::vector<Texture2D> textures; // all created by MakeTexture
+	Texture2D backBufferTexture;
+	RenderTargetView2D backBuffer;
+	std::vector<UploadManager::UploadDescription> uploadRequests;
+	uint64_t frame = 0;
+};
+
+
+static Pipeline MakePipeline(const std::vector<std::shared_ptr<NodeBase>>& nodes) {
+	EngineContext engineContext(1, 1);
+	for (auto& node : nodes) {
+		dynamic_cast<GraphicsNode&>(*node).Initialize(engineContext);
+	}
+	Pipeline pipeline;
+	pipeline.CreateFromNodesList(nodes);
+	return pipeline;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestScheduler::Run() {
+	if (!TestCompiledSchedule()) {
+		return -1;
+	}
+	if (!TestParallelRecording()) {
+		return -1;
+	}
+	if (!TestQueuePlan()) {
+		return -1;
+	}
+	if (!TestAsyncQueues()) {
+		return -1;
+	}
+	if (!TestTransientAliasing()) {
+		return -1;
+	}
+	return 0;
+}
+
+
+bool TestScheduler::TestCompiledSchedule() {
+	// Build the dependency graph of the shipped pipeline, one task per node.
+	std::ifstream file(GetShippedPipelinePath());
+	if (!file.is_open()) {
+		cout << "Could not open " << GetShippedPipelinePath() << "." << endl;
+		return false;
+	}
+	std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	rapidjson::Document doc;
+	doc.Parse(json.c_str());
+	if (doc.HasParseError() || !doc.HasMember("nodes") || !doc.HasMember("links")) {
+		cout << "Pipeline description is invalid." << endl;
+		return false;
+	}
+
+	lemon::ListDigraph taskGraph;
+	lemon::ListDigraph::NodeMap<GraphicsTask*> taskFunctionMap(taskGraph);
+	std::vector<std::unique_ptr<EmptyTask>> tasks;
+	// Nodes are referred to either by id or by name.
+	std::map<int, lemon::ListDigraph::Node> nodesById;
+	std::map<std::string, lemon::ListDigraph::Node> nodesByName;
+	auto FindNode = [&](const rapidjson::Value& reference) {
+		return reference.IsString() ? nodesByName.at(reference.GetString()) : nodesById.at(reference.GetInt());
+	};
+	auto& nodes = doc["nodes"];
+	auto& links = doc["links"];
+	for (rapidjson::SizeType i = 0; i < nodes.Size(); ++i) {
+		auto taskNode = taskGraph.addNode();
+		tasks.push_back(std::make_unique<EmptyTask>());
+		taskFunctionMap[taskNode] = tasks.back().get();
+		if (nodes[i].HasMember("id")) {
+			nodesById[nodes[i]["id"].GetInt()] = taskNode;
+		}
+		if (nodes[i].HasMember("name")) {
+			nodesByName[nodes[i]["name"].GetString()] = taskNode;
+		}
+	}
+	for (rapidjson::SizeType i = 0; i < links.Size(); ++i) {
+		taskGraph.addArc(FindNode(links[i]["src"]), FindNode(links[i]["dst"]));
+	}
+
+	// Every task is scheduled once, strictly after all of its predecessors' levels.
+	ScheduleCompiler::Schedule schedule = ScheduleCompiler::CompileSchedule(taskGraph, taskFunctionMap);
+	if (schedule.GetNumTasks() != tasks.size() + 1 || schedule.tasks[ScheduleCompiler::Schedule::UploadTaskIndex] != nullptr) {
+		cout << "Compiled schedule has wrong number of tasks." << endl;
+		return false;
+	}
+	std::vector<size_t> levels(schedule.GetNumTasks());
+	for (size_t level = 0; level < schedule.GetNumLevels(); ++level) {
+		for (size_t task = schedule.levelOffsets[level]; task < schedule.levelOffsets[level + 1]; ++task) {
+			levels[task] = level;
+		}
+	}
+	size_t numArcs = 0;
+	for (size_t task = 0; task < schedule.GetNumTasks(); ++task) {
+		for (auto it = schedule.SuccessorsBegin(task); it != schedule.SuccessorsEnd(task); ++it) {
+			if (levels[*it] <= levels[task]) {
+				cout << "Task scheduled on the level of its predecessor." << endl;
+				return false;
+			}
+			++numArcs;
+		}
+	}
+	if (numArcs != (size_t)lemon::countArcs(taskGraph)) {
+		cout << "Compiled schedule lost dependencies." << endl;
+		return false;
+	}
+
+	// Compare sorting every frame to walking the compiled schedule.
+	constexpr int NumFrames = 10000;
+	size_t checksum = 0;
+	auto start = Clock::now();
+	for (int frame = 0; frame < NumFrames; ++frame) {
+		auto sorted = SortTasksPerFrame(taskGraph, taskFunctionMap);
+		checksum += sorted.size();
+	}
+	auto end = Clock::now();
+	double perFrameSort = std::chrono::duration<double, std::micro>(end - start).count() / NumFrames;
+
+	start = Clock::now();
+	for (int frame = 0; frame < 100; ++frame) {
+		checksum += ScheduleCompiler::CompileSchedule(taskGraph, taskFunctionMap).GetNumTasks();
+	}
+	end = Clock::now();
+	double compile = std::chrono::duration<double, std::micro>(end - start).count() / 100;
+
+	start = Clock::now();
+	for (int frame = 0; frame < NumFrames; ++frame) {
+		for (size_t task = 0; task < schedule.GetNumTasks(); ++task) {
+			checksum += schedule.tasks[task] != nullptr ? schedule.predecessorCounts[task] : 0;
+		}
+	}
+	end = Clock::now();
+	double walk = std::chrono::duration<double, std::micro>(end - start).count() / NumFrames;
+
+	cout << "Scheduling pipeline.json (" << tasks.size() << " tasks, " << schedule.GetNumLevels() << " levels):" << endl;
+	cout << "    sort every frame:      " << std::fixed << std::setprecision(3) << perFrameSort << " us" << endl;
+	cout << "    compile once:          " << std::fixed << std::setprecision(3) << compile << " us" << endl;
+	cout << "    walk compiled, frame:  " << std::fixed << std::setprecision(3) << walk << " us" << endl;
+	cout << "    (checksum " << checksum << ")" << endl << endl;
+
+	return true;
+}
+
+
+bool TestScheduler::TestParallelRecording() {
+	constexpr unsigned Width = 8; // number of independent branches
+	constexpr unsigned SourceId = 1, FirstLevelId = 100, SecondLevelId = 200;
+
+	TestDevice device;
+	auto& api = device.api;
+
+	// A source feeding a number of two node long chains.
+	std::vector<std::shared_ptr<NodeBase>> nodes;
+	auto source = std::make_shared<SourceNode>(SourceId, device.MakeTexture());
+	nodes.push_back(source);
+	for (unsigned i = 0; i < Width; ++i) {
+		auto first = std::make_shared<WorkNode>(FirstLevelId + i, device.MakeTexture());
+		auto second = std::make_shared<WorkNode>(SecondLevelId + i, device.MakeTexture());
+		first->GetInput(0)->Link(source->GetOutput(0));
+		second->GetInput(0)->Link(first->GetOutput(0));
+		nodes.push_back(first);
+		nodes.push_back(second);
+	}
+	Scheduler scheduler;
+	scheduler.SetPipeline(MakePipeline(nodes));
+
+	JobSystem jobSystem;
+	auto RenderFrame = [&](JobSystem* frameJobSystem) {
+		return device.RenderFrame(scheduler, frameJobSystem);
+	};
+
+	// The first frame moves resources out of their initial states, later frames all look the same.
+	RenderFrame(nullptr);
+	double serialTime = RenderFrame(nullptr);
+	auto serialSubmissions = api.GetSubmissions();
+	double parallelTime = RenderFrame(&jobSystem);
+	auto parallelSubmissions = api.GetSubmissions();
+
+	// Submission must not depend on how the lists were recorded.
+	auto serialLines = FlattenSubmissions(serialSubmissions);
+	auto parallelLines = FlattenSubmissions(parallelSubmissions);
+	if (serialLines != parallelLines) {
+		cout << "Parallel recording submitted different commands than serial recording." << endl;
+		return false;
+	}
+
+	auto positions = GetMarkerPositions(parallelSubmissions);
+	if (positions.size() != 2 * Width + 1) {
+		cout << "Expected " << 2 * Width + 1 << " nodes to submit, got " << positions.size() << "." << endl;
+		return false;
+	}
+	for (unsigned i = 0; i < Width; ++i) {
+		if (positions[FirstLevelId + i] < positions[SourceId] || positions[SecondLevelId + i] < positions[FirstLevelId + i]) {
+			cout << "Node submitted before the node it depends on." << endl;
+			return false;
+		}
+	}
+
+	// Several frames in a row must give the same result as well.
+	for (int i = 0; i < 10; ++i) {
+		parallelTime = std::min(parallelTime, RenderFrame(&jobSystem));
+		if (FlattenSubmissions(api.GetSubmissions()) != serialLines) {
+			cout << "Parallel recording is not deterministic." << endl;
+			return false;
+		}
+	}
+
+	cout << "Recording " << 2 * Width + 1 << " tasks of " << WorkDuration.count() << " us each:" << endl;
+	cout << "    serial:   " << std::fixed << std::setprecision(2) << serialTime << " ms" << endl;
+	cout << "    parallel: " << std::fixed << std::setprecision(2) << parallelTime << " ms on " << jobSystem.GetWorkerCount() << " workers" << endl;
+
+	// Barrier planning must not change what nodes see, only how barriers are submitted.
+	auto plannedStates = device.ReadStates();
+	auto plannedStatistics = api.GetStatistics();
+	size_t numBegin = 0, numEnd = 0;
+	for (auto& submission : api.GetSubmissions()) {
+		for (auto& list : submission.commandLists) {
+			for (auto& command : list.commands) {
+				for (auto& barrier : command.barriers) {
+					numBegin += barrier.transition.splitMode == gxapi::eResourceBarrierSplit::BEGIN;
+					numEnd += barrier.transition.splitMode == gxapi::eResourceBarrierSplit::END;
+				}
+			}
+		}
+	}
+
+	scheduler.SetBarrierPlanning(false);
+	RenderFrame(&jobSystem);
+	auto unplannedStatistics = api.GetStatistics();
+	auto unplannedPositions = GetMarkerPositions(api.GetSubmissions());
+	if (unplannedPositions != positions || device.ReadStates() != plannedStates) {
+		cout << "Barrier planning changed the order of nodes or the resulting resource states." << endl;
+		return false;
+	}
+	if (numBegin == 0 || numBegin != numEnd) {
+		cout << "Expected matching split barriers, got " << numBegin << " begin and " << numEnd << " end." << endl;
+		return false;
+	}
+	if (plannedStatistics.commandLists >= unplannedStatistics.commandLists) {
+		cout << "Barrier planning did not reduce command lists." << endl;
+		return false;
+	}
+	if (plannedStatistics.executeCalls != 1 || plannedStatistics.signals != 1) {
+		cout << "Expected the frame to be submitted at once, got " << plannedStatistics.executeCalls << " submissions." << endl;
+		return false;
+	}
+
+	cout << "Barriers per frame:" << endl;
+	cout << "    per task: " << unplannedStatistics.commandLists << " command lists in " << unplannedStatistics.executeCalls << " submissions, " << unplannedStatistics.barriers << " barriers" << endl;
+	cout << "    planned:  " << plannedStatistics.commandLists << " command lists in " << plannedStatistics.executeCalls << " submissions, " << plannedStatistics.barriers << " barriers (" << numBegin << " split)" << endl;
+
+	scheduler.ReleaseResources();
+	return true;
+}
+
+
+bool TestScheduler::TestQueuePlan() {
+	using Task = QueuePlanner::QueueTask;
+	using Position = QueuePlanner::QueuePosition;
+	constexpr auto GRAPHICS = gxapi::eCommandListType::GRAPHICS;
+	constexpr auto COMPUTE = gxapi::eCommandListType::COMPUTE;
+	constexpr auto COPY = gxapi::eCommandListType::COPY;
+	auto Equal = [](const std::vector<Position>& waits, const std::vector<Position>& expected) {
+		return waits.size() == expected.size() && std::equal(waits.begin(), waits.end(), expected.begin(), [](const Position& lhs, const Position& rhs) {
+			return lhs.queue == rhs.queue && lhs.task == rhs.task;
+		});
+	};
+
+	// An upload on the copy queue, a compute task beside an independent graphics one, and a graphics task using both.
+	{
+		std::vector<Task> tasks(6);
+		tasks[0] = { true, COPY, true, {} }; // upload, its barriers go on the graphics queue
+		tasks[1] = { true, GRAPHICS, true, {} };
+		tasks[2] = { true, COMPUTE, false, { 1 } };
+		tasks[3] = { true, GRAPHICS, false, { 1 } };
+		tasks[4] = { false, GRAPHICS, false, { 2 } }; // merge point, no command list
+		tasks[5] = { true, GRAPHICS, true, { 4, 0, 3 } };
+		auto plan = QueuePlanner::PlanQueues(tasks);
+
+		bool isCorrect = Equal(plan.taskWaits[0], { { GRAPHICS, 0 } })
+			&& Equal(plan.taskWaits[2], { { GRAPHICS, 1 } })
+			&& Equal(plan.gapWaits[3], {}) // independent of the compute task
+			&& Equal(plan.gapWaits[5], { { COPY, 0 }, { COMPUTE, 2 } }) // through the merge point
+			&& Equal(plan.gapWaits[6], {}); // already joined
+		if (!isCorrect) {
+			cout << "Wrong waits for upload and compute tasks." << endl;
+			return false;
+		}
+	}
+
+	// Waits implied by earlier waits are skipped.
+	{
+		std::vector<Task> tasks(5);
+		tasks[0] = { true, GRAPHICS, false, {} };
+		tasks[1] = { true, COMPUTE, false, { 0 } };
+		tasks[2] = { true, COMPUTE, false, { 1, 0 } }; // queue order already covers both
+		tasks[3] = { true, COPY, false, { 2 } };
+		tasks[4] = { true, GRAPHICS, false, { 3, 2 } }; // the copy queue already waited for compute
+		auto plan = QueuePlanner::PlanQueues(tasks);
+
+		bool isCorrect = Equal(plan.taskWaits[1], { { GRAPHICS, 0 } })
+			&& Equal(plan.taskWaits[2], {})
+			&& Equal(plan.taskWaits[3], { { COMPUTE, 2 } })
+			&& Equal(plan.gapWaits[4], { { COPY, 3 } })
+			&& Equal(plan.gapWaits[5], {});
+		if (!isCorrect) {
+			cout << "Redundant or missing waits in a chain across queues." << endl;
+			return false;
+		}
+	}
+
+	// Independent async work only waits for previous frames, and is joined at the end.
+	{
+		std::vector<Task> tasks(2);
+		tasks[0] = { true, GRAPHICS, false, {} };
+		tasks[1] = { true, COMPUTE, false, {} };
+		auto plan = QueuePlanner::PlanQueues(tasks);
+
+		bool isCorrect = Equal(plan.taskWaits[1], { { GRAPHICS, Position::FrameStart } })
+			&& Equal(plan.gapWaits[2], { { COMPUTE, 1 } });
+		if (!isCorrect) {
+			cout << "Wrong waits for independent compute task." << endl;
+			return false;
+		}
+	}
+
+	// Graphics only frames have no waits at all.
+	{
+		std::vector<Task> tasks(3);
+		tasks[0] = { true, GRAPHICS, true, {} };
+		tasks[1] = { true, GRAPHICS, true, { 0 } };
+		tasks[2] = { false, GRAPHICS, false, { 1 } };
+		auto plan = QueuePlanner::PlanQueues(tasks);
+		for (auto& waits : plan.gapWaits) {
+			if (!waits.empty()) {
+				cout << "Graphics only frame has waits." << endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+bool TestScheduler::TestAsyncQueues() {
+	TestDevice device;
+	auto& api = device.api;
+
+	// A compute task feeding a graphics one, beside an independent graphics chain.
+	std::vector<std::shared_ptr<NodeBase>> nodes;
+	auto computeSource = std::make_shared<SourceNode>(1, device.MakeTexture());
+	auto compute = std::make_shared<ComputeNode>(device.MakeTexture());
+	auto computeUser = std::make_shared<WorkNode>(2, device.MakeTexture());
+	auto graphicsSource = std::make_shared<SourceNode>(3, device.MakeTexture());
+	auto graphicsUser = std::make_shared<WorkNode>(4, device.MakeTexture());
+	compute->GetInput(0)->Link(computeSource->GetOutput(0));
+	computeUser->GetInput(0)->Link(compute->GetOutput(0));
+	graphicsUser->GetInput(0)->Link(graphicsSource->GetOutput(0));
+	nodes = { computeSource, compute, computeUser, graphicsSource, graphicsUser };
+
+	Scheduler scheduler;
+	scheduler.SetPipeline(MakePipeline(nodes));
+
+	// Everything on the graphics queue.
+	device.RenderFrame(scheduler, nullptr);
+	device.RenderFrame(scheduler, nullptr);
+	auto serialStatistics = api.GetStatistics();
+	auto serialPositions = GetMarkerPositions(api.GetSubmissions());
+	auto serialStates = device.ReadStates();
+
+	// The compute task on its own queue.
+	device.RenderFrame(scheduler, nullptr, true);
+	auto asyncStatistics = api.GetStatistics();
+	auto asyncSubmissions = api.GetSubmissions();
+
+	size_t numComputeLists = 0;
+	for (auto& submission : asyncSubmissions) {
+		for (auto& list : submission.commandLists) {
+			bool isComputeQueue = submission.queue == device.computeQueue.GetUnderlyingQueue();
+			if (isComputeQueue != (list.type == gxapi::eCommandListType::COMPUTE)) {
+				cout << "Command list submitted to the wrong queue." << endl;
+				return false;
+			}
+			numComputeLists += isComputeQueue;
+		}
+	}
+	if (numComputeLists != 1) {
+		cout << "Expected the compute task on the compute queue." << endl;
+		return false;
+	}
+	if (GetMarkerPositions(asyncSubmissions) != serialPositions || device.ReadStates() != serialStates) {
+		cout << "Async queues changed the order of graphics tasks or the resulting resource states." << endl;
+		return false;
+	}
+
+	// The compute queue waits for its barriers on the graphics queue, the graphics queue for the compute result.
+	if (serialStatistics.waits != 0 || asyncStatistics.waits != 2) {
+		cout << "Expected 2 waits, got " << asyncStatistics.waits << "." << endl;
+		return false;
+	}
+
+	cout << "Async compute: " << asyncStatistics.executeCalls << " submissions, " << asyncStatistics.signals << " signals, "
+		<< asyncStatistics.waits << " waits (graphics only: " << serialStatistics.executeCalls << " submissions, "
+		<< serialStatistics.signals << " signals)" << endl;
+
+	scheduler.ReleaseResources();
+	return true;
+}
+
+
+bool TestScheduler::TestTransientAliasing() {
+	TestDevice device;
+	auto& api = device.api;
+
+	// A chain where each transient texture is only read by the next node,
+	// so the 1st and 3rd, and the 2nd and 4th can share memory.
+	auto source = std::make_shared<SourceNode>(1, device.MakeTexture());
+	std::vector<std::shared_ptr<TransientNode>> chain;
+	for (unsigned id = 2; id <= 5; ++id) {
+		chain.push_back(std::make_shared<TransientNode>(id));
+		chain.back()->GetInput(0)->Link(chain.size() == 1 ? source->GetOutput(0) : chain[chain.size() - 2]->GetOutput(0));
+	}
+	auto sink = std::make_shared<WorkNode>(6, device.MakeTexture());
+	sink->GetInput(0)->Link(chain.back()->GetOutput(0));
+	std::vector<std::shared_ptr<NodeBase>> nodes = { source, chain[0], chain[1], chain[2], chain[3], sink };
+
+	Scheduler scheduler;
+	scheduler.SetPipeline(MakePipeline(nodes));
+
+	auto GetPlacement = [&](size_t index) {
+		auto resource = dynamic_cast<const RecordingResource*>(chain[index]->GetTexture()._GetResourcePtr());
+		return std::make_pair(resource->GetHeap(), resource->GetHeapOffset());
+	};
+	auto CountAliasingBarriers = [&] {
+		size_t count = 0;
+		for (auto& submission : api.GetSubmissions()) {
+			for (auto& list : submission.commandLists) {
+				for (auto& command : list.commands) {
+					count += std::count_if(command.barriers.begin(), command.barriers.end(), [](const gxapi::ResourceBarrier& barrier) {
+						return barrier.type == gxapi::eResourceBarrierType::ALIASING;
+					});
+				}
+			}
+		}
+		return count;
+	};
+
+	// The first frame finds out the lifetimes, the textures are committed.
+	device.RenderFrame(scheduler, nullptr);
+	for (size_t i = 0; i < chain.size(); ++i) {
+		if (GetPlacement(i).first != nullptr) {
+			cout << "Transient texture placed before its lifetime is known." << endl;
+			return false;
+		}
+	}
+	if (CountAliasingBarriers() != 0) {
+		cout << "Aliasing barriers for committed textures." << endl;
+		return false;
+	}
+
+	// From the second frame on they share the heap.
+	device.RenderFrame(scheduler, nullptr);
+	auto statistics = scheduler.GetTransientStatistics();
+	uint64_t textureSize = api.GetResourceAllocationInfo(chain[0]->GetTexture().GetDescription()).sizeInBytes;
+	if (GetPlacement(0).first == nullptr || GetPlacement(0) != GetPlacement(2) || GetPlacement(1) != GetPlacement(3) || GetPlacement(0) == GetPlacement(1)) {
+		cout << "Transient textures are not aliased." << endl;
+		return false;
+	}
+	if (statistics.numTextures != 4 || statistics.totalSize != 4 * textureSize || statistics.heapSize != 2 * textureSize || statistics.peakLiveSize != 2 * textureSize) {
+		cout << "Wrong transient statistics." << endl;
+		return false;
+	}
+	if (CountAliasingBarriers() != 4) {
+		cout << "Expected an aliasing barrier for each transient texture, got " << CountAliasingBarriers() << "." << endl;
+		return false;
+	}
+
+	// Nothing changes in later frames.
+	std::vector<const gxapi::IResource*> resources;
+	for (auto& node : chain) {
+		resources.push_back(node->GetTexture()._GetResourcePtr());
+	}
+	device.RenderFrame(scheduler, nullptr);
+	for (size_t i = 0; i < chain.size(); ++i) {
+		if (chain[i]->GetTexture()._GetResourcePtr() != resources[i]) {
+			cout << "Transient textures placed again without changes." << endl;
+			return false;
+		}
+	}
+
+	cout << "Transient aliasing: " << statistics.numTextures << " textures, " << statistics.totalSize / 1024 << " KiB separately, "
+		<< statistics.heapSize / 1024 << " KiB in heap" << endl;
+
+	scheduler.ReleaseResources();
+	return true;
+}
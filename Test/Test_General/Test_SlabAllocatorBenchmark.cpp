@@ -0,0 +1,179 @@
+#include "Test.hpp"
+#include <BaseLibrary/Memory/SlabAllocatorEngine.hpp>
+#include <BaseLibrary/Memory/HierarchicalSlabAllocatorEngine.hpp>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestSlabAllocatorBenchmark : public AutoRegisterTest<TestSlabAllocatorBenchmark> {
+public:
+	TestSlabAllocatorBenchmark() {}
+
+	static std::string Name() {
+		return "Allocator - Slab vs. Hierarchical";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+struct SlabBenchResult {
+	double allocNs; // per slot
+	double deallocNs; // per slot
+	double resizeUs; // per resize call
+	bool isOk;
+};
+
+
+template <class EngineT>
+static SlabBenchResult BenchmarkEngine(size_t poolSize, const std::vector<size_t>& deallocOrder) {
+	using Clock = std::chrono::high_resolution_clock;
+	SlabBenchResult result;
+	result.isOk = true;
+
+	// allocate whole pool
+	EngineT engine(poolSize);
+	std::vector<size_t> indices(poolSize);
+	auto startTime = Clock::now();
+	for (size_t i = 0; i < poolSize; ++i) {
+		indices[i] = engine.Allocate();
+	}
+	auto endTime = Clock::now();
+	result.allocNs = std::chrono::duration<double, std::nano>(endTime - startTime).count() / poolSize;
+
+	// check that every slot was given out exactly once
+	std::vector<char> taken(poolSize, 0);
+	for (auto index : indices) {
+		if (index >= poolSize || taken[index]++ != 0) {
+			result.isOk = false;
+		}
+	}
+	try {
+		engine.Allocate();
+		result.isOk = false;
+	}
+	catch (std::bad_alloc&) {}
+
+	// deallocate in random order
+	startTime = Clock::now();
+	for (auto index : deallocOrder) {
+		engine.Deallocate(index);
+	}
+	endTime = Clock::now();
+	result.deallocNs = std::chrono::duration<double, std::nano>(endTime - startTime).count() / poolSize;
+
+	// grow in many small steps while filling, like descriptor heaps do
+	constexpr size_t NumSteps = 100;
+	const size_t step = std::max(size_t(1), poolSize / NumSteps);
+	EngineT growing;
+	std::chrono::nanoseconds resizeTime(0);
+	size_t numResizes = 0;
+	for (size_t i = 0; i < poolSize; ++i) {
+		try {
+			growing.Allocate();
+		}
+		catch (std::bad_alloc&) {
+			startTime = Clock::now();
+			growing.Resize(growing.Size() + step);
+			endTime = Clock::now();
+			resizeTime += endTime - startTime;
+			++numResizes;
+			growing.Allocate();
+		}
+	}
+	result.resizeUs = std::chrono::duration<double, std::micro>(resizeTime).count() / std::max(size_t(1), numResizes);
+
+	return result;
+}
+
+
+template <class EngineT>
+static bool ChurnConsistency(size_t poolSize) {
+	EngineT engine(poolSize / 2);
+	std::vector<int> counter(poolSize, 0);
+	std::vector<size_t> allocations;
+	std::mt19937 rne;
+
+	for (int cycle = 0; cycle < 20; ++cycle) {
+		while (allocations.size() < poolSize * 2 / 3) {
+			size_t index;
+			try {
+				index = engine.Allocate();
+			}
+			catch (std::bad_alloc&) {
+				engine.Resize(std::min(poolSize, engine.Size() + 1000));
+				index = engine.Allocate();
+			}
+			if (index >= poolSize || ++counter[index] != 1) {
+				return false;
+			}
+			allocations.push_back(index);
+		}
+		std::shuffle(allocations.begin(), allocations.end(), rne);
+		for (size_t i = 0; i < poolSize / 3; ++i) {
+			engine.Deallocate(allocations.back());
+			--counter[allocations.back()];
+			allocations.pop_back();
+		}
+	}
+	return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestSlabAllocatorBenchmark::Run() {
+	cout << "Consistency:" << endl;
+	bool slabOk = ChurnConsistency<inl::SlabAllocatorEngine>(100'000);
+	bool hierOk = ChurnConsistency<inl::HierarchicalSlabAllocatorEngine>(100'000);
+	cout << "  Slab:         " << (slabOk ? "OK." : "Double allocation.") << endl;
+	cout << "  Hierarchical: " << (hierOk ? "OK." : "Double allocation.") << endl << endl;
+
+	cout << "Benchmark (alloc/dealloc in ns per slot, resize in us per call):" << endl;
+	cout << std::setw(10) << "slots"
+		<< std::setw(14) << "slab alloc" << std::setw(14) << "hier alloc"
+		<< std::setw(14) << "slab dealloc" << std::setw(14) << "hier dealloc"
+		<< std::setw(14) << "slab resize" << std::setw(14) << "hier resize" << endl;
+
+	std::mt19937 rne;
+	for (size_t poolSize : { 10'000ull, 100'000ull, 1'000'000ull, 10'000'000ull }) {
+		std::vector<size_t> deallocOrder(poolSize);
+		for (size_t i = 0; i < poolSize; ++i) {
+			deallocOrder[i] = i;
+		}
+		std::shuffle(deallocOrder.begin(), deallocOrder.end(), rne);
+
+		SlabBenchResult slab = BenchmarkEngine<inl::SlabAllocatorEngine>(poolSize, deallocOrder);
+		SlabBenchResult hier = BenchmarkEngine<inl::HierarchicalSlabAllocatorEngine>(poolSize, deallocOrder);
+
+		cout << std::fixed << std::setprecision(2)
+			<< std::setw(10) << poolSize
+			<< std::setw(14) << slab.allocNs << std::setw(14) << hier.allocNs
+			<< std::setw(14) << slab.deallocNs << std::setw(14) << hier.deallocNs
+			<< std::setw(14) << slab.resizeUs << std::setw(14) << hier.resizeUs << endl;
+		if (!slab.isOk || !hier.isOk) {
+			cout << "  Double allocation." << endl;
+			return -1;
+		}
+	}
+
+	return (slabOk && hierOk) ? 0 : -1;
+}
@@ -0,0 +1,155 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/SpinMutex.hpp>
+#include <BaseLibrary/Exception/Exception.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestSpinMutex : public AutoRegisterTest<TestSpinMutex> {
+public:
+	TestSpinMutex() {}
+
+	static std::string Name() {
+		return "Spin mutex";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// Every thread increments a shared counter numIterations times inside the lock,
+// doing workInside units of work while holding it, and workOutside units between acquisitions.
+// Returns million acquisitions per second.
+template <class MutexT>
+static double Contend(MutexT& mutex, unsigned numThreads, unsigned numIterations, unsigned workInside, unsigned workOutside, bool& isOk) {
+	uint64_t counter = 0;
+	std::atomic_bool start(false);
+	std::vector<std::thread> threads;
+
+	for (unsigned t = 0; t < numThreads; ++t) {
+		threads.emplace_back([&] {
+			volatile uint64_t sink = 0;
+			while (!start.load()) {
+				std::this_thread::yield();
+			}
+			for (unsigned i = 0; i < numIterations; ++i) {
+				{
+					std::lock_guard<MutexT> lkg(mutex);
+					uint64_t value = counter;
+					for (unsigned w = 0; w < workInside; ++w) {
+						sink = sink + w;
+					}
+					counter = value + 1;
+				}
+				for (unsigned w = 0; w < workOutside; ++w) {
+					sink = sink + w;
+				}
+			}
+		});
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	start.store(true);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	isOk = counter == uint64_t(numThreads) * numIterations;
+	return counter / std::chrono::duration<double>(endTime - startTime).count() / 1e6;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestSpinMutex::Run() {
+	// basic semantics
+	{
+		inl::spin_mutex mutex;
+		if (!mutex.try_lock()) {
+			cout << "Failed to lock a free mutex." << endl;
+			return -1;
+		}
+		if (mutex.try_lock()) {
+			cout << "Locked a mutex twice." << endl;
+			return -1;
+		}
+		bool isThrown = false;
+		std::thread other([&] {
+			try {
+				mutex.unlock();
+			}
+			catch (inl::InvalidCallException&) {
+				isThrown = true;
+			}
+		});
+		other.join();
+		if (!isThrown) {
+			cout << "Unlocked from a foreign thread." << endl;
+			return -1;
+		}
+		mutex.unlock();
+	}
+
+	constexpr unsigned TotalIterations = 400'000;
+	struct Workload {
+		const char* name;
+		unsigned inside;
+		unsigned outside;
+	};
+
+	for (Workload workload : { Workload{ "short critical section", 4, 64 }, Workload{ "long critical section", 256, 64 } }) {
+		cout << "Contention, " << workload.name << " (million acquisitions per second):" << endl;
+		cout << std::setw(8) << "threads" << std::setw(12) << "std::mutex" << std::setw(12) << "spin_mutex"
+			<< std::setw(10) << "spins" << std::setw(10) << "yields" << std::setw(10) << "parks" << endl;
+
+		for (unsigned numThreads : { 2u, 8u, 32u }) {
+			bool isStdOk, isSpinOk;
+			std::mutex stdMutex;
+			inl::spin_mutex spinMutex;
+			spinMutex.EnableStatistics(true);
+
+			double stdRate = Contend(stdMutex, numThreads, TotalIterations / numThreads, workload.inside, workload.outside, isStdOk);
+			double spinRate = Contend(spinMutex, numThreads, TotalIterations / numThreads, workload.inside, workload.outside, isSpinOk);
+			auto statistics = spinMutex.GetStatistics();
+
+			cout << std::fixed << std::setprecision(2)
+				<< std::setw(8) << numThreads << std::setw(12) << stdRate << std::setw(12) << spinRate
+				<< std::setw(10) << statistics.spins << std::setw(10) << statistics.yields << std::setw(10) << statistics.parks << endl;
+
+			if (!isStdOk || !isSpinOk) {
+				cout << "Lost updates, mutual exclusion is broken." << endl;
+				return -1;
+			}
+			if (statistics.acquisitions != uint64_t(numThreads) * (TotalIterations / numThreads)) {
+				cout << "Acquisition count is wrong." << endl;
+				return -1;
+			}
+		}
+		cout << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include "Test.hpp"
+
+#include <BaseLibrary/SpscRingBuffer.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::cout;
+using std::endl;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestSpscRingBuffer : public AutoRegisterTest<TestSpscRingBuffer> {
+public:
+	TestSpscRingBuffer() {}
+
+	static std::string Name() {
+		return "RingBuffer - SPSC";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+// The usual way of handing things over between threads.
+class LockedQueue {
+public:
+	LockedQueue(size_t capacity) : m_capacity(capacity) {}
+	bool TryPush(uint64_t value) {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		if (m_queue.size() == m_capacity) {
+			return false;
+		}
+		m_queue.push_back(value);
+		return true;
+	}
+	bool TryPop(uint64_t& value) {
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		if (m_queue.empty()) {
+			return false;
+		}
+		value = m_queue.front();
+		m_queue.pop_front();
+		return true;
+	}
+private:
+	std::mutex m_mutex;
+	std::deque<uint64_t> m_queue;
+	size_t m_capacity;
+};
+
+
+// Sends a sequence of numbers from one thread to another, checks order and completeness.
+// Returns million elements per second.
+template <class QueueT>
+static double Transfer(uint64_t numElements, size_t capacity, bool& isOk) {
+	QueueT queue(capacity);
+	isOk = true;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	std::thread producer([&] {
+		for (uint64_t i = 0; i < numElements; ++i) {
+			while (!queue.TryPush(i)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	uint64_t expected = 0;
+	while (expected < numElements) {
+		uint64_t value;
+		if (queue.TryPop(value)) {
+			isOk = isOk && value == expected;
+			++expected;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	return numElements / std::chrono::duration<double>(endTime - startTime).count() / 1e6;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestSpscRingBuffer::Run() {
+	// non-trivial elements left in the ring must be destroyed
+	{
+		auto shared = std::make_shared<int>(0);
+		{
+			inl::SpscRingBuffer<std::shared_ptr<int>> ring(5);
+			if (ring.Capacity() != 8) {
+				cout << "Capacity is not rounded to power of two." << endl;
+				return -1;
+			}
+			for (int i = 0; i < 8; ++i) {
+				ring.TryPush(shared);
+			}
+			if (ring.TryPush(shared)) {
+				cout << "Pushed into a full ring." << endl;
+				return -1;
+			}
+			std::shared_ptr<int> popped;
+			ring.TryPop(popped);
+		}
+		if (shared.use_count() != 1) {
+			cout << "Elements leaked." << endl;
+			return -1;
+		}
+	}
+
+	constexpr uint64_t NumElements = 10'000'000;
+	bool isLockedOk, isSpscOk;
+	cout << "Single producer, single consumer (million elements per second):" << endl;
+	cout << std::setw(10) << "capacity" << std::setw(16) << "mutex + deque" << std::setw(10) << "spsc" << endl;
+	for (size_t capacity : { 16, 256, 4096 }) {
+		double locked = Transfer<LockedQueue>(NumElements, capacity, isLockedOk);
+		double spsc = Transfer<inl::SpscRingBuffer<uint64_t>>(NumElements, capacity, isSpscOk);
+		cout << std::fixed << std::setprecision(2)
+			<< std::setw(10) << capacity << std::setw(16) << locked << std::setw(10) << spsc << endl;
+		if (!isLockedOk || !isSpscOk) {
+			cout << "Elements arrived out of order." << endl;
+			return -1;
+		}
+	}
+
+	return 0;
+}
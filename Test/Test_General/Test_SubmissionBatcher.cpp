@@ -0,0 +1,142 @@
+#include "Test.hpp"
+#include "RecordingGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/SubmissionBatcher.hpp>
+#include <GraphicsEngine_LL/CommandAllocatorPool.hpp>
+#include <GraphicsEngine_LL/CommandListPool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+using std::cout;
+using std::endl;
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestSubmissionBatcher : public AutoRegisterTest<TestSubmissionBatcher> {
+public:
+	TestSubmissionBatcher() {}
+
+	static std::string Name() {
+		return "Submission batcher";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestSubmissionBatcher::Run() {
+	RecordingGraphicsApi api;
+	CommandAllocatorPool commandAllocatorPool(&api);
+	CommandListPool commandListPool(&api);
+	CommandQueue commandQueue(&api, gxapi::eCommandListType::GRAPHICS);
+	ResourceResidencyQueue residencyQueue(std::unique_ptr<gxapi::IFence>(api.CreateFence(0)));
+
+	auto EnqueueMarked = [&](SubmissionBatcher& batcher, unsigned marker) {
+		CmdAllocPtr allocator = commandAllocatorPool.RequestAllocator(gxapi::eCommandListType::GRAPHICS);
+		GraphicsCmdListPtr list = commandListPool.RequestGraphicsList(allocator.get());
+		list->SetStencilRef(marker);
+		list->Close();
+		batcher.Enqueue(std::move(list), std::move(allocator), {}, {}, {});
+	};
+
+	// a whole frame in one submission, in order
+	{
+		constexpr unsigned NumLists = 10;
+		api.ClearRecording();
+		SubmissionBatcher batcher(commandQueue, residencyQueue);
+		batcher.Flush(); // empty flush submits nothing
+		for (unsigned i = 0; i < NumLists; ++i) {
+			EnqueueMarked(batcher, i);
+		}
+		if (api.GetStatistics().executeCalls != 0 || batcher.GetNumPending() != NumLists) {
+			cout << "Lists submitted before flush." << endl;
+			return -1;
+		}
+		batcher.Flush();
+
+		auto statistics = api.GetStatistics();
+		if (statistics.executeCalls != 1 || statistics.commandLists != NumLists || statistics.signals != 1 || statistics.waits != 1) {
+			cout << "Expected one submission with one wait and signal, got " << statistics.executeCalls << " submissions, "
+				<< statistics.waits << " waits and " << statistics.signals << " signals." << endl;
+			return -1;
+		}
+		auto submissions = api.GetSubmissions();
+		for (unsigned i = 0; i < NumLists; ++i) {
+			if (submissions[0].commandLists[i].commands[0].argument != i) {
+				cout << "Lists submitted out of order." << endl;
+				return -1;
+			}
+		}
+	}
+
+	// budget limits the batch size
+	{
+		api.ClearRecording();
+		SubmissionBatcher batcher(commandQueue, residencyQueue, 4);
+		for (unsigned i = 0; i < 10; ++i) {
+			EnqueueMarked(batcher, i);
+		}
+		if (api.GetStatistics().executeCalls != 2 || batcher.GetNumPending() != 2) {
+			cout << "Budget not respected." << endl;
+			return -1;
+		}
+		batcher.Flush();
+		if (api.GetStatistics().executeCalls != 3 || api.GetStatistics().commandLists != 10) {
+			cout << "Remaining lists not flushed." << endl;
+			return -1;
+		}
+	}
+
+	// leftovers are submitted on destruction
+	{
+		api.ClearRecording();
+		{
+			SubmissionBatcher batcher(commandQueue, residencyQueue);
+			EnqueueMarked(batcher, 0);
+		}
+		if (api.GetStatistics().commandLists != 1) {
+			cout << "Pending lists lost on destruction." << endl;
+			return -1;
+		}
+	}
+
+	// host overhead of submitting one by one versus in one batch
+	{
+		constexpr unsigned NumLists = 2000;
+		auto Measure = [&](size_t maxBatchSize) {
+			api.ClearRecording();
+			SubmissionBatcher batcher(commandQueue, residencyQueue, maxBatchSize);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (unsigned i = 0; i < NumLists; ++i) {
+				EnqueueMarked(batcher, i);
+			}
+			batcher.Flush();
+			auto end = std::chrono::high_resolution_clock::now();
+			return std::chrono::duration<double, std::micro>(end - start).count() / NumLists;
+		};
+		double single = Measure(1);
+		auto singleStatistics = api.GetStatistics();
+		double batched = Measure(0);
+		auto batchedStatistics = api.GetStatistics();
+
+		cout << "Submitting " << NumLists << " command lists:" << endl;
+		cout << "    one by one: " << singleStatistics.executeCalls << " submissions, " << singleStatistics.signals << " signals, "
+			<< std::fixed << std::setprecision(2) << single << " us per list" << endl;
+		cout << "    batched:    " << batchedStatistics.executeCalls << " submissions, " << batchedStatistics.signals << " signals, "
+			<< std::fixed << std::setprecision(2) << batched << " us per list" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,189 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/TransientHeapPlanner.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestTransientHeap : public AutoRegisterTest<TestTransientHeap> {
+public:
+	TestTransientHeap() {}
+
+	static std::string Name() {
+		return "Transient heap";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Fake heap
+//------------------------------------------------------------------------------
+
+// Plays the frame on a heap of blocks that remember which resource they belong to.
+// Fails if two live resources share a block, or a resource takes over a block
+// from a resource that the layout does not list as its predecessor.
+static bool CheckLayout(const std::vector<TransientResourceDesc>& resources, const TransientHeapLayout& layout, uint64_t blockSize) {
+	constexpr size_t Free = ~size_t(0);
+	size_t numTasks = 0;
+	for (auto& desc : resources) {
+		numTasks = std::max(numTasks, desc.lastUse + 1);
+	}
+
+	std::vector<size_t> owners((layout.heapSize + blockSize - 1) / blockSize, Free);
+	std::vector<size_t> previousOwners = owners;
+	for (size_t task = 0; task < numTasks; ++task) {
+		std::fill(owners.begin(), owners.end(), Free);
+		for (size_t resource = 0; resource < resources.size(); ++resource) {
+			const TransientResourceDesc& desc = resources[resource];
+			if (task < desc.firstUse || desc.lastUse < task) {
+				continue;
+			}
+			if (layout.offsets[resource] % std::max<uint64_t>(1, desc.alignment) != 0 || layout.offsets[resource] + desc.size > layout.heapSize) {
+				cout << "Resource " << resource << " is misplaced." << endl;
+				return false;
+			}
+			for (uint64_t block = layout.offsets[resource] / blockSize; block * blockSize < layout.offsets[resource] + desc.size; ++block) {
+				if (owners[block] != Free) {
+					cout << "Resources " << owners[block] << " and " << resource << " overlap at task " << task << "." << endl;
+					return false;
+				}
+				owners[block] = resource;
+
+				size_t previous = previousOwners[block];
+				auto& predecessors = layout.aliasedPredecessors[resource];
+				if (task == desc.firstUse && previous != Free && previous != resource
+					&& std::find(predecessors.begin(), predecessors.end(), previous) == predecessors.end())
+				{
+					cout << "Resource " << resource << " does not wait for " << previous << "." << endl;
+					return false;
+				}
+			}
+		}
+		for (size_t block = 0; block < owners.size(); ++block) {
+			previousOwners[block] = owners[block] != Free ? owners[block] : previousOwners[block];
+		}
+	}
+	return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestTransientHeap::Run() {
+	constexpr uint64_t Alignment = 65536;
+	auto AlignUp = [](uint64_t size) {
+		return (size + Alignment - 1) / Alignment * Alignment;
+	};
+
+	// resources alive one after the other share all their memory
+	{
+		std::vector<TransientResourceDesc> resources = {
+			{ 4 * Alignment, Alignment, 0, 1 },
+			{ 4 * Alignment, Alignment, 2, 3 },
+			{ 2 * Alignment, Alignment, 4, 4 },
+		};
+		TransientHeapLayout layout = PlanTransientHeap(resources);
+		if (layout.heapSize != 4 * Alignment || layout.offsets[1] != 0 || layout.offsets[2] != 0) {
+			cout << "Sequential resources are not aliased." << endl;
+			return -1;
+		}
+		if (layout.aliasedPredecessors[1] != std::vector<size_t>{ 0 } || layout.aliasedPredecessors[2] != std::vector<size_t>{ 0, 1 }) {
+			cout << "Wrong predecessors of sequential resources." << endl;
+			return -1;
+		}
+		if (!CheckLayout(resources, layout, Alignment)) {
+			return -1;
+		}
+	}
+
+	// resources alive together don't
+	{
+		std::vector<TransientResourceDesc> resources = {
+			{ Alignment, Alignment, 0, 2 },
+			{ Alignment, Alignment, 1, 3 },
+		};
+		TransientHeapLayout layout = PlanTransientHeap(resources);
+		if (layout.heapSize != 2 * Alignment || !CheckLayout(resources, layout, Alignment)) {
+			cout << "Overlapping resources are aliased." << endl;
+			return -1;
+		}
+	}
+
+	// a post-processing chain at 1080p, intermediate targets are only alive between their producer and consumer
+	{
+		const uint64_t fullRes = AlignUp(1920 * 1080 * 8); // R16G16B16A16_FLOAT
+		const uint64_t halfRes = AlignUp(960 * 540 * 8);
+		const uint64_t halfDepth = AlignUp(960 * 540 * 4); // R32_FLOAT
+		std::vector<TransientResourceDesc> resources = {
+			{ fullRes, Alignment, 1, 2 }, // bright pass
+			{ halfRes, Alignment, 2, 3 }, // bloom downsample
+			{ halfRes, Alignment, 3, 4 }, // bloom blur horizontal
+			{ halfRes, Alignment, 4, 5 }, // bloom blur vertical
+			{ fullRes, Alignment, 5, 6 }, // bloom add
+			{ fullRes, Alignment, 6, 8 }, // DOF prepare color
+			{ halfDepth, Alignment, 6, 8 }, // DOF prepare depth
+			{ fullRes, Alignment, 8, 9 }, // DOF main
+			{ fullRes, Alignment, 9, 10 }, // motion blur
+			{ fullRes, Alignment, 10, 11 }, // tone mapped
+		};
+		TransientHeapLayout layout = PlanTransientHeap(resources);
+		if (!CheckLayout(resources, layout, Alignment)) {
+			return -1;
+		}
+		if (layout.heapSize >= layout.totalSize || layout.heapSize < layout.peakLiveSize) {
+			cout << "Post-processing chain is not aliased." << endl;
+			return -1;
+		}
+		cout << "Post-processing chain, " << resources.size() << " textures:" << endl;
+		cout << "  without aliasing: " << layout.totalSize / 1024 << " KiB" << endl;
+		cout << "  with aliasing:    " << layout.heapSize / 1024 << " KiB" << endl;
+		cout << "  peak live:        " << layout.peakLiveSize / 1024 << " KiB" << endl;
+	}
+
+	// random frames
+	{
+		std::mt19937 rne(1337);
+		std::uniform_int_distribution<size_t> taskDist(0, 30);
+		std::uniform_int_distribution<uint64_t> sizeDist(1, 64);
+		uint64_t totalSize = 0, heapSize = 0, peakLiveSize = 0;
+		for (int frame = 0; frame < 200; ++frame) {
+			std::vector<TransientResourceDesc> resources(20);
+			for (auto& desc : resources) {
+				size_t first = taskDist(rne), last = taskDist(rne);
+				desc = { sizeDist(rne) * 4096, (rne() % 2) ? Alignment : 4096, std::min(first, last), std::max(first, last) };
+			}
+			TransientHeapLayout layout = PlanTransientHeap(resources);
+			if (!CheckLayout(resources, layout, 4096)) {
+				cout << "Random frame " << frame << " failed." << endl;
+				return -1;
+			}
+			if (layout.heapSize < layout.peakLiveSize || layout.heapSize > layout.totalSize + resources.size() * Alignment) {
+				cout << "Random frame " << frame << " has impossible sizes." << endl;
+				return -1;
+			}
+			totalSize += layout.totalSize;
+			heapSize += layout.heapSize;
+			peakLiveSize += layout.peakLiveSize;
+		}
+		cout << "Random frames, heap / separate: " << double(heapSize) / double(totalSize)
+			<< ", heap / peak live: " << double(heapSize) / double(peakLiveSize) << endl;
+	}
+
+	return 0;
+}
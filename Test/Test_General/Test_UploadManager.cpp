@@ -0,0 +1,330 @@
+#include "Test.hpp"
+#include "RecordingGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/UploadManager.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestUploadManager : public AutoRegisterTest<TestUploadManager> {
+public:
+	TestUploadManager() {}
+
+	static std::string Name() {
+		return "Upload manager";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+
+
+static LinearBuffer MakeBuffer(RecordingGraphicsApi& api, size_t size) {
+	return LinearBuffer(MemoryObjDesc(
+		api.CreateCommittedResource(gxapi::HeapProperties(gxapi::eHeapType::DEFAULT),
+									gxapi::eHeapFlags::NONE,
+									gxapi::ResourceDesc::Buffer(size),
+									gxapi::eResourceState::COPY_DEST),
+		eResourceHeap::CRITICAL));
+}
+
+
+static Texture2D MakeTexture(RecordingGraphicsApi& api, uint64_t width, uint32_t height) {
+	return Texture2D(MemoryObjDesc(
+		api.CreateCommittedResource(gxapi::HeapProperties(gxapi::eHeapType::DEFAULT),
+									gxapi::eHeapFlags::NONE,
+									gxapi::ResourceDesc::Texture2D(width, height, gxapi::eFormat::R8G8B8A8_UNORM),
+									gxapi::eResourceState::COPY_DEST),
+		eResourceHeap::CRITICAL));
+}
+
+
+// The staging memory of an upload, as the copy queue would read it.
+static const uint8_t* GetStagingData(const UploadManager::UploadDescription& upload) {
+	return reinterpret_cast<const uint8_t*>(upload.source._GetResourcePtr()->Map(0)) + upload.srcOffset;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestUploadManager::Run() {
+	RecordingGraphicsApi api;
+	UploadManager uploadManager(&api);
+	// Frames start at zero like in the engine, the GPU lags behind by the given number of frames.
+	uint64_t frame = 0;
+	uint64_t numCompletedFrames = 0;
+	uploadManager.OnFrameBeginAwait(frame);
+	auto BeginNextFrame = [&](uint64_t framesInFlight) {
+		++frame;
+		uploadManager.OnFrameBeginAwait(frame);
+		while (numCompletedFrames + framesInFlight <= frame) {
+			uploadManager.OnFrameCompleteDevice(numCompletedFrames++);
+		}
+	};
+
+	// small uploads share pages, packed one after the other within the thread's block
+	{
+		constexpr int NumUploads = 1000;
+		constexpr size_t ChunkSize = 3000;
+		LinearBuffer target = MakeBuffer(api, NumUploads * ChunkSize);
+		size_t resourcesBefore = api.GetStatistics().resources;
+
+		std::vector<uint8_t> chunk(ChunkSize);
+		for (int i = 0; i < NumUploads; ++i) {
+			std::fill(chunk.begin(), chunk.end(), uint8_t(i));
+			uploadManager.Upload(target, i * ChunkSize, chunk.data(), ChunkSize);
+		}
+
+		auto& uploads = uploadManager.CollectUploads();
+		if (uploads.size() != NumUploads) {
+			cout << "Expected " << NumUploads << " queued uploads, got " << uploads.size() << "." << endl;
+			return -1;
+		}
+		int numBreaks = 0;
+		for (int i = 0; i < NumUploads; ++i) {
+			const uint8_t* staging = GetStagingData(uploads[i]);
+			if (uploads[i].size != ChunkSize || uploads[i].dstOffsetX != i * ChunkSize || uploads[i].srcOffset % 4 != 0
+				|| staging[0] != uint8_t(i) || staging[ChunkSize - 1] != uint8_t(i))
+			{
+				cout << "Upload " << i << " is corrupted." << endl;
+				return -1;
+			}
+			numBreaks += i > 0 && uploads[i].srcOffset != uploads[i - 1].srcOffset + ChunkSize;
+		}
+		if (numBreaks > NumUploads / 64) {
+			cout << "Consecutive uploads are not packed." << endl;
+			return -1;
+		}
+		size_t created = api.GetStatistics().resources - resourcesBefore;
+		cout << NumUploads << " uploads of " << ChunkSize << " bytes created " << created << " resources." << endl;
+		if (created != uploadManager.GetNumStagingPages() || created > 2) {
+			cout << "Small uploads got their own resources." << endl;
+			return -1;
+		}
+	}
+
+	// texture rows are pitched in the staging memory
+	{
+		constexpr uint32_t Width = 50, Height = 4;
+		Texture2D target = MakeTexture(api, 64, 64);
+		std::vector<uint32_t> pixels(Width * Height);
+		for (size_t i = 0; i < pixels.size(); ++i) {
+			pixels[i] = uint32_t(i);
+		}
+		uploadManager.Upload(target, 8, 8, 0, pixels.data(), Width, Height, gxapi::eFormat::R8G8B8A8_UNORM);
+
+		auto& upload = uploadManager.CollectUploads().back();
+		const uint8_t* staging = GetStagingData(upload);
+		if (upload.textureBufferDesc.byteOffset != upload.srcOffset || upload.srcOffset % 512 != 0) {
+			cout << "Texture footprint does not point at the staging memory." << endl;
+			return -1;
+		}
+		for (uint32_t y = 0; y < Height; ++y) {
+			if (std::memcmp(staging + y * 256, pixels.data() + y * Width, Width * 4) != 0) {
+				cout << "Texture row " << y << " is misplaced." << endl;
+				return -1;
+			}
+		}
+	}
+
+	// oversized uploads get a dedicated resource
+	{
+		std::vector<uint8_t> large(5 * 1024 * 1024, 7);
+		LinearBuffer target = MakeBuffer(api, large.size());
+		size_t resourcesBefore = api.GetStatistics().resources;
+		size_t pagesBefore = uploadManager.GetNumStagingPages();
+		uploadManager.Upload(target, 0, large.data(), large.size());
+
+		auto& upload = uploadManager.CollectUploads().back();
+		if (api.GetStatistics().resources - resourcesBefore != 1 || uploadManager.GetNumStagingPages() != pagesBefore
+			|| upload.srcOffset != 0 || upload.source.GetSize() != large.size() || GetStagingData(upload)[large.size() - 1] != 7)
+		{
+			cout << "Oversized upload is not dedicated." << endl;
+			return -1;
+		}
+	}
+
+	// pages filled in the first frame are not reused while the GPU may still copy from them
+	{
+		constexpr size_t ChunkSize = 16 * 1024;
+		LinearBuffer target = MakeBuffer(api, ChunkSize);
+		std::vector<uint8_t> chunk(ChunkSize, 0xAB);
+		uploadManager.Upload(target, 0, chunk.data(), ChunkSize);
+		UploadManager::UploadDescription firstUpload = uploadManager.CollectUploads().back();
+		const uint8_t* firstStaging = GetStagingData(firstUpload);
+
+		// fill more than all pages in the next frame while frame 0 is still in flight
+		BeginNextFrame(2);
+		std::fill(chunk.begin(), chunk.end(), uint8_t(0xCD));
+		size_t numChunks = (uploadManager.GetNumStagingPages() + 1) * (4 * 1024 * 1024 / ChunkSize);
+		for (size_t i = 0; i < numChunks; ++i) {
+			uploadManager.Upload(target, 0, chunk.data(), ChunkSize);
+		}
+		uploadManager.CollectUploads();
+		if (numCompletedFrames != 0 || firstStaging[0] != 0xAB || firstStaging[ChunkSize - 1] != 0xAB) {
+			cout << "Staging page of frame 0 was reused before the frame completed." << endl;
+			return -1;
+		}
+
+		// once the GPU is done with frame 0, its pages are refilled instead of creating new ones
+		BeginNextFrame(1);
+		size_t resourcesBefore = api.GetStatistics().resources;
+		for (size_t i = 0; i < 4 * 1024 * 1024 / ChunkSize; ++i) {
+			uploadManager.Upload(target, 0, chunk.data(), ChunkSize);
+		}
+		uploadManager.CollectUploads();
+		if (numCompletedFrames != 2 || api.GetStatistics().resources != resourcesBefore) {
+			cout << "Staging pages of completed frames are not reused." << endl;
+			return -1;
+		}
+	}
+
+	// streaming: pages are reused once the GPU has finished their frame
+	{
+		constexpr int NumFrames = 200;
+		constexpr int UploadsPerFrame = 256;
+		constexpr size_t ChunkSize = 16 * 1024;
+		constexpr uint64_t FramesInFlight = 2;
+		LinearBuffer target = MakeBuffer(api, ChunkSize);
+		std::vector<uint8_t> chunk(ChunkSize, 1);
+
+		size_t resourcesBefore = api.GetStatistics().resources;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < NumFrames; ++i) {
+			for (int u = 0; u < UploadsPerFrame; ++u) {
+				uploadManager.Upload(target, 0, chunk.data(), ChunkSize);
+			}
+			uploadManager.CollectUploads();
+			BeginNextFrame(FramesInFlight);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+		double megabytes = double(NumFrames) * UploadsPerFrame * ChunkSize / (1024.0 * 1024.0);
+		size_t created = api.GetStatistics().resources - resourcesBefore;
+		cout << std::fixed << std::setprecision(2)
+			<< NumFrames * UploadsPerFrame << " streamed uploads: " << megabytes / seconds << " MiB/s, "
+			<< created << " resources created, " << uploadManager.GetNumStagingPages() << " staging pages." << endl;
+
+		// 4 MiB per frame, at most three frames are written or in flight, the earlier tests left pages to reuse
+		if (created > 4) {
+			cout << "Staging pages are not recycled." << endl;
+			return -1;
+		}
+	}
+
+	// producer threads: every upload is collected once, in order per thread, with its own data
+	{
+		constexpr int NumThreads = 8;
+		constexpr int UploadsPerThread = 4000;
+		constexpr size_t ChunkSize = 1024;
+		constexpr size_t LargeChunkSize = 96 * 1024; // every 64th, allocated from a page directly
+		LinearBuffer target = MakeBuffer(api, LargeChunkSize);
+
+		std::atomic<int> numRunning = NumThreads;
+		std::vector<std::thread> producers;
+		for (uint32_t thread = 0; thread < NumThreads; ++thread) {
+			producers.emplace_back([&, thread] {
+				std::vector<uint32_t> chunk(LargeChunkSize / 4);
+				for (uint32_t seq = 0; seq < UploadsPerThread; ++seq) {
+					size_t size = seq % 64 == 63 ? LargeChunkSize : ChunkSize;
+					std::fill(chunk.begin(), chunk.begin() + size / 4, thread * UploadsPerThread + seq);
+					uploadManager.Upload(target, 0, chunk.data(), size);
+				}
+				--numRunning;
+			});
+		}
+
+		// The main thread plays the frames: collect, check, let the GPU lag two frames behind.
+		std::vector<int> nextSeq(NumThreads, 0);
+		bool isRunning = true;
+		while (isRunning) {
+			isRunning = numRunning > 0; // one more round after the last producer is done
+			for (auto& upload : uploadManager.CollectUploads()) {
+				const uint32_t* staging = reinterpret_cast<const uint32_t*>(GetStagingData(upload));
+				uint32_t id = staging[0];
+				uint32_t thread = id / UploadsPerThread;
+				uint32_t seq = id % UploadsPerThread;
+				if (thread >= NumThreads || int(seq) != nextSeq[thread] || staging[upload.size / 4 - 1] != id) {
+					cout << "Upload of producer " << thread << " is out of order or corrupted." << endl;
+					for (auto& producer : producers) {
+						producer.join();
+					}
+					return -1;
+				}
+				++nextSeq[thread];
+			}
+			BeginNextFrame(2);
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+		}
+		for (auto& producer : producers) {
+			producer.join();
+		}
+		if (std::any_of(nextSeq.begin(), nextSeq.end(), [](int count) { return count != UploadsPerThread; })) {
+			cout << "Uploads of producers were lost." << endl;
+			return -1;
+		}
+		cout << NumThreads << " producers, " << NumThreads * UploadsPerThread << " uploads arrived in order, "
+			<< uploadManager.GetNumStagingPages() << " staging pages." << endl;
+	}
+
+	// throughput of small uploads with one and more producers
+	for (int numThreads : { 1, 4 }) {
+		constexpr int UploadsPerThread = 50000;
+		constexpr size_t ChunkSize = 4096;
+		LinearBuffer target = MakeBuffer(api, ChunkSize);
+
+		std::atomic<int> numRunning = numThreads;
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> producers;
+		for (int thread = 0; thread < numThreads; ++thread) {
+			producers.emplace_back([&] {
+				std::vector<uint8_t> chunk(ChunkSize, 1);
+				for (int i = 0; i < UploadsPerThread; ++i) {
+					uploadManager.Upload(target, 0, chunk.data(), ChunkSize);
+				}
+				--numRunning;
+			});
+		}
+		bool isRunning = true;
+		while (isRunning) {
+			isRunning = numRunning > 0;
+			uploadManager.CollectUploads();
+			BeginNextFrame(2);
+		}
+		for (auto& producer : producers) {
+			producer.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+		cout << std::fixed << std::setprecision(2) << numThreads << " producers: "
+			<< numThreads * UploadsPerThread / seconds / 1e6 << " M uploads/s, "
+			<< numThreads * UploadsPerThread * double(ChunkSize) / (1024.0 * 1024.0) / seconds << " MiB/s" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,220 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/UploadPlanner.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestUploadPlanner : public AutoRegisterTest<TestUploadPlanner> {
+public:
+	TestUploadPlanner() {}
+
+	static std::string Name() {
+		return "Upload planner";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Fake buffers
+//------------------------------------------------------------------------------
+
+// Every destination byte remembers which staging byte it was copied from.
+using StagingByte = std::pair<const void*, uint64_t>;
+using BufferContents = std::map<std::pair<const void*, uint64_t>, StagingByte>;
+
+
+static BufferContents PlayUploads(const std::vector<BufferUploadRange>& uploads) {
+	BufferContents contents;
+	for (auto& upload : uploads) {
+		for (uint64_t i = 0; i < upload.size; ++i) {
+			contents[{ upload.destination, upload.dstOffset + i }] = { upload.source, upload.srcOffset + i };
+		}
+	}
+	return contents;
+}
+
+
+// Fails if the copies write something else than the uploads would, or a destination is split up.
+static bool CheckCopies(const std::vector<BufferUploadRange>& uploads, const std::vector<BufferUploadCopy>& copies) {
+	BufferContents expected = PlayUploads(uploads);
+	BufferContents actual;
+	std::set<const void*> finishedDestinations;
+	const void* destination = nullptr;
+	for (auto& copy : copies) {
+		const BufferUploadRange& upload = uploads[copy.upload];
+		if (upload.destination != destination) {
+			if (!finishedDestinations.insert(upload.destination).second) {
+				cout << "Copies of a destination are not grouped." << endl;
+				return false;
+			}
+			destination = upload.destination;
+		}
+		for (uint64_t i = 0; i < copy.size; ++i) {
+			if (!actual.insert({ { upload.destination, copy.dstOffset + i }, { upload.source, copy.srcOffset + i } }).second) {
+				cout << "Copies overlap." << endl;
+				return false;
+			}
+		}
+	}
+	if (actual != expected) {
+		cout << "Copies don't write what the uploads did." << endl;
+		return false;
+	}
+	return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestUploadPlanner::Run() {
+	// Only their addresses matter.
+	int buffers[4];
+	int pages[2];
+
+	// adjacent in both the buffer and the staging page: one copy
+	{
+		std::vector<BufferUploadRange> uploads = {
+			{ &buffers[0], 0, 64, &pages[0], 0 },
+			{ &buffers[0], 64, 64, &pages[0], 64 },
+			{ &buffers[0], 128, 32, &pages[0], 128 },
+		};
+		auto copies = PlanBufferCopies(uploads);
+		if (copies.size() != 1 || copies[0].size != 160 || !CheckCopies(uploads, copies)) {
+			cout << "Adjacent uploads are not merged." << endl;
+			return -1;
+		}
+	}
+
+	// adjacent in the buffer only: separate copies
+	{
+		std::vector<BufferUploadRange> uploads = {
+			{ &buffers[0], 0, 64, &pages[0], 0 },
+			{ &buffers[0], 64, 64, &pages[1], 0 },
+		};
+		auto copies = PlanBufferCopies(uploads);
+		if (copies.size() != 2 || !CheckCopies(uploads, copies)) {
+			cout << "Uploads from different pages are merged." << endl;
+			return -1;
+		}
+	}
+
+	// overlapping and overwritten uploads
+	{
+		std::vector<BufferUploadRange> uploads = {
+			{ &buffers[0], 0, 100, &pages[0], 0 },
+			{ &buffers[1], 0, 100, &pages[0], 100 },
+			{ &buffers[0], 50, 100, &pages[0], 200 },
+			{ &buffers[1], 0, 100, &pages[0], 300 },
+			{ &buffers[0], 20, 10, &pages[1], 0 },
+		};
+		auto copies = PlanBufferCopies(uploads);
+		// buffer 0 ends up as [0, 20) [20, 30) [30, 50) [50, 150), buffer 1 is the fourth upload
+		if (copies.size() != 5 || !CheckCopies(uploads, copies)) {
+			cout << "Overlapping uploads are not cut." << endl;
+			return -1;
+		}
+		if (std::any_of(copies.begin(), copies.end(), [](const BufferUploadCopy& copy) { return copy.upload == 1; })) {
+			cout << "Overwritten upload is not dropped." << endl;
+			return -1;
+		}
+	}
+
+	// random uploads
+	{
+		std::mt19937 rne(1337);
+		std::uniform_int_distribution<int> bufferDist(0, 3);
+		std::uniform_int_distribution<uint64_t> offsetDist(0, 200);
+		std::uniform_int_distribution<uint64_t> sizeDist(0, 60);
+		for (int frame = 0; frame < 200; ++frame) {
+			std::vector<BufferUploadRange> uploads;
+			uint64_t stagingOffset = 0;
+			for (int i = 0; i < 30; ++i) {
+				uint64_t size = sizeDist(rne);
+				uploads.push_back({ &buffers[bufferDist(rne)], offsetDist(rne), size, &pages[rne() % 2], stagingOffset });
+				stagingOffset += (rne() % 2) ? size : size + 4;
+			}
+			if (!CheckCopies(uploads, PlanBufferCopies(uploads))) {
+				cout << "Random frame " << frame << " failed." << endl;
+				return -1;
+			}
+		}
+	}
+
+	// streaming meshes: each frame updates consecutive vertex ranges and rewrites some of them
+	{
+		constexpr int NumMeshes = 64;
+		constexpr int RangesPerMesh = 8;
+		constexpr uint64_t RangeSize = 32 * 100; // 100 vertices of 32 bytes
+		std::vector<int> meshes(NumMeshes);
+		std::vector<BufferUploadRange> uploads;
+		uint64_t stagingOffset = 0;
+		for (int mesh = 0; mesh < NumMeshes; ++mesh) {
+			for (int range = 0; range < RangesPerMesh; ++range) {
+				uploads.push_back({ &meshes[mesh], range * RangeSize, RangeSize, &pages[0], stagingOffset });
+				stagingOffset += RangeSize;
+			}
+		}
+		// animated meshes rewrite their first ranges later in the frame
+		for (int mesh = 0; mesh < NumMeshes; mesh += 2) {
+			uploads.push_back({ &meshes[mesh], 0, 2 * RangeSize, &pages[0], stagingOffset });
+			stagingOffset += 2 * RangeSize;
+		}
+		auto copies = PlanBufferCopies(uploads);
+		if (!CheckCopies(uploads, copies)) {
+			return -1;
+		}
+		cout << "Streaming " << NumMeshes << " meshes: " << uploads.size() << " copies before, " << copies.size() << " after." << endl;
+		if (copies.size() != NumMeshes + NumMeshes / 2) {
+			cout << "Streaming uploads are not merged." << endl;
+			return -1;
+		}
+	}
+
+	// textures: uploads inside a later one to the same subresource are dropped
+	{
+		int textures[2];
+		std::vector<TextureUploadRegion> uploads = {
+			{ &textures[0], 0, 16, 16, 16, 16 },
+			{ &textures[1], 0, 0, 0, 64, 64 },
+			{ &textures[0], 1, 0, 0, 64, 64 }, // other subresource
+			{ &textures[0], 0, 8, 8, 32, 16 }, // partially covers the first
+			{ &textures[0], 0, 0, 0, 64, 64 },
+			{ &textures[1], 0, 32, 32, 8, 8 },
+		};
+		std::vector<size_t> copies = PlanTextureCopies(uploads);
+		std::vector<size_t> textures0(copies.begin(), copies.end());
+		textures0.erase(std::remove_if(textures0.begin(), textures0.end(), [&](size_t index) { return uploads[index].destination != &textures[0]; }), textures0.end());
+		if (copies.size() != 4 || textures0 != std::vector<size_t>{ 2, 4 }) {
+			cout << "Wrong texture uploads are kept." << endl;
+			return -1;
+		}
+		bool isGrouped = uploads[copies[0]].destination == uploads[copies[1]].destination
+			&& uploads[copies[2]].destination == uploads[copies[3]].destination;
+		if (!isGrouped) {
+			cout << "Texture uploads are not grouped." << endl;
+			return -1;
+		}
+	}
+
+	return 0;
+}